@@ -0,0 +1,74 @@
+/**
+ * @file:     deca_airtime.c
+ *
+ * @brief     Frame air time and reply delays of a PHY configuration
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_airtime.h"
+
+#define AIRTIME_DTU_PER_10US    (638976ULL)     // 63.8976 GHz time stamp clock, in DTU per 10 us
+#define AIRTIME_UUS_PER_40US    (39ULL)         // 1 UUS is 512 / 499.2 MHz, 40 us are 39 UUS
+
+/**
+ * airtime_ns_to_dtu() - Convert a duration to DTU, rounded up
+ */
+static uint32_t airtime_ns_to_dtu(uint32_t ns)
+{
+    return (uint32_t)((((uint64_t)ns * AIRTIME_DTU_PER_10US) + 9999ULL) / 10000ULL);
+}
+
+/**
+ * airtime_dtu_to_ns() - Convert a duration in DTU to ns, rounded down
+ */
+static uint32_t airtime_dtu_to_ns(uint32_t dtu)
+{
+    return (uint32_t)(((uint64_t)dtu * 10000ULL) / AIRTIME_DTU_PER_10US);
+}
+
+void airtime_calc(const dwt_config_t *config, dwt_airtime_t *at)
+{
+    at->shr_ns = AIRTIME_SHR_NS(config->txPreambLength, config->txCode, config->sfdType);
+    at->sts_ns = AIRTIME_STS_NS(config->stsMode, config->stsLength);
+    at->phr_ns = AIRTIME_PHR_NS(config->dataRate, config->phrRate, config->stsMode);
+    at->bit_ps = AIRTIME_NO_DATA(config->dataRate, config->stsMode) ? 0UL : AIRTIME_BIT_PS(config->dataRate);
+}
+
+uint32_t airtime_after_rmarker_ns(const dwt_airtime_t *at, uint16_t len)
+{
+    return at->sts_ns + at->phr_ns + AIRTIME_PS_TO_NS(AIRTIME_DATA_BITS(len), at->bit_ps);
+}
+
+uint32_t airtime_frame_ns(const dwt_airtime_t *at, uint16_t len)
+{
+    return at->shr_ns + airtime_after_rmarker_ns(at, len);
+}
+
+uint32_t airtime_reply_dly_dtu(const dwt_airtime_t *at, uint16_t rx_len, uint32_t turnaround_ns)
+{
+    // The reply preamble starts its SHR before the RMARKER, which may come up to 512 DTU early
+    return airtime_ns_to_dtu(airtime_after_rmarker_ns(at, rx_len) + turnaround_ns + at->shr_ns) + AIRTIME_DX_ROUNDING_DTU;
+}
+
+uint32_t airtime_rx_after_tx_uus(const dwt_airtime_t *at, uint16_t tx_len, uint32_t reply_dly_dtu)
+{
+    uint32_t ret = 0UL;
+
+    if (reply_dly_dtu > AIRTIME_DX_ROUNDING_DTU)
+    {
+        uint32_t reply_ns = airtime_dtu_to_ns(reply_dly_dtu - AIRTIME_DX_ROUNDING_DTU);
+        uint32_t busy_ns = airtime_after_rmarker_ns(at, tx_len) + at->shr_ns;
+
+        if (reply_ns > busy_ns)
+        {
+            ret = (uint32_t)(((uint64_t)(reply_ns - busy_ns) * AIRTIME_UUS_PER_40US) / 40000ULL);
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file:     deca_airtime.h
+ *
+ * @brief     Frame air time and reply delays of a PHY configuration
+ *
+ *            A frame is made of, in this order:
+ *              SHR:  preamble (txPreambLength symbols) and SFD (8 or 16 symbols), up to the RMARKER
+ *              STS:  in STS mode 1 and in no data mode (32 to 2048 symbols of 512 chips)
+ *              PHR:  19 bits and 2 tail bits, at 850 kb/s or at the data rate (DWT_PHRRATE_DTA)
+ *              data: payload bits and 48 Reed-Solomon parity bits per block of up to 330 bits
+ *              STS:  in STS mode 2
+ *            No PHR nor data is sent in no data mode (SP3). The gaps before the STS are not counted.
+ *
+ *            The AIRTIME_* macros evaluate to constants when given constants (e.g. the fields of a
+ *            configuration known at build time), so that delays can be set at compile time.
+ *            airtime_calc() gives the same durations at run time, and is cached by the driver each
+ *            time dwt_configure() runs (see dwt_getairtime()).
+ *
+ *            The minimum reply delay, from the RMARKER of a received frame to the RMARKER of the reply,
+ *            is the rest of the received frame, the turnaround time of the host (RX interrupt to delayed
+ *            TX started, platform dependent) and the SHR of the reply.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_AIRTIME_H_
+#define DECA_AIRTIME_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+#define AIRTIME_PSYM_PRF16_PS     (993590UL)    // Preamble symbol at 16 MHz PRF (codes 1 to 8), in ps
+#define AIRTIME_PSYM_PRF64_PS     (1017628UL)   // Preamble symbol at 64 MHz PRF, in ps
+#define AIRTIME_STS_SYM_PS        (1025641UL)   // STS symbol, 512 chips, in ps
+#define AIRTIME_BIT_850K_PS       (1025641UL)   // Data bit at 850 kb/s, in ps
+#define AIRTIME_BIT_6M8_PS        (128205UL)    // Data bit at 6.8 Mb/s, in ps
+#define AIRTIME_PHR_BITS          (21UL)
+#define AIRTIME_RS_BLOCK_BITS     (330UL)
+#define AIRTIME_RS_PARITY_BITS    (48UL)
+#define AIRTIME_DX_ROUNDING_DTU   (512UL)       // Delayed TX times are rounded down to 512 DTU (8 ns)
+
+/* Preamble symbols of a txPreambLength code, DWT_PLEN_32 to DWT_PLEN_4096 */
+#define AIRTIME_PLEN_SYMBOLS(plen)  (((uint32_t)(plen) + 1UL) * 8UL)
+
+/* Preamble symbol duration of a preamble code, in ps */
+#define AIRTIME_PSYM_PS(code)       (((uint32_t)(code) >= 9UL) ? AIRTIME_PSYM_PRF64_PS : AIRTIME_PSYM_PRF16_PS)
+
+/* SFD symbols of an SFD type */
+#define AIRTIME_SFD_SYMBOLS(sfd)    (((uint32_t)(sfd) == (uint32_t)DWT_SFD_DW_16) ? 16UL : 8UL)
+
+/* Data bits of a payload (including the FCS), with the Reed-Solomon parity bits */
+#define AIRTIME_DATA_BITS(len) \
+    (((uint32_t)(len) * 8UL) + ((((uint32_t)(len) * 8UL) + AIRTIME_RS_BLOCK_BITS - 1UL) / AIRTIME_RS_BLOCK_BITS) * AIRTIME_RS_PARITY_BITS)
+
+/* Data bit duration of a data rate, in ps */
+#define AIRTIME_BIT_PS(rate)        (((uint32_t)(rate) == (uint32_t)DWT_BR_6M8) ? AIRTIME_BIT_6M8_PS : AIRTIME_BIT_850K_PS)
+
+/* A duration in ps as ns, rounded up */
+#define AIRTIME_PS_TO_NS(n, ps)     ((uint32_t)((((uint64_t)(n) * (uint64_t)(ps)) + 999ULL) / 1000ULL))
+
+/* SHR: preamble and SFD, in ns */
+#define AIRTIME_SHR_NS(plen, code, sfd) \
+    AIRTIME_PS_TO_NS(AIRTIME_PLEN_SYMBOLS(plen) + AIRTIME_SFD_SYMBOLS(sfd), AIRTIME_PSYM_PS(code))
+
+/* STS of an STS mode and dwt_sts_lengths_e, in ns */
+#define AIRTIME_STS_NS(sts_mode, sts_len) \
+    ((((uint32_t)(sts_mode) & (uint32_t)DWT_STS_CONFIG_MASK_NO_SDC) == (uint32_t)DWT_STS_MODE_OFF) ? \
+        0UL : AIRTIME_PS_TO_NS(32UL << (uint32_t)(sts_len), AIRTIME_STS_SYM_PS))
+
+/* No PHR nor data: no data rate or STS no data mode */
+#define AIRTIME_NO_DATA(rate, sts_mode) \
+    (((uint32_t)(rate) == (uint32_t)DWT_BR_NODATA) \
+        || (((uint32_t)(sts_mode) & (uint32_t)DWT_STS_CONFIG_MASK_NO_SDC) == (uint32_t)DWT_STS_MODE_ND))
+
+/* PHR, in ns */
+#define AIRTIME_PHR_NS(rate, phr_rate, sts_mode) \
+    (AIRTIME_NO_DATA(rate, sts_mode) ? 0UL : \
+        AIRTIME_PS_TO_NS(AIRTIME_PHR_BITS, ((uint32_t)(phr_rate) == (uint32_t)DWT_PHRRATE_DTA) ? AIRTIME_BIT_PS(rate) : AIRTIME_BIT_850K_PS))
+
+/* Data of a payload of len bytes (including the FCS), in ns */
+#define AIRTIME_DATA_NS(len, rate, sts_mode) \
+    (AIRTIME_NO_DATA(rate, sts_mode) ? 0UL : AIRTIME_PS_TO_NS(AIRTIME_DATA_BITS(len), AIRTIME_BIT_PS(rate)))
+
+/* Whole frame of len bytes (including the FCS), in ns */
+#define AIRTIME_FRAME_NS(plen, code, sfd, rate, phr_rate, sts_mode, sts_len, len) \
+    (AIRTIME_SHR_NS(plen, code, sfd) + AIRTIME_STS_NS(sts_mode, sts_len) + AIRTIME_PHR_NS(rate, phr_rate, sts_mode) \
+        + AIRTIME_DATA_NS(len, rate, sts_mode))
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Frame timing of a configuration, from its TX preamble length and code, SFD type, data rate,
+ *        PHR rate, STS mode and length.
+ *
+ * input parameters
+ * @param config configuration, as given to dwt_configure()
+ *
+ * output parameters
+ * @param at frame timing
+ */
+void airtime_calc(const dwt_config_t *config, dwt_airtime_t *at);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Air time of a frame.
+ *
+ * input parameters
+ * @param at frame timing
+ * @param len frame length in bytes, including the FCS
+ *
+ * return: air time in ns.
+ */
+uint32_t airtime_frame_ns(const dwt_airtime_t *at, uint16_t len);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Air time of a frame after its RMARKER: STS, PHR and data.
+ *
+ * input parameters
+ * @param at frame timing
+ * @param len frame length in bytes, including the FCS
+ *
+ * return: air time in ns.
+ */
+uint32_t airtime_after_rmarker_ns(const dwt_airtime_t *at, uint16_t len);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Shortest safe reply delay, from the RX time stamp of a frame to the TX time stamp of the
+ *        reply, e.g. for twr_config_t.poll_rx_to_resp_tx_dly. The rounding of delayed TX times is
+ *        accounted for.
+ *
+ * input parameters
+ * @param at frame timing
+ * @param rx_len length of the frame received, including the FCS
+ * @param turnaround_ns host time from the end of the frame received to the delayed TX started
+ *
+ * return: reply delay in DTU.
+ */
+uint32_t airtime_reply_dly_dtu(const dwt_airtime_t *at, uint16_t rx_len, uint32_t turnaround_ns);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Longest delay to turn the receiver on after a frame sent, for a reply sent with a given
+ *        reply delay to be received, e.g. for twr_config_t.poll_tx_to_resp_rx_dly_uus (see
+ *        dwt_setrxaftertxdelay()). The receiver is turned on at the start of the reply preamble.
+ *
+ * input parameters
+ * @param at frame timing
+ * @param tx_len length of the frame sent, including the FCS
+ * @param reply_dly_dtu reply delay of the peer, from the RMARKER of the frame sent to that of the reply
+ *
+ * return: RX after TX delay in UWB microseconds (UUS, 1.0256 us), 0 if the reply delay is too short.
+ */
+uint32_t airtime_rx_after_tx_uus(const dwt_airtime_t *at, uint16_t tx_len, uint32_t reply_dly_dtu);
+
+#endif /* DECA_AIRTIME_H_ */
@@ -0,0 +1,170 @@
+/**
+ * @file:     deca_antcal.c
+ *
+ * @brief     Antenna delay calibration against a reference device at a known distance
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+#include "deca_twr.h"
+#include "deca_antcal.h"
+
+#define ANTCAL_VAR_MIN_Q8     (256LL)   // Variance floor of the outlier test, 1 DTU^2, the time stamp resolution
+
+const antcal_store_t antcal_otp_store = { antcal_otp_write, antcal_otp_read, NULL };
+
+/**
+ * antcal_var_q8() - Variance of true - measured of the measurements accepted
+ *
+ * @cal: calibration, with at least 2 measurements accepted.
+ *
+ * The residuals are below ANTCAL_RESIDUAL_MAX_DTU (2^12) and there are at most 2^16 of them: the sum
+ * of squares is below 2^40, count * sum_sq * 2^8 below 2^64 for the default limit.
+ *
+ * Return: unbiased variance in 1/256 DTU^2.
+ */
+static int64_t antcal_var_q8(const antcal_t *cal)
+{
+    int64_t n = (int64_t)cal->count;
+
+    return (((n * cal->sum_sq) - (cal->sum * cal->sum)) * 256LL) / (n * (n - 1LL));
+}
+
+void antcal_init(antcal_t *cal, const antcal_config_t *config)
+{
+    cal->config = *config;
+    cal->count = 0U;
+    cal->rejected = 0U;
+    cal->sum = 0LL;
+    cal->sum_sq = 0LL;
+}
+
+uint32_t antcal_mm_to_tof(uint32_t distance_mm)
+{
+    return (uint32_t)((((uint64_t)distance_mm * (TS40_DTU_PER_S / 1000ULL)) + ((uint64_t)TWR_SPEED_OF_LIGHT / 2ULL))
+                      / (uint64_t)TWR_SPEED_OF_LIGHT);
+}
+
+antcal_status_e antcal_add(antcal_t *cal, int32_t tof_dtu)
+{
+    antcal_status_e ret = ANTCAL_REJECTED;
+    int64_t r = (int64_t)cal->config.tof_dtu - (int64_t)tof_dtu;
+    int32_t accept = 0L;
+
+    if ((r <= ANTCAL_RESIDUAL_MAX_DTU) && (r >= -ANTCAL_RESIDUAL_MAX_DTU) && (cal->count < ANTCAL_COUNT_MAX))
+    {
+        accept = 1L;
+        if (cal->count >= ANTCAL_OUTLIER_MIN)
+        {
+            int64_t dev_q4 = (r * 16LL) - ((cal->sum * 16LL) / (int64_t)cal->count);
+            int64_t var_q8 = antcal_var_q8(cal);
+
+            if (var_q8 < ANTCAL_VAR_MIN_Q8)
+            {
+                var_q8 = ANTCAL_VAR_MIN_Q8;
+            }
+            if ((dev_q4 * dev_q4) > (ANTCAL_OUTLIER_SIGMA * ANTCAL_OUTLIER_SIGMA * var_q8))
+            {
+                accept = 0L;
+            }
+        }
+    }
+
+    if (accept != 0L)
+    {
+        cal->count++;
+        cal->sum += r;
+        cal->sum_sq += r * r;
+        ret = ANTCAL_RUNNING;
+        if ((cal->count >= cal->config.min_count) && (cal->count >= 2U))
+        {
+            int64_t max_q4 = (int64_t)cal->config.max_stderr_q4;
+
+            // Standard error of the mean: variance / count below the limit squared
+            if (antcal_var_q8(cal) <= (max_q4 * max_q4 * (int64_t)cal->count))
+            {
+                ret = ANTCAL_DONE;
+            }
+        }
+    }
+    else
+    {
+        cal->rejected++;
+    }
+    return ret;
+}
+
+int32_t antcal_solve(const antcal_t *cal, antcal_delays_t *delays)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if (cal->count >= 2U)
+    {
+        int64_t n = (int64_t)cal->count;
+        // Error of the sum of the delays, twice the mean of true - measured, rounded to the nearest
+        int64_t err = (cal->sum >= 0LL) ? (((2LL * cal->sum) + (n / 2LL)) / n) : -(((-2LL * cal->sum) + (n / 2LL)) / n);
+        int64_t total = (int64_t)cal->config.tx_antenna_delay + (int64_t)cal->config.rx_antenna_delay - err;
+        int64_t tx = ((total * (int64_t)cal->config.tx_share_q8) + 128LL) / 256LL;
+        int64_t rx = total - tx;
+
+        if ((total >= 0LL) && (tx <= (int64_t)UINT16_MAX) && (rx <= (int64_t)UINT16_MAX) && (rx >= 0LL))
+        {
+            delays->tx_antenna_delay = (uint16_t)tx;
+            delays->rx_antenna_delay = (uint16_t)rx;
+            ret = (int32_t)DWT_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+void antcal_apply(const antcal_delays_t *delays)
+{
+    dwt_settxantennadelay(delays->tx_antenna_delay);
+    dwt_setrxantennadelay(delays->rx_antenna_delay);
+}
+
+int32_t antcal_otp_write(void *ctx, const antcal_delays_t *delays)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint32_t value = ((uint32_t)delays->rx_antenna_delay << 16U) | (uint32_t)delays->tx_antenna_delay;
+    uint32_t word;
+
+    (void)ctx;
+    dwt_otpread((uint16_t)ANTCAL_OTP_ADDR, &word, 1U);
+    if (word == value)
+    {
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    else if (word == 0UL)
+    {
+        ret = dwt_otpwriteandverify(value, (uint16_t)ANTCAL_OTP_ADDR);
+    }
+    else
+    {
+        // Already programmed with other delays
+    }
+    return ret;
+}
+
+int32_t antcal_otp_read(void *ctx, antcal_delays_t *delays)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint32_t word;
+
+    (void)ctx;
+    dwt_otpread((uint16_t)ANTCAL_OTP_ADDR, &word, 1U);
+    if (word != 0UL)
+    {
+        delays->tx_antenna_delay = (uint16_t)word;
+        delays->rx_antenna_delay = (uint16_t)(word >> 16U);
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
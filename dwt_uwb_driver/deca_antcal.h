@@ -0,0 +1,176 @@
+/**
+ * @file:     deca_antcal.h
+ *
+ * @brief     Antenna delay calibration against a reference device at a known distance
+ *
+ *            The device to calibrate ranges with DS-TWR (see deca_twr.h) against a reference device
+ *            whose antenna delays are calibrated, at a known distance. With e the error of the sum of
+ *            the programmed TX and RX antenna delays of the device (programmed - true), every time of
+ *            flight is measured e / 2 short:
+ *              measured = true - e / 2
+ *            so the least squares estimate of e over the exchanges is twice the mean of true - measured.
+ *
+ *            Time of flight measurements are added one at a time and only running sums are kept, so
+ *            exchanges can go on for as long as needed without buffering them. Measurements further
+ *            than ANTCAL_OUTLIER_SIGMA standard deviations from the mean (e.g. a reflection taken for the
+ *            first path) are rejected once ANTCAL_OUTLIER_MIN of them have been accepted. Calibration is
+ *            done once the standard error of the mean is below the configured limit.
+ *
+ *            Ranging only gives the sum of the TX and RX delays, which is split between them with the
+ *            configured TX share (usually half each).
+ *
+ *            The delays found can be saved to OTP or to a store of the host (flash, file).
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_ANTCAL_H_
+#define DECA_ANTCAL_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+#ifndef ANTCAL_RESIDUAL_MAX_DTU
+#define ANTCAL_RESIDUAL_MAX_DTU   (2132L)     // Largest true - measured time of flight accepted (10 m)
+#endif
+
+#ifndef ANTCAL_OUTLIER_SIGMA
+#define ANTCAL_OUTLIER_SIGMA      (4L)        // Standard deviations from the mean a measurement is rejected beyond
+#endif
+
+#ifndef ANTCAL_OUTLIER_MIN
+#define ANTCAL_OUTLIER_MIN        (16U)       // Measurements accepted before rejecting outliers
+#endif
+
+#define ANTCAL_COUNT_MAX          (0xFFFFU)   // Measurements accepted, later ones are ignored
+#define ANTCAL_TX_SHARE_HALF      (128U)      // TX share of the delays, TX and RX delays equal
+
+#ifndef ANTCAL_OTP_ADDR
+#define ANTCAL_OTP_ADDR           (0x50U)     // OTP word of the delays, RX delay in the upper 16 bits, to be set per product
+#endif
+
+typedef enum
+{
+    ANTCAL_RUNNING = 0,     // Measurement accepted, more are needed
+    ANTCAL_DONE,            // Measurement accepted, the delays can be solved for
+    ANTCAL_REJECTED         // Measurement rejected as an outlier
+} antcal_status_e;
+
+typedef struct
+{
+    uint32_t tof_dtu;               // True time of flight to the reference, see antcal_mm_to_tof()
+    uint16_t tx_antenna_delay;      // TX antenna delay programmed during the exchanges
+    uint16_t rx_antenna_delay;      // RX antenna delay programmed during the exchanges
+    uint16_t tx_share_q8;           // TX share of the sum of the delays, in 1/256, e.g. ANTCAL_TX_SHARE_HALF
+    uint16_t min_count;             // Measurements needed, at least 2
+    uint16_t max_stderr_q4;         // Largest standard error of the mean time of flight, in 1/16 DTU
+} antcal_config_t;
+
+typedef struct
+{
+    antcal_config_t config;
+    uint16_t count;                 // Measurements accepted
+    uint16_t rejected;              // Measurements rejected
+    int64_t sum;                    // Sum of true - measured of the measurements accepted
+    int64_t sum_sq;                 // Sum of the squares of true - measured
+} antcal_t;
+
+typedef struct
+{
+    uint16_t tx_antenna_delay;
+    uint16_t rx_antenna_delay;
+} antcal_delays_t;
+
+/* Store of the delays found, e.g. in flash: each function returns DWT_SUCCESS or DWT_ERROR */
+typedef struct
+{
+    int32_t (*write)(void *ctx, const antcal_delays_t *delays);
+    int32_t (*read)(void *ctx, antcal_delays_t *delays);
+    void *ctx;
+} antcal_store_t;
+
+/* Store in the OTP word at ANTCAL_OTP_ADDR */
+extern const antcal_store_t antcal_otp_store;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start a calibration.
+ *
+ * input parameters
+ * @param cal calibration to initialise
+ * @param config configuration, copied
+ */
+void antcal_init(antcal_t *cal, const antcal_config_t *config);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Convert a distance to a time of flight.
+ *
+ * input parameters
+ * @param distance_mm distance in mm
+ *
+ * return: time of flight in DTU, rounded to the nearest.
+ */
+uint32_t antcal_mm_to_tof(uint32_t distance_mm);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Add a time of flight measured with the reference, e.g. from the result callback of the
+ *        DS-TWR engine (twr_result_t.tof_dtu).
+ *
+ * input parameters
+ * @param cal calibration
+ * @param tof_dtu measured time of flight in DTU
+ *
+ * return: ANTCAL_RUNNING or ANTCAL_DONE if the measurement is accepted, ANTCAL_REJECTED otherwise.
+ */
+antcal_status_e antcal_add(antcal_t *cal, int32_t tof_dtu);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Solve for the antenna delays, from the measurements accepted so far.
+ *
+ * input parameters
+ * @param cal calibration
+ *
+ * output parameters
+ * @param delays TX and RX antenna delays to program
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if fewer than 2 measurements are accepted or the delays are out of range.
+ */
+int32_t antcal_solve(const antcal_t *cal, antcal_delays_t *delays);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Program antenna delays. The TX antenna delay given to the ranging engines (e.g.
+ *        twr_config_t.tx_antenna_delay) must be updated as well.
+ *
+ * input parameters
+ * @param delays TX and RX antenna delays
+ */
+void antcal_apply(const antcal_delays_t *delays);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Write antenna delays to the OTP word at ANTCAL_OTP_ADDR, callback of antcal_otp_store.
+ *        OTP bits cannot be cleared: the word must be blank or hold the same delays.
+ *
+ * input parameters
+ * @param ctx unused
+ * @param delays TX and RX antenna delays
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the word holds other delays or does not verify.
+ */
+int32_t antcal_otp_write(void *ctx, const antcal_delays_t *delays);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Read antenna delays from the OTP word at ANTCAL_OTP_ADDR, callback of antcal_otp_store.
+ *
+ * input parameters
+ * @param ctx unused
+ *
+ * output parameters
+ * @param delays TX and RX antenna delays
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the word is blank.
+ */
+int32_t antcal_otp_read(void *ctx, antcal_delays_t *delays);
+
+#endif /* DECA_ANTCAL_H_ */
@@ -0,0 +1,317 @@
+/**
+ * @file:     deca_clksync.c
+ *
+ * @brief     Wireless clock synchronisation of TDoA anchors
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_clksync.h"
+
+#define CSYNC_FC_0            (0x41U)   // Data frame, PAN ID compression
+#define CSYNC_FC_1            (0x88U)   // Short destination and source addresses
+#define CSYNC_SEQ_IDX         (2U)
+#define CSYNC_PAN_IDX         (3U)
+#define CSYNC_DST_IDX         (5U)
+#define CSYNC_SRC_IDX         (7U)
+
+#define CSYNC_PRODUCT_SHIFT   (16U)     // Time differences are scaled down by 2^16 in the fit products
+
+/**
+ * csync_get16() - Read a little endian 16-bit value from a frame
+ */
+static inline uint16_t csync_get16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[1] << 8U) | (uint16_t)p[0]);
+}
+
+/**
+ * csync_find_ref() - Index of a reference anchor
+ *
+ * @cs: clock synchronisation.
+ * @addr: short address of the reference anchor.
+ *
+ * Return: index in cs->ref, or CSYNC_REF_MAX if not tracked.
+ */
+static uint8_t csync_find_ref(const csync_t *cs, uint16_t addr)
+{
+    uint8_t i;
+
+    for (i = 0U; i < cs->ref_count; i++)
+    {
+        if (cs->ref[i].addr == addr)
+        {
+            break;
+        }
+    }
+    return (i < cs->ref_count) ? i : (uint8_t)CSYNC_REF_MAX;
+}
+
+/**
+ * csync_drift_dtu() - Change of master - local over a local time difference
+ *
+ * @drift_q40: drift as a q0.40.
+ * @dt: local time difference, |dt| < 2^39.
+ *
+ * dt is taken in units of 2^8 DTU, which is below 0.1 DTU of error at 200 ppm: |drift| < 2^28 and
+ * |dt| < 2^31, the product is below 2^59.
+ *
+ * Return: drift * dt in DTU.
+ */
+static int64_t csync_drift_dtu(int64_t drift_q40, int64_t dt)
+{
+    return (drift_q40 * (dt / 256LL)) / (int64_t)(1LL << 32);
+}
+
+/**
+ * csync_offset_at() - Fitted master - local at a local time
+ *
+ * @ref: reference anchor, with a valid fit.
+ * @local: local time stamp, less than half a period from the newest sync frame.
+ *
+ * Return: master - local modulo 2^40.
+ */
+static ts40_t csync_offset_at(const csync_ref_t *ref, ts40_t local)
+{
+    return ts40_add(ref->fit_offset, (uint64_t)csync_drift_dtu(ref->drift_q40, ts40_diff(local, ref->fit_local)));
+}
+
+/**
+ * csync_fit() - Least squares fit of master - local over the sync frames in the window
+ *
+ * @ref: reference anchor, with at least one sync frame.
+ * @clock_offset: clock offset measured on the newest sync frame, for the drift when the fit cannot give it.
+ *
+ * The offsets and local times are taken relative to the oldest sync frame so that they are small:
+ * x below CSYNC_SPAN_MAX (2^38) and y below 200 ppm of it, and only the deviations to the means,
+ * scaled down by 2^16, are multiplied.
+ */
+static void csync_fit(csync_ref_t *ref, int16_t clock_offset)
+{
+    uint8_t newest = (uint8_t)((ref->first + ref->count - 1U) % CSYNC_WINDOW);
+    int64_t x[CSYNC_WINDOW];
+    int64_t y[CSYNC_WINDOW];
+    int64_t sx = 0LL;
+    int64_t sy = 0LL;
+    int64_t sxx = 0LL;
+    int64_t sxy = 0LL;
+    int64_t n = (int64_t)ref->count;
+    int64_t mx, my;
+    int64_t drift;
+
+    for (uint8_t i = 0U; i < ref->count; i++)
+    {
+        uint8_t k = (uint8_t)((ref->first + i) % CSYNC_WINDOW);
+
+        x[i] = (int64_t)ts40_sub(ref->local[k], ref->local[ref->first]);
+        y[i] = ts40_diff(ref->offset[k], ref->offset[ref->first]);
+        sx += x[i];
+        sy += y[i];
+    }
+    mx = sx / n;
+    my = sy / n;
+    for (uint8_t i = 0U; i < ref->count; i++)
+    {
+        int64_t dx = (x[i] - mx) / (int64_t)(1L << CSYNC_PRODUCT_SHIFT);
+
+        sxx += dx * dx;
+        sxy += dx * (y[i] - my);
+    }
+
+    // Clock offset is a q5.26 (positive when the local clock is slower), the drift a q0.40
+    drift = (int64_t)clock_offset * 16384LL;
+    if (sxx > 0LL)
+    {
+        // Keep sxx within 31 bits so that sxy * 2^24 cannot overflow
+        while (sxx > (int64_t)INT32_MAX)
+        {
+            sxx /= 2LL;
+            sxy /= 2LL;
+        }
+        // sxy / sxx is in DTU per 2^16 DTU
+        drift = (sxy * (int64_t)(1L << (40U - CSYNC_PRODUCT_SHIFT))) / sxx;
+        if ((drift > CSYNC_DRIFT_MAX_Q40) || (drift < -CSYNC_DRIFT_MAX_Q40))
+        {
+            drift = (int64_t)clock_offset * 16384LL;
+        }
+    }
+
+    ref->drift_q40 = drift;
+    ref->fit_local = ref->local[newest];
+    ref->fit_offset = ts40_add(ref->offset[ref->first], (uint64_t)(my + csync_drift_dtu(drift, x[ref->count - 1U] - mx)));
+    ref->valid = 1U;
+}
+
+void csync_init(csync_t *cs, uint16_t pan_id, uint16_t address, uint16_t tx_antenna_delay, txtmpl_mgr_t *tx)
+{
+    cs->pan_id = pan_id;
+    cs->address = address;
+    cs->tx_antenna_delay = tx_antenna_delay;
+    cs->seq = 0U;
+    cs->tx = tx;
+    cs->tmpl = TXTMPL_NONE;
+    cs->ref_count = 0U;
+}
+
+int32_t csync_add_ref(csync_t *cs, uint16_t addr, uint32_t tof_dtu)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if (cs->ref_count < CSYNC_REF_MAX)
+    {
+        csync_ref_t *ref = &cs->ref[cs->ref_count];
+
+        ref->addr = addr;
+        ref->tof_dtu = tof_dtu;
+        ref->first = 0U;
+        ref->count = 0U;
+        ref->rejected = 0U;
+        ref->valid = 0U;
+        cs->ref_count++;
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+int32_t csync_update(csync_t *cs, uint16_t addr, ts40_t master_tx, ts40_t local_rx, int16_t clock_offset)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint8_t r = csync_find_ref(cs, addr);
+
+    if (r < CSYNC_REF_MAX)
+    {
+        csync_ref_t *ref = &cs->ref[r];
+        ts40_t offset = ts40_sub(ts40_add(master_tx, ref->tof_dtu), local_rx);
+        int64_t err = 0LL;
+
+        if (ref->valid != 0U)
+        {
+            err = ts40_diff(offset, csync_offset_at(ref, local_rx));
+        }
+        if ((err > CSYNC_OUTLIER_DTU) || (err < -CSYNC_OUTLIER_DTU))
+        {
+            ref->rejected++;
+            if (ref->rejected >= CSYNC_REJECT_MAX)
+            {
+                // The reference has most likely been reset, start again from this sync frame
+                ref->count = 0U;
+                ref->valid = 0U;
+            }
+        }
+        if (((err <= CSYNC_OUTLIER_DTU) && (err >= -CSYNC_OUTLIER_DTU)) || (ref->valid == 0U))
+        {
+            uint8_t k;
+
+            // Drop the sync frames too old for the time differences to stay in range
+            while ((ref->count > 0U) && (ts40_sub(local_rx, ref->local[ref->first]) >= CSYNC_SPAN_MAX))
+            {
+                ref->first = (uint8_t)((ref->first + 1U) % CSYNC_WINDOW);
+                ref->count--;
+            }
+            if (ref->count == CSYNC_WINDOW)
+            {
+                ref->first = (uint8_t)((ref->first + 1U) % CSYNC_WINDOW);
+                ref->count--;
+            }
+            k = (uint8_t)((ref->first + ref->count) % CSYNC_WINDOW);
+            ref->local[k] = local_rx;
+            ref->offset[k] = offset;
+            ref->count++;
+            ref->rejected = 0U;
+            csync_fit(ref, clock_offset);
+            ret = (int32_t)DWT_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+int32_t csync_rx_ok_handler(csync_t *cs, const dwt_cb_data_t *cb_data)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint8_t f[CSYNC_LEN - FCS_LEN];
+    uint8_t ts[TS40_LEN];
+
+    if (cb_data->datalength == (uint16_t)CSYNC_LEN)
+    {
+        dwt_readrxdata(f, (uint16_t)(CSYNC_LEN - FCS_LEN), 0U);
+
+        if ((f[0] == CSYNC_FC_0) && (f[1] == CSYNC_FC_1) && (csync_get16(&f[CSYNC_PAN_IDX]) == cs->pan_id)
+            && (csync_get16(&f[CSYNC_DST_IDX]) == CSYNC_BROADCAST) && (f[CSYNC_FUNC_IDX] == CSYNC_FUNC))
+        {
+            int16_t clock_offset = dwt_readrxtimestamp_clkoffset(ts);
+
+            // Sync frames of references which are not tracked are consumed all the same
+            (void)csync_update(cs, csync_get16(&f[CSYNC_SRC_IDX]), ts40_load(&f[CSYNC_TX_IDX]), ts40_load(ts), clock_offset);
+            ret = (int32_t)DWT_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+int32_t csync_to_master(const csync_t *cs, uint16_t addr, ts40_t local, ts40_t *master)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint8_t r = csync_find_ref(cs, addr);
+
+    if ((r < CSYNC_REF_MAX) && (cs->ref[r].valid != 0U))
+    {
+        *master = ts40_add(local, csync_offset_at(&cs->ref[r], local));
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+int32_t csync_send(csync_t *cs, uint32_t delay_dtu)
+{
+    uint8_t f[CSYNC_LEN - FCS_LEN];
+    int32_t id = (int32_t)DWT_ERROR;
+    uint32_t starttime = (dwt_readsystimestamphi32() + (delay_dtu >> TS40_DELAYED_SHIFT)) & ~1UL;
+
+    f[0] = CSYNC_FC_0;
+    f[1] = CSYNC_FC_1;
+    f[CSYNC_SEQ_IDX] = cs->seq;
+    f[CSYNC_PAN_IDX] = (uint8_t)cs->pan_id;
+    f[CSYNC_PAN_IDX + 1U] = (uint8_t)(cs->pan_id >> 8U);
+    f[CSYNC_DST_IDX] = (uint8_t)CSYNC_BROADCAST;
+    f[CSYNC_DST_IDX + 1U] = (uint8_t)(CSYNC_BROADCAST >> 8U);
+    f[CSYNC_SRC_IDX] = (uint8_t)cs->address;
+    f[CSYNC_SRC_IDX + 1U] = (uint8_t)(cs->address >> 8U);
+    f[CSYNC_FUNC_IDX] = CSYNC_FUNC;
+    // The TX time stamp is known before transmission: the programmed time plus the antenna delay
+    ts40_store(ts40_add(ts40_from_delayed(starttime), cs->tx_antenna_delay), &f[CSYNC_TX_IDX]);
+    cs->seq++;
+
+    if (cs->tx != NULL)
+    {
+        // The template is added again if the manager was initialised since
+        id = (int32_t)cs->tmpl;
+        if ((cs->tmpl >= cs->tx->count) || (cs->tx->tmpl[cs->tmpl].len != (uint16_t)CSYNC_LEN)
+            || (cs->tx->tmpl[cs->tmpl].image[CSYNC_FUNC_IDX] != CSYNC_FUNC))
+        {
+            id = txtmpl_add(cs->tx, f, (uint16_t)CSYNC_LEN, 1U);
+        }
+    }
+    if (id >= 0L)
+    {
+        // Only the sequence number and TX time stamp change from one sync frame to the next
+        cs->tmpl = (uint8_t)id;
+        (void)txtmpl_patch(cs->tx, cs->tmpl, 0U, f, (uint16_t)(CSYNC_LEN - FCS_LEN));
+        (void)txtmpl_select(cs->tx, cs->tmpl);
+    }
+    else
+    {
+        (void)dwt_writetxdata((uint16_t)(CSYNC_LEN - FCS_LEN), f, CSYNC_TX_OFFSET);
+        dwt_writetxfctrl((uint16_t)CSYNC_LEN, CSYNC_TX_OFFSET, 1U);
+        if (cs->tx != NULL)
+        {
+            txtmpl_invalidate(cs->tx);
+        }
+    }
+    dwt_setdelayedtrxtime(starttime);
+    return dwt_starttx((uint8_t)DWT_START_TX_DELAYED);
+}
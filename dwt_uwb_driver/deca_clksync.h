@@ -0,0 +1,183 @@
+/**
+ * @file:     deca_clksync.h
+ *
+ * @brief     Wireless clock synchronisation of TDoA anchors
+ *
+ *            A reference anchor periodically broadcasts sync frames carrying their own TX time
+ *            stamp (known before transmission, the frame being sent with delayed TX). An anchor
+ *            receiving them knows the master time of each RX time stamp:
+ *              master(rx) = master_tx + tof
+ *            with tof the propagation time from the reference, fixed since the anchor positions are
+ *            known. Per reference the offset master - local is fitted as a linear function of the
+ *            local time by least squares over the last CSYNC_WINDOW sync frames, giving the offset
+ *            and drift used to convert any local time stamp (e.g. of a blink) to master time.
+ *
+ *            Until two sync frames have been received the drift is taken from the clock offset
+ *            measured on the sync frame (see dwt_readclockoffset()), so conversions are available
+ *            from the first one. A sync frame more than CSYNC_OUTLIER_DTU off the fit is rejected,
+ *            and after CSYNC_REJECT_MAX rejections in a row the reference is restarted, e.g. after
+ *            a reset of the reference anchor.
+ *
+ *            Sync frame, IEEE 802.15.4 data frame with short addresses, broadcast:
+ *              FC (0x41 0x88), sequence number, PAN ID, 0xFFFF, source, CSYNC_FUNC, master_tx (40 bits)
+ *
+ *            A reference anchor which also sends frames from templates (see deca_txtemplate.h, e.g. the
+ *            TWR engine) sends its sync frames as a template of the same manager, after the others, so
+ *            that the manager keeps track of the TX buffer and TX_FCTRL.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_CLKSYNC_H_
+#define DECA_CLKSYNC_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+#include "deca_txtemplate.h"
+
+#ifndef CSYNC_REF_MAX
+#define CSYNC_REF_MAX           (4U)            // Reference anchors tracked
+#endif
+
+#ifndef CSYNC_WINDOW
+#define CSYNC_WINDOW            (8U)            // Sync frames the fit is made over, up to 16
+#endif
+
+#ifndef CSYNC_OUTLIER_DTU
+#define CSYNC_OUTLIER_DTU       (640L)          // Largest error of a sync frame w.r.t. the fit (10 ns)
+#endif
+
+#define CSYNC_REJECT_MAX        (3U)            // Rejections in a row restarting a reference
+#define CSYNC_DRIFT_MAX_Q40     (219902326LL)   // Largest drift accepted, 200 ppm as a q0.40
+#define CSYNC_SPAN_MAX          (1ULL << 38U)   // Longest time spanned by the window (4.3 s), older frames are dropped
+
+#define CSYNC_FUNC              (0x2AU)         // Function code of sync frames
+#define CSYNC_BROADCAST         (0xFFFFU)
+#define CSYNC_HDR_LEN           (9U)            // Frame control, sequence number, PAN ID, destination, source
+#define CSYNC_FUNC_IDX          (CSYNC_HDR_LEN)
+#define CSYNC_TX_IDX            (CSYNC_FUNC_IDX + 1U)
+#define CSYNC_LEN               (CSYNC_TX_IDX + TS40_LEN + FCS_LEN)
+
+#ifndef CSYNC_TX_OFFSET
+#define CSYNC_TX_OFFSET         (128U)          // TX buffer offset of sync frames sent without template, after the TWR templates
+#endif
+
+#if (CSYNC_WINDOW < 2U) || (CSYNC_WINDOW > 16U)
+#error "CSYNC_WINDOW out of range"
+#endif
+
+typedef struct
+{
+    uint16_t addr;                  // Short address of the reference anchor
+    uint32_t tof_dtu;               // Propagation time from the reference anchor
+    ts40_t local[CSYNC_WINDOW];     // Local RX time stamps of the sync frames in the window
+    ts40_t offset[CSYNC_WINDOW];    // master - local of the sync frames, modulo 2^40
+    uint8_t first;                  // Oldest sync frame in the window
+    uint8_t count;                  // Sync frames in the window
+    uint8_t rejected;               // Sync frames rejected in a row
+    uint8_t valid;                  // Fit below is valid
+    ts40_t fit_local;               // Local time of the newest sync frame
+    ts40_t fit_offset;              // Fitted master - local at fit_local, modulo 2^40
+    int64_t drift_q40;              // Fitted d(master - local) / d(local), as a q0.40
+} csync_ref_t;
+
+typedef struct
+{
+    uint16_t pan_id;                // PAN ID of sync frames
+    uint16_t address;               // Own short address, source of the sync frames sent
+    uint16_t tx_antenna_delay;      // TX antenna delay, for the TX time stamp of the sync frames sent
+    uint8_t seq;                    // Sequence number of the next sync frame sent
+    txtmpl_mgr_t *tx;               // Template manager the sync frames are sent from, or NULL
+    uint8_t tmpl;                   // Template of the sync frame in tx, TXTMPL_NONE until added
+    uint8_t ref_count;
+    csync_ref_t ref[CSYNC_REF_MAX];
+} csync_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Initialise clock synchronisation, without reference anchor.
+ *
+ * input parameters
+ * @param cs clock synchronisation to initialise
+ * @param pan_id PAN ID of sync frames
+ * @param address own short address
+ * @param tx_antenna_delay TX antenna delay, only used to send sync frames
+ * @param tx template manager of the other frames sent (e.g. &engine->tx of the TWR engine), the sync
+ *           frame is added to it on the first csync_send(). NULL if the TX buffer has no other templates.
+ */
+void csync_init(csync_t *cs, uint16_t pan_id, uint16_t address, uint16_t tx_antenna_delay, txtmpl_mgr_t *tx);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Track a reference anchor.
+ *
+ * input parameters
+ * @param cs clock synchronisation
+ * @param addr short address of the reference anchor
+ * @param tof_dtu propagation time from the reference anchor, in DTU
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if CSYNC_REF_MAX references are already tracked.
+ */
+int32_t csync_add_ref(csync_t *cs, uint16_t addr, uint32_t tof_dtu);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Add a sync frame to the fit of a reference anchor.
+ *
+ * input parameters
+ * @param cs clock synchronisation
+ * @param addr short address of the reference anchor
+ * @param master_tx TX time stamp of the sync frame, in master time
+ * @param local_rx RX time stamp of the sync frame, in local time
+ * @param clock_offset clock offset measured on the sync frame, as returned by dwt_readclockoffset()
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the reference is not tracked or the sync frame is rejected.
+ */
+int32_t csync_update(csync_t *cs, uint16_t addr, ts40_t master_tx, ts40_t local_rx, int16_t clock_offset);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Handle a received frame, to be called from the RX good frame callback. Sync frames from a
+ *        tracked reference are added to its fit, with their RX time stamp and clock offset read in
+ *        one SPI transaction (see dwt_readrxtimestamp_clkoffset()).
+ *
+ * input parameters
+ * @param cs clock synchronisation
+ * @param cb_data callback data of the received frame
+ *
+ * return: DWT_SUCCESS if the frame was a sync frame, DWT_ERROR otherwise, to be given to other handlers.
+ */
+int32_t csync_rx_ok_handler(csync_t *cs, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Convert a local time stamp to the master time of a reference anchor. The time stamp must
+ *        be less than half a period of the counter (8.6 s) from the last sync frame.
+ *
+ * input parameters
+ * @param cs clock synchronisation
+ * @param addr short address of the reference anchor
+ * @param local local time stamp
+ *
+ * output parameters
+ * @param master time stamp in master time
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if no sync frame of the reference has been received.
+ */
+int32_t csync_to_master(const csync_t *cs, uint16_t addr, ts40_t local, ts40_t *master);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Reference anchor: send a sync frame with delayed TX, at @delay_dtu from now.
+ *
+ * The frame is a template of the manager given to csync_init(), added again if the manager was
+ * initialised since. Without manager, or if it is full, it is written at TX buffer offset
+ * CSYNC_TX_OFFSET, and the templates of the manager are written again on their next selection.
+ *
+ * input parameters
+ * @param cs clock synchronisation
+ * @param delay_dtu delay of the transmission, long enough for the frame to be written
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the delayed TX was late.
+ */
+int32_t csync_send(csync_t *cs, uint32_t delay_dtu);
+
+#endif /* DECA_CLKSYNC_H_ */
@@ -74,6 +74,7 @@ extern "C"
         DWT_ERR_RX_CAL_RESI = -4,
         DWT_ERR_RX_CAL_RESQ = -5,
         DWT_ERR_RX_ADC_CAL = -6,
+        DWT_ERR_BUSY = -7,
     } dwt_error_e;
 
 #define DWT_TIME_UNITS (1.0 / 499.2e6 / 128.0) //!< = 15.65e-12 s
@@ -603,6 +604,7 @@ extern "C"
 
     typedef enum
     {
+        DWT_SLP_CNT_RPT = 0x40, // sleep counter loop after expiration, to wake up periodically
         DWT_PRES_SLEEP = 0x20, // allows for SLEEP_EN bit to be "preserved", although it will self - clear on wake up
         DWT_WAKE_WUP = 0x10,   // wake up on WAKEUP PIN
         DWT_WAKE_CSN = 0x8,    // wake up on chip select
@@ -618,6 +620,16 @@ extern "C"
         DWT_RX_COMPLETE = 0x02
     } dwt_sleep_after_param_e;
 
+    // Duty-cycled listening, see dwt_listen_start()
+    typedef struct
+    {
+        uint32_t period_ms;  // Wake-up period, rounded to the sleep counter unit (4096 LP OSC cycles, about 200 ms)
+        uint16_t window_pac; // Listen window after each wake-up: preamble detection timeout in PACs, see dwt_setpreambledetecttimeout()
+        uint8_t sniff_on;    // SNIFF mode ON time in PACs, 0 to listen continuously in the window, see dwt_setsniffmode()
+        uint8_t sniff_off;   // SNIFF mode OFF time, in units of approximately 1 us
+        uint8_t recal_temp;  // Temperature change from the last sleep counter calibration, in degrees C, which calls for a new one
+    } dwt_listen_config_t;
+
     // DW3000 IDLE/INIT mode definitions
     typedef enum
     {
@@ -634,6 +646,34 @@ extern "C"
         DWT_READ_OTP_TMP = 0x80, // read ref temperature from OTP
     } dwt_read_otp_modes_e;
 
+#define DWT_OTP_SNAPSHOT_VERSION (1U) // Layout version of dwt_otp_snapshot_t
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * Structure typedef: dwt_otp_snapshot_t
+     *
+     * Raw OTP calibration words read by dwt_initialise(), kept by the host to skip the OTP reads of the next
+     * dwt_initialise() (see dwt_otpsnapshot_export() and dwt_otpsnapshot_import())
+     *
+     */
+    typedef struct
+    {
+        uint16_t version;             //!< DWT_OTP_SNAPSHOT_VERSION
+        uint16_t mode;                //!< dwt_read_otp_modes_e values read into the snapshot
+        uint32_t part_id;             //!< PARTID_ADDRESS
+        uint32_t lot_id_lo;           //!< WSLOTID_LOW_ADDRESS, with DWT_READ_OTP_LID
+        uint32_t lot_id_hi;           //!< WSLOTID_HIGH_ADDRESS, with DWT_READ_OTP_LID
+        uint32_t ldo_tune_lo;         //!< LDOTUNELO_ADDRESS
+        uint32_t ldo_tune_hi;         //!< LDOTUNEHI_ADDRESS
+        uint32_t bias_tune;           //!< BIAS_TUNE_ADDRESS
+        uint32_t dgc_tune;            //!< DGC_TUNE_ADDRESS
+        uint32_t vbat;                //!< VBAT_ADDRESS, with DWT_READ_OTP_BAT
+        uint32_t vtemp;               //!< VTEMP_ADDRESS, with DWT_READ_OTP_TMP
+        uint32_t otprev;              //!< OTPREV_ADDRESS
+        uint32_t xtrim;               //!< XTRIM_ADDRESS
+        uint32_t pll_cc;              //!< PLL_CC_ADDRESS
+        uint32_t crc;                 //!< CRC-32 of the fields above (see deca_otpsnap.h)
+    } dwt_otp_snapshot_t;
+
     // DW3xxx enabling manual control of antenna selection
     typedef enum
     {
@@ -811,6 +851,20 @@ extern "C"
     } dwt_config_t;
 #endif // WIN32
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * Structure typedef: dwt_airtime_t
+     *
+     * Frame timing of a configuration, cached by dwt_configure() (see dwt_getairtime() and deca_airtime.h)
+     *
+     */
+    typedef struct
+    {
+        uint32_t shr_ns;              //!< Preamble and SFD, from the start of the frame to the RMARKER
+        uint32_t sts_ns;              //!< STS, 0 without STS
+        uint32_t phr_ns;              //!< PHR, 0 in no data mode
+        uint32_t bit_ps;              //!< Data bit, 0 in no data mode
+    } dwt_airtime_t;
+
     typedef struct
     {
         uint8_t PGdly;
@@ -887,6 +941,37 @@ extern "C"
 } dwt_rxdiag_t;
 #endif // WIN32
 
+    // Field selection for dwt_readdiagnostics_sel(), each bit maps to one contiguous span of diagnostic registers
+    typedef enum
+    {
+        DWT_DIAG_SEL_IP_TOA = 0x000001UL,        // ipatovRxTime, ipatovPOA and ipatovRxStatus
+        DWT_DIAG_SEL_STS_TOA = 0x000002UL,       // stsRxTime, stsPOA and stsRxStatus
+        DWT_DIAG_SEL_STS2_TOA = 0x000004UL,      // sts2RxTime, sts2POA and sts2RxStatus
+        DWT_DIAG_SEL_TDOA = 0x000008UL,          // tdoa
+        DWT_DIAG_SEL_PDOA = 0x000010UL,          // pdoa
+        DWT_DIAG_SEL_XTAL_OFFSET = 0x000020UL,   // xtalOffset
+        DWT_DIAG_SEL_CIA_DIAG1 = 0x000040UL,     // ciaDiag1
+        DWT_DIAG_SEL_IP_PEAK = 0x000080UL,       // ipatovPeak
+        DWT_DIAG_SEL_IP_POWER = 0x000100UL,      // ipatovPower
+        DWT_DIAG_SEL_IP_F = 0x000200UL,          // ipatovF1, ipatovF2 and ipatovF3
+        DWT_DIAG_SEL_IP_FP_INDEX = 0x000400UL,   // ipatovFpIndex
+        DWT_DIAG_SEL_IP_ACCUM = 0x000800UL,      // ipatovAccumCount
+        DWT_DIAG_SEL_STS_PEAK = 0x001000UL,      // stsPeak
+        DWT_DIAG_SEL_STS_POWER = 0x002000UL,     // stsPower
+        DWT_DIAG_SEL_STS_F = 0x004000UL,         // stsF1, stsF2 and stsF3
+        DWT_DIAG_SEL_STS_FP_INDEX = 0x008000UL,  // stsFpIndex
+        DWT_DIAG_SEL_STS_ACCUM = 0x010000UL,     // stsAccumCount
+        DWT_DIAG_SEL_STS2_PEAK = 0x020000UL,     // sts2Peak
+        DWT_DIAG_SEL_STS2_POWER = 0x040000UL,    // sts2Power
+        DWT_DIAG_SEL_STS2_F = 0x080000UL,        // sts2F1, sts2F2 and sts2F3
+        DWT_DIAG_SEL_STS2_FP_INDEX = 0x100000UL, // sts2FpIndex
+        DWT_DIAG_SEL_STS2_ACCUM = 0x200000UL,    // sts2AccumCount
+        DWT_DIAG_SEL_ALL = 0x3FFFFFUL,
+    } dwt_diag_sel_e;
+
+// Gap (in bytes) between two selected diagnostic spans below which they are fetched in a single SPI transaction
+#define DWT_DIAG_SEL_MERGE_GAP 4U
+
     typedef struct
     {
         uint32_t power;      //!< Channel area allows estimation of channel power for the CIR sequence, [30:0].
@@ -1175,6 +1260,45 @@ extern "C"
         uint32_t index_pp_u32;  // the Peak Path Index
     } dwt_nlos_ipdiag_t;
 
+    // Accumulators to read with dwt_nlos_readsnapshot(), one bit per dwt_diag_type_e
+    #define DWT_NLOS_SEL_IPATOV  (1U << (uint8_t)IPATOV)
+    #define DWT_NLOS_SEL_STS1    (1U << (uint8_t)STS1)
+    #define DWT_NLOS_SEL_STS2    (1U << (uint8_t)STS2)
+    #define DWT_NLOS_SEL_ALL     (DWT_NLOS_SEL_IPATOV | DWT_NLOS_SEL_STS1 | DWT_NLOS_SEL_STS2)
+
+    typedef enum
+    {
+        DWT_NLOS_RESULT_LOS = 0,      // Line of sight
+        DWT_NLOS_RESULT_POSSIBLE = 1, // Possible non line of sight
+        DWT_NLOS_RESULT_NLOS = 2,     // Non line of sight
+    } dwt_nlos_result_e;
+
+    // NLOS diagnostics of one accumulator
+    typedef struct
+    {
+        uint32_t accumCount;          // the number of preamble symbols accumulated, or accumulated STS length.
+        uint32_t F1;                  // the First Path Amplitude (point 1) magnitude value.
+        uint32_t F2;                  // the First Path Amplitude (point 2) magnitude value.
+        uint32_t F3;                  // the First Path Amplitude (point 3) magnitude value.
+        uint32_t cir_power;           // the Channel Impulse Response Power value.
+        uint32_t index_fp;            // the First Path Index (6 fractional bits).
+        uint32_t index_pp;            // the Peak Path Index, shifted left by 6 so it compares with index_fp.
+    } dwt_nlos_accdiag_t;
+
+    // NLOS diagnostics of all requested accumulators of one frame, and the LOS/NLOS estimation made from them
+    typedef struct
+    {
+        uint8_t acc_mask;                 // accumulators read (DWT_NLOS_SEL_xxx), acc[] entries of the others are not set.
+        uint8_t D;                        // the DGC_DECISION, treated as an unsigned integer in range 0 to 7.
+        dwt_nlos_accdiag_t acc[3];        // diagnostics, indexed by dwt_diag_type_e.
+        dwt_diag_type_e diag_type;        // accumulator used for the estimation: Ipatov if read, else the first STS read.
+        int16_t rsl_q8;                   // signal power (q8.8 dBm) of diag_type accumulator.
+        int16_t fsl_q8;                   // first path power (q8.8 dBm) of diag_type accumulator.
+        dwt_nlos_result_e result;         // LOS/NLOS decision.
+        uint8_t prob_nlos;                // probability of NLOS, in percent.
+        uint8_t confidence;               // confidence in the LOS/NLOS decision, in percent.
+    } dwt_nlos_snapshot_t;
+
     typedef enum
     {
         DWT_CH5 = 5,      //!< Ch 5 configuration with PLL using 38.4 MHz crystal
@@ -1588,6 +1712,34 @@ extern "C"
      */
     int32_t dwt_initialise(int32_t mode);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This function gives dwt_initialise() the OTP calibration snapshot exported after a previous initialisation.
+     *        dwt_initialise() then reads the part ID from OTP and, if it is that of the snapshot and the snapshot holds all
+     *        the values requested by its mode, applies the snapshot instead of reading the other OTP values.
+     *        Otherwise the OTP is read as usual. The snapshot is kept for the following calls to dwt_initialise().
+     *
+     * input parameters
+     * @param snap - snapshot given by dwt_otpsnapshot_export(), or NULL to always read the OTP
+     *
+     * output parameters
+     *
+     * returns DWT_SUCCESS for success, or DWT_ERROR if the version or the CRC of the snapshot is wrong
+     */
+    int32_t dwt_otpsnapshot_import(const dwt_otp_snapshot_t *snap);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This function gives the OTP calibration snapshot of the last dwt_initialise(), to be kept in flash or RAM
+     *        and given to dwt_otpsnapshot_import() before the next dwt_initialise().
+     *
+     * input parameters
+     *
+     * output parameters
+     * @param snap - snapshot, sealed with its version and CRC
+     *
+     * returns DWT_SUCCESS for success, or DWT_ERROR if the part ID was not read (DWT_READ_OTP_PID not given to dwt_initialise())
+     */
+    int32_t dwt_otpsnapshot_export(dwt_otp_snapshot_t *snap);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief This function can place DW3000 into IDLE/IDLE_PLL or IDLE_RC mode when it is not actively in TX or RX.
      *
@@ -1649,9 +1801,41 @@ extern "C"
      * output parameters
      *
      * return DWT_SUCCESS or DWT_ERROR (e.g. when PLL CAL fails / PLL fails to lock)
+     *
+     * Note: the automotive driver (AUTO_PLL_CAL) reads the temperature on each call, which blocks for two SAR
+     * conversions before the PLL calibration.
      */
     int32_t dwt_configure(dwt_config_t *config);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This function applies a configuration as dwt_configure() does, but only writes the registers depending on
+     * the fields which differ from the configuration last applied by dwt_configure() or dwt_reconfigure(), e.g. to hop
+     * preamble codes or lengths every slot. The PLL is only calibrated again when the channel changes, and the DGC LUTs
+     * are only loaded and the RX calibrated again when the PRF of the RX preamble code changes. It is a full
+     * dwt_configure() when there is no previous configuration, when the channel changes or with SCP preamble codes.
+     *
+     * NOTE: Settings changed by other calls since the last configuration (e.g. dwt_setstslength(),
+     * dwt_configurestsmode()) are not seen, call dwt_configure() after them.
+     *
+     * input parameters
+     * @param config    -   pointer to the configuration structure, which contains the device configuration data.
+     *
+     * output parameters
+     *
+     * return DWT_SUCCESS or DWT_ERROR (e.g. when PLL CAL fails / PLL fails to lock)
+     */
+    int32_t dwt_reconfigure(dwt_config_t *config);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This function returns the frame timing of the configuration last set with dwt_configure(), so that frame
+     *        air times and reply delays can be computed without hard-coded constants (see deca_airtime.h).
+     *
+     * input parameters
+     *
+     * return pointer to the frame timing, all zero until dwt_configure() is called
+     */
+    const dwt_airtime_t *dwt_getairtime(void);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief This function provides the API for the configuration of the TX power
      * The input is the desired tx power to configure.
@@ -2034,6 +2218,20 @@ extern "C"
      */
     void dwt_readrxtimestamp_sts(uint8_t *timestamp);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This is used to read the RX timestamp (adjusted time of arrival) together with the crystal offset
+     *        (see dwt_readclockoffset()). In double buffer mode both are read in one SPI transaction.
+     *
+     * input parameters
+     * @param timestamp - a pointer to a 5-byte buffer which will store the read RX timestamp time
+     *
+     * output parameters - the timestamp buffer will contain the value after the function call
+     *
+     * return value - the (int12) signed offset value. (s[-15:-26])
+     *                A positive value means the local (RX) clock is running slower than that of the remote (TX) device.
+     */
+    int16_t dwt_readrxtimestamp_clkoffset(uint8_t *timestamp);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief This is used to read the high 32-bits of the RX timestamp (adjusted with the programmed antenna delay)
      *
@@ -2321,6 +2519,43 @@ extern "C"
      */
     void dwt_entersleepafter(int32_t event_mask);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Starts duty-cycled listening. The device wakes up on its own sleep counter every period, listens in SNIFF
+     * mode for the window (preamble detection timeout) and goes back to sleep, without the host. A frame received keeps
+     * the device awake and raises the RXFCG interrupt, to be handled by dwt_isr(); call dwt_listen_start() again to
+     * go on listening, or dwt_listen_stop(). Only the RXFCG interrupt is enabled until dwt_listen_stop().
+     *
+     * The LP OSC calibration of the sleep counter (see dwt_calibratesleepcnt()) is kept, and only run again when the
+     * temperature moved by recal_temp since. dwt_configure() and the other RX settings (e.g. frame wait timeout) must
+     * be done before. The device enters sleep before this returns.
+     *
+     * The device enables its receiver on wake without dwt_restoreconfig(): it loads the LDO and bias tunes and the DGC
+     * from OTP itself, but the DGC LUTs programmed by the host when the OTP has none, TX_CTRL_LO and the double buffer
+     * diagnostics (and on DW3000 the channel 5 PLL LDO tune increase) are not restored. Once a frame is received, call
+     * dwt_listen_stop() then dwt_restoreconfig() before any other TX or RX.
+     *
+     * input parameters
+     * @param config - wake-up period, listen window, SNIFF ON/OFF times and recalibration temperature
+     *
+     * output parameters
+     *
+     * returns DWT_SUCCESS for success, or DWT_ERROR if the sleep counter could not be calibrated
+     */
+    int32_t dwt_listen_start(const dwt_listen_config_t *config);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Stops duty-cycled listening: clears auto RX to sleep, SNIFF mode and the on-wake configuration, and enables
+     * the interrupts enabled before dwt_listen_start() again. The device must be awake: after a frame was received, or
+     * woken up by the host and dwt_restoreconfig() called.
+     *
+     * input parameters
+     *
+     * output parameters
+     *
+     * no return value
+     */
+    void dwt_listen_stop(void);
+
 #ifdef WIN32
     /*! ------------------------------------------------------------------------------------------------------------------
      * @fn dwt_spicswakeup()   ---------  ********** NOTE: in decatest only ****************
@@ -2796,6 +3031,23 @@ extern "C"
      */
     void dwt_readdiagnostics(dwt_rxdiag_t *diagnostics);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief this function reads a subset of the RX signal quality diagnostic data. Only the register spans backing the
+     *        requested fields are read (adjacent spans are merged into one SPI transaction), so a caller needing e.g.
+     *        only the Ipatov F1/F2/F3 and accumulation count transfers 14 bytes instead of the full diagnostic set.
+     *        Fields which are not selected, or which are not logged by the CIA for the current diagnostic logging
+     *        level (see dwt_configciadiag), are left untouched.
+     *
+     * input parameters
+     * @param field_mask - bitmask of dwt_diag_sel_e values selecting the fields to read
+     *
+     * output parameters
+     * @param diagnostics - diagnostic structure pointer, the selected fields will be updated with the data read from the DW3000
+     *
+     * returns the bitmask of dwt_diag_sel_e values which have been updated
+     */
+    uint32_t dwt_readdiagnostics_sel(dwt_rxdiag_t *diagnostics, uint32_t field_mask);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief This is used to enable/disable the event counter in the IC
      *
@@ -3015,6 +3267,63 @@ extern "C"
      */
     uint16_t dwt_readtempvbat(void);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Starts the conversion of the temperature and battery voltage values read by dwt_readtempvbat(), without
+     * waiting for it: dwt_readtempvbat_complete() is then polled to collect the readings. The SAR ADC converts the
+     * temperature, then the voltage, so the host is free between the polls, and the device can be receiving.
+     * No other SAR reading can be done until the readings are collected: dwt_readtempvbat() finishes the conversion
+     * and returns its readings instead. dwt_readtempvbat_abort() gives the conversion up, as entering sleep does.
+     *
+     * input parameters:
+     *
+     * output parameters
+     *
+     * returns DWT_SUCCESS, or DWT_ERR_BUSY if a conversion started before is not collected yet
+     */
+    int32_t dwt_readtempvbat_start(void);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Collects the readings of the conversion started by dwt_readtempvbat_start(). Each call checks the
+     * SAR once and never waits: the voltage conversion is started by the call which finds the temperature converted,
+     * so at least two calls are needed.
+     *
+     * input parameters:
+     *
+     * output parameters
+     * @param tempvbat - (temp_raw<<8)|(vbat_raw), as returned by dwt_readtempvbat(), set on DWT_SUCCESS
+     *
+     * returns DWT_SUCCESS once both readings are collected, DWT_ERR_BUSY while converting, or DWT_ERROR if no
+     * conversion was started
+     */
+    int32_t dwt_readtempvbat_complete(uint16_t *tempvbat);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Gives up the conversion started by dwt_readtempvbat_start(): the SAR ADC is stopped and its inputs
+     * powered down, and readings not collected yet are dropped. A new conversion can then be started.
+     *
+     * input parameters:
+     *
+     * output parameters
+     *
+     * returns DWT_SUCCESS, or DWT_ERROR if no conversion was started
+     */
+    int32_t dwt_readtempvbat_abort(void);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief Converts both raw values of a temperature and battery voltage reading with integer arithmetic only,
+     * as dwt_convertrawtemperature_cdeg() and dwt_convertrawvoltage_mv() do.
+     *
+     * input parameters:
+     * @param tempvbat - (temp_raw<<8)|(vbat_raw), as read by dwt_readtempvbat() or dwt_readtempvbat_complete()
+     *
+     * output parameters
+     * @param temp_cdeg - temperature, in hundredths of degrees C
+     * @param vbat_mv - battery voltage, in mV
+     *
+     * no return value
+     */
+    void dwt_converttempvbat(uint16_t tempvbat, int16_t *temp_cdeg, uint16_t *vbat_mv);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief  this function takes in a raw temperature value and applies the conversion factor
      * to give true temperature. The dwt_initialise needs to be called before call to this to
@@ -3025,7 +3334,7 @@ extern "C"
      *
      * output parameters:
      *
-     * returns: temperature sensor value
+     * returns: temperature sensor value, see dwt_convertrawtemperature_cdeg()
      */
     float dwt_convertrawtemperature(uint8_t raw_temp);
 
@@ -3039,10 +3348,38 @@ extern "C"
      *
      * output parameters:
      *
-     * returns: voltage sensor value
+     * returns: voltage sensor value, see dwt_convertrawvoltage_mv()
      */
     float dwt_convertrawvoltage(uint8_t raw_voltage);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief  this function takes in a raw temperature value and applies the conversion factor
+     * to give true temperature, with integer arithmetic only. The dwt_initialise needs to be called before call to
+     * this to ensure pdw3000local->tempP contains the SAR_LTEMP value from OTP.
+     *
+     * input parameters:
+     * @param raw_temp - this is the 8-bit raw temperature value as read by dwt_readtempvbat
+     *
+     * output parameters:
+     *
+     * returns: temperature sensor value, in hundredths of degrees C
+     */
+    int16_t dwt_convertrawtemperature_cdeg(uint8_t raw_temp);
+
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief this function takes in a raw voltage value and applies the conversion factor
+     * to give true voltage, with integer arithmetic only. The dwt_initialise needs to be called before call to
+     * this to ensure pdw3000local->vBatP contains the SAR_LVBAT value from OTP
+     *
+     * input parameters:
+     * @param raw_voltage - this is the 8-bit raw voltage value as read by dwt_readtempvbat
+     *
+     * output parameters:
+     *
+     * returns: voltage sensor value, rounded to the nearest mV, 0 if below
+     */
+    uint16_t dwt_convertrawvoltage_mv(uint8_t raw_voltage);
+
     /*! ------------------------------------------------------------------------------------------------------------------
      * @brief this function reads the temperature of the DW3000 that was sampled
      * on waking from Sleep/Deepsleep. They are not current values, but read on last
@@ -3564,6 +3901,29 @@ extern "C"
      */
     void dwt_nlos_ipdiag(dwt_nlos_ipdiag_t *index);
 
+    /*! ------------------------------------------------------------------------------------------------------------------
+     * @brief This function reads the NLOS diagnostics of all requested accumulators at once and estimates the LOS/NLOS
+     *        condition of the received frame from them. It gives the data of dwt_nlos_alldiag() and dwt_nlos_ipdiag()
+     *        for each accumulator, but reads each contiguous diagnostic register span in a single SPI transaction
+     *        (one for Ipatov only, two when STS accumulators are requested, plus the DGC decision) instead of one
+     *        transaction per register.
+     *
+     *        The estimation is made on the Ipatov accumulator if it is requested, else on the first STS one: the signal
+     *        power to first path power difference decides on NLOS (above 12 dB) or possible NLOS (above 4.8 dB). Below
+     *        that the peak to first path index spread is used, as described in APS006 part 3.
+     *
+     * NOTE:  CIA Diagnostics need to be enabled to "DW_CIA_DIAG_LOG_ALL" else the diagnostic registers read will be 0.
+     *
+     * input parameters:
+     * @param acc_mask  - accumulators to read, a combination of DWT_NLOS_SEL_IPATOV, DWT_NLOS_SEL_STS1, DWT_NLOS_SEL_STS2.
+     *
+     * output parameters:
+     * @param snap      - pointer to the structure into which to read the diagnostics and the estimation result.
+     *
+     * @return DWT_SUCCESS for success, or DWT_ERROR if acc_mask is empty or invalid.
+     */
+    int32_t dwt_nlos_readsnapshot(dwt_nlos_snapshot_t *snap, uint8_t acc_mask);
+
     /*! ------------------------------------------------------------------------------------------------------------------
     * @brief This is used to read the value stored in CTR_DBG_ID register, these are the low 32-bits of the STS IV counter.
     *
@@ -0,0 +1,244 @@
+/**
+ * @file:     deca_nlos.c
+ *
+ * @brief     This file contains the LOS/NLOS estimation computations
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "deca_device_api.h"
+#include "deca_nlos.h"
+#include "deca_rsl.h"
+#include "qmath.h"
+
+#define NLOS_SL_DIFF_THRESHOLD_Q8     3072L     // 12 dB, signal to first path power difference of NLOS.
+#define NLOS_SL_DIFF_POSSIBLE_Q8      1229L     // 4.8 dB (12 dB * 0.4), difference of possible NLOS.
+#define NLOS_IP_MIN_THRESHOLD_Q6      211L      // 3.3 samples, index spread up to which signal is LOS.
+#define NLOS_IP_MAX_THRESHOLD_Q6      384L      // 6.0 samples, index spread from which signal is NLOS.
+#define NLOS_PR_IP_A_Q3               39178L    // 0.39178 * 100 in 1/1000 of percent.
+#define NLOS_PR_IP_B_Q3               131719L   // 1.31719 * 100 in 1/1000 of percent.
+#define NLOS_PR_MAX                   100U
+
+#define Q8_OFFSET 256L
+
+/**
+ * nlos_select_acc() - Accumulator on which to run the estimation
+ *
+ * @acc_mask: accumulators available, see DWT_NLOS_SEL_IPATOV.
+ * @diag_type: selected accumulator.
+ *
+ * Return: true if an accumulator is available.
+ */
+static bool nlos_select_acc(uint8_t acc_mask, dwt_diag_type_e *diag_type)
+{
+    bool found = true;
+
+    if ((acc_mask & DWT_NLOS_SEL_IPATOV) != 0U)
+    {
+        *diag_type = IPATOV;
+    }
+    else if ((acc_mask & DWT_NLOS_SEL_STS1) != 0U)
+    {
+        *diag_type = STS1;
+    }
+    else if ((acc_mask & DWT_NLOS_SEL_STS2) != 0U)
+    {
+        *diag_type = STS2;
+    }
+    else
+    {
+        found = false;
+    }
+    return found;
+}
+
+/**
+ * nlos_index_probability() - NLOS probability from the peak to first path index spread
+ *
+ * @diag: diagnostics of the accumulator.
+ *
+ * Return: probability of NLOS in percent.
+ */
+static uint8_t nlos_index_probability(const dwt_nlos_accdiag_t *diag)
+{
+    int32_t spread_q6 = (int32_t)diag->index_pp - (int32_t)diag->index_fp;
+    uint8_t prob;
+
+    if (spread_q6 <= NLOS_IP_MIN_THRESHOLD_Q6)
+    {
+        prob = 0U;
+    }
+    else if (spread_q6 >= NLOS_IP_MAX_THRESHOLD_Q6)
+    {
+        prob = NLOS_PR_MAX;
+    }
+    else
+    {
+        // 100 * (A * spread - B), spread having 6 fractional bits
+        int32_t prob_q3 = ((NLOS_PR_IP_A_Q3 * spread_q6) >> 6) - NLOS_PR_IP_B_Q3;
+
+        if (prob_q3 < 0L)
+        {
+            prob = 0U;
+        }
+        else if (prob_q3 >= ((int32_t)NLOS_PR_MAX * 1000L))
+        {
+            prob = NLOS_PR_MAX;
+        }
+        else
+        {
+            prob = (uint8_t)((prob_q3 + 500L) / 1000L);
+        }
+    }
+    return prob;
+}
+
+/**
+ * nlos_power_probability() - NLOS probability from the first path to total power ratio
+ *
+ * @fp_ratio_q8: first path to total power ratio in dB, as a q8.8.
+ *
+ * Return: probability of NLOS in percent.
+ */
+static uint8_t nlos_power_probability(int16_t fp_ratio_q8)
+{
+    int32_t sl_diff_q8 = -(int32_t)fp_ratio_q8;
+    uint8_t prob;
+
+    if (sl_diff_q8 > NLOS_SL_DIFF_THRESHOLD_Q8)
+    {
+        prob = NLOS_PR_MAX;
+    }
+    else if (sl_diff_q8 > NLOS_SL_DIFF_POSSIBLE_Q8)
+    {
+        prob = (uint8_t)(((sl_diff_q8 - NLOS_SL_DIFF_POSSIBLE_Q8) * (int32_t)NLOS_PR_MAX)
+                         / (NLOS_SL_DIFF_THRESHOLD_Q8 - NLOS_SL_DIFF_POSSIBLE_Q8));
+    }
+    else
+    {
+        prob = 0U;
+    }
+    return prob;
+}
+
+int32_t nlos_compute_metrics(const dwt_nlos_accdiag_t *diag, uint8_t quantization_factor, nlos_metrics_t *metrics)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((diag != NULL) && (metrics != NULL) && (diag->cir_power != 0UL))
+    {
+        uint32_t f1 = diag->F1 / 4UL;
+        uint32_t f2 = diag->F2 / 4UL;
+        uint32_t f3 = diag->F3 / 4UL;
+        uint64_t fp_energy = ((uint64_t)f1 * f1) + ((uint64_t)f2 * f2) + ((uint64_t)f3 * f3);
+        uint32_t shift = 0UL;
+
+        if (fp_energy != 0ULL)
+        {
+            /* F1..F3 are up to 20 bits, scale their energy down to 32 bits and add the shift back in the log. */
+            while ((fp_energy >> 32UL) != 0ULL)
+            {
+                fp_energy >>= 1UL;
+                shift++;
+            }
+
+            /* 10 * log10(fp_energy / (C * 2^q)), A, D and n of both powers cancel out. */
+            int32_t ratio_log2 = (int32_t)log2_lut((uint32_t)fp_energy) + (int32_t)(shift << LUT_LOG_SHIFT)
+                                 - (int32_t)log2_lut(diag->cir_power) - (int32_t)((uint32_t)quantization_factor << LUT_LOG_SHIFT);
+            int32_t ratio_q8 = (ratio_log2 * Q8_OFFSET) / (int32_t)LOG2_10_SHIFTED;
+
+            if (ratio_q8 < SHRT_MIN)
+            {
+                ratio_q8 = SHRT_MIN;
+            }
+            else if (ratio_q8 > SHRT_MAX)
+            {
+                ratio_q8 = SHRT_MAX;
+            }
+            metrics->fp_ratio_q8 = (int16_t)ratio_q8;
+            metrics->index_spread_q6 = (int32_t)diag->index_pp - (int32_t)diag->index_fp;
+            ret = (int32_t)DWT_SUCCESS;
+        }
+    }
+    return ret;
+}
+
+int32_t nlos_classify(const dwt_nlos_accdiag_t *diag, uint8_t quantization_factor, nlos_class_t *cls)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((cls != NULL) && (nlos_compute_metrics(diag, quantization_factor, &cls->metrics) == (int32_t)DWT_SUCCESS))
+    {
+        uint8_t prob_power = nlos_power_probability(cls->metrics.fp_ratio_q8);
+        uint8_t prob_index = nlos_index_probability(diag);
+        int32_t certainty;
+        int32_t agreement;
+
+        /* The power ratio decides when it shows some NLOS, the index spread otherwise (weak first path). */
+        cls->prob_nlos = (prob_power != 0U) ? prob_power : prob_index;
+        if (cls->prob_nlos == 0U)
+        {
+            cls->result = DWT_NLOS_RESULT_LOS;
+        }
+        else if (cls->prob_nlos < NLOS_PR_MAX)
+        {
+            cls->result = DWT_NLOS_RESULT_POSSIBLE;
+        }
+        else
+        {
+            cls->result = DWT_NLOS_RESULT_NLOS;
+        }
+
+        /* Confidence is the distance of the probability to 50 %, reduced by half the disagreement of both metrics. */
+        certainty = (2L * (int32_t)cls->prob_nlos) - (int32_t)NLOS_PR_MAX;
+        if (certainty < 0L)
+        {
+            certainty = -certainty;
+        }
+        agreement = (int32_t)prob_power - (int32_t)prob_index;
+        if (agreement < 0L)
+        {
+            agreement = -agreement;
+        }
+        agreement = (int32_t)NLOS_PR_MAX - (agreement / 2L);
+        cls->confidence = (uint8_t)((certainty * agreement) / (int32_t)NLOS_PR_MAX);
+
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+int32_t nlos_estimate(dwt_nlos_snapshot_t *snap, uint8_t quantization_factor, uint8_t rx_pcode)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    dwt_diag_type_e diag_type;
+
+    if ((snap != NULL) && nlos_select_acc(snap->acc_mask, &diag_type))
+    {
+        const dwt_nlos_accdiag_t *diag = &snap->acc[diag_type];
+        bool is_sts = (diag_type != IPATOV);
+        nlos_class_t cls;
+
+        snap->diag_type = diag_type;
+        snap->rsl_q8 = rsl_calculate_signal_power((int32_t)diag->cir_power, quantization_factor,
+                                                  (uint16_t)diag->accumCount, snap->D, rx_pcode, is_sts);
+        snap->fsl_q8 = rsl_calculate_first_path_power(diag->F1, diag->F2, diag->F3,
+                                                      (uint16_t)diag->accumCount, snap->D, rx_pcode, is_sts);
+
+        if ((snap->rsl_q8 != SHRT_MIN) && (snap->fsl_q8 != SHRT_MIN)
+            && (nlos_classify(diag, quantization_factor, &cls) == (int32_t)DWT_SUCCESS))
+        {
+            snap->result = cls.result;
+            snap->prob_nlos = cls.prob_nlos;
+            snap->confidence = cls.confidence;
+            ret = (int32_t)DWT_SUCCESS;
+        }
+    }
+    return ret;
+}
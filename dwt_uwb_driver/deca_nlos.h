@@ -0,0 +1,95 @@
+/**
+ * @file:     deca_nlos.h
+ *
+ * @brief     This file contains the LOS/NLOS estimation computations
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_NLOS_H_
+#define DECA_NLOS_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+/* Per frame metrics of one accumulator used by the classifier */
+typedef struct
+{
+    int16_t fp_ratio_q8;         // First path to total (channel area) power ratio in dB, as a q8.8
+    int32_t index_spread_q6;     // Peak to first path index spread in samples, 6 fractional bits
+} nlos_metrics_t;
+
+/* Classification of one frame */
+typedef struct
+{
+    nlos_metrics_t metrics;      // Metrics the classification was made from
+    dwt_nlos_result_e result;    // LOS/NLOS decision
+    uint8_t prob_nlos;           // Probability of NLOS, in percent
+    uint8_t confidence;          // Confidence in the decision, in percent
+} nlos_class_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Compute the classifier metrics of one accumulator using fixed point math
+ *
+ * The first path to total power ratio is 10 * log10((F1² + F2² + F3²) / (C * 2^q)): it is the first
+ * path power minus the signal power, without computing either (constant A, DGC decision and
+ * accumulation count cancel out).
+ *
+ * input parameters
+ * @param diag diagnostics of the accumulator
+ * @param quantization_factor power of two multiplied to C (21 or 17)
+ *
+ * output parameters
+ * @param metrics computed metrics
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if C or the first path amplitudes are 0.
+ */
+int32_t nlos_compute_metrics(const dwt_nlos_accdiag_t *diag, uint8_t quantization_factor, nlos_metrics_t *metrics);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Classify one frame as LOS, possible NLOS or NLOS from the diagnostics of one accumulator
+ *
+ * A first path more than 12 dB below the total power gives NLOS, more than 4.8 dB possible NLOS
+ * with a probability growing linearly up to 12 dB. Otherwise the peak to first path index spread
+ * decides: up to 3.3 samples is LOS, from 6 samples NLOS, and in between probability is
+ * 0.39178 * spread - 1.31719 (APS006 part 3).
+ *
+ * The confidence is |2 * prob_nlos - 100|, lowered when the NLOS probabilities given by the power
+ * ratio and by the index spread disagree: 100 for a clear decision both metrics agree with, 0 for
+ * a probability of 50 %.
+ *
+ * input parameters
+ * @param diag diagnostics of the accumulator
+ * @param quantization_factor power of two multiplied to C (21 or 17)
+ *
+ * output parameters
+ * @param cls classification and the metrics it was made from
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the metrics can't be computed.
+ */
+int32_t nlos_classify(const dwt_nlos_accdiag_t *diag, uint8_t quantization_factor, nlos_class_t *cls);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Estimate the LOS/NLOS condition of a received frame from its NLOS diagnostics, using fixed
+ *        point math only.
+ *
+ * The accumulator used is Ipatov if present in snap->acc_mask, else the first STS one. Its signal
+ * power and first path power are computed (see rsl_calculate_signal_power()) and it is classified
+ * with nlos_classify().
+ *
+ * input parameters
+ * @param snap diagnostics as read by dwt_nlos_readsnapshot(), acc_mask, D and acc[] must be set
+ * @param quantization_factor power of two multiplied to C (21 or 17)
+ * @param rx_pcode RX code, used to know which PRF is used
+ *
+ * output parameters
+ * @param snap diag_type, rsl_q8, fsl_q8, result, prob_nlos and confidence are set
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if no accumulator is selected or its power can't be computed.
+ */
+int32_t nlos_estimate(dwt_nlos_snapshot_t *snap, uint8_t quantization_factor, uint8_t rx_pcode);
+
+#endif /* DECA_NLOS_H_ */
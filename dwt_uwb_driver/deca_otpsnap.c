@@ -0,0 +1,54 @@
+/**
+ * @file:     deca_otpsnap.c
+ *
+ * @brief     Integrity of the OTP calibration snapshots given to dwt_otpsnapshot_import()
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_otpsnap.h"
+
+#define OTPSNAP_CRC32_POLY      (0xEDB88320UL)  // 0x04C11DB7, reflected
+#define OTPSNAP_CRC32_INIT      (0xFFFFFFFFUL)
+#define OTPSNAP_CRC32_XOROUT    (0xFFFFFFFFUL)
+
+/* All fields up to the CRC */
+#define OTPSNAP_CRC_LEN         ((uint16_t)offsetof(dwt_otp_snapshot_t, crc))
+
+uint32_t otpsnap_crc32(const uint8_t *data, uint16_t len)
+{
+    uint32_t crc = OTPSNAP_CRC32_INIT;
+
+    for (uint16_t i = 0U; i < len; i++)
+    {
+        crc ^= (uint32_t)data[i];
+        for (uint8_t j = 0U; j < 8U; j++)
+        {
+            crc = ((crc & 1UL) != 0UL) ? ((crc >> 1U) ^ OTPSNAP_CRC32_POLY) : (crc >> 1U);
+        }
+    }
+    return crc ^ OTPSNAP_CRC32_XOROUT;
+}
+
+void otpsnap_seal(dwt_otp_snapshot_t *snap)
+{
+    snap->version = DWT_OTP_SNAPSHOT_VERSION;
+    snap->crc = otpsnap_crc32((const uint8_t *)snap, OTPSNAP_CRC_LEN);
+}
+
+int32_t otpsnap_check(const dwt_otp_snapshot_t *snap)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((snap->version == DWT_OTP_SNAPSHOT_VERSION) && (snap->crc == otpsnap_crc32((const uint8_t *)snap, OTPSNAP_CRC_LEN)))
+    {
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
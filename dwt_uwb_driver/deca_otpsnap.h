@@ -0,0 +1,61 @@
+/**
+ * @file:     deca_otpsnap.h
+ *
+ * @brief     Integrity of the OTP calibration snapshots given to dwt_otpsnapshot_import()
+ *
+ *            A snapshot holds the raw OTP words read by dwt_initialise() (LDO and bias tunes, DGC
+ *            configuration, part and lot IDs, reference voltage and temperature, OTP revision,
+ *            crystal trim and PLL coarse code). The host keeps it in flash or RAM, and gives it
+ *            back before the next dwt_initialise(), which then reads the part ID only from OTP.
+ *
+ *            Snapshots are sealed with their layout version and a CRC-32 (IEEE 802.3) of their
+ *            fields, so that a corrupted or outdated copy is ignored rather than applied.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_OTPSNAP_H_
+#define DECA_OTPSNAP_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+/* OTP values which dwt_initialise() only reads on request */
+#define OTPSNAP_MODE_MASK   ((uint16_t)DWT_READ_OTP_PID | (uint16_t)DWT_READ_OTP_LID | (uint16_t)DWT_READ_OTP_BAT | (uint16_t)DWT_READ_OTP_TMP)
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief CRC-32 (IEEE 802.3, reflected, polynomial 0x04C11DB7) of a buffer.
+ *
+ * input parameters
+ * @param data buffer
+ * @param len length of the buffer in bytes
+ *
+ * return: CRC of the buffer.
+ */
+uint32_t otpsnap_crc32(const uint8_t *data, uint16_t len);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Set the version and the CRC of a snapshot, after its fields have been set.
+ *
+ * input parameters
+ * @param snap snapshot
+ *
+ * output parameters
+ * @param snap snapshot, with version and crc set
+ */
+void otpsnap_seal(dwt_otp_snapshot_t *snap);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Check the version and the CRC of a snapshot.
+ *
+ * input parameters
+ * @param snap snapshot
+ *
+ * return: DWT_SUCCESS if the snapshot can be used, DWT_ERROR otherwise.
+ */
+int32_t otpsnap_check(const dwt_otp_snapshot_t *snap);
+
+#endif /* DECA_OTPSNAP_H_ */
@@ -0,0 +1,159 @@
+/**
+ * @file:     deca_recal.c
+ *
+ * @brief     Temperature-driven background recalibration
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "deca_device_api.h"
+#include "deca_recal.h"
+
+void recal_init(recal_t *rc, const recal_config_t *config, int8_t temp_c)
+{
+    (void)memset(rc, 0, sizeof(*rc));
+    rc->config = *config;
+    rc->temp_c = TEMP_INIT;
+    for (uint8_t i = 0U; i < (uint8_t)RECAL_TASKS; i++)
+    {
+        rc->done_c[i] = temp_c;
+    }
+}
+
+uint8_t recal_temperature(recal_t *rc, uint32_t now_ms, int8_t temp_c)
+{
+    rc->sampled_ms = now_ms;
+    rc->sampled = 1U;
+    rc->temp_c = temp_c;
+
+    for (uint8_t i = 0U; i < (uint8_t)RECAL_TASKS; i++)
+    {
+        if ((rc->config.tasks & RECAL_BIT(i)) != 0U)
+        {
+            int16_t delta = (int16_t)temp_c - (int16_t)rc->done_c[i];
+
+            if ((rc->done_c[i] == TEMP_INIT) || (delta >= (int16_t)rc->config.hysteresis_c[i])
+                || (-delta >= (int16_t)rc->config.hysteresis_c[i]))
+            {
+                rc->due |= RECAL_BIT(i);
+            }
+        }
+    }
+    return rc->due;
+}
+
+uint16_t recal_sleepcnt(uint32_t sleep_ms, uint16_t lposc_cal)
+{
+    uint16_t ret = 0U;
+
+    if (lposc_cal != 0U)
+    {
+        // The sleep counter counts the upper 16 bits of 28: units of 4096 LP OSC cycles, of lposc_cal 38.4 MHz cycles
+        uint64_t unit = 4096ULL * lposc_cal;
+        uint64_t sleepcnt = (((uint64_t)sleep_ms * 38400ULL) + (unit / 2ULL)) / unit;
+
+        if (sleepcnt == 0ULL)
+        {
+            sleepcnt = 1ULL;
+        }
+        else if (sleepcnt > 0xFFFFULL)
+        {
+            sleepcnt = 0xFFFFULL;
+        }
+        else
+        {
+            // In range
+        }
+        ret = (uint16_t)sleepcnt;
+    }
+    return ret;
+}
+
+/**
+ * recal_run() - Run a calibration at the temperature sampled last
+ * @rc: service state
+ * @task: calibration
+ *
+ * Return: DWT_SUCCESS or DWT_ERROR
+ */
+static int32_t recal_run(recal_t *rc, recal_task_e task)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    switch (task)
+    {
+    case RECAL_XTAL:
+    {
+        dwt_xtal_trim_t params = rc->config.xtal;
+        uint8_t trim;
+
+        params.temperature = rc->temp_c;
+        ret = dwt_xtal_temperature_compensation(&params, &trim);
+        break;
+    }
+    case RECAL_PLL:
+        ret = dwt_pll_cal();
+        break;
+    case RECAL_PGF:
+        ret = dwt_pgf_cal(1);
+        break;
+    case RECAL_SLEEPCNT:
+    {
+        uint16_t sleepcnt = recal_sleepcnt(rc->config.sleep_ms, dwt_calibratesleepcnt());
+
+        if (sleepcnt != 0U)
+        {
+            dwt_configuresleepcnt(sleepcnt);
+            ret = (int32_t)DWT_SUCCESS;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return ret;
+}
+
+uint8_t recal_idle(recal_t *rc, uint32_t now_ms, uint32_t gap_us)
+{
+    uint8_t ran = 0U;
+
+    if ((rc->sampled == 0U) || ((now_ms - rc->sampled_ms) >= rc->config.sample_ms))
+    {
+        if (rc->config.source == RECAL_TEMP_WAKEUP)
+        {
+            (void)recal_temperature(rc, now_ms, (int8_t)(dwt_convertrawtemperature_cdeg(dwt_readwakeuptemp()) / 100));
+        }
+        else if (gap_us >= RECAL_SAMPLE_US)
+        {
+            gap_us -= RECAL_SAMPLE_US;
+            (void)recal_temperature(rc, now_ms, (int8_t)(dwt_convertrawtemperature_cdeg((uint8_t)(dwt_readtempvbat() >> 8U)) / 100));
+        }
+        else
+        {
+            // No time to sample
+        }
+    }
+
+    for (uint8_t i = 0U; i < (uint8_t)RECAL_TASKS; i++)
+    {
+        if (((rc->due & RECAL_BIT(i)) != 0U) && (rc->config.cost_us[i] <= gap_us))
+        {
+            gap_us -= rc->config.cost_us[i];
+            // A failed calibration is not retried before the temperature moves again
+            rc->due &= (uint8_t)~RECAL_BIT(i);
+            rc->done_c[i] = rc->temp_c;
+            if (recal_run(rc, (recal_task_e)i) == (int32_t)DWT_SUCCESS)
+            {
+                rc->runs[i]++;
+                ran |= RECAL_BIT(i);
+            }
+        }
+    }
+    return ran;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file:     deca_recal.h
+ *
+ * @brief     Temperature-driven background recalibration
+ *
+ *            The crystal trim (DW3720), the PLL lock, the RX PGF calibration and the LP OSC calibration of the
+ *            sleep counter all drift with temperature, while dwt_configure() only calibrates them once.
+ *            This service samples the temperature at a configurable period, and reruns a calibration only
+ *            once the temperature moved by its own hysteresis since that calibration last ran. Everything runs
+ *            from recal_idle(), called by the application in the idle gaps of its schedule, with the length
+ *            of the gap: only the calibrations which fit in it are run, the others stay due for a later gap.
+ *
+ *            The temperature is read with dwt_readtempvbat() (SAR conversion) or, on devices woken from sleep
+ *            every cycle, for free with dwt_readwakeuptemp() (DWT_TANDV set in dwt_configuresleep()).
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_RECAL_H_
+#define DECA_RECAL_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+/* Calibrations, in the order they run */
+typedef enum
+{
+    RECAL_XTAL = 0,     // Crystal trim, dwt_xtal_temperature_compensation() (DW3720 only)
+    RECAL_PLL,          // PLL, dwt_pll_cal()
+    RECAL_PGF,          // RX PGF, dwt_pgf_cal()
+    RECAL_SLEEPCNT,     // Sleep counter, dwt_calibratesleepcnt() and dwt_configuresleepcnt()
+    RECAL_TASKS
+} recal_task_e;
+
+#define RECAL_BIT(task) ((uint8_t)(1U << (uint8_t)(task)))
+
+typedef enum
+{
+    RECAL_TEMP_SAR = 0, // dwt_readtempvbat(), the device must be in IDLE
+    RECAL_TEMP_WAKEUP   // dwt_readwakeuptemp(), sampled by the device on its last wake-up
+} recal_source_e;
+
+/* Typical duration of the calibrations and of a SAR temperature sample, with a SPI at 8 MHz or more, in us */
+#define RECAL_XTAL_US     50U
+#define RECAL_PLL_US      400U
+#define RECAL_PGF_US      200U
+#define RECAL_SLEEPCNT_US 2000U
+#define RECAL_SAMPLE_US   100U
+
+typedef struct
+{
+    uint32_t sample_ms;                 // Period of the temperature samples, in ms
+    recal_source_e source;              // Temperature sensor reading
+    uint8_t tasks;                      // Calibrations to run, RECAL_BIT() mask
+    uint8_t hysteresis_c[RECAL_TASKS];  // Temperature change since the last run rerunning a calibration, in degrees C
+    uint16_t cost_us[RECAL_TASKS];      // Duration of each calibration, e.g. RECAL_PLL_US
+    uint32_t sleep_ms;                  // RECAL_SLEEPCNT: sleep time programmed in the sleep counter, in ms
+    dwt_xtal_trim_t xtal;               // RECAL_XTAL: crystal characteristics, the temperature is the one sampled
+} recal_config_t;
+
+typedef struct
+{
+    recal_config_t config;
+    uint32_t sampled_ms;                // Time of the last temperature sample
+    uint8_t sampled;                    // A temperature was sampled
+    int8_t temp_c;                      // Last temperature sampled, in degrees C
+    int8_t done_c[RECAL_TASKS];         // Temperature of the last run of each calibration, TEMP_INIT if none
+    uint8_t due;                        // Calibrations due, RECAL_BIT() mask
+    uint32_t runs[RECAL_TASKS];         // Number of runs of each calibration
+} recal_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Initialise the service.
+ *
+ * input parameters
+ * @param config sample period, calibrations and their hysteresis, copied
+ * @param temp_c temperature of the calibrations done by dwt_configure(), or TEMP_INIT to run them all
+ *               after the first sample
+ *
+ * output parameters
+ * @param rc service state
+ */
+void recal_init(recal_t *rc, const recal_config_t *config, int8_t temp_c);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Record a temperature sample and update the calibrations due. recal_idle() calls it with the
+ *        temperature it samples; it can also be called with a temperature read by the application.
+ *
+ * input parameters
+ * @param rc service state
+ * @param now_ms time of the sample, in ms, wrapping at 2^32
+ * @param temp_c temperature, in degrees C
+ *
+ * return: calibrations due, RECAL_BIT() mask.
+ */
+uint8_t recal_temperature(recal_t *rc, uint32_t now_ms, int8_t temp_c);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Sample the temperature if the sample period elapsed, and run the calibrations due which fit in
+ *        the idle gap, in the order of recal_task_e. The device must be awake and not in TX or RX.
+ *
+ * input parameters
+ * @param rc service state
+ * @param now_ms current time, in ms, wrapping at 2^32
+ * @param gap_us time the device is not needed by the application, in us
+ *
+ * return: calibrations run, RECAL_BIT() mask.
+ */
+uint8_t recal_idle(recal_t *rc, uint32_t now_ms, uint32_t gap_us);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Sleep counter value for a sleep time.
+ *
+ * input parameters
+ * @param sleep_ms sleep time, in ms
+ * @param lposc_cal result of dwt_calibratesleepcnt(), XTAL cycles per LP OSC cycle
+ *
+ * return: value for dwt_configuresleepcnt(), 1 to 0xFFFF, or 0 if lposc_cal is 0.
+ */
+uint16_t recal_sleepcnt(uint32_t sleep_ms, uint16_t lposc_cal);
+
+#endif /* DECA_RECAL_H_ */
@@ -21,6 +21,54 @@
 #define Q8_OFFSET 256UL
 #define Q8_SHIFT 8UL
 
+/**
+ * rsl_alpha_q8() - Constant A of the signal power equation
+ *
+ * @rx_pcode: RX code, used to know which PRF is used.
+ * @is_sts: if RSL is calculated on a STS segment.
+ *
+ * Return: A as a q8.8.
+ */
+static int32_t rsl_alpha_q8(uint8_t rx_pcode, bool is_sts)
+{
+    int32_t alpha_q8;
+
+    if (PCODE_PRF64_START <= rx_pcode)
+    {
+        alpha_q8 = ALPHA_IP_PRF_64_Q8;
+        if (is_sts)
+        {
+            uint32_t q8_shifted_u32 = 1UL << Q8_SHIFT;
+            alpha_q8 -= (int32_t)q8_shifted_u32;
+        }
+    }
+    else
+    {
+        alpha_q8 = ALPHA_IP_PRF_16_Q8;
+    }
+    return alpha_q8;
+}
+
+/**
+ * rsl_apply_offsets() - Add the DGC gain and remove constant A
+ *
+ * @rsl_dbm_q8: 10 * log10(power * 2^pow2 / n²) as a q8.8.
+ * @dgc_decision: DGC_DECISION, in range 0 to 7.
+ * @alpha_q8: constant A as a q8.8, see rsl_alpha_q8().
+ *
+ * Return: signal power as a signed q8.8, saturated to SHRT_MIN.
+ */
+static int16_t rsl_apply_offsets(int32_t rsl_dbm_q8, uint8_t dgc_decision, int32_t alpha_q8)
+{
+    /* Computation of the offsets. */
+    uint16_t dgc_desision_shifted = ((uint16_t)dgc_decision * 6U) << (uint16_t)Q8_SHIFT;
+    int32_t dgc_decision_q8 = (int32_t)dgc_desision_shifted;
+
+    rsl_dbm_q8 = rsl_dbm_q8 + dgc_decision_q8 - alpha_q8;
+
+    return (rsl_dbm_q8 < SHRT_MIN) ? (int16_t)SHRT_MIN : (int16_t)rsl_dbm_q8;
+}
+
 /**
  * rsl_calculate() - Estimate the signal power in dBm
  *
@@ -84,27 +132,7 @@ static int16_t rsl_calculate(uint32_t c, uint32_t n, uint32_t pow2, uint8_t dgc_
     rsl_dbm_q8_u32 = (rsl_dbm_q8_u32 * Q8_OFFSET) / LOG2_10_SHIFTED;
     int32_t rsl_dbm_q8 = (int32_t)rsl_dbm_q8_u32;
 
-    /* Computation of the offsets. */
-    uint16_t dgc_desision_shifted = ((uint16_t)dgc_decision * 6U) << (uint16_t)Q8_SHIFT;
-    int32_t dgc_decision_q8 = (int32_t)dgc_desision_shifted;
-    int32_t alpha_q8;
-
-    if (PCODE_PRF64_START <= rx_pcode)
-    {
-        alpha_q8 = ALPHA_IP_PRF_64_Q8;
-        if (is_sts)
-        {
-            uint32_t q8_shifted_u32 = 1UL << Q8_SHIFT;
-            alpha_q8 -= (int32_t)q8_shifted_u32;
-        }
-    }
-    else
-    {
-        alpha_q8 = ALPHA_IP_PRF_16_Q8;
-    }
-    rsl_dbm_q8 = rsl_dbm_q8 + dgc_decision_q8 - alpha_q8;
-
-    return (rsl_dbm_q8 < SHRT_MIN) ? (int16_t)SHRT_MIN : (int16_t)rsl_dbm_q8;
+    return rsl_apply_offsets(rsl_dbm_q8, dgc_decision, rsl_alpha_q8(rx_pcode, is_sts));
 }
 
 int16_t rsl_calculate_signal_power(
@@ -135,3 +163,91 @@ int16_t rsl_calculate_first_path_power(
 
     return rsl_calculate(channel_area, preamble_accumulation_count, 0, dgc_decision, rx_pcode, is_sts);
 }
+
+/**
+ * rsl_calculate_cached() - rsl_calculate() with precomputed per-batch terms
+ *
+ * @c: power as integer.
+ * @n: number of accumulate symbols or STS length.
+ * @pow2: power of 2 to be multiplied to @c.
+ * @dgc_decision: DGC_DECISION, in range 0 to 7.
+ * @alpha_q8: constant A as a q8.8, see rsl_alpha_q8().
+ * @last_n: n of the previous record, updated on return.
+ * @log2_n2: 2 * log2(@last_n) << LUT_LOG_SHIFT, updated on return.
+ *
+ * Within a batch n is usually fixed by the preamble length, so log2(n) is
+ * only recomputed when it changes from one record to the next.
+ *
+ * Return: as rsl_calculate().
+ */
+static inline int16_t rsl_calculate_cached(uint32_t c, uint32_t n, uint32_t pow2, uint8_t dgc_decision, int32_t alpha_q8,
+                                           uint32_t *last_n, uint32_t *log2_n2)
+{
+    if (c == 0UL || n == 0UL)
+    {
+        return (int16_t)SHRT_MIN;
+    }
+    if (n != *last_n)
+    {
+        *last_n = n;
+        *log2_n2 = log2_lut(n) << 1UL;
+    }
+    uint32_t rsl_dbm_q8_u32 = (pow2 << LUT_LOG_SHIFT) + log2_lut(c) - *log2_n2;
+    rsl_dbm_q8_u32 = (rsl_dbm_q8_u32 * Q8_OFFSET) / LOG2_10_SHIFTED;
+
+    return rsl_apply_offsets((int32_t)rsl_dbm_q8_u32, dgc_decision, alpha_q8);
+}
+
+int32_t rsl_calculate_signal_power_batch(
+    const rsl_diag_batch_t *batch,
+    uint8_t quantization_factor,
+    uint8_t rx_pcode,
+    bool is_sts,
+    int16_t *rsl_q8
+) {
+    uint32_t last_n = 0UL;
+    uint32_t log2_n2 = 0UL;
+    int32_t alpha_q8 = rsl_alpha_q8(rx_pcode, is_sts);
+
+    if (batch == NULL || batch->power == NULL || batch->accum_count == NULL || batch->dgc_decision == NULL || rsl_q8 == NULL)
+    {
+        return (int32_t)DWT_ERROR;
+    }
+
+    for (uint32_t i = 0UL; i < batch->count; i++)
+    {
+        rsl_q8[i] = rsl_calculate_cached((uint32_t)batch->power[i], batch->accum_count[i], quantization_factor,
+                                         batch->dgc_decision[i], alpha_q8, &last_n, &log2_n2);
+    }
+
+    return (int32_t)DWT_SUCCESS;
+}
+
+int32_t rsl_calculate_first_path_power_batch(
+    const rsl_diag_batch_t *batch,
+    uint8_t rx_pcode,
+    bool is_sts,
+    int16_t *fsl_q8
+) {
+    uint32_t last_n = 0UL;
+    uint32_t log2_n2 = 0UL;
+    int32_t alpha_q8 = rsl_alpha_q8(rx_pcode, is_sts);
+
+    if (batch == NULL || batch->F1 == NULL || batch->F2 == NULL || batch->F3 == NULL || batch->accum_count == NULL ||
+        batch->dgc_decision == NULL || fsl_q8 == NULL)
+    {
+        return (int32_t)DWT_ERROR;
+    }
+
+    for (uint32_t i = 0UL; i < batch->count; i++)
+    {
+        uint32_t f1 = batch->F1[i] / 4UL; // The First Path Amplitude (point 1) magnitude value.
+        uint32_t f2 = batch->F2[i] / 4UL; // The First Path Amplitude (point 2) magnitude value.
+        uint32_t f3 = batch->F3[i] / 4UL; // The First Path Amplitude (point 3) magnitude value.
+
+        fsl_q8[i] = rsl_calculate_cached(f1*f1 + f2*f2 + f3*f3, batch->accum_count[i], 0UL,
+                                         batch->dgc_decision[i], alpha_q8, &last_n, &log2_n2);
+    }
+
+    return (int32_t)DWT_SUCCESS;
+}
@@ -15,6 +15,20 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Diagnostics of many received frames in struct-of-arrays layout, as used by
+ * the batch computations below. All arrays hold @count entries; arrays not
+ * used by a given computation may be NULL. */
+typedef struct
+{
+    uint32_t count;               // Number of records
+    const int32_t *power;         // Channel Impulse Response Power values (C), as rsl_calculate_signal_power() takes them
+    const uint32_t *F1;           // First Path Amplitude (point 1) magnitude values (2 fractional bits)
+    const uint32_t *F2;           // First Path Amplitude (point 2) magnitude values (2 fractional bits)
+    const uint32_t *F3;           // First Path Amplitude (point 3) magnitude values (2 fractional bits)
+    const uint16_t *accum_count;  // Preamble Accumulation Count values
+    const uint8_t *dgc_decision;  // DGC_DECISION values, in range 0 to 7
+} rsl_diag_batch_t;
+
 /*! ---------------------------------------------------------------------------------------------------
  * @brief Estimate signal power as described in DW3000 Datasheet using fixed point math
  * 
@@ -67,4 +81,50 @@ int16_t rsl_calculate_first_path_power(
     bool is_sts
 );
 
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Estimate signal power of a batch of received frames
+ *
+ * Gives the same result as calling rsl_calculate_signal_power() on each record.
+ *
+ * input parameters
+ * @param batch records to process, power, accum_count and dgc_decision must be set
+ * @param quantization_factor power of two multiplied to C (21 or 17)
+ * @param rx_pcode RX code, used to know which PRF is used
+ * @param is_sts if RSL is calculated on a STS segment
+ *
+ * output parameters
+ * @param rsl_q8 array of batch->count signal powers, encoded as in rsl_calculate_signal_power()
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if a required array is NULL.
+ */
+int32_t rsl_calculate_signal_power_batch(
+    const rsl_diag_batch_t *batch,
+    uint8_t quantization_factor,
+    uint8_t rx_pcode,
+    bool is_sts,
+    int16_t *rsl_q8
+);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Estimate first path signal power of a batch of received frames
+ *
+ * Gives the same result as calling rsl_calculate_first_path_power() on each record.
+ *
+ * input parameters
+ * @param batch records to process, F1, F2, F3, accum_count and dgc_decision must be set
+ * @param rx_pcode RX code, used to know which PRF is used
+ * @param is_sts if RSL is calculated on a STS segment
+ *
+ * output parameters
+ * @param fsl_q8 array of batch->count first path powers, encoded as in rsl_calculate_first_path_power()
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if a required array is NULL.
+ */
+int32_t rsl_calculate_first_path_power_batch(
+    const rsl_diag_batch_t *batch,
+    uint8_t rx_pcode,
+    bool is_sts,
+    int16_t *fsl_q8
+);
+
 #endif /* _DECA_RSL_H_ */
@@ -0,0 +1,116 @@
+/**
+ * @file:     deca_sleepprof.c
+ *
+ * @brief     Wake/sleep latency and energy profiler
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "deca_device_api.h"
+#include "deca_sleepprof.h"
+
+typedef struct
+{
+    sleepprof_clock_fn now_us;
+    sleepprof_currents_t currents;
+    sleepprof_phase_e phase;            // Phase in progress
+    uint32_t since_us;                  // Start of the phase in progress
+    uint8_t in_cycle;                   // A dwt_entersleep() was seen, the cycle in progress is complete
+    uint32_t cycles;
+    uint32_t cur_us[SLEEPPROF_PHASES];  // Cycle in progress
+    uint32_t last_us[SLEEPPROF_PHASES]; // Last complete cycle
+} sleepprof_t;
+
+static sleepprof_t sleepprof;
+
+static const sleepprof_state_e sleepprof_states[SLEEPPROF_PHASES] = {
+    SLEEPPROF_STATE_SLEEP,      // SLEEPPROF_SLEEP
+    SLEEPPROF_STATE_WAKEUP,     // SLEEPPROF_WAKE_PULSE
+    SLEEPPROF_STATE_WAKEUP,     // SLEEPPROF_WAKE_DELAY
+    SLEEPPROF_STATE_IDLE_RC,    // SLEEPPROF_SPI_READY
+    SLEEPPROF_STATE_IDLE_RC,    // SLEEPPROF_RESTORE
+    SLEEPPROF_STATE_IDLE_PLL,   // SLEEPPROF_FIRST_TXRX
+    SLEEPPROF_STATE_TX,         // SLEEPPROF_TX
+    SLEEPPROF_STATE_RX,         // SLEEPPROF_RX
+    SLEEPPROF_STATE_IDLE_PLL,   // SLEEPPROF_IDLE
+    SLEEPPROF_STATE_IDLE_PLL    // SLEEPPROF_CONFIG_SLEEP
+};
+
+void sleepprof_start(sleepprof_clock_fn now_us, const sleepprof_currents_t *currents)
+{
+    (void)memset(&sleepprof, 0, sizeof(sleepprof));
+    sleepprof.currents = *currents;
+    sleepprof.phase = SLEEPPROF_IDLE;
+    sleepprof.since_us = now_us();
+    sleepprof.now_us = now_us;
+}
+
+void sleepprof_stop(void)
+{
+    sleepprof.now_us = NULL;
+}
+
+void sleepprof_mark(sleepprof_phase_e phase)
+{
+    if (sleepprof.now_us != NULL)
+    {
+        uint32_t now = sleepprof.now_us();
+
+        // Unsigned difference, right across a wrap of the clock
+        sleepprof.cur_us[sleepprof.phase] += now - sleepprof.since_us;
+
+        if ((phase == SLEEPPROF_SLEEP) && (sleepprof.phase != SLEEPPROF_SLEEP))
+        {
+            // The time before the first dwt_entersleep() is not part of a cycle
+            if (sleepprof.in_cycle != 0U)
+            {
+                (void)memcpy(sleepprof.last_us, sleepprof.cur_us, sizeof(sleepprof.last_us));
+                sleepprof.cycles++;
+            }
+            (void)memset(sleepprof.cur_us, 0, sizeof(sleepprof.cur_us));
+            sleepprof.in_cycle = 1U;
+        }
+
+        sleepprof.phase = phase;
+        sleepprof.since_us = now;
+    }
+}
+
+sleepprof_state_e sleepprof_phase_state(sleepprof_phase_e phase)
+{
+    return sleepprof_states[phase];
+}
+
+int32_t sleepprof_report(sleepprof_report_t *report)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if (sleepprof.cycles != 0UL)
+    {
+        uint64_t charge_pc = 0ULL; // uA times us
+        uint32_t cycle_us = 0UL;
+
+        for (uint8_t i = 0U; i < (uint8_t)SLEEPPROF_PHASES; i++)
+        {
+            report->phase_us[i] = sleepprof.last_us[i];
+            cycle_us += sleepprof.last_us[i];
+            charge_pc += (uint64_t)sleepprof.last_us[i] * sleepprof.currents.current_ua[sleepprof_states[i]];
+        }
+
+        report->cycles = sleepprof.cycles;
+        report->cycle_us = cycle_us;
+        report->wake_us = sleepprof.last_us[SLEEPPROF_WAKE_PULSE] + sleepprof.last_us[SLEEPPROF_WAKE_DELAY]
+                          + sleepprof.last_us[SLEEPPROF_SPI_READY] + sleepprof.last_us[SLEEPPROF_RESTORE]
+                          + sleepprof.last_us[SLEEPPROF_FIRST_TXRX];
+        report->charge_nc = (uint32_t)(charge_pc / 1000ULL);
+        report->energy_nj = (uint32_t)((charge_pc * sleepprof.currents.supply_mv) / 1000000ULL);
+        report->avg_current_ua = (cycle_us != 0UL) ? (uint32_t)(charge_pc / cycle_us) : 0UL;
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
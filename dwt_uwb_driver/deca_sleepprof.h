@@ -0,0 +1,137 @@
+/**
+ * @file:     deca_sleepprof.h
+ *
+ * @brief     Wake/sleep latency and energy profiler
+ *
+ *            Splits each sleep cycle, from one dwt_entersleep() to the next, into phases:
+ *              SLEEP:       dwt_entersleep() to the wake-up pulse
+ *              WAKE_PULSE:  CS or WAKEUP pulse of dw3000_hw_wakeup()
+ *              WAKE_DELAY:  fixed delay of dw3000_hw_wakeup() after the pulse
+ *              SPI_READY:   end of dw3000_hw_wakeup() to dwt_restoreconfig(), wait for SPIRDY / IDLE_RC
+ *              RESTORE:     dwt_restoreconfig()
+ *              FIRST_TXRX:  end of dwt_restoreconfig() to the first TX or RX started
+ *              TX, RX:      TX or RX started to its completion handled by dwt_isr() (or dwt_forcetrxoff())
+ *              IDLE:        between TX and RX, waiting for the host
+ *              CONFIG_SLEEP: dwt_configuresleep() to dwt_entersleep()
+ *            Each phase draws the current of a device state, given by the host in a per-state current
+ *            table (from the data sheet, or better measured on the board), which gives the charge and
+ *            the energy of a cycle and the average current of a duty cycle.
+ *
+ *            The driver and the platform wake-up mark the phases when built with DWT_SLEEPPROF set to 1
+ *            (CONFIG_DW3000_SLEEP_PROF in Zephyr and ESP-IDF); otherwise the marks compile to nothing.
+ *            Profiling runs from sleepprof_start() on, timed by a free running microsecond clock of the
+ *            host. A frame sent with DWT_RESPONSE_EXPECTED counts its RX as IDLE, and sleep entered
+ *            automatically after TX (dwt_entersleepaftertx()) is not seen.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_SLEEPPROF_H_
+#define DECA_SLEEPPROF_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+
+#ifndef DWT_SLEEPPROF
+#define DWT_SLEEPPROF 0
+#endif
+
+#if DWT_SLEEPPROF
+#define SLEEPPROF_MARK(phase) sleepprof_mark(phase)
+#else
+#define SLEEPPROF_MARK(phase) do { } while (0)
+#endif
+
+typedef enum
+{
+    SLEEPPROF_SLEEP = 0,
+    SLEEPPROF_WAKE_PULSE,
+    SLEEPPROF_WAKE_DELAY,
+    SLEEPPROF_SPI_READY,
+    SLEEPPROF_RESTORE,
+    SLEEPPROF_FIRST_TXRX,
+    SLEEPPROF_TX,
+    SLEEPPROF_RX,
+    SLEEPPROF_IDLE,
+    SLEEPPROF_CONFIG_SLEEP,
+    SLEEPPROF_PHASES
+} sleepprof_phase_e;
+
+typedef enum
+{
+    SLEEPPROF_STATE_SLEEP = 0,      // SLEEP or DEEPSLEEP, as configured by dwt_configuresleep()
+    SLEEPPROF_STATE_WAKEUP,         // WAKEUP and INIT_RC, crystal starting
+    SLEEPPROF_STATE_IDLE_RC,
+    SLEEPPROF_STATE_IDLE_PLL,
+    SLEEPPROF_STATE_TX,
+    SLEEPPROF_STATE_RX,
+    SLEEPPROF_STATES
+} sleepprof_state_e;
+
+typedef struct
+{
+    uint32_t current_ua[SLEEPPROF_STATES];  // Supply current in each device state, in uA
+    uint16_t supply_mv;                     // Supply voltage, in mV
+} sleepprof_currents_t;
+
+typedef struct
+{
+    uint32_t cycles;                        // Complete cycles profiled
+    uint32_t phase_us[SLEEPPROF_PHASES];    // Time in each phase during the last cycle, in us
+    uint32_t cycle_us;                      // Length of the last cycle, in us
+    uint32_t wake_us;                       // Wake-up pulse to the first TX or RX in the last cycle, in us
+    uint32_t charge_nc;                     // Charge drawn during the last cycle, in nC
+    uint32_t energy_nj;                     // Energy used during the last cycle, in nJ
+    uint32_t avg_current_ua;                // Average current over the last cycle, in uA
+} sleepprof_report_t;
+
+/* Free running clock of the host, in us, wrapping at 2^32 */
+typedef uint32_t (*sleepprof_clock_fn)(void);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start profiling, from the next dwt_entersleep() on. Previous cycles are cleared.
+ *
+ * input parameters
+ * @param now_us clock of the host
+ * @param currents supply current in each device state and supply voltage, copied
+ */
+void sleepprof_start(sleepprof_clock_fn now_us, const sleepprof_currents_t *currents);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Stop profiling. The last cycle can still be reported.
+ */
+void sleepprof_stop(void);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief End the current phase and start another one. Called through SLEEPPROF_MARK() by the driver
+ *        and the platform; does nothing unless profiling was started.
+ *
+ * input parameters
+ * @param phase phase starting
+ */
+void sleepprof_mark(sleepprof_phase_e phase);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Device state drawing current during a phase.
+ *
+ * input parameters
+ * @param phase phase
+ *
+ * return: device state.
+ */
+sleepprof_state_e sleepprof_phase_state(sleepprof_phase_e phase);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Latency and energy of the last complete cycle.
+ *
+ * output parameters
+ * @param report phase times, charge, energy and average current of the last cycle
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if no cycle was completed yet.
+ */
+int32_t sleepprof_report(sleepprof_report_t *report);
+
+#endif /* DECA_SLEEPPROF_H_ */
@@ -0,0 +1,202 @@
+/**
+ * @file:     deca_tdoa.c
+ *
+ * @brief     TDoA anchor blink capture pipeline
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_nlos.h"
+#include "deca_tdoa.h"
+
+/**
+ * tdoa_start_batch() - Start filling a free batch, if any
+ * @cap: pipeline
+ * @from: batch to start searching from
+ */
+static void tdoa_start_batch(tdoa_capture_t *cap, uint8_t from)
+{
+    cap->fill = TDOA_BATCH_NONE;
+    for (uint8_t i = 0U; i < TDOA_BATCH_NUM; i++)
+    {
+        uint8_t b = (uint8_t)((from + i) % TDOA_BATCH_NUM);
+
+        if (cap->busy[b] == 0U)
+        {
+            cap->batch[b].count = 0U;
+            cap->batch[b].dropped = cap->dropped;
+            cap->dropped = 0UL;
+            cap->fill = b;
+            break;
+        }
+    }
+}
+
+/**
+ * tdoa_handoff() - Give the batch being filled to the transport and start the next one
+ * @cap: pipeline
+ */
+static void tdoa_handoff(tdoa_capture_t *cap)
+{
+    uint8_t b = cap->fill;
+
+    cap->busy[b] = 1U;
+    cap->config.batch_cb(&cap->batch[b]);
+    tdoa_start_batch(cap, (uint8_t)(b + 1U));
+}
+
+void tdoa_init(tdoa_capture_t *cap, const tdoa_config_t *config)
+{
+    cap->config = *config;
+    cap->dropped = 0UL;
+    for (uint8_t i = 0U; i < TDOA_BATCH_NUM; i++)
+    {
+        cap->busy[i] = 0U;
+    }
+    tdoa_start_batch(cap, 0U);
+}
+
+int32_t tdoa_start(tdoa_capture_t *cap)
+{
+    // The time stamps are logged in the swinging set from the medium set on, the first path amplitudes with the maximum set
+    if ((cap->config.capture & TDOA_CAP_FP_QUALITY) != 0U)
+    {
+        dwt_configciadiag((uint8_t)DW_CIA_DIAG_LOG_MAX);
+    }
+    else
+    {
+        dwt_configciadiag((uint8_t)DW_CIA_DIAG_LOG_MID);
+    }
+    dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_AUTO);
+    dwt_setrxtimeout(0UL);
+    return dwt_rxenable((int32_t)DWT_START_RX_IMMEDIATE);
+}
+
+void tdoa_stop(tdoa_capture_t *cap)
+{
+    (void)cap;
+    dwt_forcetrxoff();
+    dwt_setdblrxbuffmode(DBL_BUF_STATE_DIS, DBL_BUF_MODE_MAN);
+}
+
+/**
+ * tdoa_capture_blink() - Write a blink into the batch being filled
+ * @cap: pipeline
+ * @hdr: blink header
+ */
+static void tdoa_capture_blink(tdoa_capture_t *cap, const uint8_t *hdr)
+{
+    const uint32_t fp_sel = (uint32_t)DWT_DIAG_SEL_IP_POWER | (uint32_t)DWT_DIAG_SEL_IP_F | (uint32_t)DWT_DIAG_SEL_IP_ACCUM;
+    tdoa_batch_t *batch = &cap->batch[cap->fill];
+    tdoa_blink_t *blink = &batch->blink[batch->count];
+    uint32_t sel = (uint32_t)DWT_DIAG_SEL_IP_TOA;
+    uint32_t got;
+    uint64_t id = 0ULL;
+
+    if ((cap->config.capture & TDOA_CAP_STS) != 0U)
+    {
+        sel |= (uint32_t)DWT_DIAG_SEL_STS_TOA;
+    }
+    if ((cap->config.capture & TDOA_CAP_FP_QUALITY) != 0U)
+    {
+        sel |= fp_sel;
+    }
+    // Both time stamps and the first path diagnostics in as few SPI transactions as possible
+    got = dwt_readdiagnostics_sel(&cap->diag, sel);
+
+    for (uint8_t i = 8U; i > 0U; i--)
+    {
+        id = (id << 8U) | hdr[TDOA_BLINK_ID_IDX + i - 1U];
+    }
+    blink->tag_id = id;
+    blink->seq = hdr[TDOA_BLINK_SEQ_IDX];
+    blink->rx_ipatov = ts40_load(cap->diag.ipatovRxTime);
+    blink->ip_status = cap->diag.ipatovRxStatus;
+    blink->rx_sts = ((got & (uint32_t)DWT_DIAG_SEL_STS_TOA) != 0UL) ? ts40_load(cap->diag.stsRxTime) : 0ULL;
+    blink->fp_ratio_q8 = TDOA_FP_UNKNOWN;
+    if ((got & fp_sel) == fp_sel)
+    {
+        dwt_nlos_accdiag_t acc;
+        nlos_metrics_t metrics;
+
+        acc.accumCount = cap->diag.ipatovAccumCount;
+        acc.F1 = cap->diag.ipatovF1;
+        acc.F2 = cap->diag.ipatovF2;
+        acc.F3 = cap->diag.ipatovF3;
+        acc.cir_power = cap->diag.ipatovPower;
+        acc.index_fp = 0UL;
+        acc.index_pp = 0UL;
+        if (nlos_compute_metrics(&acc, cap->config.quantization_factor, &metrics) == (int32_t)DWT_SUCCESS)
+        {
+            blink->fp_ratio_q8 = metrics.fp_ratio_q8;
+        }
+    }
+
+    batch->count++;
+    if (batch->count == TDOA_BATCH_LEN)
+    {
+        tdoa_handoff(cap);
+    }
+}
+
+void tdoa_rx_ok_handler(tdoa_capture_t *cap, const dwt_cb_data_t *cb_data)
+{
+    uint8_t hdr[TDOA_BLINK_HDR_LEN];
+
+    if (cb_data->datalength >= TDOA_BLINK_MIN_LEN)
+    {
+        // Only the header is read, whatever the blink carries after the tag ID is not captured
+        dwt_readrxdata(hdr, TDOA_BLINK_HDR_LEN, 0U);
+        if (hdr[0] == TDOA_BLINK_FC)
+        {
+            if (cap->fill == TDOA_BATCH_NONE)
+            {
+                // A batch may have been released since the last blink
+                tdoa_start_batch(cap, 0U);
+            }
+            if (cap->fill == TDOA_BATCH_NONE)
+            {
+                cap->dropped++;
+            }
+            else
+            {
+                tdoa_capture_blink(cap, hdr);
+            }
+        }
+    }
+    // The receiver has already been re-enabled on the other buffer
+}
+
+void tdoa_rx_error_handler(tdoa_capture_t *cap, const dwt_cb_data_t *cb_data)
+{
+    (void)cap;
+    // The receiver re-enables itself after a frame error, a timeout leaves it off
+    if ((cb_data->status & ((uint32_t)DWT_INT_RXFTO_BIT_MASK | (uint32_t)DWT_INT_RXPTO_BIT_MASK)) != 0UL)
+    {
+        (void)dwt_rxenable((int32_t)DWT_START_RX_IMMEDIATE);
+    }
+}
+
+void tdoa_flush(tdoa_capture_t *cap)
+{
+    if ((cap->fill != TDOA_BATCH_NONE) && (cap->batch[cap->fill].count > 0U))
+    {
+        tdoa_handoff(cap);
+    }
+}
+
+void tdoa_release(tdoa_capture_t *cap, tdoa_batch_t *batch)
+{
+    uint8_t b = (uint8_t)(batch - cap->batch);
+
+    // Only the busy flag is written here, the batch is taken again by the RX callback
+    if (b < TDOA_BATCH_NUM)
+    {
+        cap->busy[b] = 0U;
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file:     deca_tdoa.h
+ *
+ * @brief     TDoA anchor blink capture pipeline
+ *
+ *            The receiver is kept enabled with double buffering and automatic re-enable, so a blink
+ *            is received while the previous one is processed. For each blink the RX time stamps
+ *            (Ipatov and optionally STS), the tag ID, the sequence number and the first path quality
+ *            are written into a preallocated batch record, with one read of the CIA diagnostics.
+ *            Full batches are given to a transport callback, which releases them once sent. No
+ *            memory is allocated and no callback is made per blink.
+ *
+ *            Blinks are IEEE 802.15.4 blink frames: 0xC5, sequence number, 64-bit tag ID.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_TDOA_H_
+#define DECA_TDOA_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+
+#ifndef TDOA_BATCH_LEN
+#define TDOA_BATCH_LEN          (32U)        // Blinks per batch
+#endif
+
+#ifndef TDOA_BATCH_NUM
+#define TDOA_BATCH_NUM          (2U)         // Batches: one filled while the others are with the transport
+#endif
+
+#define TDOA_BLINK_FC           (0xC5U)      // Blink frame control
+#define TDOA_BLINK_SEQ_IDX      (1U)
+#define TDOA_BLINK_ID_IDX       (2U)
+#define TDOA_BLINK_HDR_LEN      (TDOA_BLINK_ID_IDX + 8U)
+#define TDOA_BLINK_MIN_LEN      (TDOA_BLINK_HDR_LEN + FCS_LEN)
+
+#define TDOA_CAP_STS            (0x01U)      // Capture the STS RX time stamp
+#define TDOA_CAP_FP_QUALITY     (0x02U)      // Capture the first path quality
+
+#define TDOA_FP_UNKNOWN         (INT16_MIN)  // First path quality not captured
+#define TDOA_BATCH_NONE         (0xFFU)
+
+/* One received blink */
+typedef struct
+{
+    uint64_t tag_id;          // 64-bit tag ID
+    ts40_t rx_ipatov;         // RX time stamp w.r.t. the Ipatov CIR
+    ts40_t rx_sts;            // RX time stamp w.r.t. the STS CIR, 0 if not captured
+    int16_t fp_ratio_q8;      // First path to total power in dB q8.8 (see nlos_compute_metrics()), or TDOA_FP_UNKNOWN
+    uint8_t seq;              // Blink sequence number
+    uint8_t ip_status;        // Ipatov RX status of the CIA
+} tdoa_blink_t;
+
+typedef struct
+{
+    uint32_t dropped;                      // Blinks dropped before this batch because no batch was free
+    uint16_t count;                        // Blinks in the batch
+    tdoa_blink_t blink[TDOA_BATCH_LEN];
+} tdoa_batch_t;
+
+/* Called with a full batch, which must be given back with tdoa_release() once sent */
+typedef void (*tdoa_batch_cb_t)(tdoa_batch_t *batch);
+
+typedef struct
+{
+    uint8_t capture;                       // TDOA_CAP_xxx flags
+    uint8_t quantization_factor;           // Power of two multiplied to C (21 on DW3000, 17 on DW3720), for the first path quality
+    tdoa_batch_cb_t batch_cb;              // Transport callback
+} tdoa_config_t;
+
+typedef struct
+{
+    tdoa_config_t config;
+    tdoa_batch_t batch[TDOA_BATCH_NUM];
+    volatile uint8_t busy[TDOA_BATCH_NUM]; // Batch is with the transport
+    uint8_t fill;                          // Batch being filled, or TDOA_BATCH_NONE
+    uint32_t dropped;                      // Blinks dropped since the last batch was started
+    dwt_rxdiag_t diag;                     // Diagnostics of the blink being captured
+} tdoa_capture_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Initialise the pipeline, all batches are free.
+ *
+ * input parameters
+ * @param cap pipeline to initialise
+ * @param config configuration, copied into the pipeline
+ */
+void tdoa_init(tdoa_capture_t *cap, const tdoa_config_t *config);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start capturing: configure the CIA diagnostics logging and double buffering with automatic
+ *        re-enable, and enable the receiver without timeout.
+ *
+ * input parameters
+ * @param cap pipeline
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the receiver could not be enabled.
+ */
+int32_t tdoa_start(tdoa_capture_t *cap);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Stop capturing: disable the receiver and double buffering. The batch being filled is kept,
+ *        see tdoa_flush().
+ *
+ * input parameters
+ * @param cap pipeline
+ */
+void tdoa_stop(tdoa_capture_t *cap);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Capture a received frame, to be called from the RX good frame callback. Frames which are
+ *        not blinks are ignored, blinks are counted as dropped when no batch is free.
+ *
+ * input parameters
+ * @param cap pipeline
+ * @param cb_data callback data of the received frame
+ */
+void tdoa_rx_ok_handler(tdoa_capture_t *cap, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Re-enable the receiver after a frame wait or preamble timeout, to be called from the RX timeout
+ *        and error callbacks. After a frame error the receiver is already re-enabled automatically, doing
+ *        it again would abort the reception of the next blink.
+ *
+ * input parameters
+ * @param cap pipeline
+ * @param cb_data callback data of the event
+ */
+void tdoa_rx_error_handler(tdoa_capture_t *cap, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Give the batch being filled to the transport, if it holds any blink. To be called from the
+ *        RX callbacks context, or with the capture stopped.
+ *
+ * input parameters
+ * @param cap pipeline
+ */
+void tdoa_flush(tdoa_capture_t *cap);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Give a batch back once the transport has sent it. Can be called from another context than
+ *        the RX callbacks: only the busy flag of the batch is written, it is taken again on the next
+ *        blink.
+ *
+ * input parameters
+ * @param cap pipeline
+ * @param batch batch given to the transport callback
+ */
+void tdoa_release(tdoa_capture_t *cap, tdoa_batch_t *batch);
+
+#endif /* DECA_TDOA_H_ */
@@ -0,0 +1,222 @@
+/**
+ * @file:     deca_timestamp.h
+ *
+ * @brief     40-bit device time stamp arithmetic
+ *
+ *            The DW3xxx counts time in device time units (DTU) of 1/(128 * 499.2 MHz), about
+ *            15.65 ps, on 40 bits: the counter wraps every 2^40 DTU, about 17.2 s.
+ *            Time stamps are held right aligned in a uint64_t (ts40_t); all helpers below
+ *            keep results within 40 bits, so differences across a wrap are correct as long
+ *            as the two time stamps are less than half a period (about 8.6 s) apart.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_TIMESTAMP_H_
+#define DECA_TIMESTAMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TS40_LEN            (5U)                     // Time stamp length in bytes, as read by dwt_readtxtimestamp()
+#define TS40_SYSTIME_LEN    (4U)                     // System time length in bytes, as read by dwt_readsystime()
+#define TS40_BITS           (40U)
+#define TS40_MASK           0xFFFFFFFFFFULL          // 2^40 - 1
+#define TS40_HALF           0x8000000000ULL          // 2^39, half of the wrap period
+#define TS40_DELAYED_SHIFT  (8U)                     // dwt_setdelayedtrxtime() takes the high 32 bits
+
+/* DTU <-> time conversions. One DTU is 10^7 / 638976 ps, kept as reduced integer ratios so
+ * conversions of any 40-bit value fit in 64-bit intermediates. */
+#define TS40_DTU_PER_S      63897600000ULL           // 128 * 499.2 MHz
+#define TS40_PS_NUM         78125ULL                 // ps = dtu * TS40_PS_NUM / TS40_PS_DEN
+#define TS40_PS_DEN         4992ULL
+#define TS40_NS_NUM         625ULL                   // ns = dtu * TS40_NS_NUM / TS40_NS_DEN
+#define TS40_NS_DEN         39936ULL
+#define TS40_US_NUM         5ULL                     // us = dtu * TS40_US_NUM / TS40_US_DEN
+#define TS40_US_DEN         319488ULL
+
+typedef uint64_t ts40_t;                             // 40-bit time stamp in DTU, right aligned
+
+/**
+ * ts40_load() - Time stamp from the 5 bytes read by dwt_readtxtimestamp() or dwt_readrxtimestamp()
+ *
+ * @ts: time stamp bytes, least significant byte first.
+ *
+ * Return: time stamp in DTU.
+ */
+static inline ts40_t ts40_load(const uint8_t *ts)
+{
+    return ((uint64_t)ts[4] << 32U) | ((uint64_t)ts[3] << 24U) | ((uint64_t)ts[2] << 16U) |
+           ((uint64_t)ts[1] << 8U) | (uint64_t)ts[0];
+}
+
+/**
+ * ts40_load_systime() - Time stamp from the 4 bytes read by dwt_readsystime()
+ *
+ * @systime: system time bytes, least significant byte first, bits 39 to 8 of the device time.
+ *
+ * Return: time stamp in DTU, the low 8 bits are 0.
+ */
+static inline ts40_t ts40_load_systime(const uint8_t *systime)
+{
+    return ((uint64_t)systime[3] << 32U) | ((uint64_t)systime[2] << 24U) | ((uint64_t)systime[1] << 16U) |
+           ((uint64_t)systime[0] << 8U);
+}
+
+/**
+ * ts40_store() - Write a time stamp as 5 bytes, least significant byte first
+ *
+ * @ts: time stamp in DTU.
+ * @buf: 5 bytes buffer.
+ */
+static inline void ts40_store(ts40_t ts, uint8_t *buf)
+{
+    buf[0] = (uint8_t)ts;
+    buf[1] = (uint8_t)(ts >> 8U);
+    buf[2] = (uint8_t)(ts >> 16U);
+    buf[3] = (uint8_t)(ts >> 24U);
+    buf[4] = (uint8_t)(ts >> 32U);
+}
+
+/**
+ * ts40_add() - Add a duration to a time stamp, wrapping at 2^40
+ *
+ * @ts: time stamp in DTU.
+ * @dtu: duration in DTU.
+ *
+ * Return: ts + dtu modulo 2^40.
+ */
+static inline ts40_t ts40_add(ts40_t ts, uint64_t dtu)
+{
+    return (ts + dtu) & TS40_MASK;
+}
+
+/**
+ * ts40_sub() - Duration from @b to @a, modulo 2^40
+ *
+ * @a: later time stamp in DTU.
+ * @b: earlier time stamp in DTU.
+ *
+ * Return: a - b modulo 2^40, correct across one wrap of the counter.
+ */
+static inline uint64_t ts40_sub(ts40_t a, ts40_t b)
+{
+    return (a - b) & TS40_MASK;
+}
+
+/**
+ * ts40_diff() - Signed difference of two time stamps less than half a period apart
+ *
+ * @a: time stamp in DTU.
+ * @b: time stamp in DTU.
+ *
+ * Return: a - b in range [-2^39, 2^39).
+ */
+static inline int64_t ts40_diff(ts40_t a, ts40_t b)
+{
+    uint64_t d = ts40_sub(a, b);
+
+    return (d >= TS40_HALF) ? ((int64_t)d - (int64_t)(TS40_MASK + 1ULL)) : (int64_t)d;
+}
+
+/**
+ * ts40_before() - Check if @a is earlier than @b, across wraps
+ *
+ * @a: time stamp in DTU.
+ * @b: time stamp in DTU.
+ *
+ * Return: true if a is strictly before b, the time stamps being less than half a period apart.
+ */
+static inline bool ts40_before(ts40_t a, ts40_t b)
+{
+    return ts40_diff(a, b) < 0;
+}
+
+/**
+ * ts40_to_delayed() - Convert a time stamp to the dwt_setdelayedtrxtime() format
+ *
+ * @ts: time stamp in DTU.
+ *
+ * Return: high 32 bits of the 40-bit time, the device ignores the low 9 bits of the time stamp.
+ */
+static inline uint32_t ts40_to_delayed(ts40_t ts)
+{
+    return (uint32_t)((ts & TS40_MASK) >> TS40_DELAYED_SHIFT);
+}
+
+/**
+ * ts40_from_delayed() - Time stamp at which a delayed TX/RX programmed with @starttime happens
+ *
+ * @starttime: value given to dwt_setdelayedtrxtime().
+ *
+ * Return: time stamp in DTU, with the low 9 bits cleared as done by the device.
+ */
+static inline ts40_t ts40_from_delayed(uint32_t starttime)
+{
+    return ((uint64_t)starttime << TS40_DELAYED_SHIFT) & (TS40_MASK & ~0x1FFULL);
+}
+
+/**
+ * ts40_dtu_to_ps() - Convert a duration of up to 2^40 DTU to picoseconds
+ *
+ * @dtu: duration in DTU.
+ *
+ * Return: duration in ps, rounded down.
+ */
+static inline uint64_t ts40_dtu_to_ps(uint64_t dtu)
+{
+    return (dtu * TS40_PS_NUM) / TS40_PS_DEN;
+}
+
+/**
+ * ts40_dtu_to_ns() - Convert a duration of up to 2^40 DTU to nanoseconds
+ *
+ * @dtu: duration in DTU.
+ *
+ * Return: duration in ns, rounded down.
+ */
+static inline uint64_t ts40_dtu_to_ns(uint64_t dtu)
+{
+    return (dtu * TS40_NS_NUM) / TS40_NS_DEN;
+}
+
+/**
+ * ts40_ps_to_dtu() - Convert a duration of up to 17.2 s in picoseconds to DTU
+ *
+ * @ps: duration in ps.
+ *
+ * Return: duration in DTU, rounded down.
+ */
+static inline uint64_t ts40_ps_to_dtu(uint64_t ps)
+{
+    return (ps * TS40_PS_DEN) / TS40_PS_NUM;
+}
+
+/**
+ * ts40_ns_to_dtu() - Convert a duration of up to 17.2 s in nanoseconds to DTU
+ *
+ * @ns: duration in ns.
+ *
+ * Return: duration in DTU, rounded down.
+ */
+static inline uint64_t ts40_ns_to_dtu(uint64_t ns)
+{
+    return (ns * TS40_NS_DEN) / TS40_NS_NUM;
+}
+
+/**
+ * ts40_us_to_dtu() - Convert a duration of up to 17.2 s in microseconds to DTU
+ *
+ * @us: duration in us.
+ *
+ * Return: duration in DTU, rounded down.
+ */
+static inline uint64_t ts40_us_to_dtu(uint64_t us)
+{
+    return (us * TS40_US_DEN) / TS40_US_NUM;
+}
+
+#endif /* DECA_TIMESTAMP_H_ */
@@ -0,0 +1,1051 @@
+/**
+ * @file:     deca_twr.c
+ *
+ * @brief     Double-sided two-way ranging (DS-TWR) engine
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+#include "deca_txtemplate.h"
+#include "deca_twr.h"
+
+#define TWR_FC_0              (0x41U)   // Data frame, PAN ID compression
+#define TWR_FC_1              (0x88U)   // Short destination and source addresses
+#define TWR_SEQ_IDX           (2U)
+#define TWR_PAN_IDX           (3U)
+#define TWR_DST_IDX           (5U)
+#define TWR_SRC_IDX           (7U)
+#define TWR_UUS_SHIFT         (16U)     // One UWB microsecond is 65536 DTU
+
+/**
+ * twr_get16() - Read a little endian 16-bit value from a frame
+ */
+static inline uint16_t twr_get16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[1] << 8U) | (uint16_t)p[0]);
+}
+
+/**
+ * twr_get32() - Read a little endian 32-bit value from a frame
+ */
+static inline uint32_t twr_get32(const uint8_t *p)
+{
+    return (((uint32_t)p[3] << 24UL) | ((uint32_t)p[2] << 16UL) | ((uint32_t)p[1] << 8UL) | (uint32_t)p[0]);
+}
+
+/**
+ * twr_put32() - Write a little endian 32-bit value into a frame
+ */
+static inline void twr_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8UL);
+    p[2] = (uint8_t)(v >> 16UL);
+    p[3] = (uint8_t)(v >> 24UL);
+}
+
+/**
+ * twr_build_header() - Write the MAC header and function code of a frame
+ *
+ * @engine: engine, frame is built in engine->frame.
+ * @seq: sequence number.
+ * @dst: destination short address.
+ * @func: function code.
+ */
+static void twr_build_header(twr_engine_t *engine, uint8_t seq, uint16_t dst, uint8_t func)
+{
+    uint8_t *f = engine->frame;
+
+    f[0] = TWR_FC_0;
+    f[1] = TWR_FC_1;
+    f[TWR_SEQ_IDX] = seq;
+    f[TWR_PAN_IDX] = (uint8_t)engine->config.pan_id;
+    f[TWR_PAN_IDX + 1U] = (uint8_t)(engine->config.pan_id >> 8U);
+    f[TWR_DST_IDX] = (uint8_t)dst;
+    f[TWR_DST_IDX + 1U] = (uint8_t)(dst >> 8U);
+    f[TWR_SRC_IDX] = (uint8_t)engine->config.address;
+    f[TWR_SRC_IDX + 1U] = (uint8_t)(engine->config.address >> 8U);
+    f[TWR_FUNC_IDX] = func;
+}
+
+/**
+ * twr_load_frame() - Make the frame built in engine->frame the next one to send
+ *
+ * @engine: engine.
+ * @which: frame template.
+ * @len: frame length, including the FCS.
+ *
+ * Only the bytes which differ from the template in the TX buffer are written.
+ */
+static void twr_load_frame(twr_engine_t *engine, twr_frame_e which, uint16_t len)
+{
+    uint8_t id = engine->tmpl[which];
+
+    (void)txtmpl_setlen(&engine->tx, id, len);
+    (void)txtmpl_patch(&engine->tx, id, 0U, engine->frame, (uint16_t)(len - FCS_LEN));
+    (void)txtmpl_select(&engine->tx, id);
+}
+
+/**
+ * twr_planned_tx() - Delayed TX time and resulting TX time stamp
+ *
+ * @engine: engine, for the TX antenna delay.
+ * @rx_ts: RX time stamp the delay is counted from.
+ * @delay: delay in DTU.
+ * @starttime: value to give to dwt_setdelayedtrxtime().
+ *
+ * Return: TX time stamp the frame will have, the device ignoring the low 9 bits of the delayed
+ *         time and adding the antenna delay.
+ */
+static ts40_t twr_planned_tx(const twr_engine_t *engine, ts40_t rx_ts, uint32_t delay, uint32_t *starttime)
+{
+    *starttime = ts40_to_delayed(ts40_add(rx_ts, delay));
+    return ts40_add(ts40_from_delayed(*starttime), engine->config.tx_antenna_delay);
+}
+
+/**
+ * twr_planned_tx_ref() - Delayed TX relative to a reference time, and resulting TX time stamp
+ *
+ * @engine: engine, for the TX antenna delay.
+ * @ref_ts: time stamp the delay is counted from.
+ * @delay: delay in DTU.
+ * @reftime: value to give to dwt_setreferencetrxtime().
+ * @dx: value to give to dwt_setdelayedtrxtime(), for DWT_START_TX_DLY_REF.
+ *
+ * Both are even, the device ignoring their bit 0, so the planned time stamp is exact.
+ *
+ * Return: TX time stamp the frame will have.
+ */
+static ts40_t twr_planned_tx_ref(const twr_engine_t *engine, ts40_t ref_ts, uint32_t delay, uint32_t *reftime, uint32_t *dx)
+{
+    *reftime = ts40_to_delayed(ref_ts) & ~1UL;
+    *dx = (delay >> TS40_DELAYED_SHIFT) & ~1UL;
+    return ts40_add(ts40_from_delayed(*reftime + *dx), engine->config.tx_antenna_delay);
+}
+
+/**
+ * twr_find_session() - Session of an exchange with a peer
+ *
+ * @engine: engine.
+ * @peer: short address of the other device.
+ * @state: state the session must be in.
+ *
+ * Return: session, or NULL if none matches.
+ */
+static twr_session_t *twr_find_session(twr_engine_t *engine, uint16_t peer, twr_state_e state)
+{
+    twr_session_t *session = NULL;
+
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        if ((engine->sessions[i].state == state) && (engine->sessions[i].peer == peer))
+        {
+            session = &engine->sessions[i];
+            break;
+        }
+    }
+    return session;
+}
+
+/**
+ * twr_alloc_session() - Allocate a session entry for an exchange with a peer
+ *
+ * @engine: engine.
+ * @peer: short address of the other device, a previous exchange with it is replaced.
+ *
+ * Return: session, or NULL if the table is full.
+ */
+static twr_session_t *twr_alloc_session(twr_engine_t *engine, uint16_t peer)
+{
+    twr_session_t *session = NULL;
+
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        twr_session_t *s = &engine->sessions[i];
+
+        if ((s->state != TWR_STATE_IDLE) && (s->peer == peer))
+        {
+            session = s;
+            break;
+        }
+        if ((session == NULL) && (s->state == TWR_STATE_IDLE))
+        {
+            session = s;
+        }
+    }
+    if (session != NULL)
+    {
+        session->peer = peer;
+    }
+    return session;
+}
+
+/**
+ * twr_waiting() - Check if an exchange is waiting for a frame
+ *
+ * @engine: engine.
+ *
+ * Return: true if a session waits for a response or a final.
+ */
+static bool twr_waiting(const twr_engine_t *engine)
+{
+    bool waiting = false;
+
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        if (engine->sessions[i].state != TWR_STATE_IDLE)
+        {
+            waiting = true;
+        }
+    }
+    return waiting;
+}
+
+/**
+ * twr_rx_timeout() - RX timeout up to the earliest end of the waits for a frame
+ *
+ * @engine: engine.
+ * @from: time the receiver is enabled at.
+ *
+ * Return: timeout in UWB microseconds, at least 1, or 0 (no timeout) if no session is waiting.
+ */
+static uint32_t twr_rx_timeout(const twr_engine_t *engine, ts40_t from)
+{
+    int64_t left = 0LL;
+    bool waiting = false;
+
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        const twr_session_t *s = &engine->sessions[i];
+
+        if ((s->state != TWR_STATE_IDLE) && (!waiting || (ts40_diff(s->deadline, from) < left)))
+        {
+            left = ts40_diff(s->deadline, from);
+            waiting = true;
+        }
+    }
+    left >>= TWR_UUS_SHIFT;
+    return waiting ? ((left > 0LL) ? (uint32_t)left : 1UL) : 0UL;
+}
+
+/**
+ * twr_expire() - End the sessions whose wait for a frame is over
+ *
+ * @engine: engine.
+ * @now: current device time.
+ *
+ * A wait is over when less than one UWB microsecond of it is left, no RX timeout is shorter.
+ */
+static void twr_expire(twr_engine_t *engine, ts40_t now)
+{
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        twr_session_t *s = &engine->sessions[i];
+
+        if ((s->state != TWR_STATE_IDLE) && ((ts40_diff(s->deadline, now) >> TWR_UUS_SHIFT) <= 0LL))
+        {
+            s->state = TWR_STATE_IDLE;
+        }
+    }
+}
+
+/**
+ * twr_latch_poll_tx() - Initiator: read the TX time stamp of the last poll sent
+ *
+ * @engine: engine.
+ *
+ * Called on the TX done event of the poll, or at the latest on the next RX event, before another TX
+ * overwrites the TX time stamp. The session then waits for its response up to the end of its RX
+ * window, counted from the poll.
+ */
+static void twr_latch_poll_tx(twr_engine_t *engine)
+{
+    twr_session_t *session;
+    uint8_t ts[TS40_LEN];
+
+    if (engine->poll_pending != 0U)
+    {
+        session = &engine->sessions[engine->poll_pending - 1U];
+        engine->poll_pending = 0U;
+        dwt_readtxtimestamp(ts);
+        session->poll_tx = ts40_load(ts);
+        session->deadline = ts40_add(session->poll_tx, (uint64_t)(engine->config.poll_tx_to_resp_rx_dly_uus + engine->config.rx_timeout_uus)
+                                                           << TWR_UUS_SHIFT);
+    }
+}
+
+/**
+ * twr_rx_resume() - Re-enable the receiver after a frame which did not start a TX
+ *
+ * @engine: engine.
+ *
+ * Sessions waiting for a frame are given the rest of their wait, not a new RX timeout.
+ */
+static void twr_rx_resume(twr_engine_t *engine)
+{
+    uint8_t ts[TS40_SYSTIME_LEN];
+
+    if (twr_waiting(engine))
+    {
+        dwt_readsystime(ts);
+        dwt_setrxtimeout(twr_rx_timeout(engine, ts40_load_systime(ts)));
+        (void)dwt_rxenable((int32_t)DWT_START_RX_IMMEDIATE);
+    }
+    else if (engine->listening != 0U)
+    {
+        (void)twr_listen(engine);
+    }
+    else
+    {
+        // Nothing to receive
+    }
+}
+
+/**
+ * twr_send_resp() - Responder: answer a poll with a delayed response
+ *
+ * @engine: engine.
+ * @session: session of the exchange.
+ *
+ * Return: true if the response TX was started.
+ */
+static bool twr_send_resp(twr_engine_t *engine, twr_session_t *session)
+{
+    uint32_t starttime;
+    bool started = false;
+
+    session->resp_tx = twr_planned_tx(engine, session->poll_rx, engine->config.poll_rx_to_resp_tx_dly, &starttime);
+    twr_build_header(engine, session->seq, session->peer, TWR_FUNC_RESP);
+
+    twr_load_frame(engine, TWR_FRAME_RESP, (uint16_t)TWR_RESP_LEN);
+    dwt_setdelayedtrxtime(starttime);
+    dwt_setrxaftertxdelay(engine->config.resp_tx_to_final_rx_dly_uus);
+    dwt_setrxtimeout(engine->config.rx_timeout_uus);
+    session->deadline = ts40_add(session->resp_tx, (uint64_t)(engine->config.resp_tx_to_final_rx_dly_uus + engine->config.rx_timeout_uus)
+                                                       << TWR_UUS_SHIFT);
+
+    if (dwt_starttx((uint8_t)DWT_START_TX_DELAYED | (uint8_t)DWT_RESPONSE_EXPECTED) == (int32_t)DWT_SUCCESS)
+    {
+        session->state = TWR_STATE_RESP_SENT;
+        started = true;
+    }
+    return started;
+}
+
+/**
+ * twr_send_final() - Initiator: send the final with the exchange time stamps
+ *
+ * @engine: engine.
+ * @session: session of the exchange, already ended.
+ *
+ * The receiver is enabled after the TX if other sessions wait for a frame or the engine listens.
+ *
+ * Return: true if the final TX was started.
+ */
+static bool twr_send_final(twr_engine_t *engine, const twr_session_t *session)
+{
+    uint32_t starttime;
+    uint8_t mode = (uint8_t)DWT_START_TX_DELAYED;
+    ts40_t final_tx;
+
+    final_tx = twr_planned_tx(engine, session->resp_rx, engine->config.resp_rx_to_final_tx_dly, &starttime);
+
+    twr_build_header(engine, session->seq, session->peer, TWR_FUNC_FINAL);
+    twr_put32(&engine->frame[TWR_FINAL_POLL_TX_IDX], (uint32_t)session->poll_tx);
+    twr_put32(&engine->frame[TWR_FINAL_RESP_RX_IDX], (uint32_t)session->resp_rx);
+    twr_put32(&engine->frame[TWR_FINAL_FINAL_TX_IDX], (uint32_t)final_tx);
+
+    twr_load_frame(engine, TWR_FRAME_FINAL, (uint16_t)TWR_FINAL_LEN);
+    dwt_setdelayedtrxtime(starttime);
+    if (twr_waiting(engine) || (engine->listening != 0U))
+    {
+        dwt_setrxaftertxdelay(0UL);
+        dwt_setrxtimeout(twr_rx_timeout(engine, final_tx));
+        mode |= (uint8_t)DWT_RESPONSE_EXPECTED;
+    }
+
+    return (dwt_starttx(mode) == (int32_t)DWT_SUCCESS);
+}
+
+/**
+ * twr_multi_slot() - Responder: slot of this device in a multi-responder poll
+ *
+ * @engine: engine, poll in engine->frame.
+ * @len: received frame length.
+ * @count: number of responders in the poll.
+ *
+ * Return: slot, or TWR_MULTI_MAX if the poll is malformed or does not list this device.
+ */
+static uint8_t twr_multi_slot(const twr_engine_t *engine, uint16_t len, uint8_t *count)
+{
+    const uint8_t *f = engine->frame;
+    uint8_t slot = (uint8_t)TWR_MULTI_MAX;
+
+    *count = f[TWR_MPOLL_COUNT_IDX];
+    if ((*count > 0U) && (*count <= TWR_MULTI_MAX) && (len == (uint16_t)TWR_MPOLL_LEN(*count)))
+    {
+        for (uint8_t i = 0U; i < *count; i++)
+        {
+            if (twr_get16(&f[TWR_MPOLL_ADDR_IDX + (2U * i)]) == engine->config.address)
+            {
+                slot = i;
+                break;
+            }
+        }
+    }
+    return slot;
+}
+
+/**
+ * twr_send_multi_resp() - Responder: answer a multi-responder poll in its slot
+ *
+ * @engine: engine.
+ * @session: session of the exchange, with its slot.
+ * @count: number of responders in the poll.
+ *
+ * The slot TX time is given relative to the poll RX time with DWT_START_TX_DLY_REF. The receiver
+ * is enabled for the final, which comes after the slots of the following responders.
+ *
+ * Return: true if the response TX was started.
+ */
+static bool twr_send_multi_resp(twr_engine_t *engine, twr_session_t *session, uint8_t count)
+{
+    uint32_t slot_dly = (uint32_t)session->slot * (engine->config.slot_uus << TWR_UUS_SHIFT);
+    uint32_t rx_dly_uus = engine->config.resp_tx_to_final_rx_dly_uus + ((uint32_t)(count - 1U - session->slot) * engine->config.slot_uus);
+    uint32_t reftime;
+    uint32_t dx;
+    bool started = false;
+
+    session->resp_tx = twr_planned_tx_ref(engine, session->poll_rx, engine->config.poll_rx_to_resp_tx_dly + slot_dly, &reftime, &dx);
+    twr_build_header(engine, session->seq, session->peer, TWR_FUNC_RESP);
+
+    twr_load_frame(engine, TWR_FRAME_RESP, (uint16_t)TWR_RESP_LEN);
+    dwt_setreferencetrxtime(reftime);
+    dwt_setdelayedtrxtime(dx);
+    dwt_setrxaftertxdelay(rx_dly_uus);
+    dwt_setrxtimeout(engine->config.rx_timeout_uus);
+    session->deadline = ts40_add(session->resp_tx, (uint64_t)(rx_dly_uus + engine->config.rx_timeout_uus) << TWR_UUS_SHIFT);
+
+    if (dwt_starttx((uint8_t)DWT_START_TX_DLY_REF | (uint8_t)DWT_RESPONSE_EXPECTED) == (int32_t)DWT_SUCCESS)
+    {
+        session->state = TWR_STATE_RESP_SENT;
+        started = true;
+    }
+    return started;
+}
+
+/**
+ * twr_multi_final() - Initiator: end the collection of a multi-responder exchange
+ *
+ * @engine: engine.
+ *
+ * The final is sent at its planned time after the last slot, relative to the poll TX time, with the
+ * RX time stamps of the responses received. Nothing is sent if no response was received.
+ */
+static void twr_multi_final(twr_engine_t *engine)
+{
+    twr_multi_t *m = &engine->multi;
+    uint8_t *f = engine->frame;
+    uint32_t reftime;
+    uint32_t dx;
+    ts40_t final_tx;
+
+    m->active = 0U;
+    dwt_setdblrxbuffmode(DBL_BUF_STATE_DIS, DBL_BUF_MODE_MAN);
+
+    if (m->received != 0U)
+    {
+        final_tx = twr_planned_tx_ref(engine, m->poll_tx,
+                                      engine->config.poll_rx_to_resp_tx_dly + ((uint32_t)(m->count - 1U) * (engine->config.slot_uus << TWR_UUS_SHIFT))
+                                          + engine->config.resp_rx_to_final_tx_dly,
+                                      &reftime, &dx);
+
+        twr_build_header(engine, m->seq, TWR_BROADCAST, TWR_FUNC_MFINAL);
+        f[TWR_MFINAL_COUNT_IDX] = m->count;
+        f[TWR_MFINAL_MASK_IDX] = m->received;
+        twr_put32(&f[TWR_MFINAL_POLL_TX_IDX], (uint32_t)m->poll_tx);
+        twr_put32(&f[TWR_MFINAL_FINAL_TX_IDX], (uint32_t)final_tx);
+        for (uint8_t i = 0U; i < m->count; i++)
+        {
+            // Slots not received are zeroed, their bit in the mask is clear
+            twr_put32(&f[TWR_MFINAL_RESP_RX_IDX + (4U * i)], (uint32_t)m->resp_rx[i]);
+        }
+
+        twr_load_frame(engine, TWR_FRAME_MFINAL, (uint16_t)TWR_MFINAL_LEN(m->count));
+        dwt_setreferencetrxtime(reftime);
+        dwt_setdelayedtrxtime(dx);
+        (void)dwt_starttx((uint8_t)DWT_START_TX_DLY_REF);
+    }
+}
+
+/**
+ * twr_multi_resume() - Initiator: keep receiving until the end of the RX window
+ *
+ * @engine: engine.
+ * @now: current device time.
+ *
+ * Return: true if the receiver was enabled, false if the window is over.
+ */
+static bool twr_multi_resume(twr_engine_t *engine, ts40_t now)
+{
+    int64_t left = ts40_diff(engine->multi.window_end, now);
+    bool resumed = false;
+
+    if ((left >> TWR_UUS_SHIFT) > 0LL)
+    {
+        dwt_setrxtimeout((uint32_t)(left >> TWR_UUS_SHIFT));
+        resumed = (dwt_rxenable((int32_t)DWT_START_RX_IMMEDIATE) == (int32_t)DWT_SUCCESS);
+    }
+    return resumed;
+}
+
+/**
+ * twr_multi_start_window() - Initiator: read the poll TX time stamp on the first RX event
+ *
+ * @engine: engine.
+ */
+static void twr_multi_start_window(twr_engine_t *engine)
+{
+    twr_multi_t *m = &engine->multi;
+    uint8_t ts[TS40_LEN];
+
+    if (m->window_end == 0ULL)
+    {
+        dwt_readtxtimestamp(ts);
+        m->poll_tx = ts40_load(ts);
+        m->window_end = ts40_add(m->poll_tx, (uint64_t)(engine->config.poll_tx_to_resp_rx_dly_uus + engine->config.rx_timeout_uus
+                                                        + ((uint32_t)(m->count - 1U) * engine->config.slot_uus)) << TWR_UUS_SHIFT);
+    }
+}
+
+/**
+ * twr_multi_rx() - Initiator: process a frame received during the response slots
+ *
+ * @engine: engine.
+ * @len: received frame length.
+ *
+ * Unless this frame can be the last response, the receiver is enabled again, into the other buffer,
+ * before the frame is read.
+ */
+static void twr_multi_rx(twr_engine_t *engine, uint16_t len)
+{
+    twr_multi_t *m = &engine->multi;
+    const uint8_t *f = engine->frame;
+    uint8_t ts[TS40_LEN];
+    ts40_t rx_ts;
+    uint8_t all = (uint8_t)((1UL << m->count) - 1UL);
+    uint8_t missing = all & (uint8_t)~m->received;
+    bool resumed = false;
+
+    twr_multi_start_window(engine);
+    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+    rx_ts = ts40_load(ts);
+
+    if ((missing & (uint8_t)(missing - 1U)) != 0U)
+    {
+        resumed = twr_multi_resume(engine, rx_ts);
+    }
+
+    if (len == (uint16_t)TWR_RESP_LEN)
+    {
+        dwt_readrxdata(engine->frame, (uint16_t)(len - FCS_LEN), 0U);
+
+        if ((f[0] == TWR_FC_0) && (f[1] == TWR_FC_1) && (twr_get16(&f[TWR_PAN_IDX]) == engine->config.pan_id)
+            && (twr_get16(&f[TWR_DST_IDX]) == engine->config.address) && (f[TWR_FUNC_IDX] == TWR_FUNC_RESP)
+            && (f[TWR_SEQ_IDX] == m->seq))
+        {
+            for (uint8_t i = 0U; i < m->count; i++)
+            {
+                if (m->peers[i] == twr_get16(&f[TWR_SRC_IDX]))
+                {
+                    m->resp_rx[i] = rx_ts;
+                    m->received |= (uint8_t)(1U << i);
+                }
+            }
+        }
+    }
+
+    if ((m->received != all) && !resumed)
+    {
+        resumed = twr_multi_resume(engine, rx_ts);
+    }
+
+    if (m->received == all)
+    {
+        if (resumed)
+        {
+            dwt_forcetrxoff();
+        }
+        twr_multi_final(engine);
+    }
+    else if (!resumed)
+    {
+        // End of the RX window
+        twr_multi_final(engine);
+    }
+    else
+    {
+        // Waiting for the next slots
+    }
+}
+
+/**
+ * twr_send_ss_resp() - Single-sided responder: answer a poll with its RX and planned TX time stamps
+ *
+ * @engine: engine.
+ * @peer: short address of the initiator.
+ * @seq: sequence number of the poll.
+ * @poll_rx: RX time stamp of the poll.
+ *
+ * Nothing more is expected from the initiator, a listening responder goes on listening after the TX.
+ *
+ * Return: true if the response TX was started.
+ */
+static bool twr_send_ss_resp(twr_engine_t *engine, uint16_t peer, uint8_t seq, ts40_t poll_rx)
+{
+    uint32_t starttime;
+    ts40_t resp_tx = twr_planned_tx(engine, poll_rx, engine->config.poll_rx_to_resp_tx_dly, &starttime);
+
+    twr_build_header(engine, seq, peer, TWR_FUNC_SS_RESP);
+    twr_put32(&engine->frame[TWR_SS_POLL_RX_IDX], (uint32_t)poll_rx);
+    twr_put32(&engine->frame[TWR_SS_RESP_TX_IDX], (uint32_t)resp_tx);
+
+    twr_load_frame(engine, TWR_FRAME_SS_RESP, (uint16_t)TWR_SS_RESP_LEN);
+    dwt_setdelayedtrxtime(starttime);
+    dwt_setrxaftertxdelay(0UL);
+    dwt_setrxtimeout(0UL);
+
+    return (dwt_starttx((uint8_t)DWT_START_TX_DELAYED | (uint8_t)DWT_RESPONSE_EXPECTED) == (int32_t)DWT_SUCCESS);
+}
+
+/**
+ * twr_ss_range() - Single-sided initiator: compute the range from the response
+ *
+ * @engine: engine, response in engine->frame.
+ * @session: session of the exchange, with the TX time stamp of its poll.
+ *
+ * The RX time stamp and the clock offset are read together, the carrier integrator is read after
+ * them if configured.
+ */
+static void twr_ss_range(twr_engine_t *engine, const twr_session_t *session)
+{
+    const uint8_t *f = engine->frame;
+    uint8_t ts[TS40_LEN];
+    ts40_t resp_rx;
+    int32_t offset;
+    twr_result_t result;
+
+    offset = (int32_t)dwt_readrxtimestamp_clkoffset(ts) * 64L;
+    resp_rx = ts40_load(ts);
+    if (engine->config.ss_clock_offset == TWR_CLKOFS_CARRIER_CH5)
+    {
+        // 2^32 * FREQ_OFFSET_MULTIPLIER * HERTZ_TO_PPM_MULTIPLIER_CHAN_5 / 1e6 = -32 / 13
+        offset = -(dwt_readcarrierintegrator() * 32L) / 13L;
+    }
+    else if (engine->config.ss_clock_offset == TWR_CLKOFS_CARRIER_CH9)
+    {
+        // 2^32 * FREQ_OFFSET_MULTIPLIER * HERTZ_TO_PPM_MULTIPLIER_CHAN_9 / 1e6 = -2
+        offset = -dwt_readcarrierintegrator() * 2L;
+    }
+    else
+    {
+        // CIA estimate, in units of 2^-26
+    }
+
+    result.peer = session->peer;
+    result.seq = session->seq;
+    result.tof_dtu = twr_compute_ss_tof((uint32_t)ts40_sub(resp_rx, session->poll_tx),
+                                       twr_get32(&f[TWR_SS_RESP_TX_IDX]) - twr_get32(&f[TWR_SS_POLL_RX_IDX]), offset);
+    result.distance_mm = twr_tof_to_mm(result.tof_dtu);
+
+    if (engine->config.result_cb != NULL)
+    {
+        engine->config.result_cb(&result);
+    }
+}
+
+/**
+ * twr_range() - Responder: compute the range of a completed exchange
+ *
+ * @engine: engine.
+ * @session: session of the exchange.
+ * @poll_tx: initiator time stamps given in the final, low 32 bits.
+ * @resp_rx:
+ * @final_tx:
+ * @final_rx: RX time stamp of the final.
+ */
+static void twr_range(twr_engine_t *engine, const twr_session_t *session, uint32_t poll_tx, uint32_t resp_rx,
+                      uint32_t final_tx, ts40_t final_rx)
+{
+    twr_result_t result;
+
+    result.peer = session->peer;
+    result.seq = session->seq;
+    result.tof_dtu = twr_compute_tof(resp_rx - poll_tx, final_tx - resp_rx,
+                                     (uint32_t)ts40_sub(final_rx, session->resp_tx),
+                                     (uint32_t)ts40_sub(session->resp_tx, session->poll_rx));
+    result.distance_mm = twr_tof_to_mm(result.tof_dtu);
+
+    if (engine->config.result_cb != NULL)
+    {
+        engine->config.result_cb(&result);
+    }
+}
+
+void twr_init(twr_engine_t *engine, const twr_config_t *config)
+{
+    engine->config = *config;
+    for (uint32_t i = 0UL; i < TWR_SESSION_MAX; i++)
+    {
+        engine->sessions[i].state = TWR_STATE_IDLE;
+    }
+    engine->seq = 0U;
+    engine->listening = 0U;
+    engine->poll_pending = 0U;
+    engine->multi.active = 0U;
+
+    // Stage the frames with what does not change between exchanges, time stamps are zeroed
+    for (uint32_t i = 0UL; i < TWR_FRAME_MAX; i++)
+    {
+        engine->frame[i] = 0U;
+    }
+    txtmpl_init(&engine->tx, 0U);
+    twr_build_header(engine, 0U, 0U, TWR_FUNC_POLL);
+    engine->tmpl[TWR_FRAME_POLL] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_POLL_LEN, 1U);
+    twr_build_header(engine, 0U, 0U, TWR_FUNC_RESP);
+    engine->tmpl[TWR_FRAME_RESP] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_RESP_LEN, 1U);
+    twr_build_header(engine, 0U, 0U, TWR_FUNC_FINAL);
+    engine->tmpl[TWR_FRAME_FINAL] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_FINAL_LEN, 1U);
+    twr_build_header(engine, 0U, TWR_BROADCAST, TWR_FUNC_MPOLL);
+    engine->tmpl[TWR_FRAME_MPOLL] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_MPOLL_LEN(TWR_MULTI_MAX), 1U);
+    twr_build_header(engine, 0U, TWR_BROADCAST, TWR_FUNC_MFINAL);
+    engine->tmpl[TWR_FRAME_MFINAL] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_MFINAL_LEN(TWR_MULTI_MAX), 1U);
+    twr_build_header(engine, 0U, 0U, TWR_FUNC_SS_RESP);
+    engine->tmpl[TWR_FRAME_SS_RESP] = (uint8_t)txtmpl_add(&engine->tx, engine->frame, (uint16_t)TWR_SS_RESP_LEN, 1U);
+}
+
+/**
+ * twr_send_poll() - Initiator: start an exchange with a poll
+ *
+ * @engine: engine.
+ * @peer: short address of the responder.
+ * @func: function code of the poll.
+ * @state: state of the session once the poll is sent.
+ *
+ * The TX time stamp of the poll is read by twr_latch_poll_tx(), no other poll is sent until then.
+ *
+ * Return: DWT_SUCCESS, or DWT_ERROR if the previous poll is pending, the session table is full or the
+ *         TX could not start.
+ */
+static int32_t twr_send_poll(twr_engine_t *engine, uint16_t peer, uint8_t func, twr_state_e state)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    twr_session_t *session = NULL;
+
+    if ((engine->poll_pending == 0U) && (engine->multi.active == 0U))
+    {
+        session = twr_alloc_session(engine, peer);
+    }
+
+    if (session != NULL)
+    {
+        session->role = TWR_ROLE_INITIATOR;
+        session->seq = engine->seq;
+        engine->seq++;
+
+        twr_build_header(engine, session->seq, peer, func);
+        twr_load_frame(engine, TWR_FRAME_POLL, (uint16_t)TWR_POLL_LEN);
+        dwt_setrxaftertxdelay(engine->config.poll_tx_to_resp_rx_dly_uus);
+        dwt_setrxtimeout(engine->config.rx_timeout_uus);
+        engine->poll_pending = (uint8_t)(session - engine->sessions) + 1U;
+
+        if (dwt_starttx((uint8_t)DWT_START_TX_IMMEDIATE | (uint8_t)DWT_RESPONSE_EXPECTED) == (int32_t)DWT_SUCCESS)
+        {
+            session->state = state;
+            ret = (int32_t)DWT_SUCCESS;
+        }
+        else
+        {
+            session->state = TWR_STATE_IDLE;
+            engine->poll_pending = 0U;
+        }
+    }
+    return ret;
+}
+
+int32_t twr_initiate(twr_engine_t *engine, uint16_t peer)
+{
+    return twr_send_poll(engine, peer, TWR_FUNC_POLL, TWR_STATE_POLL_SENT);
+}
+
+int32_t twr_initiate_ss(twr_engine_t *engine, uint16_t peer)
+{
+    return twr_send_poll(engine, peer, TWR_FUNC_SS_POLL, TWR_STATE_SS_POLL_SENT);
+}
+
+int32_t twr_initiate_multi(twr_engine_t *engine, const uint16_t *peers, uint8_t count)
+{
+    twr_multi_t *m = &engine->multi;
+    uint8_t *f = engine->frame;
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((m->active == 0U) && (engine->poll_pending == 0U) && (count > 0U) && (count <= TWR_MULTI_MAX))
+    {
+        m->seq = engine->seq;
+        engine->seq++;
+        m->count = count;
+        m->received = 0U;
+        m->window_end = 0ULL;
+
+        twr_build_header(engine, m->seq, TWR_BROADCAST, TWR_FUNC_MPOLL);
+        f[TWR_MPOLL_COUNT_IDX] = count;
+        for (uint8_t i = 0U; i < count; i++)
+        {
+            m->peers[i] = peers[i];
+            m->resp_rx[i] = 0ULL;
+            f[TWR_MPOLL_ADDR_IDX + (2U * i)] = (uint8_t)peers[i];
+            f[TWR_MPOLL_ADDR_IDX + (2U * i) + 1U] = (uint8_t)(peers[i] >> 8U);
+        }
+
+        twr_load_frame(engine, TWR_FRAME_MPOLL, (uint16_t)TWR_MPOLL_LEN(count));
+        dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN);
+        dwt_setrxaftertxdelay(engine->config.poll_tx_to_resp_rx_dly_uus);
+        dwt_setrxtimeout(engine->config.rx_timeout_uus + ((uint32_t)(count - 1U) * engine->config.slot_uus));
+
+        if (dwt_starttx((uint8_t)DWT_START_TX_IMMEDIATE | (uint8_t)DWT_RESPONSE_EXPECTED) == (int32_t)DWT_SUCCESS)
+        {
+            m->active = 1U;
+            ret = (int32_t)DWT_SUCCESS;
+        }
+        else
+        {
+            dwt_setdblrxbuffmode(DBL_BUF_STATE_DIS, DBL_BUF_MODE_MAN);
+        }
+    }
+    return ret;
+}
+
+int32_t twr_listen(twr_engine_t *engine)
+{
+    engine->listening = 1U;
+    dwt_setrxtimeout(0UL);
+    return dwt_rxenable((int32_t)DWT_START_RX_IMMEDIATE);
+}
+
+void twr_tx_done_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data)
+{
+    (void)cb_data;
+
+    twr_latch_poll_tx(engine);
+    if (engine->multi.active != 0U)
+    {
+        twr_multi_start_window(engine);
+    }
+}
+
+void twr_rx_ok_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data)
+{
+    const uint8_t *f = engine->frame;
+    twr_session_t *session;
+    uint8_t ts[TS40_LEN];
+    uint16_t len = cb_data->datalength;
+    uint8_t count;
+    bool started = false;
+
+    twr_latch_poll_tx(engine);
+    if (engine->multi.active != 0U)
+    {
+        twr_multi_rx(engine, len);
+        started = true;
+    }
+    else if ((len >= (uint16_t)TWR_POLL_LEN) && (len <= (uint16_t)TWR_FRAME_MAX))
+    {
+        dwt_readrxdata(engine->frame, (uint16_t)(len - FCS_LEN), 0U);
+
+        if ((f[0] == TWR_FC_0) && (f[1] == TWR_FC_1) && (twr_get16(&f[TWR_PAN_IDX]) == engine->config.pan_id)
+            && ((twr_get16(&f[TWR_DST_IDX]) == engine->config.address) || (twr_get16(&f[TWR_DST_IDX]) == TWR_BROADCAST)))
+        {
+            uint16_t src = twr_get16(&f[TWR_SRC_IDX]);
+            uint8_t seq = f[TWR_SEQ_IDX];
+
+            switch (f[TWR_FUNC_IDX])
+            {
+            case TWR_FUNC_POLL:
+                session = (engine->listening != 0U) ? twr_alloc_session(engine, src) : NULL;
+                if (session != NULL)
+                {
+                    session->role = TWR_ROLE_RESPONDER;
+                    session->seq = seq;
+                    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                    session->poll_rx = ts40_load(ts);
+                    started = twr_send_resp(engine, session);
+                    if (!started)
+                    {
+                        session->state = TWR_STATE_IDLE;
+                    }
+                }
+                break;
+            case TWR_FUNC_RESP:
+                session = twr_find_session(engine, src, TWR_STATE_POLL_SENT);
+                if ((session != NULL) && (session->seq == seq))
+                {
+                    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                    session->resp_rx = ts40_load(ts);
+                    // Nothing more is expected by the initiator, the exchange is complete once the final is sent
+                    session->state = TWR_STATE_IDLE;
+                    started = twr_send_final(engine, session);
+                }
+                break;
+            case TWR_FUNC_FINAL:
+                session = twr_find_session(engine, src, TWR_STATE_RESP_SENT);
+                if ((session != NULL) && (session->seq == seq) && (len == (uint16_t)TWR_FINAL_LEN))
+                {
+                    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                    twr_range(engine, session, twr_get32(&f[TWR_FINAL_POLL_TX_IDX]), twr_get32(&f[TWR_FINAL_RESP_RX_IDX]),
+                              twr_get32(&f[TWR_FINAL_FINAL_TX_IDX]), ts40_load(ts));
+                    session->state = TWR_STATE_IDLE;
+                }
+                break;
+            case TWR_FUNC_SS_POLL:
+                if (engine->listening != 0U)
+                {
+                    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                    started = twr_send_ss_resp(engine, src, seq, ts40_load(ts));
+                }
+                break;
+            case TWR_FUNC_SS_RESP:
+                session = twr_find_session(engine, src, TWR_STATE_SS_POLL_SENT);
+                if ((session != NULL) && (session->seq == seq) && (len == (uint16_t)TWR_SS_RESP_LEN))
+                {
+                    twr_ss_range(engine, session);
+                    session->state = TWR_STATE_IDLE;
+                }
+                break;
+            case TWR_FUNC_MPOLL:
+                session = NULL;
+                if (engine->listening != 0U)
+                {
+                    uint8_t slot = twr_multi_slot(engine, len, &count);
+
+                    session = (slot < TWR_MULTI_MAX) ? twr_alloc_session(engine, src) : NULL;
+                    if (session != NULL)
+                    {
+                        session->slot = slot;
+                    }
+                }
+                if (session != NULL)
+                {
+                    session->role = TWR_ROLE_RESPONDER;
+                    session->seq = seq;
+                    dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                    session->poll_rx = ts40_load(ts);
+                    started = twr_send_multi_resp(engine, session, count);
+                    if (!started)
+                    {
+                        session->state = TWR_STATE_IDLE;
+                    }
+                }
+                break;
+            case TWR_FUNC_MFINAL:
+                session = twr_find_session(engine, src, TWR_STATE_RESP_SENT);
+                count = f[TWR_MFINAL_COUNT_IDX];
+                if ((session != NULL) && (session->seq == seq) && (session->slot < count) && (count <= TWR_MULTI_MAX)
+                    && (len == (uint16_t)TWR_MFINAL_LEN(count)))
+                {
+                    // The initiator may have missed the response of this device
+                    if ((f[TWR_MFINAL_MASK_IDX] & (1U << session->slot)) != 0U)
+                    {
+                        dwt_readrxtimestamp(ts, DWT_COMPAT_NONE);
+                        twr_range(engine, session, twr_get32(&f[TWR_MFINAL_POLL_TX_IDX]),
+                                  twr_get32(&f[TWR_MFINAL_RESP_RX_IDX + (4U * session->slot)]), twr_get32(&f[TWR_MFINAL_FINAL_TX_IDX]),
+                                  ts40_load(ts));
+                    }
+                    session->state = TWR_STATE_IDLE;
+                }
+                break;
+            default:
+                // Not a ranging frame
+                break;
+            }
+        }
+    }
+
+    if (!started)
+    {
+        twr_rx_resume(engine);
+    }
+}
+
+void twr_rx_error_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data)
+{
+    uint8_t ts[TS40_SYSTIME_LEN];
+
+    twr_latch_poll_tx(engine);
+    if (engine->multi.active != 0U)
+    {
+        // A bad frame in a slot does not end the collection, a timeout ends the RX window
+        twr_multi_start_window(engine);
+        if ((cb_data->status & ((uint32_t)DWT_INT_RXFTO_BIT_MASK | (uint32_t)DWT_INT_RXPTO_BIT_MASK)) != 0UL)
+        {
+            twr_multi_final(engine);
+        }
+        else
+        {
+            dwt_readsystime(ts);
+            if (!twr_multi_resume(engine, ts40_load_systime(ts)))
+            {
+                twr_multi_final(engine);
+            }
+        }
+    }
+    else
+    {
+        // Only the exchanges whose wait is over end, the others go on receiving
+        dwt_readsystime(ts);
+        twr_expire(engine, ts40_load_systime(ts));
+        twr_rx_resume(engine);
+    }
+}
+
+int32_t twr_compute_tof(uint32_t round_a, uint32_t reply_a, uint32_t round_b, uint32_t reply_b)
+{
+    /* Products of 32-bit durations fit in 64 bits, keep them unsigned and handle the sign of their difference. */
+    uint64_t rounds = (uint64_t)round_a * round_b;
+    uint64_t replies = (uint64_t)reply_a * reply_b;
+    uint64_t sum = (uint64_t)round_a + round_b + reply_a + reply_b;
+    int32_t tof = 0L;
+
+    if (sum != 0ULL)
+    {
+        if (rounds >= replies)
+        {
+            tof = (int32_t)((rounds - replies) / sum);
+        }
+        else
+        {
+            tof = -(int32_t)((replies - rounds) / sum);
+        }
+    }
+    return tof;
+}
+
+int32_t twr_compute_ss_tof(uint32_t round, uint32_t reply, int32_t offset_q32)
+{
+    /* The reply time in local DTU is reply * (1 - offset), the correction is below 2^50 */
+    int64_t correction = ((int64_t)reply * offset_q32) / (int64_t)(1LL << 32);
+
+    return (int32_t)(((int64_t)round - (int64_t)reply + correction) / 2LL);
+}
+
+int32_t twr_tof_to_mm(int32_t tof_dtu)
+{
+    /* mm = tof * c * 1000 / TS40_DTU_PER_S, simplified by 1000 to stay within 64 bits */
+    return (int32_t)(((int64_t)tof_dtu * TWR_SPEED_OF_LIGHT) / (int64_t)(TS40_DTU_PER_S / 1000ULL));
+}
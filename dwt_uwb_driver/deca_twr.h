@@ -0,0 +1,353 @@
+/**
+ * @file:     deca_twr.h
+ *
+ * @brief     Double-sided two-way ranging (DS-TWR) engine
+ *
+ *            Three messages exchange, IEEE 802.15.4 data frames with short addresses:
+ *
+ *              Initiator                         Responder
+ *                 | ---- Poll ---------------------> |   poll_tx / poll_rx
+ *                 | <--------------------- Resp ---- |   resp_rx / resp_tx  (delayed TX)
+ *                 | ---- Final (poll_tx, resp_rx, -> |   final_tx / final_rx (delayed TX)
+ *                 |             final_tx)            |
+ *
+ *            The responder computes the time of flight with the asymmetric formula:
+ *              tof = (Ra * Rb - Da * Db) / (Ra + Rb + Da + Db)
+ *              Ra = resp_rx - poll_tx, Db = resp_tx - poll_rx, Rb = final_rx - resp_tx, Da = final_tx - resp_rx
+ *
+ *            Delayed TX times are computed from RX time stamps, so the TX time stamps of
+ *            responses and finals are known before transmission and embedded in the frames
+ *            without reading them back. The engine is driven from the driver event callbacks
+ *            (see dwt_setcallbacks()): the application calls twr_tx_done_handler(), twr_rx_ok_handler()
+ *            and twr_rx_error_handler() from its TX confirmation, RX good frame and RX timeout/error
+ *            callbacks.
+ *
+ *            Each session waits for its response or final up to the end of its own RX window, sessions
+ *            in progress with several peers share the receiver until then. The TX time stamp of a poll
+ *            is read on its TX done event, or at the latest on the next RX event, and another poll can
+ *            only be sent after it.
+ *
+ *            Multi-responder mode (twr_initiate_multi()): one broadcast poll lists up to
+ *            TWR_MULTI_MAX responders, which answer in that order in slots of slot_uus, and one
+ *            broadcast final carries the response RX time stamps of all of them:
+ *
+ *              Initiator                       Responders 0..N-1
+ *                 | ---- Poll (list) ------------> |   poll_rx + poll_rx_to_resp_tx_dly + i * slot
+ *                 | <------------------ Resp 0 --- |
+ *                 | <------------------ Resp i --- |   receiver kept on, double buffered
+ *                 | ---- Final (resp_rx[0..N-1]) > |   each responder computes its own range
+ *
+ *            so N ranges take N + 2 frames instead of 3 * N. All devices must use the same
+ *            poll_rx_to_resp_tx_dly, resp_rx_to_final_tx_dly and slot_uus, and the initiator
+ *            RX window (poll_tx_to_resp_rx_dly_uus + rx_timeout_uus + (N - 1) * slot_uus) must end
+ *            before the final TX time (poll_rx_to_resp_tx_dly + (N - 1) * slot + resp_rx_to_final_tx_dly).
+ *
+ *            Single-sided mode (twr_initiate_ss()): two messages, the response carries the responder
+ *            poll_rx and resp_tx, and the initiator computes the range:
+ *              tof = (Ra - Db * (1 - offset)) / 2
+ *            where offset is the clock offset of the responder measured on the response, read with
+ *            its RX time stamp. The correction removes the error of the crystal offset on the reply
+ *            time, which otherwise dominates (1 ppm on a 300 us reply is 4.5 cm).
+ *
+ *            The poll, response and final frames are kept in the TX buffer as templates (see
+ *            deca_txtemplate.h), from offset 0 to 126. After sleep, or if the application sends
+ *            other frames, it must call txtmpl_invalidate(&engine->tx) before the next exchange. Clock
+ *            sync frames (see csync_init()) can be sent from &engine->tx instead.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_TWR_H_
+#define DECA_TWR_H_
+
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+#include "deca_txtemplate.h"
+
+#ifndef TWR_SESSION_MAX
+#define TWR_SESSION_MAX         (4U)         // Number of ranging exchanges that can be in progress at a time
+#endif
+
+#define TWR_FUNC_POLL           (0x21U)      // Function codes of the exchanged frames
+#define TWR_FUNC_RESP           (0x10U)
+#define TWR_FUNC_FINAL          (0x23U)
+#define TWR_FUNC_MPOLL          (0x24U)
+#define TWR_FUNC_MFINAL         (0x25U)
+#define TWR_FUNC_SS_POLL        (0xE0U)
+#define TWR_FUNC_SS_RESP        (0xE1U)
+
+#ifndef TWR_MULTI_MAX
+#define TWR_MULTI_MAX           (6U)         // Largest number of responders to a multi-responder poll, up to 8
+#endif
+
+#define TWR_BROADCAST           (0xFFFFU)    // Destination address of multi-responder polls and finals
+
+#define TWR_HDR_LEN             (9U)         // Frame control, sequence number, PAN ID, destination, source
+#define TWR_FUNC_IDX            (TWR_HDR_LEN)
+#define TWR_FINAL_POLL_TX_IDX   (TWR_FUNC_IDX + 1U)
+#define TWR_FINAL_RESP_RX_IDX   (TWR_FINAL_POLL_TX_IDX + 4U)
+#define TWR_FINAL_FINAL_TX_IDX  (TWR_FINAL_RESP_RX_IDX + 4U)
+#define TWR_MPOLL_COUNT_IDX     (TWR_FUNC_IDX + 1U)
+#define TWR_MPOLL_ADDR_IDX      (TWR_MPOLL_COUNT_IDX + 1U)
+#define TWR_MFINAL_COUNT_IDX    (TWR_FUNC_IDX + 1U)
+#define TWR_MFINAL_MASK_IDX     (TWR_MFINAL_COUNT_IDX + 1U)
+#define TWR_MFINAL_POLL_TX_IDX  (TWR_MFINAL_MASK_IDX + 1U)
+#define TWR_MFINAL_FINAL_TX_IDX (TWR_MFINAL_POLL_TX_IDX + 4U)
+#define TWR_MFINAL_RESP_RX_IDX  (TWR_MFINAL_FINAL_TX_IDX + 4U)
+#define TWR_SS_POLL_RX_IDX      (TWR_FUNC_IDX + 1U)
+#define TWR_SS_RESP_TX_IDX      (TWR_SS_POLL_RX_IDX + 4U)
+#define TWR_POLL_LEN            (TWR_FUNC_IDX + 1U + FCS_LEN)
+#define TWR_RESP_LEN            (TWR_FUNC_IDX + 1U + FCS_LEN)
+#define TWR_SS_RESP_LEN         (TWR_SS_RESP_TX_IDX + 4U + FCS_LEN)
+#define TWR_FINAL_LEN           (TWR_FINAL_FINAL_TX_IDX + 4U + FCS_LEN)
+#define TWR_MPOLL_LEN(n)        (TWR_MPOLL_ADDR_IDX + (2U * (n)) + FCS_LEN)
+#define TWR_MFINAL_LEN(n)       (TWR_MFINAL_RESP_RX_IDX + (4U * (n)) + FCS_LEN)
+#define TWR_FRAME_MAX           (TWR_MFINAL_LEN(TWR_MULTI_MAX))
+
+#if (TWR_MULTI_MAX > 8U) || ((TWR_FRAME_MAX - FCS_LEN) > TXTMPL_FRAME_MAX)
+#error "TWR_MULTI_MAX too large"
+#endif
+
+#define TWR_SPEED_OF_LIGHT      (299702547LL) // Speed of radio waves in air, in m/s
+
+typedef enum
+{
+    TWR_ROLE_INITIATOR = 0,
+    TWR_ROLE_RESPONDER = 1,
+} twr_role_e;
+
+typedef enum
+{
+    TWR_STATE_IDLE = 0,       // Session entry is free
+    TWR_STATE_POLL_SENT,      // Initiator: poll sent, waiting for the response
+    TWR_STATE_RESP_SENT,      // Responder: response sent, waiting for the final
+    TWR_STATE_SS_POLL_SENT,   // Single-sided initiator: poll sent, waiting for the response
+} twr_state_e;
+
+typedef enum
+{
+    TWR_FRAME_POLL = 0,
+    TWR_FRAME_RESP,
+    TWR_FRAME_FINAL,
+    TWR_FRAME_MPOLL,
+    TWR_FRAME_MFINAL,
+    TWR_FRAME_SS_RESP,
+    TWR_FRAME_NUM,
+} twr_frame_e;
+
+/* Clock offset used to correct single-sided ranges */
+typedef enum
+{
+    TWR_CLKOFS_CIA = 0,       // Crystal offset estimated by the CIA, read in the same transaction as the RX time stamp
+    TWR_CLKOFS_CARRIER_CH5,   // Carrier integrator, finer resolution for one more read, channel 5
+    TWR_CLKOFS_CARRIER_CH9,   // Carrier integrator, channel 9
+} twr_clkofs_e;
+
+/* Result of one ranging exchange, given to the result callback on the device computing the range */
+typedef struct
+{
+    uint16_t peer;            // Short address of the other device
+    uint8_t seq;              // Sequence number of the poll
+    int32_t tof_dtu;          // Time of flight in DTU, can be negative at short range if antenna delays are too large
+    int32_t distance_mm;      // Distance in mm
+} twr_result_t;
+
+typedef void (*twr_result_cb_t)(const twr_result_t *result);
+
+typedef struct
+{
+    uint16_t pan_id;                       // PAN ID
+    uint16_t address;                      // Own short address
+    uint32_t poll_rx_to_resp_tx_dly;       // Responder: delay from poll RX to response TX, in DTU
+    uint32_t resp_rx_to_final_tx_dly;      // Initiator: delay from response RX to final TX, in DTU
+    uint32_t poll_tx_to_resp_rx_dly_uus;   // Initiator: delay from poll TX to RX enable, in UWB microseconds (1.0256 us)
+    uint32_t resp_tx_to_final_rx_dly_uus;  // Responder: delay from response TX to RX enable, in UWB microseconds
+    uint32_t rx_timeout_uus;               // RX timeout waiting for a response or a final, in UWB microseconds
+    uint16_t tx_antenna_delay;             // TX antenna delay, in DTU, added to the planned TX time stamps
+    twr_result_cb_t result_cb;             // Called when a range is computed, on the responder (DS-TWR) or the initiator (SS-TWR), may be NULL
+    uint32_t slot_uus;                     // Multi-responder: period of the response slots, in UWB microseconds
+    twr_clkofs_e ss_clock_offset;          // Single-sided initiator: clock offset source
+} twr_config_t;
+
+/* State of one ranging exchange */
+typedef struct
+{
+    twr_state_e state;
+    twr_role_e role;
+    uint16_t peer;            // Short address of the other device
+    uint8_t seq;              // Sequence number of the poll
+    uint8_t slot;             // Multi-responder responder: response slot
+    ts40_t poll_tx;           // Time stamps of the exchange known by this device
+    ts40_t poll_rx;
+    ts40_t resp_tx;
+    ts40_t resp_rx;
+    ts40_t deadline;          // End of the RX window for the response or the final
+} twr_session_t;
+
+/* Initiator side of a multi-responder exchange */
+typedef struct
+{
+    uint8_t active;                        // Collecting responses
+    uint8_t seq;                           // Sequence number of the poll
+    uint8_t count;                         // Number of responders
+    uint8_t received;                      // Bit mask of the slots received
+    uint16_t peers[TWR_MULTI_MAX];         // Responders, in slot order
+    ts40_t poll_tx;
+    ts40_t window_end;                     // End of the RX window, 0 until poll_tx is read
+    ts40_t resp_rx[TWR_MULTI_MAX];
+} twr_multi_t;
+
+typedef struct
+{
+    twr_config_t config;
+    twr_session_t sessions[TWR_SESSION_MAX];
+    uint8_t seq;                           // Next poll sequence number
+    uint8_t listening;                     // Responder is listening for polls
+    uint8_t poll_pending;                  // Session of the last poll plus 1 until its TX time stamp is read, else 0
+    uint8_t frame[TWR_FRAME_MAX];          // Frame being built or parsed
+    txtmpl_mgr_t tx;                       // Poll, response and final frames in the TX buffer
+    uint8_t tmpl[TWR_FRAME_NUM];           // Template of each frame, indexed by twr_frame_e
+    twr_multi_t multi;                     // Multi-responder exchange in progress
+} twr_engine_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Initialise the engine, all sessions are free. The frame templates are written to the TX
+ *        buffer on their first use.
+ *
+ * input parameters
+ * @param engine engine to initialise
+ * @param config configuration, copied into the engine
+ */
+void twr_init(twr_engine_t *engine, const twr_config_t *config);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start a ranging exchange with @peer: send a poll and enable the receiver for the response.
+ *
+ * input parameters
+ * @param engine engine
+ * @param peer short address of the responder
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the TX time stamp of the previous poll is not read yet, the
+ *         session table is full or the TX could not start.
+ */
+int32_t twr_initiate(twr_engine_t *engine, uint16_t peer);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start a multi-responder exchange: broadcast a poll listing @peers, then collect their
+ *        responses in their slots and broadcast the final. Ranges are computed by the responders.
+ *
+ * The receiver stays enabled across the slots with double buffering, so a response can be received
+ * while the previous one is processed.
+ *
+ * input parameters
+ * @param engine engine
+ * @param peers short addresses of the responders, in slot order
+ * @param count number of responders, 1 to TWR_MULTI_MAX
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if an exchange is already in progress, the TX time stamp of the
+ *         previous poll is not read yet, @count is out of range or the TX could not start.
+ */
+int32_t twr_initiate_multi(twr_engine_t *engine, const uint16_t *peers, uint8_t count);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Start a single-sided exchange with @peer: send a poll and enable the receiver for the response.
+ *        The range is computed on this device when the response is received.
+ *
+ * input parameters
+ * @param engine engine
+ * @param peer short address of the responder
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the TX time stamp of the previous poll is not read yet, the
+ *         session table is full or the TX could not start.
+ */
+int32_t twr_initiate_ss(twr_engine_t *engine, uint16_t peer);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Act as responder: enable the receiver, without timeout, waiting for polls, including
+ *        multi-responder polls listing this device.
+ *
+ * input parameters
+ * @param engine engine
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the receiver could not be enabled.
+ */
+int32_t twr_listen(twr_engine_t *engine);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Read the TX time stamp of a poll as soon as it is sent, to be called from the TX confirmation
+ *        callback. Without it, the time stamp is read on the next RX event.
+ *
+ * input parameters
+ * @param engine engine
+ * @param cb_data callback data of the event
+ */
+void twr_tx_done_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Process a received frame, to be called from the RX good frame callback.
+ *
+ * Frames which are not for this device or not part of an exchange are ignored, and a listening
+ * responder re-enables its receiver.
+ *
+ * input parameters
+ * @param engine engine
+ * @param cb_data callback data of the received frame
+ */
+void twr_rx_ok_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief End the exchanges whose RX window is over, to be called from the RX timeout and error callbacks.
+ *
+ * The receiver is enabled again for the other exchanges, up to the earliest end of their RX windows,
+ * and a listening responder re-enables its receiver.
+ *
+ * input parameters
+ * @param engine engine
+ * @param cb_data callback data of the event
+ */
+void twr_rx_error_handler(twr_engine_t *engine, const dwt_cb_data_t *cb_data);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Asymmetric DS-TWR time of flight, in integer arithmetic.
+ *
+ * Durations are differences of time stamps modulo 2^32, so exchanges up to 67 ms long are handled
+ * across a wrap of the device time.
+ *
+ * input parameters
+ * @param round_a  Ra, initiator round trip time (resp_rx - poll_tx), in DTU
+ * @param reply_a  Da, initiator reply time (final_tx - resp_rx), in DTU
+ * @param round_b  Rb, responder round trip time (final_rx - resp_tx), in DTU
+ * @param reply_b  Db, responder reply time (resp_tx - poll_rx), in DTU
+ *
+ * return: time of flight in DTU, rounded toward zero.
+ */
+int32_t twr_compute_tof(uint32_t round_a, uint32_t reply_a, uint32_t round_b, uint32_t reply_b);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Single-sided TWR time of flight corrected with the clock offset, in integer arithmetic.
+ *
+ * input parameters
+ * @param round    initiator round trip time (resp_rx - poll_tx), in DTU
+ * @param reply    responder reply time (resp_tx - poll_rx), in DTU of the responder
+ * @param offset_q32 clock offset of the responder relative to this device, in units of 2^-32, positive if
+ *                   the local clock is slower (dwt_readclockoffset() * 64)
+ *
+ * return: time of flight in DTU, rounded toward zero.
+ */
+int32_t twr_compute_ss_tof(uint32_t round, uint32_t reply, int32_t offset_q32);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Convert a time of flight to a distance.
+ *
+ * input parameters
+ * @param tof_dtu time of flight in DTU
+ *
+ * return: distance in mm.
+ */
+int32_t twr_tof_to_mm(int32_t tof_dtu);
+
+#endif /* DECA_TWR_H_ */
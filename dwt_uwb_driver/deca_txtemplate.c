@@ -0,0 +1,131 @@
+/**
+ * @file:     deca_txtemplate.c
+ *
+ * @brief     TX frame templates kept resident in the TX buffer
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#include <stdint.h>
+#include "deca_device_api.h"
+#include "deca_txtemplate.h"
+
+void txtmpl_init(txtmpl_mgr_t *mgr, uint16_t base)
+{
+    mgr->count = 0U;
+    mgr->selected = TXTMPL_NONE;
+    mgr->base = base;
+    mgr->next_offset = base;
+}
+
+int32_t txtmpl_add(txtmpl_mgr_t *mgr, const uint8_t *frame, uint16_t len, uint8_t ranging)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((mgr->count < TXTMPL_MAX) && (len > (uint16_t)FCS_LEN) && ((len - FCS_LEN) <= TXTMPL_FRAME_MAX)
+        && (((uint32_t)mgr->next_offset + len) < TX_BUFFER_MAX_LEN))
+    {
+        txtmpl_t *t = &mgr->tmpl[mgr->count];
+
+        t->offset = mgr->next_offset;
+        t->len = len;
+        t->cap = len;
+        t->ranging = ranging;
+        t->staged = 0U;
+        for (uint16_t i = 0U; i < (len - FCS_LEN); i++)
+        {
+            t->image[i] = frame[i];
+        }
+        // The FCS is appended by the device, the next frame can start over it
+        mgr->next_offset += (uint16_t)(len - FCS_LEN);
+        ret = (int32_t)mgr->count;
+        mgr->count++;
+    }
+    return ret;
+}
+
+int32_t txtmpl_patch(txtmpl_mgr_t *mgr, uint8_t id, uint16_t pos, const uint8_t *data, uint16_t n)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((id < mgr->count) && (((uint32_t)pos + n) <= ((uint32_t)mgr->tmpl[id].len - FCS_LEN)))
+    {
+        txtmpl_t *t = &mgr->tmpl[id];
+        uint16_t first = 0xFFFFU;
+        uint16_t last = 0U;
+
+        for (uint16_t i = 0U; i < n; i++)
+        {
+            if (t->image[pos + i] != data[i])
+            {
+                t->image[pos + i] = data[i];
+                if (first == 0xFFFFU)
+                {
+                    first = pos + i;
+                }
+                last = pos + i;
+            }
+        }
+        if ((t->staged != 0U) && (first != 0xFFFFU))
+        {
+            (void)dwt_writetxdata((uint16_t)(last - first + 1U), &t->image[first], (uint16_t)(t->offset + first));
+        }
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+int32_t txtmpl_setlen(txtmpl_mgr_t *mgr, uint8_t id, uint16_t len)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((id < mgr->count) && (len > (uint16_t)FCS_LEN) && (len <= mgr->tmpl[id].cap))
+    {
+        if (mgr->tmpl[id].len != len)
+        {
+            mgr->tmpl[id].len = len;
+            if (mgr->selected == id)
+            {
+                mgr->selected = TXTMPL_NONE;
+            }
+        }
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+int32_t txtmpl_select(txtmpl_mgr_t *mgr, uint8_t id)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if (id < mgr->count)
+    {
+        txtmpl_t *t = &mgr->tmpl[id];
+
+        if (t->staged == 0U)
+        {
+            // Whole reserved space, so that the TX buffer matches the image whatever the length later set
+            (void)dwt_writetxdata((uint16_t)(t->cap - FCS_LEN), t->image, t->offset);
+            t->staged = 1U;
+        }
+        if (mgr->selected != id)
+        {
+            dwt_writetxfctrl(t->len, t->offset, t->ranging);
+            mgr->selected = id;
+        }
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+void txtmpl_invalidate(txtmpl_mgr_t *mgr)
+{
+    for (uint8_t i = 0U; i < mgr->count; i++)
+    {
+        mgr->tmpl[i].staged = 0U;
+    }
+    mgr->selected = TXTMPL_NONE;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file:     deca_txtemplate.h
+ *
+ * @brief     TX frame templates kept resident in the TX buffer
+ *
+ *            Frames sent repeatedly (e.g. the poll, response and final of a ranging exchange)
+ *            are staged once, each at its own TX buffer offset. Sending one again only writes the
+ *            bytes which changed since it was last written (sequence number, embedded time stamps)
+ *            and TX_FCTRL when the template to send is not the one last selected.
+ *
+ *            The manager keeps an image of what it wrote to the device: the TX buffer content is
+ *            lost in sleep, so txtmpl_invalidate() must be called on wake up, and also whenever the
+ *            application writes the TX buffer or TX_FCTRL by other means.
+ *
+ * @author    Decawave Applications
+ *
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+#ifndef DECA_TXTEMPLATE_H_
+#define DECA_TXTEMPLATE_H_
+
+#include <stdint.h>
+
+#ifndef TXTMPL_MAX
+#define TXTMPL_MAX              (8U)     // Number of templates per manager, the TWR engine takes 6
+#endif
+
+#ifndef TXTMPL_FRAME_MAX
+#define TXTMPL_FRAME_MAX        (48U)    // Largest template frame, without FCS
+#endif
+
+#define TXTMPL_NONE             (0xFFU)  // No template selected in TX_FCTRL
+
+typedef struct
+{
+    uint16_t offset;                     // TX buffer offset of the frame
+    uint16_t len;                        // Frame length, including the FCS
+    uint16_t cap;                        // Length reserved in the TX buffer, including the FCS
+    uint8_t ranging;                     // Ranging bit of the frame
+    uint8_t staged;                      // Image has been written to the TX buffer
+    uint8_t image[TXTMPL_FRAME_MAX];     // Frame as it is in the TX buffer
+} txtmpl_t;
+
+typedef struct
+{
+    txtmpl_t tmpl[TXTMPL_MAX];
+    uint8_t count;                       // Templates added
+    uint8_t selected;                    // Template set in TX_FCTRL, or TXTMPL_NONE
+    uint16_t base;                       // TX buffer offset of the first template
+    uint16_t next_offset;                // TX buffer offset of the next template added
+} txtmpl_mgr_t;
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Initialise a template manager, templates will be placed in the TX buffer from @base on.
+ *
+ * Templates are written with single SPI transactions when they are within the first 128 bytes of
+ * the TX buffer, further offsets need the indirect access of dwt_writetxdata().
+ *
+ * input parameters
+ * @param mgr manager to initialise
+ * @param base TX buffer offset of the first template
+ */
+void txtmpl_init(txtmpl_mgr_t *mgr, uint16_t base);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Add a template, placed in the TX buffer after the previous one. It is written to the
+ *        device on its first selection.
+ *
+ * input parameters
+ * @param mgr manager
+ * @param frame frame content, without FCS
+ * @param len frame length, including the FCS
+ * @param ranging ranging bit of the frame
+ *
+ * return: template index, or DWT_ERROR if the manager is full or the frame does not fit.
+ */
+int32_t txtmpl_add(txtmpl_mgr_t *mgr, const uint8_t *frame, uint16_t len, uint8_t ranging);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Update bytes of a template. Only the span from the first to the last byte differing from
+ *        the TX buffer content is written, in one SPI transaction, nothing if no byte changed.
+ *
+ * input parameters
+ * @param mgr manager
+ * @param id template index
+ * @param pos position of the first byte to update in the frame
+ * @param data new bytes
+ * @param n number of bytes
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the template does not exist or the bytes are out of the frame.
+ */
+int32_t txtmpl_patch(txtmpl_mgr_t *mgr, uint8_t id, uint16_t pos, const uint8_t *data, uint16_t n);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Change the length of a template, for frames with a variable number of fields. The new
+ *        length is written to TX_FCTRL on the next selection.
+ *
+ * input parameters
+ * @param mgr manager
+ * @param id template index
+ * @param len frame length, including the FCS, up to the length the template was added with
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the template does not exist or the length is too large.
+ */
+int32_t txtmpl_setlen(txtmpl_mgr_t *mgr, uint8_t id, uint16_t len);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Make a template the frame sent by the next dwt_starttx(). It is written to the TX buffer
+ *        if not yet there, and TX_FCTRL is only written when the template was not already selected.
+ *
+ * input parameters
+ * @param mgr manager
+ * @param id template index
+ *
+ * return: DWT_SUCCESS, or DWT_ERROR if the template does not exist.
+ */
+int32_t txtmpl_select(txtmpl_mgr_t *mgr, uint8_t id);
+
+/*! ---------------------------------------------------------------------------------------------------
+ * @brief Forget the device content: all templates will be written again on their next selection.
+ *
+ * input parameters
+ * @param mgr manager
+ */
+void txtmpl_invalidate(txtmpl_mgr_t *mgr);
+
+#endif /* DECA_TXTEMPLATE_H_ */
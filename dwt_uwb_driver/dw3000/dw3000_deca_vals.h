@@ -37,6 +37,9 @@ extern "C"
 #define RF_EN_CH9        0x0405C000UL
 
 #define AUTO_PLL_CAL_STEPS 20
+#define PLL_CACHE_STEPS    4    // Steps verifying the lock with a coarse code of the PLL calibration cache
+#define PLL_CACHE_BANDS    8    // Temperature bands of the PLL calibration cache, from -40 C
+#define PLL_CACHE_BAND_C   20   // Width of a temperature band, in degrees C
 #define LDO_TUNE_HI_VDDDIG_TRIM_MASK    0x00F00000UL
 #define LDO_TUNE_HI_VDDDIG_COARSE_MASK  0x30000000UL
 
@@ -16,6 +16,10 @@
 #include "dw3720_deca_vals.h"
 #include "deca_version.h"
 #include "deca_rsl.h"
+#include "deca_nlos.h"
+#include "deca_airtime.h"
+#include "deca_otpsnap.h"
+#include "deca_sleepprof.h"
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -27,6 +31,28 @@
 #define DWT_API_ERROR_CHECK  /* API checks config input parameters */
 #endif
 
+#define DWT_WAKE_PROFILE_OPS (20U) // Register writes of ull_restoreconfig() kept in the wake profile
+#define DWT_WAKE_OP_DATA     (8U)  // Largest of them: AND and OR values of a 32-bit modify
+
+// A register write, as given to dwt_xfer3xxx()
+typedef struct
+{
+    uint32_t regFileID;
+    uint16_t index;
+    uint16_t length;
+    spi_modes_e mode;
+    uint8_t data[DWT_WAKE_OP_DATA];
+} dwt_wake_op_t;
+
+// Register writes of ull_restoreconfig(), precomputed by ull_configure() and replayed on wake without register reads
+typedef struct
+{
+    uint8_t count;                           // Writes recorded, 0 if there is no profile
+    uint8_t common;                          // Writes of every restore, the others are for a full restore only
+    uint8_t invalid;                         // Set while recording if a write cannot be precomputed
+    dwt_wake_op_t ops[DWT_WAKE_PROFILE_OPS];
+} dwt_wake_profile_t;
+
 // -------------------------------------------------------------------------------------------------------------------
 // Device Data for DW3720 Transceiver control
 //
@@ -54,6 +80,22 @@ typedef struct
     uint8_t sys_cfg_dis_fce_bit_flag; // Cached value of the SYS_CFG_DIS_FCE_BIT in the SYS_CFG_ID register
     dwt_sts_lengths_e stsLength;       // Current STS length
     uint16_t preamble_len;             // Current preamble length
+    uint8_t rxCode;                    // Current RX preamble code, 0 until dwt_configure is called
+    dwt_airtime_t airtime;             // Frame timing of the current configuration, zero until dwt_configure is called
+    dwt_otp_snapshot_t otp;            // OTP calibration words of the last initialisation (see ull_otpsnapshot_export)
+    dwt_wake_profile_t wake_profile;   // Register writes replayed by ull_restoreconfig, see dwt_wake_build
+    uint16_t lposc_cal;                // XTAL cycles per LP OSC cycle of the last sleep counter calibration, 0 if none
+    uint8_t lposc_temp;                // Raw SAR temperature of the last sleep counter calibration
+    uint8_t listening;                 // Duty-cycled listen started, see ull_listen_start
+    uint32_t listen_int_lo;            // Interrupts enabled before ull_listen_start
+    uint32_t listen_int_hi;
+    dwt_config_t config;               // Configuration last applied, see ull_reconfigure
+    uint8_t config_valid;              // config is the one applied to the device
+    uint32_t pll_cc[2][PLL_CACHE_BANDS]; // PLL_COARSE_CODE locked on channel 5 and 9 in each temperature band, 0 if none
+    uint8_t sar_mux;                   // SAR input converted for ull_readtempvbat_start(), 0 if none
+    uint8_t sar_temp;                  // Raw temperature converted first for ull_readtempvbat_start()
+    uint16_t sar_tempvbat;             // Readings of ull_readtempvbat_start() taken by ull_readtempvbat(), if sar_mux is SAR_MUX_TAKEN
+    uint32_t sar_ldo_ctrl;             // LDO_CTRL restored once ull_readtempvbat_complete() collected both readings
 } dwt_local_data_t;
 
 // -------------------------------------------------------------------------------------------------------------------
@@ -99,6 +141,9 @@ typedef struct
 #define DGC_TUNE_ADDRESS     (0x20U)
 #define PLL_CC_ADDRESS       (0x35U)
 
+#define SAR_MUX_TAKEN 0xFFU // sar_mux once ull_readtempvbat() finished the conversion of ull_readtempvbat_start()
+#define SAR_WAIT_POLLS 100U // Polls of ull_readtempvbat() for the conversion of ull_readtempvbat_start() before giving it up
+
 /* internal arithmetic */
 #define B20_SIGN_EXTEND_TEST (0x00100000UL)
 #define B20_SIGN_EXTEND_MASK (0xFFF00000UL)
@@ -361,9 +406,13 @@ void ull_setrxtimeout(dwchip_t *dw, uint32_t on_time);
 void ull_setpreambledetecttimeout(dwchip_t *dw, uint16_t timeout);
 static void ull_aon_write(dwchip_t *dw, uint16_t aon_address, uint8_t aon_write_data);
 static uint8_t ull_aon_read(dwchip_t *dw, uint16_t aon_address);
-float ull_convertrawtemperature(dwchip_t *dw, uint8_t raw_temp);
+int16_t ull_convertrawtemperature_cdeg(dwchip_t *dw, uint8_t raw_temp);
 uint16_t ull_readtempvbat(dwchip_t *dw);
+int32_t ull_readtempvbat_complete(dwchip_t *dw, uint16_t *tempvbat);
+int32_t ull_readtempvbat_abort(dwchip_t *dw);
+static void dwt_sar_sleep(dwchip_t *dw);
 static uint16_t ull_readsar(dwchip_t *dw, uint8_t input_mux, uint8_t attn);
+uint16_t ull_convertrawvoltage_mv(dwchip_t *dw, uint8_t raw_voltage);
 static uint8_t ull_pll_ch5_auto_cal(dwchip_t *dw, uint32_t coarse_code, uint16_t sleep_us, uint8_t steps, uint8_t *p_num_steps_lock, int8_t temperature);
 static uint8_t ull_pll_ch9_auto_cal(dwchip_t *dw, uint32_t coarse_code, uint16_t sleep_us, uint8_t steps, uint8_t *p_num_steps_lock);
 static void ull_capture_adc_samples(dwchip_t *dw, dwt_capture_adc_t *capture_adc);
@@ -438,6 +487,37 @@ static void ull_wakeup_ic(dwchip_t *dw)
 #endif
 }
 
+/**
+ * dwt_wake_record() - Append a register write to a wake profile being built by dwt_wake_build()
+ * @wp: wake profile being built
+ * @regFileID: ID of register file or buffer being accessed
+ * @index: byte index into register file or buffer being accessed
+ * @length: number of bytes being written
+ * @buffer: bytes being written
+ * @mode: DW3000_SPI_WR_BIT, DW3000_SPI_WR_FAST_CMD or DW3000_SPI_AND_OR_x
+ */
+static void dwt_wake_record(dwt_wake_profile_t *wp, uint32_t regFileID, uint16_t index, uint16_t length, const uint8_t *buffer, const spi_modes_e mode)
+{
+    if ((wp->count < DWT_WAKE_PROFILE_OPS) && (length <= DWT_WAKE_OP_DATA))
+    {
+        dwt_wake_op_t *op = &wp->ops[wp->count];
+
+        op->regFileID = regFileID;
+        op->index = index;
+        op->length = length;
+        op->mode = mode;
+        for (uint16_t i = 0U; i < length; i++)
+        {
+            op->data[i] = buffer[i];
+        }
+        wp->count++;
+    }
+    else
+    {
+        wp->invalid = 1U;
+    }
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief  this function is used to read/write to the DW3720 device registers
  *
@@ -817,6 +897,33 @@ static void dwt_modify8bitoffsetreg(dwchip_t *dw, const uint32_t regFileID, cons
     dwt_xfer3xxx(dw, regFileID, regOffset, (uint16_t)sizeof(buf), buf, DW3000_SPI_AND_OR_8);
 }
 
+/**
+ * dwt_wake_write() - Write a register restored on wake, or append the write to a wake profile being built
+ * @dw: DW3720 chip descriptor handler.
+ * @wp: wake profile being built by dwt_wake_build(), NULL to write the register now
+ * @regFileID: ID of register file being accessed
+ * @regOffset: the index into register file being accessed
+ * @width: size of the register, 1, 2 or 4 bytes
+ * @value: the value to write
+ */
+static void dwt_wake_write(dwchip_t *dw, dwt_wake_profile_t *wp, uint32_t regFileID, uint16_t regOffset, uint16_t width, uint32_t value)
+{
+    uint8_t buf[4];
+
+    for (uint16_t j = 0U; j < width; j++)
+    {
+        buf[j] = (uint8_t)(value >> (8U * j));
+    }
+    if (wp != NULL)
+    {
+        dwt_wake_record(wp, regFileID, regOffset, width, buf, DW3000_SPI_WR_BIT);
+    }
+    else
+    {
+        dwt_xfer3xxx(dw, regFileID, regOffset, width, buf, DW3000_SPI_WR_BIT);
+    }
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This is used to enable SPI CRC check in DW3720
  *
@@ -867,6 +974,22 @@ static void dwt_localstruct_init(dwt_local_data_t *data)
     data->vBatP = 0U;
     data->tempP = 0U;
     data->sys_cfg_dis_fce_bit_flag = 0U;
+    data->rxCode = 0U;
+    data->airtime.shr_ns = 0UL;
+    data->airtime.sts_ns = 0UL;
+    data->airtime.phr_ns = 0UL;
+    data->airtime.bit_ps = 0UL;
+    data->wake_profile.count = 0U;
+    data->wake_profile.common = 0U;
+    data->lposc_cal = 0U;
+    data->listening = 0U;
+    data->config_valid = 0U;
+    for (uint8_t i = 0U; i < (uint8_t)PLL_CACHE_BANDS; i++)
+    {
+        data->pll_cc[0][i] = 0UL;
+        data->pll_cc[1][i] = 0UL;
+    }
+    data->sar_mux = 0U;
 }
 
 #ifdef AUTO_PLL_CAL
@@ -946,6 +1069,55 @@ static int32_t ull_set_vdddig_mv(dwchip_t *dw,  dwt_vdddig_mv_t vdddig)
 
 /** @note unique instance of local driver data */
 static dwt_local_data_t dwt_local_data;
+static dwt_otp_snapshot_t dwt_otp_snapshot; // Given by ull_otpsnapshot_import(), unusable (version 0) until then
+
+/**
+ * dwt_readotpcalib() - Read the OTP calibration words used by ull_initialise(), or take them from the imported
+ * snapshot if it was taken from the same part and holds all the values of the mode
+ * @dw: DW3720 chip descriptor handler.
+ * @mode: mask which defines which OTP values to read.
+ * @otp: OTP calibration words, sealed
+ */
+static void dwt_readotpcalib(dwchip_t *dw, int32_t mode, dwt_otp_snapshot_t *otp)
+{
+    uint16_t otp_mode = (uint16_t)((uint32_t)mode & OTPSNAP_MODE_MASK);
+    bool snap_valid = (otpsnap_check(&dwt_otp_snapshot) == (int32_t)DWT_SUCCESS);
+
+    // The part ID tells which part the snapshot was taken from
+    otp->part_id = 0UL;
+    if (snap_valid || ((otp_mode & (uint16_t)DWT_READ_OTP_PID) != 0U))
+    {
+        otp->part_id = dwt_otpreadpintoparams(dw, PARTID_ADDRESS);
+        otp_mode |= (uint16_t)DWT_READ_OTP_PID;
+    }
+
+    if (snap_valid && (otp->part_id != 0UL) && (otp->part_id == dwt_otp_snapshot.part_id)
+        && ((otp_mode & dwt_otp_snapshot.mode) == otp_mode))
+    {
+        *otp = dwt_otp_snapshot;
+    }
+    else
+    {
+        otp->mode = otp_mode;
+        otp->ldo_tune_lo = dwt_otpreadpintoparams(dw, LDOTUNELO_ADDRESS);
+        otp->ldo_tune_hi = dwt_otpreadpintoparams(dw, LDOTUNEHI_ADDRESS);
+        otp->bias_tune = dwt_otpreadpintoparams(dw, BIAS_TUNE_ADDRESS);
+        otp->dgc_tune = dwt_otpreadpintoparams(dw, DGC_TUNE_ADDRESS);
+        otp->lot_id_lo = 0UL;
+        otp->lot_id_hi = 0UL;
+        if ((otp_mode & (uint16_t)DWT_READ_OTP_LID) != 0U)
+        {
+            otp->lot_id_lo = dwt_otpreadpintoparams(dw, WSLOTID_LOW_ADDRESS);
+            otp->lot_id_hi = dwt_otpreadpintoparams(dw, WSLOTID_HIGH_ADDRESS);
+        }
+        otp->vbat = ((otp_mode & (uint16_t)DWT_READ_OTP_BAT) != 0U) ? dwt_otpreadpintoparams(dw, VBAT_ADDRESS) : 0UL;
+        otp->vtemp = ((otp_mode & (uint16_t)DWT_READ_OTP_TMP) != 0U) ? dwt_otpreadpintoparams(dw, VTEMP_ADDRESS) : 0UL;
+        otp->otprev = dwt_otpreadpintoparams(dw, OTPREV_ADDRESS);
+        otp->xtrim = dwt_otpreadpintoparams(dw, XTRIM_ADDRESS);
+        otp->pll_cc = dwt_otpreadpintoparams(dw, PLL_CC_ADDRESS);
+        otpsnap_seal(otp);
+    }
+}
 
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function initialises the DW3720 transceiver:
@@ -957,6 +1129,7 @@ static dwt_local_data_t dwt_local_data;
  * NOTES:
  * 1.it also reads and applies LDO and BIAS tune and crystal trim values from OTP memory
  * 2.it is assumed this function is called after a reset or on power up of the DW3720
+ * 3.the OTP values are taken from the snapshot given to ull_otpsnapshot_import() when it comes from the same part
  *
  * input parameters
  * @param dw - DW3720 chip descriptor handler.
@@ -978,10 +1151,13 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
 
     dwt_localstruct_init(pdw3000local);
 
-    // Read LDO_TUNE and BIAS_TUNE from OTP
-    ldo_tune_lo = dwt_otpreadpintoparams(dw, LDOTUNELO_ADDRESS);
-    ldo_tune_hi = dwt_otpreadpintoparams(dw, LDOTUNEHI_ADDRESS);
-    bias_tune = (uint16_t)dwt_otpreadpintoparams(dw, BIAS_TUNE_ADDRESS);
+    // Read the OTP calibration words, or take them from the imported snapshot
+    dwt_readotpcalib(dw, mode, &pdw3000local->otp);
+
+    // LDO_TUNE and BIAS_TUNE
+    ldo_tune_lo = pdw3000local->otp.ldo_tune_lo;
+    ldo_tune_hi = pdw3000local->otp.ldo_tune_hi;
+    bias_tune = (uint16_t)pdw3000local->otp.bias_tune;
 
     // Saving VDDDIG value from OTP in chip local context to prevent future OTP reading
     // OTP contains trim code value only. Coarse set to 0 by default.
@@ -1006,8 +1182,8 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
     ull_set_vdddig_mv(dw, VDDDIG_88mV);
 #endif
 
-    // Read DGC_CFG from OTP
-    if (dwt_otpreadpintoparams(dw, DGC_TUNE_ADDRESS) == DWT_DGC_CFG0)
+    // DGC_CFG from OTP
+    if (pdw3000local->otp.dgc_tune == DWT_DGC_CFG0)
     {
         pdw3000local->dgc_otp_set = (uint8_t)DWT_DGC_LOAD_FROM_OTP;
     }
@@ -1019,15 +1195,12 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
     // Load Part and Lot ID from OTP
     if (((uint32_t)mode & (uint32_t)DWT_READ_OTP_PID) != 0U)
     {
-        pdw3000local->partID = dwt_otpreadpintoparams(dw, PARTID_ADDRESS);
+        pdw3000local->partID = pdw3000local->otp.part_id;
     }
 
     if (((uint32_t)mode & (uint32_t)DWT_READ_OTP_LID) != 0U)
     {
-        uint32_t lot_id[2];
-        lot_id[0] = dwt_otpreadpintoparams(dw, WSLOTID_LOW_ADDRESS);
-        lot_id[1] = dwt_otpreadpintoparams(dw, WSLOTID_HIGH_ADDRESS);
-        pdw3000local->lotID = ((uint64_t)lot_id[1] << 32) | lot_id[0];
+        pdw3000local->lotID = ((uint64_t)pdw3000local->otp.lot_id_hi << 32) | pdw3000local->otp.lot_id_lo;
     }
 
     if (((uint32_t)mode & (uint32_t)DWT_READ_OTP_BAT) != 0U)
@@ -1036,12 +1209,12 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
         // [7:0] = Vbat @ 1.62V
         // [15:8] = Vbat @ 3.6V
         // [23:16] = Vbat @ 3.0V
-        pdw3000local->vBatP = (uint8_t)(dwt_otpreadpintoparams(dw, VBAT_ADDRESS) >> 16U);
+        pdw3000local->vBatP = (uint8_t)(pdw3000local->otp.vbat >> 16U);
     }
 
     if (((uint32_t)mode & (uint32_t)DWT_READ_OTP_TMP) != 0U)
     {
-        pdw3000local->tempP = (uint8_t)dwt_otpreadpintoparams(dw, VTEMP_ADDRESS);
+        pdw3000local->tempP = (uint8_t)pdw3000local->otp.vtemp;
     }
 
     // if the reference temperature has not been programmed in OTP (early eng samples) set to default value
@@ -1056,9 +1229,9 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
         pdw3000local->vBatP = 0x74U; //@Vref of 3.0V
     }
 
-    pdw3000local->otprev = (uint8_t)dwt_otpreadpintoparams(dw, OTPREV_ADDRESS);
+    pdw3000local->otprev = (uint8_t)pdw3000local->otp.otprev;
 
-    pdw3000local->init_xtrim = (uint8_t)dwt_otpreadpintoparams(dw, XTRIM_ADDRESS) & XTAL_TRIM_BIT_MASK;
+    pdw3000local->init_xtrim = (uint8_t)pdw3000local->otp.xtrim & XTAL_TRIM_BIT_MASK;
     if (pdw3000local->init_xtrim == 0U)
     {
         // set the default value
@@ -1066,7 +1239,7 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
     }
     dwt_write8bitoffsetreg(dw, XTAL_ID, 0U, pdw3000local->init_xtrim);
 
-    pll_coarse_code = dwt_otpreadpintoparams(dw, PLL_CC_ADDRESS);
+    pll_coarse_code = pdw3000local->otp.pll_cc;
     if (pll_coarse_code != 0UL)
     {
         dwt_write32bitoffsetreg(dw, PLL_COARSE_CODE_ID, 0U, pll_coarse_code);
@@ -1076,7 +1249,7 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
     if (pdw3000local->temperature == TEMP_INIT)
     {
         uint16_t tempvbat = ull_readtempvbat(dw);
-        pdw3000local->temperature = ull_convertrawtemperature(dw, tempvbat >> 8U);  // Temperature in upper 8 bits
+        pdw3000local->temperature = (int8_t)(ull_convertrawtemperature_cdeg(dw, (uint8_t)(tempvbat >> 8U)) / 100);  // Temperature in upper 8 bits
     }
 #endif
 
@@ -1087,6 +1260,62 @@ static int32_t ull_initialise(dwchip_t *dw, int32_t mode)
     return (int32_t)DWT_SUCCESS;
 } // end dwt_initialise()
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function keeps the OTP calibration snapshot exported after a previous initialisation, for
+ *        ull_initialise() to apply instead of reading the OTP when it comes from the same part.
+ *
+ * input parameters
+ * @param dw - DW3000 chip descriptor handler.
+ * @param snap - snapshot given by ull_otpsnapshot_export(), or NULL to always read the OTP
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if the version or the CRC of the snapshot is wrong
+ */
+int32_t ull_otpsnapshot_import(dwchip_t *dw, const dwt_otp_snapshot_t *snap)
+{
+    int32_t ret = (int32_t)DWT_SUCCESS;
+
+    (void)dw;
+    if (snap == NULL)
+    {
+        dwt_otp_snapshot.version = 0U;
+    }
+    else if (otpsnap_check(snap) == (int32_t)DWT_SUCCESS)
+    {
+        dwt_otp_snapshot = *snap;
+    }
+    else
+    {
+        ret = (int32_t)DWT_ERROR;
+    }
+    return ret;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function gives the OTP calibration snapshot of the last initialisation.
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * output parameters
+ * @param snap - snapshot, sealed with its version and CRC
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if not initialised or the part ID was not read
+ */
+int32_t ull_otpsnapshot_export(dwchip_t *dw, dwt_otp_snapshot_t *snap)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((dw->priv != NULL) && (otpsnap_check(&LOCAL_DATA(dw)->otp) == (int32_t)DWT_SUCCESS)
+        && ((LOCAL_DATA(dw)->otp.mode & (uint16_t)DWT_READ_OTP_PID) != 0U))
+    {
+        *snap = LOCAL_DATA(dw)->otp;
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief
  * This function checks if PLL is locked or not.
@@ -1586,16 +1815,13 @@ static uint16_t get_sts_mnth(uint16_t cipher, uint8_t threshold, uint8_t shift_v
     return (uint16_t)value;
 }
 
-/*! ------------------------------------------------------------------------------------------------------------------
- * @brief This function sets the default values of the lookup tables depending on the channel selected.
- *
- * input parameters
- * @param[in] dw - DW3720 chip descriptor handler.
- * @param[in] channel - Channel that the device will be transmitting/receiving on.
- *
- * no return value
+/**
+ * dwt_wake_configmrxlut() - ull_configmrxlut(), or append its writes to a wake profile being built
+ * @dw: DW3720 chip descriptor handler.
+ * @wp: wake profile being built by dwt_wake_build(), NULL to write the registers now
+ * @channel: Channel that the device will be transmitting/receiving on.
  */
-void ull_configmrxlut(dwchip_t *dw, int32_t channel)
+static void dwt_wake_configmrxlut(dwchip_t *dw, dwt_wake_profile_t *wp, int32_t channel)
 {
     uint32_t lut0, lut1, lut2, lut3, lut4, lut5, lut6 = 0UL;
 
@@ -1619,74 +1845,169 @@ void ull_configmrxlut(dwchip_t *dw, int32_t channel)
         lut5 = (uint32_t)E0_CH9_DGC_LUT_5;
         lut6 = (uint32_t)E0_CH9_DGC_LUT_6;
     }
-    dwt_write32bitoffsetreg(dw, DGC_CFG0_ID, 0x0U, DWT_DGC_CFG0);
-    dwt_write32bitoffsetreg(dw, DGC_CFG1_ID, 0x0U, DWT_DGC_CFG1);
-    dwt_write32bitoffsetreg(dw, DGC_CFG2_ID, 0x0U, DWT_DGC_CFG2);
+    dwt_wake_write(dw, wp, DGC_CFG0_ID, 0x0U, 4U, DWT_DGC_CFG0);
+    dwt_wake_write(dw, wp, DGC_CFG1_ID, 0x0U, 4U, DWT_DGC_CFG1);
+    dwt_wake_write(dw, wp, DGC_CFG2_ID, 0x0U, 4U, DWT_DGC_CFG2);
+
+    dwt_wake_write(dw, wp, DGC_LUT_0_CFG_ID, 0x0U, 4U, lut0);
+    dwt_wake_write(dw, wp, DGC_LUT_1_CFG_ID, 0x0U, 4U, lut1);
+    dwt_wake_write(dw, wp, DGC_LUT_2_CFG_ID, 0x0U, 4U, lut2);
+    dwt_wake_write(dw, wp, DGC_LUT_3_CFG_ID, 0x0U, 4U, lut3);
+    dwt_wake_write(dw, wp, DGC_LUT_4_CFG_ID, 0x0U, 4U, lut4);
+    dwt_wake_write(dw, wp, DGC_LUT_5_CFG_ID, 0x0U, 4U, lut5);
+    dwt_wake_write(dw, wp, DGC_LUT_6_CFG_ID, 0x0U, 4U, lut6);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function sets the default values of the lookup tables depending on the channel selected.
+ *
+ * input parameters
+ * @param[in] dw - DW3720 chip descriptor handler.
+ * @param[in] channel - Channel that the device will be transmitting/receiving on.
+ *
+ * no return value
+ */
+void ull_configmrxlut(dwchip_t *dw, int32_t channel)
+{
+    dwt_wake_configmrxlut(dw, NULL, channel);
+}
+
+/**
+ * dwt_restoreconfig_common() - Register writes of ull_restoreconfig() done on every wake
+ * @dw: DW3720 chip descriptor handler.
+ * @wp: wake profile being built by dwt_wake_build(), NULL to write the registers now
+ */
+static void dwt_restoreconfig_common(dwchip_t *dw, dwt_wake_profile_t *wp)
+{
+    // CIA diagnostic should be enabled when in DB mode, otherwise the data in diagnostic
+    // SETs will be empty/invalid
+    if ((LOCAL_DATA(dw)->cia_diagnostic >> 1U) == 0U)
+    {
+        dwt_wake_write(dw, wp, RDB_DIAG_MODE_ID, 0U, 1U, (uint8_t)((uint8_t)DW_CIA_DIAG_LOG_MIN >> 1U));
+    }
+    else
+    {
+        dwt_wake_write(dw, wp, RDB_DIAG_MODE_ID, 0U, 1U, LOCAL_DATA(dw)->cia_diagnostic >> 1U);
+    }
+}
+
+/**
+ * dwt_restoreconfig_channel() - Register writes of ull_restoreconfig() done on a full restore, which depend on
+ * the channel and the preamble code
+ * @dw: DW3720 chip descriptor handler.
+ * @wp: wake profile being built by dwt_wake_build(), NULL to write the registers now
+ */
+static void dwt_restoreconfig_channel(dwchip_t *dw, dwt_wake_profile_t *wp)
+{
+    uint8_t channel = 5U;
+    uint16_t chan_ctrl;
+
+    chan_ctrl = dwt_read16bitoffsetreg(dw, CHAN_CTRL_ID, 0U);
+
+    // assume RX code is the same as TX (e.g. we will not RX on 16 MHz or SCP and TX on 64 MHz)
+    // only enable DGC for PRF 64
+    if ((((chan_ctrl & CHAN_CTRL_TX_PCODE_BIT_MASK) >> CHAN_CTRL_TX_PCODE_BIT_OFFSET) >= 9U)
+        && (((chan_ctrl & CHAN_CTRL_TX_PCODE_BIT_MASK) >> CHAN_CTRL_TX_PCODE_BIT_OFFSET) <= 24U))
+    {
+        if ((chan_ctrl & 0x1U) != 0U)
+        {
+            channel = 9;
+        }
+
+        /* If the OTP has DGC info programmed into it, do a manual kick from OTP. */
+        if (LOCAL_DATA(dw)->dgc_otp_set != (uint8_t)DWT_DGC_LOAD_FROM_OTP)
+        {
+            dwt_wake_configmrxlut(dw, wp, (int32_t)channel); /* Manually program hard-coded values into the DGC registers. */
+        }
+    }
+    dwt_wake_write(dw, wp, TX_CTRL_LO_ID, 0U, 4U, TX_CTRL_LO_DEF);
+}
+
+/**
+ * dwt_wake_build() - Precompute the wake profile: record the writes of dwt_restoreconfig_common() and
+ * dwt_restoreconfig_channel() for the current configuration, for ull_restoreconfig() to replay them on wake.
+ * The registers these writes depend on are read now rather than after wake. Without a valid profile,
+ * ull_restoreconfig() reads them on wake.
+ * @dw: DW3720 chip descriptor handler.
+ */
+static void dwt_wake_build(dwchip_t *dw)
+{
+    dwt_wake_profile_t *wp = &LOCAL_DATA(dw)->wake_profile;
+
+    wp->count = 0U;
+    wp->invalid = 0U;
+    dwt_restoreconfig_common(dw, wp);
+    wp->common = wp->count;
+    dwt_restoreconfig_channel(dw, wp);
+
+    if (wp->invalid != 0U)
+    {
+        wp->count = 0U;
+        wp->common = 0U;
+    }
+}
 
-    dwt_write32bitoffsetreg(dw, DGC_LUT_0_CFG_ID, 0x0U, lut0);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_1_CFG_ID, 0x0U, lut1);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_2_CFG_ID, 0x0U, lut2);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_3_CFG_ID, 0x0U, lut3);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_4_CFG_ID, 0x0U, lut4);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_5_CFG_ID, 0x0U, lut5);
-    dwt_write32bitoffsetreg(dw, DGC_LUT_6_CFG_ID, 0x0U, lut6);
+/**
+ * dwt_wake_replay() - Send the writes of the wake profile, in the order recorded
+ * @dw: DW3720 chip descriptor handler.
+ * @full_restore: also send the writes of dwt_restoreconfig_channel() if not 0
+ */
+static void dwt_wake_replay(dwchip_t *dw, int32_t full_restore)
+{
+    dwt_wake_profile_t *wp = &LOCAL_DATA(dw)->wake_profile;
+    uint8_t count = (full_restore != 0) ? wp->count : wp->common;
+
+    for (uint8_t i = 0U; i < count; i++)
+    {
+        dwt_xfer3xxx(dw, wp->ops[i].regFileID, wp->ops[i].index, wp->ops[i].length, wp->ops[i].data, wp->ops[i].mode);
+    }
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function needs to be called after device is woken up from DEEPSLEEP/SLEEP state, to restore the
  * configuration which has not been automatically restored from AON
  *
+ * NOTE: after ull_configure(), the register writes are precomputed (see dwt_wake_build()) and are sent without
+ * reading any register, only the calibrations of the full restore read the device.
+ *
  * input parameters
  * @param dw - DW3720 chip descriptor handler.
  * @param full_restore - If set to 0, the function will skip DGC update, PGC and ADC offset calibration.
  *                     - If set to any other value, the function will perform the complete update.
- *
  */
 void ull_restoreconfig(dwchip_t *dw, int32_t full_restore)
 {
-    uint8_t channel = 5U;
-    uint16_t chan_ctrl;
+    SLEEPPROF_MARK(SLEEPPROF_RESTORE);
 
     // restore/enable the OTP IPS for normal OTP use
     ull_dis_otp_ips(dw, 0);
 
-    // CIA diagnostic should be enabled when in DB mode, otherwise the data in diagnostic
-    // SETs will be empty/invalid
-    if ((LOCAL_DATA(dw)->cia_diagnostic >> 1U) == 0U)
+    if (LOCAL_DATA(dw)->wake_profile.count != 0U)
     {
-        dwt_write8bitoffsetreg(dw, RDB_DIAG_MODE_ID, 0U, (uint8_t)((uint8_t)DW_CIA_DIAG_LOG_MIN >> 1U));
-        LOCAL_DATA(dw)->cia_diagnostic |= (uint8_t)DW_CIA_DIAG_LOG_MIN;
+        dwt_wake_replay(dw, full_restore);
     }
     else
     {
-        dwt_write8bitoffsetreg(dw, RDB_DIAG_MODE_ID, 0U, LOCAL_DATA(dw)->cia_diagnostic >> 1U);
+        dwt_restoreconfig_common(dw, NULL);
+        if (full_restore != 0)
+        {
+            dwt_restoreconfig_channel(dw, NULL);
+        }
+    }
+
+    if ((LOCAL_DATA(dw)->cia_diagnostic >> 1U) == 0U)
+    {
+        LOCAL_DATA(dw)->cia_diagnostic |= (uint8_t)DW_CIA_DIAG_LOG_MIN;
     }
 
     if (full_restore != 0)
     {
-        chan_ctrl = dwt_read16bitoffsetreg(dw, CHAN_CTRL_ID, 0U);
-
-        // assume RX code is the same as TX (e.g. we will not RX on 16 MHz or SCP and TX on 64 MHz)
-        // only enable DGC for PRF 64
-        if ((((chan_ctrl & CHAN_CTRL_TX_PCODE_BIT_MASK) >> CHAN_CTRL_TX_PCODE_BIT_OFFSET) >= 9U)
-            && (((chan_ctrl & CHAN_CTRL_TX_PCODE_BIT_MASK) >> CHAN_CTRL_TX_PCODE_BIT_OFFSET) <= 24U))
-        {
-            if ((chan_ctrl & 0x1U) != 0U)
-            {
-                channel = 9;
-            }
-
-            /* If the OTP has DGC info programmed into it, do a manual kick from OTP. */
-            if (LOCAL_DATA(dw)->dgc_otp_set != (uint8_t)DWT_DGC_LOAD_FROM_OTP)
-            {
-                ull_configmrxlut(dw, (int32_t)channel); /* Manually program hard-coded values into the DGC registers. */
-            }
-        }
-        dwt_write32bitreg(dw, TX_CTRL_LO_ID, TX_CTRL_LO_DEF);
         (void)ull_pgf_cal(dw, 1);
 
         (void)ull_adcoffsetscalibration(dw);
     }
+
+    SLEEPPROF_MARK(SLEEPPROF_FIRST_TXRX);
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -1774,6 +2095,28 @@ int32_t ull_setpdoamode(dwchip_t *dw, dwt_pdoa_mode_e pdoaMode)
     return (int32_t)DWT_SUCCESS;
 }
 
+/**
+ * dwt_config_applied() - Record the configuration applied by ull_configure() or ull_reconfigure(), for
+ * ull_reconfigure() to compare the next one with
+ * @dw: DW3720 chip descriptor handler.
+ * @config: configuration applied
+ * @error: DWT_SUCCESS if it was fully applied
+ */
+static void dwt_config_applied(dwchip_t *dw, const dwt_config_t *config, int32_t error)
+{
+    LOCAL_DATA(dw)->config = *config;
+    LOCAL_DATA(dw)->config_valid = (error == (int32_t)DWT_SUCCESS) ? 1U : 0U;
+}
+
+/**
+ * dwt_prf64() - Whether a preamble code is one of PRF 64 MHz, using the DGC
+ * @code: preamble code
+ */
+static uint8_t dwt_prf64(uint8_t code)
+{
+    return ((code >= 9U) && (code <= 24U)) ? 1U : 0U;
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function provides the main API for the configuration of the
  * DW3720 and this low-level driver.  The input is a pointer to the data structure
@@ -1787,6 +2130,8 @@ int32_t ull_setpdoamode(dwchip_t *dw, dwt_pdoa_mode_e pdoaMode)
  * @return DWT_SUCCESS or DWT_ERROR
  * Note: If the RX calibration routine fails the device receiver performance will be severely affected,
  * the application should reset device and try again
+ * Note: with AUTO_PLL_CAL each call first reads the temperature with ull_readtempvbat(), for the band of the PLL
+ * calibration cache and the VDDDIG setting: two blocking SAR conversions, about 24 SPI transactions.
  *
  */
 static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
@@ -1820,6 +2165,7 @@ static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
 #endif
     uint32_t sts_threshold_calc;
 
+    LOCAL_DATA(dw)->config_valid = 0U;
     LOCAL_DATA(dw)->preamble_len = ((config->txPreambLength + 1U) * 8U);
 
     LOCAL_DATA(dw)->sleep_mode &= (~((uint16_t)DWT_ALT_OPS | (uint16_t)DWT_SEL_OPS3)); // clear the sleep mode ALT_OPS bit
@@ -1832,7 +2178,7 @@ static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
 #ifdef AUTO_PLL_CAL
     // Set the temperature of the device so calibration can use it.
     uint16_t tempvbat = ull_readtempvbat(dw);
-    LOCAL_DATA(dw)->temperature = ull_convertrawtemperature(dw, tempvbat >> 8U);  // Temperature in upper 8 bits
+    LOCAL_DATA(dw)->temperature = (int8_t)(ull_convertrawtemperature_cdeg(dw, (uint8_t)(tempvbat >> 8U)) / 100);  // Temperature in upper 8 bits
 
     if((LOCAL_DATA(dw)->temperature >= 0) && (LOCAL_DATA(dw)->vdddig_otp != 0U)) // If OTP is not provisioned, we cannot use set_vdddig_mv
     {
@@ -1926,6 +2272,8 @@ static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
     temp |= (CHAN_CTRL_SFD_TYPE_BIT_MASK & ((uint32_t)config->sfdType << CHAN_CTRL_SFD_TYPE_BIT_OFFSET));
 
     dwt_write32bitoffsetreg(dw, CHAN_CTRL_ID, 0U, temp);
+    LOCAL_DATA(dw)->rxCode = config->rxCode;
+    airtime_calc(config, &LOCAL_DATA(dw)->airtime);
 
     if(config->txPreambLength == DWT_PLEN_4096)
     {
@@ -2004,6 +2352,9 @@ static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
 
     dwt_write32bitreg(dw, TX_CTRL_LO_ID, TX_CTRL_LO_DEF);
 
+    // Precompute the register writes of ull_restoreconfig() for this configuration
+    dwt_wake_build(dw);
+
     ///////////////////////
     // PGF
     // Update: limited number of silicon shown that running PGF_CAL solely after power-on may lead to reduced receiver performance.
@@ -2020,70 +2371,270 @@ static int32_t ull_configure(dwchip_t *dw, dwt_config_t *config)
     }
 #endif
     error = ull_adcoffsetscalibration(dw);
+    dwt_config_applied(dw, config, error);
     return error;
 } // end ull_configure()
 
 /*! ------------------------------------------------------------------------------------------------------------------
- * @brief This function runs the PGF calibration. This is needed prior to reception.
- * Note: If the RX calibration routine fails the device receiver performance will be severely affected, the application should reset and try again
+ * @brief This function applies a configuration as ull_configure() does, but only writes the registers depending on
+ * the fields which differ from the configuration last applied by ull_configure() or ull_reconfigure(). The PLL is
+ * only calibrated again when the channel changes, and the DGC LUTs are only loaded and the RX calibrated again when
+ * the PRF of the RX preamble code changes. It runs ull_configure() when there is no previous configuration, when
+ * the channel changes or when either configuration uses SCP preamble codes.
+ *
+ * NOTE: Settings changed by other calls since the last configuration (e.g. ull_setstslength(),
+ * ull_configurestsmode()) are not seen, call ull_configure() after them.
  *
  * input parameters
- * @param dw    - DW3720 chip descriptor handler.
- * @param ldoen - if set to 1 the function will enable LDOs prior to calibration and disable afterwards.
+ * @param dw        -   DW3720 chip descriptor handler.
+ * @param config    -   pointer to the configuration structure, which contains the device configuration data.
  *
- * return result of PGF calibration (DWT_ERROR/-1 = error)
+ * return DWT_SUCCESS or DWT_ERROR
  */
-int32_t ull_pgf_cal(dwchip_t *dw, int32_t ldoen)
+int32_t ull_reconfigure(dwchip_t *dw, dwt_config_t *config)
 {
-    int32_t temp;
-    uint16_t val;
+    const dwt_config_t *last = &LOCAL_DATA(dw)->config;
+    uint16_t sleep_mode = LOCAL_DATA(dw)->sleep_mode;
+    uint16_t preamble_len = LOCAL_DATA(dw)->preamble_len;
+    uint8_t scp = ((config->rxCode > 24U) || (config->txCode > 24U) || (last->rxCode > 24U) || (last->txCode > 24U)) ? 1U : 0U;
+    int32_t error = (int32_t)DWT_SUCCESS;
 
-    // PGF needs LDOs turned on - ensure PGF LDOs are enabled
-    if (ldoen == 1)
+    // Don't allow 0 - SFD timeout will always be enabled
+    if (config->sfdTO == 0U)
     {
-        val = dwt_read16bitoffsetreg(dw, LDO_CTRL_ID, 0U);
+        config->sfdTO = DWT_SFDTOC_DEF;
+    }
 
-        dwt_or16bitoffsetreg(dw, LDO_CTRL_ID, 0U,
-            (uint16_t)(LDO_CTRL_LDO_VDDIF2_EN_BIT_MASK | LDO_CTRL_LDO_VDDMS3_EN_BIT_MASK | LDO_CTRL_LDO_VDDMS2_EN_BIT_MASK | // This usually enabled already for the PLL
-                LDO_CTRL_LDO_VDDMS1_EN_BIT_MASK));
+    if ((LOCAL_DATA(dw)->config_valid == 0U) || (config->chan != last->chan) || (scp != 0U))
+    {
+        return ull_configure(dw, config);
     }
-    // Give the reference time to settle after enabling 4 LDOs simultaneously
-    deca_usleep(DELAY_20uUSec);
 
-    // Run PGF Cal
-    temp = ull_run_pgfcal(dw);
+    LOCAL_DATA(dw)->config_valid = 0U;
 
-    // Turn off RX LDOs if previously off
-    if (ldoen == 1)
+    if ((config->phrMode != last->phrMode) || (config->phrRate != last->phrRate) || (config->stsMode != last->stsMode)
+        || (config->pdoaMode != last->pdoaMode))
     {
-        dwt_and16bitoffsetreg(dw, LDO_CTRL_ID, 0U, val); // restore LDO values
+        dwt_modify32bitoffsetreg(dw, SYS_CFG_ID, 0U,
+            ~(SYS_CFG_PHR_MODE_BIT_MASK | SYS_CFG_PHR_6M8_BIT_MASK | SYS_CFG_CP_SPC_BIT_MASK | SYS_CFG_PDOA_MODE_BIT_MASK | SYS_CFG_CP_SDC_BIT_MASK),
+            ((uint32_t)config->pdoaMode << (uint32_t)SYS_CFG_PDOA_MODE_BIT_OFFSET) |
+            (((uint32_t)config->stsMode & (uint32_t)DWT_STS_CONFIG_MASK) << (uint32_t)SYS_CFG_CP_SPC_BIT_OFFSET) |
+            (SYS_CFG_PHR_6M8_BIT_MASK & ((uint32_t)config->phrRate << SYS_CFG_PHR_6M8_BIT_OFFSET)) |
+            ((config->phrMode == DWT_PHRMODE_EXT) ? SYS_CFG_PHR_MODE_BIT_MASK : 0UL));
+        LOCAL_DATA(dw)->longFrames = (uint8_t)config->phrMode;
+        LOCAL_DATA(dw)->stsconfig = (uint8_t)config->stsMode;
     }
-    return temp;
-}
 
-/*! ------------------------------------------------------------------------------------------------------------------
- * @brief This function runs the PGF calibration. This is needed prior to reception.
- *
- * input parameters
- * @param dw - DW3720 chip descriptor handler.
- *
- * return result of PGF calibration (DWT_ERROR/-1 = error)
- */
-int32_t ull_run_pgfcal(dwchip_t *dw)
-{
-    int32_t result = (int32_t)DWT_SUCCESS;
-    uint32_t val = 0UL;
-    uint8_t cnt, flag;
-    // put into cal mode
-    dwt_or8bitoffsetreg(dw, RX_CAL_CFG_ID, 0x0U, RX_CAL_CFG_CAL_MODE_BIT_MASK & 0x1U);
-    // Trigger PGF Cal
-    dwt_or8bitoffsetreg(dw, RX_CAL_CFG_ID, 0x0U, RX_CAL_CFG_CAL_EN_BIT_MASK);
+    if (config->stsLength != last->stsLength)
+    {
+        uint16_t sts_len = GET_STS_REG_SET_VALUE((uint16_t)(config->stsLength));
+        uint32_t sts_threshold_calc = ((((uint32_t)sts_len) * 8UL * STSQUAL_THRESH_64_SH15) >> 15UL);
 
-    flag = 1U;
-    for (cnt = 0U; cnt < MAX_RETRIES_FOR_PGF; cnt++)
+        LOCAL_DATA(dw)->ststhreshold = (int16_t)sts_threshold_calc;
+        LOCAL_DATA(dw)->stsLength = config->stsLength;
+        dwt_write8bitoffsetreg(dw, STS_CFG0_ID, 0U, (uint8_t)(sts_len - 1U)); /*Starts from 0 that is why -1*/
+    }
+
+    if ((config->txPreambLength != last->txPreambLength) || (config->stsMode != last->stsMode)
+        || (config->stsLength != last->stsLength) || (config->pdoaMode != last->pdoaMode))
     {
-        deca_usleep(DELAY_20uUSec);
-        if (dwt_read8bitoffsetreg(dw, RX_CAL_STS_ID, 0x0U) == 1U)
+        // ull_setpdoamode() adds the STS to the preamble length
+        LOCAL_DATA(dw)->preamble_len = ((config->txPreambLength + 1U) * 8U);
+        error = ull_setpdoamode(dw, config->pdoaMode);
+        if (error != (int32_t)DWT_SUCCESS)
+        {
+            return error;
+        }
+
+        // OPS table for the preamble length
+        if ((LOCAL_DATA(dw)->preamble_len >= 256U) != (preamble_len >= 256U))
+        {
+            LOCAL_DATA(dw)->sleep_mode &= (uint16_t)~(uint16_t)DWT_SEL_OPS3;
+            if (LOCAL_DATA(dw)->preamble_len >= 256U)
+            {
+                LOCAL_DATA(dw)->sleep_mode |= (uint16_t)DWT_SEL_OPS0;
+                dwt_modify16bitoffsetreg(dw, OTP_CFG_ID, 0U, ~((uint16_t)OTP_CFG_OPS_ID_BIT_MASK),
+                                         (uint16_t)DWT_OPSET_LONG | (uint16_t)OTP_CFG_OPS_KICK_BIT_MASK);
+            }
+            else
+            {
+                LOCAL_DATA(dw)->sleep_mode |= (uint16_t)DWT_SEL_OPS2;
+                dwt_modify16bitoffsetreg(dw, OTP_CFG_ID, 0U, (uint16_t) ~(OTP_CFG_OPS_ID_BIT_MASK),
+                                         (uint16_t)DWT_OPSET_SHORT | (uint16_t)OTP_CFG_OPS_KICK_BIT_MASK);
+            }
+        }
+
+        if ((LOCAL_DATA(dw)->preamble_len > 64U) != (preamble_len > 64U))
+        {
+            dwt_modify32bitoffsetreg(dw, DTUNE4_ID, 0x0U, (uint32_t)~DTUNE4_RX_SFD_HLDOFF_BIT_MASK,
+                                     (LOCAL_DATA(dw)->preamble_len > 64U) ? (uint32_t)RX_SFD_HLDOFF : (uint32_t)RX_SFD_HLDOFF_DEF);
+        }
+    }
+
+    if ((config->rxPAC != last->rxPAC) || (config->pdoaMode != last->pdoaMode))
+    {
+        if (config->pdoaMode == DWT_PDOA_M1)
+        {
+            dwt_modify8bitoffsetreg(dw, DTUNE0_ID, 0U, (uint8_t)~(DTUNE0_PRE_PAC_SYM_BIT_MASK | DTUNE0_DT0B4_BIT_MASK), (uint8_t)config->rxPAC); /* Disable STS CMF, and configure PAC size */
+        }
+        else
+        {
+            dwt_modify8bitoffsetreg(dw, DTUNE0_ID, 0U, (uint8_t)~DTUNE0_PRE_PAC_SYM_BIT_MASK, (uint8_t)config->rxPAC | DTUNE0_DT0B4_BIT_MASK); /* Enable STS CMF, and configure PAC size */
+        }
+    }
+
+    if ((((uint16_t)config->stsMode ^ (uint16_t)last->stsMode) & (uint16_t)DWT_STS_MODE_ND) != 0U)
+    {
+        // lower preamble detection threshold for no data STS mode
+        dwt_write32bitoffsetreg(dw, DTUNE3_ID, 0U,
+            ((((uint16_t)config->stsMode) & (uint16_t)DWT_STS_MODE_ND) == (uint16_t)DWT_STS_MODE_ND) ? PD_THRESH_NO_DATA : PD_THRESH_DEFAULT);
+    }
+
+    if ((config->rxCode != last->rxCode) || (config->txCode != last->txCode) || (config->sfdType != last->sfdType))
+    {
+        uint32_t temp = dwt_read32bitoffsetreg(dw, CHAN_CTRL_ID, 0U);
+
+        temp &= (~(CHAN_CTRL_RX_PCODE_BIT_MASK | CHAN_CTRL_TX_PCODE_BIT_MASK | CHAN_CTRL_SFD_TYPE_BIT_MASK));
+        temp |= (CHAN_CTRL_RX_PCODE_BIT_MASK & ((uint32_t)config->rxCode << CHAN_CTRL_RX_PCODE_BIT_OFFSET));
+        temp |= (CHAN_CTRL_TX_PCODE_BIT_MASK & ((uint32_t)config->txCode << CHAN_CTRL_TX_PCODE_BIT_OFFSET));
+        temp |= (CHAN_CTRL_SFD_TYPE_BIT_MASK & ((uint32_t)config->sfdType << CHAN_CTRL_SFD_TYPE_BIT_OFFSET));
+        dwt_write32bitoffsetreg(dw, CHAN_CTRL_ID, 0U, temp);
+        LOCAL_DATA(dw)->rxCode = config->rxCode;
+    }
+
+    if ((config->txPreambLength != last->txPreambLength) || (config->dataRate != last->dataRate))
+    {
+        // DW3720 accept DWT_PLEN_4096 only via TXPSR field, with FINE_PLEN cleared
+        uint32_t txpsr = (config->txPreambLength == DWT_PLEN_4096) ? (0x3UL << TX_FCTRL_TXPSR_BIT_OFFSET) : 0UL;
+
+        ull_setplenfine(dw, (config->txPreambLength == DWT_PLEN_4096) ? 0U : (uint8_t)config->txPreambLength);
+        dwt_modify32bitoffsetreg(dw, TX_FCTRL_ID, 0U, ~(TX_FCTRL_TXBR_BIT_MASK | TX_FCTRL_TXPSR_BIT_MASK),
+            ((uint32_t)config->dataRate << TX_FCTRL_TXBR_BIT_OFFSET) | txpsr);
+    }
+
+    if (config->sfdTO != last->sfdTO)
+    {
+        dwt_write16bitoffsetreg(dw, DTUNE0_ID, 2U, config->sfdTO);
+    }
+
+    airtime_calc(config, &LOCAL_DATA(dw)->airtime);
+
+    // DGC only for PRF 64, its LUTs only depend on the channel
+    if (dwt_prf64(config->rxCode) != dwt_prf64(last->rxCode))
+    {
+        if (dwt_prf64(config->rxCode) != 0U)
+        {
+            if (LOCAL_DATA(dw)->dgc_otp_set != (uint8_t)DWT_DGC_LOAD_FROM_OTP)
+            {
+                ull_configmrxlut(dw, (int32_t)config->chan);
+                LOCAL_DATA(dw)->sleep_mode &= ~((uint16_t)DWT_LOADDGC);
+            }
+            else
+            {
+                dwt_or16bitoffsetreg(dw, OTP_CFG_ID, 0U, OTP_CFG_DGC_KICK_BIT_MASK);
+                LOCAL_DATA(dw)->sleep_mode |= (uint16_t)DWT_LOADDGC;
+            }
+            dwt_modify16bitoffsetreg(dw, DGC_CFG_ID, 0x0U, (uint16_t)~DGC_CFG_THR_64_BIT_MASK, (uint16_t)DWT_DGC_CFG << DGC_CFG_THR_64_BIT_OFFSET);
+        }
+        else
+        {
+            dwt_and8bitoffsetreg(dw, DGC_CFG_ID, 0x0U, (uint8_t)~DGC_CFG_RX_TUNE_EN_BIT_MASK);
+        }
+    }
+
+    // The wake profile depends on the OPS table and on the PRF of the TX preamble code
+    if ((LOCAL_DATA(dw)->sleep_mode != sleep_mode) || (dwt_prf64(config->txCode) != dwt_prf64(last->txCode)))
+    {
+        dwt_wake_build(dw);
+    }
+
+    if (dwt_prf64(config->rxCode) != dwt_prf64(last->rxCode))
+    {
+        error = ull_pgf_cal(dw, 1);
+        if (error == (int32_t)DWT_SUCCESS)
+        {
+            error = ull_adcoffsetscalibration(dw);
+        }
+    }
+
+    dwt_config_applied(dw, config, error);
+    return error;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function returns the frame timing of the configuration last set with ull_configure().
+ *
+ * input parameters
+ * @param dw        -   DW3000 chip descriptor handler.
+ *
+ * return pointer to the frame timing, all zero until ull_configure() is called
+ */
+const dwt_airtime_t *ull_getairtime(dwchip_t *dw)
+{
+    return &LOCAL_DATA(dw)->airtime;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function runs the PGF calibration. This is needed prior to reception.
+ * Note: If the RX calibration routine fails the device receiver performance will be severely affected, the application should reset and try again
+ *
+ * input parameters
+ * @param dw    - DW3720 chip descriptor handler.
+ * @param ldoen - if set to 1 the function will enable LDOs prior to calibration and disable afterwards.
+ *
+ * return result of PGF calibration (DWT_ERROR/-1 = error)
+ */
+int32_t ull_pgf_cal(dwchip_t *dw, int32_t ldoen)
+{
+    int32_t temp;
+    uint16_t val;
+
+    // PGF needs LDOs turned on - ensure PGF LDOs are enabled
+    if (ldoen == 1)
+    {
+        val = dwt_read16bitoffsetreg(dw, LDO_CTRL_ID, 0U);
+
+        dwt_or16bitoffsetreg(dw, LDO_CTRL_ID, 0U,
+            (uint16_t)(LDO_CTRL_LDO_VDDIF2_EN_BIT_MASK | LDO_CTRL_LDO_VDDMS3_EN_BIT_MASK | LDO_CTRL_LDO_VDDMS2_EN_BIT_MASK | // This usually enabled already for the PLL
+                LDO_CTRL_LDO_VDDMS1_EN_BIT_MASK));
+    }
+    // Give the reference time to settle after enabling 4 LDOs simultaneously
+    deca_usleep(DELAY_20uUSec);
+
+    // Run PGF Cal
+    temp = ull_run_pgfcal(dw);
+
+    // Turn off RX LDOs if previously off
+    if (ldoen == 1)
+    {
+        dwt_and16bitoffsetreg(dw, LDO_CTRL_ID, 0U, val); // restore LDO values
+    }
+    return temp;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function runs the PGF calibration. This is needed prior to reception.
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * return result of PGF calibration (DWT_ERROR/-1 = error)
+ */
+int32_t ull_run_pgfcal(dwchip_t *dw)
+{
+    int32_t result = (int32_t)DWT_SUCCESS;
+    uint32_t val = 0UL;
+    uint8_t cnt, flag;
+    // put into cal mode
+    dwt_or8bitoffsetreg(dw, RX_CAL_CFG_ID, 0x0U, RX_CAL_CFG_CAL_MODE_BIT_MASK & 0x1U);
+    // Trigger PGF Cal
+    dwt_or8bitoffsetreg(dw, RX_CAL_CFG_ID, 0x0U, RX_CAL_CFG_CAL_EN_BIT_MASK);
+
+    flag = 1U;
+    for (cnt = 0U; cnt < MAX_RETRIES_FOR_PGF; cnt++)
+    {
+        deca_usleep(DELAY_20uUSec);
+        if (dwt_read8bitoffsetreg(dw, RX_CAL_STS_ID, 0x0U) == 1U)
         { // PGF cal is complete
             flag = 0U;
             break;
@@ -3153,15 +3704,15 @@ void ull_readdiagnostics(dwchip_t *dw, dwt_rxdiag_t *diagnostics)
         diagnostics->stsRxStatus = ((((uint16_t)temp[BUF0_STS_STAT - BUF0_RX_FINFO + CIA_C_STAT_OFFSET + 1UL] << 8U) +
                                       (uint16_t)temp[BUF0_STS_STAT - BUF0_RX_FINFO + CIA_C_STAT_OFFSET]) >> 7U);
         // Phase of arrival as computed from the STS 1 CIR (signed rad*2-12)
-        diagnostics->stsPOA = (((uint16_t)temp[BUF0_STS_TS - BUF0_RX_FINFO + 2UL] << 8U) |
-                                (uint16_t)temp[BUF0_STS_TS - BUF0_RX_FINFO + 1UL]);
+        diagnostics->stsPOA = (((uint16_t)temp[BUF0_STS_STAT - BUF0_RX_FINFO + 2UL] << 8U) |
+                                (uint16_t)temp[BUF0_STS_STAT - BUF0_RX_FINFO + 1UL]);
 
         // RX status info for STS1
         diagnostics->sts2RxStatus = ((((uint16_t)temp[BUF0_STS1_STAT - BUF0_RX_FINFO + CIA_C_STAT_OFFSET + 1UL] << 8U) +
                                        (uint16_t)temp[BUF0_STS1_STAT - BUF0_RX_FINFO + CIA_C_STAT_OFFSET]) >> 7U);
         // Phase of arrival as computed from the STS 1 CIR (signed rad*2-12)
-        diagnostics->sts2POA = (((uint16_t)temp[BUF0_STS1_TS - BUF0_RX_FINFO + 2UL] << 8U) |
-                                 (uint16_t)temp[BUF0_STS1_TS - BUF0_RX_FINFO + 1UL]);
+        diagnostics->sts2POA = (((uint16_t)temp[BUF0_STS1_STAT - BUF0_RX_FINFO + 2UL] << 8U) |
+                                 (uint16_t)temp[BUF0_STS1_STAT - BUF0_RX_FINFO + 1UL]);
 
         if ((LOCAL_DATA(dw)->cia_diagnostic & (uint8_t)DW_CIA_DIAG_LOG_MID) != 0U)
         {
@@ -3324,7 +3875,7 @@ void ull_readdiagnostics(dwchip_t *dw, dwt_rxdiag_t *diagnostics)
 
         // RX status info for STS
         diagnostics->sts2RxStatus = ((((uint16_t)temp[STS1_TOA_HI_ID - IP_TOA_LO_ID + CIA_C_STAT_OFFSET + 1UL] << 8U) |
-                                       (uint16_t)temp[STS_TOA_HI_ID - IP_TOA_LO_ID + CIA_C_STAT_OFFSET]) >> 7U);
+                                       (uint16_t)temp[STS1_TOA_HI_ID - IP_TOA_LO_ID + CIA_C_STAT_OFFSET]) >> 7U);
         // Phase of arrival as computed from the STS 1 CIR (signed rad*2-12)
         diagnostics->sts2POA = (((uint16_t)temp[STS1_TOA_HI_ID - IP_TOA_LO_ID + 2UL] << 8U) |
                                  (uint16_t)temp[STS1_TOA_HI_ID - IP_TOA_LO_ID + 1UL]);
@@ -3475,6 +4026,308 @@ void ull_readdiagnostics(dwchip_t *dw, dwt_rxdiag_t *diagnostics)
     diagnostics->tdoa[5] &= 0x01U; // TDoA is 41-bits
 }
 
+/* Diagnostic register span backing one dwt_diag_sel_e field group. Offsets are linear byte offsets of the first
+ * register: from IP_TOA_LO_ID in normal mode (the 0xD0000 file follows on directly after the 0xC0000 file, as in
+ * ull_readdiagnostics()) and from BUF0_RX_FINFO in double buffer mode. The layout within the span is the same in
+ * both modes. */
+typedef struct
+{
+    uint32_t sel;       // dwt_diag_sel_e value
+    uint8_t offset;     // normal mode offset
+    uint8_t db_offset;  // double buffer mode offset
+    uint8_t len;        // span length in bytes
+} diag_sel_span_t;
+
+#define DIAG_SEL_OFFSET_0XD (STS_DIAG_3_LEN + STS_DIAG_3_ID - IP_TOA_LO_ID) // 0x6C bytes in 0xC0000 base before we enter 0xD0000
+#define DIAG_SEL_OFF(id)    ((uint8_t)((id) - IP_TOA_LO_ID))
+#define DIAG_SEL_OFF_D(id)  ((uint8_t)((id) - STS_DIAG_4_ID + DIAG_SEL_OFFSET_0XD))
+#define DIAG_SEL_DB(id)     ((uint8_t)((id) - BUF0_RX_FINFO))
+#define DIAG_SEL_SUB_MAX    0x7FU // highest sub-address of a transaction, the swinging set goes on to DB_MAX_DIAG_SIZE
+
+// Offset of the phase of arrival within a time stamp span: it follows the time stamp in both modes, in the same
+// word as its 5th byte (IP_TOA_HI, STS_TOA_HI, STS1_TOA_HI, or BUF0_RES2, BUF0_STS_STAT, BUF0_STS1_STAT)
+#define DIAG_SEL_IP_POA  CIA_I_RX_TIME_LEN
+#define DIAG_SEL_STS_POA CIA_C_RX_TIME_LEN
+
+static const diag_sel_span_t diag_sel_spans[] = {
+    { (uint32_t)DWT_DIAG_SEL_IP_TOA,        DIAG_SEL_OFF(IP_TOA_LO_ID),         DIAG_SEL_DB(BUF0_IP_TS),        8U },
+    { (uint32_t)DWT_DIAG_SEL_STS_TOA,       DIAG_SEL_OFF(STS_TOA_LO_ID),        DIAG_SEL_DB(BUF0_STS_TS),       8U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_TOA,      DIAG_SEL_OFF(STS1_TOA_LO_ID),       DIAG_SEL_DB(BUF0_STS1_TS),      8U },
+    { (uint32_t)DWT_DIAG_SEL_TDOA,          DIAG_SEL_OFF(CIA_TDOA_0_ID),        DIAG_SEL_DB(BUF0_TDOA),         6U },
+    { (uint32_t)DWT_DIAG_SEL_PDOA,          DIAG_SEL_OFF(CIA_TDOA_1_PDOA_ID) + 2U, DIAG_SEL_DB(BUF0_PDOA) + 2U, 2U },
+    { (uint32_t)DWT_DIAG_SEL_XTAL_OFFSET,   DIAG_SEL_OFF(CIA_DIAG_0_ID),        DIAG_SEL_DB(BUF0_CIA_DIAG_0),   2U },
+    { (uint32_t)DWT_DIAG_SEL_CIA_DIAG1,     DIAG_SEL_OFF(CIA_DIAG_1_ID),        DIAG_SEL_DB(BUF0_CIA_DIAG_1),   4U },
+    { (uint32_t)DWT_DIAG_SEL_IP_PEAK,       DIAG_SEL_OFF(IP_DIAG_0_ID),         DIAG_SEL_DB(BUF0_IP_DIAG_0),    4U },
+    { (uint32_t)DWT_DIAG_SEL_IP_POWER,      DIAG_SEL_OFF(IP_DIAG_1_ID),         DIAG_SEL_DB(BUF0_IP_DIAG_1),    4U },
+    { (uint32_t)DWT_DIAG_SEL_IP_F,          DIAG_SEL_OFF(IP_DIAG_2_ID),         DIAG_SEL_DB(BUF0_IP_DIAG_2),    12U },
+    { (uint32_t)DWT_DIAG_SEL_IP_FP_INDEX,   DIAG_SEL_OFF(IP_DIAG_8_ID),         DIAG_SEL_DB(BUF0_IP_DIAG_8),    2U },
+    { (uint32_t)DWT_DIAG_SEL_IP_ACCUM,      DIAG_SEL_OFF(IP_DIAG_12_ID),        DIAG_SEL_DB(BUF0_IP_DIAG_12),   2U },
+    { (uint32_t)DWT_DIAG_SEL_STS_PEAK,      DIAG_SEL_OFF(STS_DIAG_0_ID),        DIAG_SEL_DB(BUF0_STS_DIAG_0),   4U },
+    { (uint32_t)DWT_DIAG_SEL_STS_POWER,     DIAG_SEL_OFF(STS_DIAG_1_ID),        DIAG_SEL_DB(BUF0_STS_DIAG_1),   2U },
+    { (uint32_t)DWT_DIAG_SEL_STS_F,         DIAG_SEL_OFF(STS_DIAG_2_ID),        DIAG_SEL_DB(BUF0_STS_DIAG_2),   12U }, // STS_DIAG_4 is in 0xD0000
+    { (uint32_t)DWT_DIAG_SEL_STS_FP_INDEX,  DIAG_SEL_OFF_D(STS_DIAG_8_ID),      DIAG_SEL_DB(BUF0_STS_DIAG_8),   2U },
+    { (uint32_t)DWT_DIAG_SEL_STS_ACCUM,     DIAG_SEL_OFF_D(STS_DIAG_12_ID),     DIAG_SEL_DB(BUF0_STS_DIAG_12),  2U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_PEAK,     DIAG_SEL_OFF_D(STS1_DIAG_0_ID),     DIAG_SEL_DB(BUF0_STS1_DIAG_0),  4U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_POWER,    DIAG_SEL_OFF_D(STS1_DIAG_1_ID),     DIAG_SEL_DB(BUF0_STS1_DIAG_1),  2U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_F,        DIAG_SEL_OFF_D(STS1_DIAG_2_ID),     DIAG_SEL_DB(BUF0_STS1_DIAG_2),  12U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_FP_INDEX, DIAG_SEL_OFF_D(STS1_DIAG_8_ID),     DIAG_SEL_DB(BUF0_STS1_DIAG_8),  2U },
+    { (uint32_t)DWT_DIAG_SEL_STS2_ACCUM,    DIAG_SEL_OFF_D(STS1_DIAG_12_ID),    DIAG_SEL_DB(BUF0_STS1_DIAG_12), 2U },
+};
+
+#define DIAG_SEL_NUM_SPANS (sizeof(diag_sel_spans) / sizeof(diag_sel_spans[0]))
+
+static inline uint16_t diag_sel_get16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[1] << 8U) | (uint16_t)p[0]);
+}
+
+static inline uint32_t diag_sel_get32(const uint8_t *p)
+{
+    return (((uint32_t)p[3] << 24UL) | ((uint32_t)p[2] << 16UL) | ((uint32_t)p[1] << 8UL) | (uint32_t)p[0]);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief this function reads a subset of the RX signal quality diagnostic data. The register spans backing the selected
+ *        fields are collected into a byte map, spans closer than DWT_DIAG_SEL_MERGE_GAP are coalesced and each resulting
+ *        run is fetched with a single SPI transaction (never crossing from the 0xC0000 into the 0xD0000 register file).
+ *        Fields not logged for the current CIA diagnostic level are dropped from the selection.
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ * @param field_mask - bitmask of dwt_diag_sel_e values selecting the fields to read
+ *
+ * output parameters
+ * @param diagnostics - diagnostic structure pointer, the selected fields will be updated with the data read from the DW3000
+ *
+ * returns the bitmask of dwt_diag_sel_e values which have been updated
+ */
+uint32_t ull_readdiagnostics_sel(dwchip_t *dw, dwt_rxdiag_t *diagnostics, uint32_t field_mask)
+{
+    uint8_t temp[DB_MAX_DIAG_SIZE];
+    uint32_t need[(DB_MAX_DIAG_SIZE + 31U) / 32U] = { 0UL };
+    const uint8_t *p;
+    uint32_t sel = 0UL;
+    uint32_t base;
+    uint16_t limit;
+    uint16_t start, end, gap;
+    uint16_t pdoa_calc, xtal_offset_calc;
+    int32_t dblbuff = (LOCAL_DATA(dw)->dblbuffon != (uint8_t)DBL_BUFF_OFF) ? 1 : 0;
+
+    // work out how much of the diagnostic set the CIA has actually logged
+    if (dblbuff != 0)
+    {
+        base = (LOCAL_DATA(dw)->dblbuffon == (uint8_t)DBL_BUFF_ACCESS_BUFFER_1) ? INDIRECT_POINTER_B_ID : BUF0_RX_FINFO;
+        if ((LOCAL_DATA(dw)->cia_diagnostic & (uint8_t)DW_CIA_DIAG_LOG_MAX) != 0U)
+        {
+            limit = DB_MAX_DIAG_SIZE;
+        }
+        else if ((LOCAL_DATA(dw)->cia_diagnostic & (uint8_t)DW_CIA_DIAG_LOG_MID) != 0U)
+        {
+            limit = DB_MID_DIAG_SIZE;
+        }
+        else
+        {
+            limit = DB_MIN_DIAG_SIZE;
+        }
+    }
+    else
+    {
+        base = IP_TOA_LO_ID;
+        if ((LOCAL_DATA(dw)->cia_diagnostic & (uint8_t)DW_CIA_DIAG_LOG_ALL) != 0U)
+        {
+            limit = (uint16_t)(DIAG_SEL_OFFSET_0XD * 2U);
+        }
+        else
+        {
+            limit = IP_TOA_LO_IP_TOA_BIT_LEN + (IP_TOA_LO_LEN * 2U);
+        }
+    }
+
+    for (uint32_t i = 0UL; i < DIAG_SEL_NUM_SPANS; i++)
+    {
+        uint16_t off = (dblbuff != 0) ? diag_sel_spans[i].db_offset : diag_sel_spans[i].offset;
+
+        if (((field_mask & diag_sel_spans[i].sel) != 0UL) && ((off + (uint16_t)diag_sel_spans[i].len) <= limit))
+        {
+            sel |= diag_sel_spans[i].sel;
+            for (uint16_t j = off; j < (off + (uint16_t)diag_sel_spans[i].len); j++)
+            {
+                need[j >> 5U] |= (1UL << (j & 0x1FU));
+            }
+        }
+    }
+
+    // read each run of needed bytes, bridging gaps shorter than DWT_DIAG_SEL_MERGE_GAP
+    start = 0U;
+    while (start < limit)
+    {
+        if ((need[start >> 5U] & (1UL << (start & 0x1FU))) == 0UL)
+        {
+            start++;
+            continue;
+        }
+
+        end = start + 1U;
+        gap = 0U;
+        // in double buffer mode a run which goes past the last sub-address goes on to the end of the selection
+        while ((end < limit) && ((gap <= DWT_DIAG_SEL_MERGE_GAP) || ((dblbuff != 0) && (end > DIAG_SEL_SUB_MAX))))
+        {
+            if ((dblbuff == 0) && (end == DIAG_SEL_OFFSET_0XD))
+            {
+                break; // no single transaction can span both register files
+            }
+            if ((need[end >> 5U] & (1UL << (end & 0x1FU))) != 0UL)
+            {
+                gap = 0U;
+            }
+            else
+            {
+                gap++;
+            }
+            end++;
+        }
+        end -= gap; // trim the trailing unused bytes
+
+        if ((dblbuff != 0) && (start > DIAG_SEL_SUB_MAX))
+        {
+            start = DIAG_SEL_SUB_MAX; // not addressable, read on from the last sub-address
+        }
+        if ((dblbuff == 0) && (start >= DIAG_SEL_OFFSET_0XD))
+        {
+            ull_readfromdevice(dw, STS_DIAG_4_ID, start - (uint16_t)DIAG_SEL_OFFSET_0XD, end - start, &temp[start]);
+        }
+        else
+        {
+            ull_readfromdevice(dw, base, start, end - start, &temp[start]);
+        }
+        start = end;
+    }
+
+    for (uint32_t i = 0UL; i < DIAG_SEL_NUM_SPANS; i++)
+    {
+        if ((sel & diag_sel_spans[i].sel) == 0UL)
+        {
+            continue;
+        }
+        p = &temp[(dblbuff != 0) ? diag_sel_spans[i].db_offset : diag_sel_spans[i].offset];
+
+        switch ((dwt_diag_sel_e)diag_sel_spans[i].sel)
+        {
+        case DWT_DIAG_SEL_IP_TOA:
+            for (uint16_t j = 0U; j < CIA_I_RX_TIME_LEN; j++)
+            {
+                diagnostics->ipatovRxTime[j] = p[j];
+            }
+            // Phase of arrival as computed from the Ipatov CIR (signed rad*2-12)
+            diagnostics->ipatovPOA = diag_sel_get16(&p[DIAG_SEL_IP_POA]);
+            diagnostics->ipatovRxStatus = p[IP_TOA_LO_LEN + CIA_I_STAT_OFFSET];
+            break;
+        case DWT_DIAG_SEL_STS_TOA:
+            for (uint16_t j = 0U; j < CIA_I_RX_TIME_LEN; j++)
+            {
+                diagnostics->stsRxTime[j] = p[j];
+            }
+            diagnostics->stsPOA = diag_sel_get16(&p[DIAG_SEL_STS_POA]);
+            diagnostics->stsRxStatus = diag_sel_get16(&p[IP_TOA_LO_LEN + CIA_C_STAT_OFFSET]) >> 7U;
+            break;
+        case DWT_DIAG_SEL_STS2_TOA:
+            for (uint16_t j = 0U; j < CIA_I_RX_TIME_LEN; j++)
+            {
+                diagnostics->sts2RxTime[j] = p[j];
+            }
+            diagnostics->sts2POA = diag_sel_get16(&p[DIAG_SEL_STS_POA]);
+            diagnostics->sts2RxStatus = diag_sel_get16(&p[IP_TOA_LO_LEN + CIA_C_STAT_OFFSET]) >> 7U;
+            break;
+        case DWT_DIAG_SEL_TDOA:
+            for (uint16_t j = 0U; j < (CIA_I_RX_TIME_LEN + 1U); j++)
+            {
+                diagnostics->tdoa[j] = p[j]; // timestamp difference of the 2 STS RX timestamps
+            }
+            // sign extend to 41-bits to match DW3000/DW3720
+            if ((diagnostics->tdoa[1] & 0x80U) != 0U)
+            {
+                diagnostics->tdoa[2] = 0xFFU;
+                diagnostics->tdoa[3] = 0xFFU;
+                diagnostics->tdoa[4] = 0xFFU;
+                diagnostics->tdoa[5] = 0xFFU;
+            }
+            diagnostics->tdoa[5] &= 0x01U; // TDoA is 41-bits
+            break;
+        case DWT_DIAG_SEL_PDOA:
+            // phase difference of the 2 STS POAs (signed in [1:-11])
+            pdoa_calc = diag_sel_get16(p) & 0x3FFFU;
+            if ((pdoa_calc & 0x2000U) != 0U)
+            {
+                pdoa_calc |= 0xC000U; // sign extend
+            }
+            diagnostics->pdoa = (int16_t)pdoa_calc;
+            break;
+        case DWT_DIAG_SEL_XTAL_OFFSET:
+            xtal_offset_calc = diag_sel_get16(p) & 0x1FFFU;
+            diagnostics->xtalOffset = (int16_t)xtal_offset_calc;
+            break;
+        case DWT_DIAG_SEL_CIA_DIAG1:
+            diagnostics->ciaDiag1 = diag_sel_get32(p) & 0x1FFFFFFFUL;
+            break;
+        case DWT_DIAG_SEL_IP_PEAK:
+            diagnostics->ipatovPeak = diag_sel_get32(p) & 0x7FFFFFFFUL;
+            break;
+        case DWT_DIAG_SEL_IP_POWER:
+            diagnostics->ipatovPower = diag_sel_get32(p) & 0x1FFFFUL;
+            break;
+        case DWT_DIAG_SEL_IP_F:
+            diagnostics->ipatovF1 = diag_sel_get32(p) & 0x3FFFFFUL;
+            diagnostics->ipatovF2 = diag_sel_get32(&p[4]) & 0x3FFFFFUL;
+            diagnostics->ipatovF3 = diag_sel_get32(&p[8]) & 0x3FFFFFUL;
+            break;
+        case DWT_DIAG_SEL_IP_FP_INDEX:
+            diagnostics->ipatovFpIndex = diag_sel_get16(p);
+            break;
+        case DWT_DIAG_SEL_IP_ACCUM:
+            diagnostics->ipatovAccumCount = diag_sel_get16(p) & 0xFFFU;
+            break;
+        case DWT_DIAG_SEL_STS_PEAK:
+            diagnostics->stsPeak = diag_sel_get32(p) & 0x3FFFFFFFUL;
+            break;
+        case DWT_DIAG_SEL_STS_POWER:
+            diagnostics->stsPower = diag_sel_get16(p);
+            break;
+        case DWT_DIAG_SEL_STS_F:
+            diagnostics->stsF1 = diag_sel_get32(p) & 0x3FFFFFUL;
+            diagnostics->stsF2 = diag_sel_get32(&p[4]) & 0x3FFFFFUL;
+            diagnostics->stsF3 = diag_sel_get32(&p[8]) & 0x3FFFFFUL;
+            break;
+        case DWT_DIAG_SEL_STS_FP_INDEX:
+            diagnostics->stsFpIndex = diag_sel_get16(p) & 0x7FFFU;
+            break;
+        case DWT_DIAG_SEL_STS_ACCUM:
+            diagnostics->stsAccumCount = diag_sel_get16(p) & 0xFFFU;
+            break;
+        case DWT_DIAG_SEL_STS2_PEAK:
+            diagnostics->sts2Peak = diag_sel_get32(p) & 0x3FFFFFFFUL;
+            break;
+        case DWT_DIAG_SEL_STS2_POWER:
+            diagnostics->sts2Power = diag_sel_get16(p);
+            break;
+        case DWT_DIAG_SEL_STS2_F:
+            diagnostics->sts2F1 = diag_sel_get32(p) & 0x3FFFFFUL;
+            diagnostics->sts2F2 = diag_sel_get32(&p[4]) & 0x3FFFFFUL;
+            diagnostics->sts2F3 = diag_sel_get32(&p[8]) & 0x3FFFFFUL;
+            break;
+        case DWT_DIAG_SEL_STS2_FP_INDEX:
+            diagnostics->sts2FpIndex = diag_sel_get16(p) & 0x7FFFU;
+            break;
+        case DWT_DIAG_SEL_STS2_ACCUM:
+            diagnostics->sts2AccumCount = diag_sel_get16(p) & 0xFFFU;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return sel;
+}
+
 /*!
  * This function reads the CIA diagnostics for an individual accumulator.
  *
@@ -3892,7 +4745,58 @@ void ull_readrxtimestamp_sts(dwchip_t *dw, uint8_t *timestamp)
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
- * @brief This is used to read the high 32-bits of the RX timestamp (adjusted with the programmed antenna delay)
+ * @brief This is used to read the RX timestamp (adjusted time of arrival) together with the crystal offset (see
+ *        ull_readclockoffset()). In double buffer mode both are read in one SPI transaction from the swinging set.
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ * @param timestamp - a pointer to a 5-byte buffer which will store the read RX timestamp time
+ *
+ * output parameters - the timestamp buffer will contain the value after the function call
+ *
+ * return value - the (int12) signed offset value. (s[-15:-26])
+ *                A positive value means the local (RX) clock is running slower than that of the remote (TX) device.
+ */
+int16_t ull_readrxtimestamp_clkoffset(dwchip_t *dw, uint8_t *timestamp)
+{
+    uint8_t buf[(BUF0_CIA_DIAG_0 - BUF0_RX_TIME) + 2U];
+    uint16_t regval;
+
+    switch ((dwt_dbl_buff_conf_e)LOCAL_DATA(dw)->dblbuffon)
+    // check if in double buffer mode and if so which buffer host is currently accessing
+    {
+    case DBL_BUFF_ACCESS_BUFFER_1:
+        //!!! Assumes that Indirect pointer register B was already set. This is done in the dwt_setdblrxbuffmode when mode is enabled.
+        ull_readfromdevice(dw, INDIRECT_POINTER_B_ID, (uint16_t)(BUF1_RX_TIME - BUF1_RX_FINFO), (uint16_t)sizeof(buf), buf);
+        break;
+    case DBL_BUFF_ACCESS_BUFFER_0:
+        ull_readfromdevice(dw, BUF0_RX_TIME, 0U, (uint16_t)sizeof(buf), buf);
+        break;
+    default:
+        // RX_TIME_0 and CIA_DIAG_0 are in different register files
+        ull_readfromdevice(dw, (uint32_t)RX_TIME_0_ID, 0U, RX_TIME_RX_STAMP_LEN, buf);
+        ull_readfromdevice(dw, CIA_DIAG_0_ID, 0U, 2U, &buf[BUF0_CIA_DIAG_0 - BUF0_RX_TIME]);
+        break;
+    }
+
+    for (uint8_t i = 0U; i < RX_TIME_RX_STAMP_LEN; i++)
+    {
+        timestamp[i] = buf[i];
+    }
+
+    regval = (uint16_t)(((uint16_t)buf[(BUF0_CIA_DIAG_0 - BUF0_RX_TIME) + 1U] << 8U) | (uint16_t)buf[BUF0_CIA_DIAG_0 - BUF0_RX_TIME]);
+    regval &= CIA_DIAG_0_COE_PPM_BIT_MASK;
+    // Bit 12 is sign, make the number to be sign extended if this bit is '1'
+    if ((regval & B12_U16_SIGN_EXTEND_TEST) != 0U)
+    {
+        regval |= B12_U16_SIGN_EXTEND_MASK; // sign extend bit #12 to whole U16 word
+    }
+
+    return (int16_t)regval;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This is used to read the high 32-bits of the RX timestamp (adjusted with the programmed antenna delay)
  *
  * input parameters
  * @param dw - DW3720 chip descriptor handler.
@@ -4364,6 +5268,7 @@ void ull_entersleep(dwchip_t *dw, int32_t idle_rc)
 {
     // OTP low power mode
     ull_dis_otp_ips(dw, 1);
+    dwt_sar_sleep(dw);
 
     // clear auto INIT2IDLE bit if required
     if (idle_rc == (int32_t)DWT_DW_IDLE_RC)
@@ -4374,6 +5279,8 @@ void ull_entersleep(dwchip_t *dw, int32_t idle_rc)
     // Copy config to AON - upload the new configuration
     dwt_write8bitoffsetreg(dw, AON_CTRL_ID, 0U, 0U);
     dwt_write8bitoffsetreg(dw, AON_CTRL_ID, 0U, AON_CTRL_ARRAY_SAVE_BIT_MASK);
+
+    SLEEPPROF_MARK(SLEEPPROF_SLEEP);
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -4489,6 +5396,9 @@ uint16_t ull_calibratesleepcnt(dwchip_t *dw)
 void ull_configuresleep(dwchip_t *dw, uint16_t mode, uint8_t wake)
 {
     uint8_t temp2;
+
+    SLEEPPROF_MARK(SLEEPPROF_CONFIG_SLEEP);
+
     // set LP OSC trim value to increase freq. to max
     ull_aon_write(dw, (uint16_t)AON_LPOSC_TRIM, 0U);
 
@@ -4557,6 +5467,7 @@ void ull_entersleepaftertx(dwchip_t *dw, int32_t enable)
     // Set the auto TX -> sleep bit
     if (enable != 0)
     {
+        dwt_sar_sleep(dw);
         dwt_or16bitoffsetreg(dw, SEQ_CTRL_ID, 0U, (uint16_t)SEQ_CTRL_ATX2SLP_BIT_MASK);
     }
     else
@@ -4609,6 +5520,11 @@ void ull_entersleepafter(dwchip_t *dw, int32_t event_mask)
         seq_ctrl_and &= (uint16_t)~SEQ_CTRL_ARX2SLP_BIT_MASK;
     }
 
+    if (seq_ctrl_or != 0U)
+    {
+        dwt_sar_sleep(dw);
+    }
+
     dwt_modify16bitoffsetreg(dw, SEQ_CTRL_ID, 0, seq_ctrl_and, seq_ctrl_or);
 }
 
@@ -4728,6 +5644,11 @@ void ull_configciadiag(dwchip_t *dw, uint8_t enable_mask)
     {
         dwt_write8bitoffsetreg(dw, RDB_DIAG_MODE_ID, 0U, enable_mask >> 1U);
     }
+
+    if (LOCAL_DATA(dw)->wake_profile.count != 0U)
+    {
+        dwt_wake_build(dw); // the diagnostic level restored on wake has changed
+    }
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -5008,6 +5929,12 @@ static void ull_isr(dwchip_t *dw)
         }
     }
 
+    // TX or RX over, before the callbacks which may start the next one
+    if ((fstat & (FINT_STAT_TXOK_BIT_MASK | FINT_STAT_RXOK_BIT_MASK | FINT_STAT_RXERR_BIT_MASK | FINT_STAT_RXTO_BIT_MASK)) != 0U)
+    {
+        SLEEPPROF_MARK(SLEEPPROF_IDLE);
+    }
+
     // Handle System panic confirmation event
     // AES_ERR|SPICRCERR|BRNOUT|SPI_UNF|SPI_OVR|CMD_ERR|SPI_COLLISION|PLLHILO
     if ((fstat & FINT_STAT_SYS_PANIC_BIT_MASK) != 0U)
@@ -5529,6 +6456,11 @@ int32_t ull_starttx(dwchip_t *dw, uint8_t mode)
         }
     }
 
+    if (retval == (int32_t)DWT_SUCCESS)
+    {
+        SLEEPPROF_MARK(SLEEPPROF_TX);
+    }
+
     return retval;
 
 } // end ull_starttx()
@@ -5562,6 +6494,8 @@ void ull_forcetrxoff(dwchip_t *dw)
         decamutexoff(stat);
     }
     // else device is already in IDLE or IDLE_RC ... must not force to IDLE if in IDLE_RC
+
+    SLEEPPROF_MARK(SLEEPPROF_IDLE);
 } // end ull_forcetrxoff()
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -5670,6 +6604,10 @@ int32_t ull_rxenable(dwchip_t *dw, int32_t mode)
         }
     }
 
+    if (retval == DWT_SUCCESS)
+    {
+        SLEEPPROF_MARK(SLEEPPROF_RX);
+    }
     return (int32_t)retval;
 } // end ull_rxenable()
 
@@ -6288,6 +7226,9 @@ void ull_disablecontinuouswavemode(dwchip_t *dw)
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief this function reads the raw battery voltage and temperature values of the DW IC.
  * The values read here will be the current values sampled by DW IC AtoD converters.
+ * A conversion started by ull_readtempvbat_start() is not restarted: it is finished, and its readings are returned
+ * and still collected by ull_readtempvbat_complete(). If it does not end within SAR_WAIT_POLLS polls, it is given up
+ * as ull_readtempvbat_abort() does and both values are converted again.
  *
  * input parameters:
  * @param dw - DW3720 chip descriptor handler.
@@ -6298,14 +7239,107 @@ void ull_disablecontinuouswavemode(dwchip_t *dw)
  */
 uint16_t ull_readtempvbat(dwchip_t *dw)
 {
-    uint16_t wr_buf;
+    uint16_t wr_buf = 0U;
+    uint8_t polls = 0U;
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((LOCAL_DATA(dw)->sar_mux != 0U) && (LOCAL_DATA(dw)->sar_mux != SAR_MUX_TAKEN))
+    {
+        do
+        {
+            ret = ull_readtempvbat_complete(dw, &wr_buf);
+            polls++;
+        } while ((ret == (int32_t)DWT_ERR_BUSY) && (polls < SAR_WAIT_POLLS));
+
+        if (ret == (int32_t)DWT_SUCCESS)
+        {
+            LOCAL_DATA(dw)->sar_tempvbat = wr_buf;
+            LOCAL_DATA(dw)->sar_mux = SAR_MUX_TAKEN;
+        }
+        else
+        {
+            (void)ull_readtempvbat_abort(dw);
+        }
+    }
 
-    wr_buf = (ull_readsar(dw, 2U, 0U) & 0xFFU) << 8U;       // Vptat
-    wr_buf |= ull_readsar(dw, 1U, 0U) & 0xFFU;             // VDD1/VDDBAT
+    if (ret != (int32_t)DWT_SUCCESS)
+    {
+        wr_buf = (ull_readsar(dw, 2U, 0U) & 0xFFU) << 8U;       // Vptat
+        wr_buf |= ull_readsar(dw, 1U, 0U) & 0xFFU;             // VDD1/VDDBAT
+    }
 
     return  wr_buf;
 }
 
+/**
+ * dwt_sar_enable() - Power the SAR ADC and its inputs
+ * @dw: DW3720 chip descriptor handler.
+ * @attn: attenuation select, see ull_readsar()
+ *
+ * Return: LDO_CTRL to restore with dwt_sar_disable().
+ */
+static uint32_t dwt_sar_enable(dwchip_t *dw, uint8_t attn)
+{
+    uint32_t ldo_ctrl_val;
+    uint32_t att = 0UL;
+
+    if ((attn > 0UL) && (attn <= 2UL))
+    {
+        att = ((uint32_t)attn + 0x1UL) << SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_OFFSET;
+    }
+
+    // turn on LDOs
+    ldo_ctrl_val = dwt_read32bitoffsetreg(dw, LDO_CTRL_ID, 0U);
+    dwt_modify32bitoffsetreg(dw, LDO_CTRL_ID, 0U, LDO_CTRL_MASK, LDO_CTRL_LDO_VDDMS2_EN_BIT_MASK);
+
+    // Enable attenuation
+    dwt_modify32bitoffsetreg(dw, SAR_TEST_ID, 0U, ~(SAR_TEST_DIG_AUXADC_ATTN_EN_ULV_BIT_MASK | SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_MASK), att);
+
+    return ldo_ctrl_val;
+}
+
+/**
+ * dwt_sar_convert() - Start a conversion of the SAR ADC, enabled by dwt_sar_enable()
+ * @dw: DW3720 chip descriptor handler.
+ * @input_mux: input select, see ull_readsar()
+ */
+static void dwt_sar_convert(dwchip_t *dw, uint8_t input_mux)
+{
+    // Select input mux and mux override
+    dwt_write32bitoffsetreg(dw, SAR_CTRL_ID, 0U, (SAR_CTRL_SAR_OVR_MUX_EN_BIT_MASK | ((uint32_t)input_mux << SAR_CTRL_SAR_FORCE_SEL_BIT_OFFSET)));
+
+    // Run SAR
+    dwt_modify32bitoffsetreg(dw, SAR_CTRL_ID, 0U, ~SAR_CTRL_SAR_START_BIT_MASK, SAR_CTRL_SAR_START_BIT_MASK);
+}
+
+/**
+ * dwt_sar_done() - Check the end of the conversion started by dwt_sar_convert()
+ * @dw: DW3720 chip descriptor handler.
+ *
+ * Return: true once the reading is in SAR_READING.
+ */
+static bool dwt_sar_done(dwchip_t *dw)
+{
+    return (dwt_read32bitoffsetreg(dw, SAR_STATUS_ID, SAR_STATUS_SAR_DONE_BIT_OFFSET) & SAR_STATUS_SAR_DONE_BIT_MASK) != 0UL;
+}
+
+/**
+ * dwt_sar_disable() - Stop the SAR ADC and power its inputs down, undoing dwt_sar_enable()
+ * @dw: DW3720 chip descriptor handler.
+ * @ldo_ctrl_val: LDO_CTRL returned by dwt_sar_enable()
+ */
+static void dwt_sar_disable(dwchip_t *dw, uint32_t ldo_ctrl_val)
+{
+    // Clear SAR enable
+    dwt_write8bitoffsetreg(dw, SAR_CTRL_ID, SAR_CTRL_SAR_START_BIT_OFFSET, 0x00U);
+
+    // restore LDO control register
+    dwt_write32bitoffsetreg(dw, LDO_CTRL_ID, 0U, ldo_ctrl_val);
+
+    // Disable attenuation
+    dwt_modify32bitoffsetreg(dw, SAR_TEST_ID, 0U, ~(SAR_TEST_DIG_AUXADC_ATTN_EN_ULV_BIT_MASK | SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_MASK), 0UL);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief Reads the SAR ADC inputs in debug mode
  * The SAR ADC is an 8-bit single-ended ADC with input range of 0-400mV
@@ -6335,32 +7369,17 @@ static uint16_t ull_readsar(dwchip_t *dw, uint8_t input_mux, uint8_t attn)
 {
     uint32_t ldo_ctrl_val;
     uint16_t reading;
-    uint32_t att = 0UL;
-
-    if ((attn > 0UL) && (attn <= 2UL))
-    {
-        att = ((uint32_t)attn + 0x1UL) << SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_OFFSET;
-    }
 
     if (input_mux > 15U)
     {
         input_mux = 1U;
     }
-    // turn on LDOs
-    ldo_ctrl_val = dwt_read32bitoffsetreg(dw, LDO_CTRL_ID, 0U);
-    dwt_modify32bitoffsetreg(dw, LDO_CTRL_ID, 0U, LDO_CTRL_MASK, LDO_CTRL_LDO_VDDMS2_EN_BIT_MASK);
 
-    // Enable attenuation
-    dwt_modify32bitoffsetreg(dw, SAR_TEST_ID, 0U, ~(SAR_TEST_DIG_AUXADC_ATTN_EN_ULV_BIT_MASK | SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_MASK), att);
-
-    // Select input mux and mux override
-    dwt_write32bitoffsetreg(dw, SAR_CTRL_ID, 0U, (SAR_CTRL_SAR_OVR_MUX_EN_BIT_MASK | ((uint32_t)input_mux << SAR_CTRL_SAR_FORCE_SEL_BIT_OFFSET)));
-
-    // Run SAR
-    dwt_modify32bitoffsetreg(dw, SAR_CTRL_ID, 0U, ~SAR_CTRL_SAR_START_BIT_MASK, SAR_CTRL_SAR_START_BIT_MASK);
+    ldo_ctrl_val = dwt_sar_enable(dw, attn);
+    dwt_sar_convert(dw, input_mux);
 
     // Wait until SAR conversion is complete.
-    while ((dwt_read32bitoffsetreg(dw, SAR_STATUS_ID, SAR_STATUS_SAR_DONE_BIT_OFFSET) & SAR_STATUS_SAR_DONE_BIT_MASK) == 0UL)
+    while (!dwt_sar_done(dw))
     {
         ;
     }
@@ -6368,17 +7387,175 @@ static uint16_t ull_readsar(dwchip_t *dw, uint8_t input_mux, uint8_t attn)
     // Reading SAR
     reading = dwt_read16bitoffsetreg(dw, SAR_READING_ID, 0U);
 
-    // Clear SAR enable
-    dwt_write8bitoffsetreg(dw, SAR_CTRL_ID, SAR_CTRL_SAR_START_BIT_OFFSET, 0x00U);
+    dwt_sar_disable(dw, ldo_ctrl_val);
 
-    // restore LDO control register
-    dwt_write32bitoffsetreg(dw, LDO_CTRL_ID, 0U, ldo_ctrl_val);
+    return reading;
 
-    // Disable attenuation
-    dwt_modify32bitoffsetreg(dw, SAR_TEST_ID, 0U, ~(SAR_TEST_DIG_AUXADC_ATTN_EN_ULV_BIT_MASK | SAR_TEST_DIG_AUXADC_ATTN_SEL_ULV_BIT_MASK), 0UL);
+}
 
-    return reading;
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Starts the conversion of the temperature and battery voltage values read by ull_readtempvbat(), without
+ * waiting for it: ull_readtempvbat_complete() is then polled to collect the readings. The SAR ADC converts the
+ * temperature, then the voltage, so the host is free between the polls, and the device can be receiving.
+ * No other SAR reading can be done until the readings are collected: ull_readtempvbat() finishes the conversion and
+ * returns its readings instead. ull_readtempvbat_abort() gives the conversion up, as entering sleep does.
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS, or DWT_ERR_BUSY if a conversion started before is not collected yet
+ */
+int32_t ull_readtempvbat_start(dwchip_t *dw)
+{
+    int32_t ret = (int32_t)DWT_ERR_BUSY;
+
+    if (LOCAL_DATA(dw)->sar_mux == 0U)
+    {
+        LOCAL_DATA(dw)->sar_ldo_ctrl = dwt_sar_enable(dw, 0U);
+        LOCAL_DATA(dw)->sar_mux = 2U;                           // Vptat
+        dwt_sar_convert(dw, LOCAL_DATA(dw)->sar_mux);
+        ret = (int32_t)DWT_SUCCESS;
+    }
+
+    return ret;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Collects the readings of the conversion started by ull_readtempvbat_start(). Each call checks the
+ * SAR once and never waits: the voltage conversion is started by the call which finds the temperature converted,
+ * so at least two calls are needed.
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * output parameters
+ * @param tempvbat - (temp_raw<<8)|(vbat_raw), as returned by ull_readtempvbat(), set on DWT_SUCCESS
+ *
+ * returns DWT_SUCCESS once both readings are collected, DWT_ERR_BUSY while converting, or DWT_ERROR if no
+ * conversion was started
+ */
+int32_t ull_readtempvbat_complete(dwchip_t *dw, uint16_t *tempvbat)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint8_t reading;
+
+    if (LOCAL_DATA(dw)->sar_mux == SAR_MUX_TAKEN)
+    {
+        // Finished by ull_readtempvbat()
+        *tempvbat = LOCAL_DATA(dw)->sar_tempvbat;
+        LOCAL_DATA(dw)->sar_mux = 0U;
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    else if (LOCAL_DATA(dw)->sar_mux != 0U)
+    {
+        ret = (int32_t)DWT_ERR_BUSY;
+        if (dwt_sar_done(dw))
+        {
+            reading = dwt_read8bitoffsetreg(dw, SAR_READING_ID, 0U);
+            if (LOCAL_DATA(dw)->sar_mux == 2U)
+            {
+                LOCAL_DATA(dw)->sar_temp = reading;
+                // Clear SAR enable and convert VDD1/VDDBAT
+                dwt_write8bitoffsetreg(dw, SAR_CTRL_ID, SAR_CTRL_SAR_START_BIT_OFFSET, 0x00U);
+                LOCAL_DATA(dw)->sar_mux = 1U;
+                dwt_sar_convert(dw, LOCAL_DATA(dw)->sar_mux);
+            }
+            else
+            {
+                *tempvbat = (uint16_t)((uint16_t)LOCAL_DATA(dw)->sar_temp << 8U) | (uint16_t)reading;
+                dwt_sar_disable(dw, LOCAL_DATA(dw)->sar_ldo_ctrl);
+                LOCAL_DATA(dw)->sar_mux = 0U;
+                ret = (int32_t)DWT_SUCCESS;
+            }
+        }
+    }
 
+    return ret;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Gives up the conversion started by ull_readtempvbat_start(): the SAR ADC is stopped and its inputs powered
+ * down as ull_readtempvbat_complete() does once both readings are collected, and readings not collected yet are
+ * dropped. A new conversion can then be started.
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS, or DWT_ERROR if no conversion was started
+ */
+int32_t ull_readtempvbat_abort(dwchip_t *dw)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if (LOCAL_DATA(dw)->sar_mux != 0U)
+    {
+        if (LOCAL_DATA(dw)->sar_mux != SAR_MUX_TAKEN)
+        {
+            dwt_sar_disable(dw, LOCAL_DATA(dw)->sar_ldo_ctrl);
+        }
+        LOCAL_DATA(dw)->sar_mux = 0U;
+        ret = (int32_t)DWT_SUCCESS;
+    }
+
+    return ret;
+}
+
+/**
+ * dwt_sar_sleep() - Give up the conversion of ull_readtempvbat_start() still running before the device sleeps: it is
+ * lost in sleep, and the LDO_CTRL saved at its start is stale after the wake-up. Readings collected by
+ * ull_readtempvbat() are kept.
+ * @dw: DW3720 chip descriptor handler.
+ */
+static void dwt_sar_sleep(dwchip_t *dw)
+{
+    if (LOCAL_DATA(dw)->sar_mux != SAR_MUX_TAKEN)
+    {
+        (void)ull_readtempvbat_abort(dw);
+    }
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Converts both raw values of a temperature and battery voltage reading with integer arithmetic only,
+ * as ull_convertrawtemperature_cdeg() and ull_convertrawvoltage_mv() do.
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ * @param tempvbat - (temp_raw<<8)|(vbat_raw), as read by ull_readtempvbat() or ull_readtempvbat_complete()
+ *
+ * output parameters
+ * @param temp_cdeg - temperature, in hundredths of degrees C
+ * @param vbat_mv - battery voltage, in mV
+ *
+ * no return value
+ */
+void ull_converttempvbat(dwchip_t *dw, uint16_t tempvbat, int16_t *temp_cdeg, uint16_t *vbat_mv)
+{
+    *temp_cdeg = ull_convertrawtemperature_cdeg(dw, (uint8_t)(tempvbat >> 8U));
+    *vbat_mv = ull_convertrawvoltage_mv(dw, (uint8_t)tempvbat);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief  this function takes in a raw temperature value and applies the conversion factor
+ * to give true temperature, with integer arithmetic only. The dwt_initialise needs to be called before call to this to
+ * ensure LOCAL_DATA(dw)->tempP contains the SAR_LTEMP value from OTP.
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ * @param raw_temp - this is the 8-bit raw temperature value as read by ull_readtempvbat
+ *
+ * output parameters:
+ *
+ * @returns: temperature sensor value, in hundredths of degrees C
+ */
+int16_t ull_convertrawtemperature_cdeg(dwchip_t *dw, uint8_t raw_temp)
+{
+    // the User Manual formula is: Temperature (C) = ( (SAR_LTEMP - OTP_READ(Vtemp @ 25C) ) x 1.05)        // Vtemp @ 25C
+    // which is exact in hundredths of degrees
+    return (int16_t)((((int32_t)raw_temp - (int32_t)LOCAL_DATA(dw)->tempP) * 105L) + 2500L);
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -6392,15 +7569,35 @@ static uint16_t ull_readsar(dwchip_t *dw, uint8_t input_mux, uint8_t attn)
  *
  * output parameters:
  *
- * returns: temperature sensor value
+ * @returns: temperature sensor value, see ull_convertrawtemperature_cdeg()
  */
 float ull_convertrawtemperature(dwchip_t *dw, uint8_t raw_temp)
 {
-    float realtemp;
+    return (float)ull_convertrawtemperature_cdeg(dw, raw_temp) / 100.0f;
+}
 
-    // the User Manual formula is: Temperature (C) = ( (SAR_LTEMP - OTP_READ(Vtemp @ 25C) ) x 1.05)        // Vtemp @ 25C
-    realtemp = (((float)raw_temp - (float)LOCAL_DATA(dw)->tempP) * 1.05f) + 25.0f;
-    return realtemp;
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief this function takes in a raw voltage value and applies the conversion factor
+ * to give true voltage, with integer arithmetic only. The dwt_initialise needs to be called before call to this to
+ * ensure LOCAL_DATA(dw)->vBatP contains the SAR_LVBAT value from OTP
+ *
+ * input parameters:
+ * @param dw - DW3720 chip descriptor handler.
+ * @param raw_voltage - this is the 8-bit raw voltage value as read by ull_readtempvbat
+ *
+ * output parameters:
+ *
+ * @returns: voltage sensor value, rounded to the nearest mV, 0 if below
+ */
+uint16_t ull_convertrawvoltage_mv(dwchip_t *dw, uint8_t raw_voltage)
+{
+    // Bench measurements gives approximately: VDDBAT = sar_read * Vref / max_code * 16x_atten   - assume Vref @ 3.0V
+    int32_t mv = ((int32_t)raw_voltage - (int32_t)LOCAL_DATA(dw)->vBatP) * 400L * 16L;
+
+    mv = (mv >= 0L) ? ((mv + 127L) / 255L) : ((mv - 127L) / 255L);
+    mv += 3000L;
+
+    return (mv > 0L) ? (uint16_t)mv : 0U;
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -6414,16 +7611,11 @@ float ull_convertrawtemperature(dwchip_t *dw, uint8_t raw_temp)
  *
  * output parameters:
  *
- * @returns: voltage sensor value
+ * @returns: voltage sensor value, see ull_convertrawvoltage_mv()
  */
 float ull_convertrawvoltage(dwchip_t *dw, uint8_t raw_voltage)
 {
-    float realvolt;
-
-    // Bench measurements gives approximately: VDDBAT = sar_read * Vref / max_code * 16x_atten   - assume Vref @ 3.0V
-    realvolt = (((float)raw_voltage - (float)LOCAL_DATA(dw)->vBatP) * 0.4f * 16.0f / 255.0f) + 3.0f;
-    // realvolt = ((float)raw_voltage * 0.4f / 255) * 16;
-    return realvolt;
+    return (float)ull_convertrawvoltage_mv(dw, raw_voltage) / 1000.0f;
 }
 
 /*! ------------------------------------------------------------------------------------------------------------------
@@ -6460,6 +7652,120 @@ uint8_t ull_readwakeupvbat(dwchip_t *dw)
     return dwt_read8bitoffsetreg(dw, SAR_READING_ID, 0U);
 }
 
+/**
+ * dwt_listen_lposc_cal() - LP OSC calibration of the sleep counter, run again only if the temperature moved
+ * @dw: DW3720 chip descriptor handler.
+ * @recal_temp: temperature change from the last calibration, in degrees C, which calls for a new one
+ *
+ * Return: XTAL cycles per LP OSC cycle, 0 if the calibration failed.
+ */
+static uint16_t dwt_listen_lposc_cal(dwchip_t *dw, uint8_t recal_temp)
+{
+    uint8_t temp = (uint8_t)(ull_readtempvbat(dw) >> 8U);
+    uint8_t delta = (temp > LOCAL_DATA(dw)->lposc_temp) ? (temp - LOCAL_DATA(dw)->lposc_temp) : (LOCAL_DATA(dw)->lposc_temp - temp);
+
+    // SAR temperature steps are 1.05 degrees C
+    if ((LOCAL_DATA(dw)->lposc_cal == 0U) || (((uint16_t)delta * 105U) >= ((uint16_t)recal_temp * 100U)))
+    {
+        LOCAL_DATA(dw)->lposc_cal = ull_calibratesleepcnt(dw);
+        LOCAL_DATA(dw)->lposc_temp = temp;
+    }
+    return LOCAL_DATA(dw)->lposc_cal;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief starts duty-cycled listening: the device wakes up on its sleep counter every period, listens in SNIFF mode
+ * until the preamble detection timeout and goes back to sleep (auto RX to sleep), without the host. A frame received
+ * keeps the device awake: only the RXFCG interrupt is enabled, so RX errors and timeouts do not hold it awake.
+ *
+ * The LP OSC calibration of the sleep counter is cached and run again only on a temperature change of recal_temp.
+ * The device enters sleep before this returns.
+ *
+ * ull_restoreconfig() does not run before the receiver is enabled on wake: the device loads the LDO and bias tunes
+ * and the DGC programmed in OTP itself, as set in the on-wake configuration by ull_initialise() and ull_configure().
+ * The DGC LUTs programmed by the host when the OTP has none, TX_CTRL_LO and the double buffer diagnostics are not
+ * restored: once a frame is received, call ull_listen_stop() then ull_restoreconfig() before any other TX or RX.
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ * @param config - wake-up period, listen window, SNIFF ON/OFF times and recalibration temperature
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if the sleep counter could not be calibrated
+ */
+int32_t ull_listen_start(dwchip_t *dw, const dwt_listen_config_t *config)
+{
+    int32_t ret = (int32_t)DWT_ERROR;
+    uint16_t lposc_cal = dwt_listen_lposc_cal(dw, config->recal_temp);
+
+    if (lposc_cal != 0U)
+    {
+        // The sleep counter counts the upper 16 bits of 28: units of 4096 LP OSC cycles, of lposc_cal 38.4 MHz cycles
+        uint64_t unit = 4096ULL * lposc_cal;
+        uint64_t sleepcnt = (((uint64_t)config->period_ms * 38400ULL) + (unit / 2ULL)) / unit;
+
+        if (sleepcnt == 0ULL)
+        {
+            sleepcnt = 1ULL;
+        }
+        else if (sleepcnt > 0xFFFFULL)
+        {
+            sleepcnt = 0xFFFFULL;
+        }
+        else
+        {
+            // in range
+        }
+
+        if (LOCAL_DATA(dw)->listening == 0U)
+        {
+            LOCAL_DATA(dw)->listen_int_lo = dwt_read32bitreg(dw, SYS_ENABLE_LO_ID);
+            LOCAL_DATA(dw)->listen_int_hi = dwt_read32bitreg(dw, SYS_ENABLE_HI_ID);
+            LOCAL_DATA(dw)->listening = 1U;
+        }
+        ull_setinterrupt(dw, (uint32_t)DWT_INT_RXFCG_BIT_MASK, 0UL, DWT_ENABLE_INT_ONLY);
+
+        ull_setsniffmode(dw, (config->sniff_on != 0U) ? 1 : 0, config->sniff_on, config->sniff_off);
+        ull_setpreambledetecttimeout(dw, config->window_pac);
+        ull_configuresleepcnt(dw, (uint16_t)sleepcnt);
+        // No DWT_PGFCAL: the DW3720 has no on-wake PGF calibration, ull_configuresleep() would clear it
+        ull_configuresleep(dw, (uint16_t)DWT_CONFIG | (uint16_t)DWT_GOTORX,
+                           (uint8_t)DWT_SLP_CNT_RPT | (uint8_t)DWT_PRES_SLEEP | (uint8_t)DWT_WAKE_CSN | (uint8_t)DWT_SLEEP | (uint8_t)DWT_SLP_EN);
+        ull_entersleepafter(dw, (int32_t)DWT_RX_COMPLETE);
+        ull_entersleep(dw, (int32_t)DWT_DW_IDLE);
+        ret = (int32_t)DWT_SUCCESS;
+    }
+    return ret;
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief stops duty-cycled listening: clears auto RX to sleep, SNIFF mode and the on-wake configuration, and enables
+ * the interrupts enabled before ull_listen_start() again. The device must be awake (frame received, or woken up by
+ * the host and ull_restoreconfig() called).
+ *
+ * input parameters
+ * @param dw - DW3720 chip descriptor handler.
+ *
+ * output parameters
+ *
+ * no return value
+ */
+void ull_listen_stop(dwchip_t *dw)
+{
+    ull_entersleepafter(dw, 0);
+    ull_dis_otp_ips(dw, 0);
+    ull_setsniffmode(dw, 0, 0U, 0U);
+    LOCAL_DATA(dw)->sleep_mode &= (uint16_t)(~((uint16_t)DWT_GOTORX));
+    ull_clearaonconfig(dw);
+
+    if (LOCAL_DATA(dw)->listening != 0U)
+    {
+        ull_setinterrupt(dw, LOCAL_DATA(dw)->listen_int_lo, LOCAL_DATA(dw)->listen_int_hi, DWT_ENABLE_INT_ONLY);
+        LOCAL_DATA(dw)->listening = 0U;
+    }
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief this function determines the adjusted bandwidth setting (PG_DELAY bitfield setting)
  * of the DW3720. The adjustment is a result of DW3720 internal PG cal routine, given a target count value it will try to
@@ -7948,6 +9254,185 @@ void ull_nlos_ipdiag(dwchip_t *dw, dwt_nlos_ipdiag_t *index)
     index->index_pp_u32 <<= 6UL; // shift left by 6 digits so it compares with first path index, to avoid using double/float
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function reads the NLOS diagnostics of all requested accumulators at once and estimates the LOS/NLOS
+ *        condition of the received frame from them (see nlos_estimate()).
+ *        The Ipatov and first STS diagnostics end of the 0xC0000 register file is read in one SPI transaction, the STS
+ *        diagnostics of the 0xD0000 register file in another one, the DGC decision in a third one: instead of the
+ *        six reads per accumulator of ull_nlos_alldiag() plus the two of ull_nlos_ipdiag().
+ *
+ * NOTE:  CIA Diagnostics need to be enabled to "DW_CIA_DIAG_LOG_ALL" else the diagnostic registers read will be 0.
+ *
+ * input parameters:
+ * @param dw        - DW3720 chip descriptor handler.
+ * @param acc_mask  - accumulators to read, a combination of DWT_NLOS_SEL_IPATOV, DWT_NLOS_SEL_STS1, DWT_NLOS_SEL_STS2.
+ *
+ * output parameters:
+ * @param snap      - pointer to the structure into which to read the diagnostics and the estimation result.
+ *
+ * @return DWT_SUCCESS for success, or DWT_ERROR if acc_mask is empty or invalid.
+ */
+int32_t ull_nlos_readsnapshot(dwchip_t *dw, dwt_nlos_snapshot_t *snap, uint8_t acc_mask)
+{
+    uint8_t buf_c[STS_DIAG_3_ID + STS_DIAG_3_LEN - IP_DIAG_0_ID];     // IP_DIAG_0 .. STS_DIAG_3
+    uint8_t buf_d[STS1_DIAG_12_ID + STS1_DIAG_12_LEN - STS_DIAG_4_ID]; // STS_DIAG_4 .. STS1_DIAG_12
+    uint32_t start;
+    uint32_t end;
+    uint8_t rx_pcode;
+    int32_t ret = (int32_t)DWT_ERROR;
+
+    if ((snap != NULL) && (acc_mask != 0U) && ((acc_mask & (uint8_t)~DWT_NLOS_SEL_ALL) == 0U))
+    {
+        snap->acc_mask = acc_mask;
+
+        // 0xC0000 file: Ipatov diagnostics, followed by STS_DIAG_0..3
+        if ((acc_mask & (DWT_NLOS_SEL_IPATOV | DWT_NLOS_SEL_STS1)) != 0U)
+        {
+            start = ((acc_mask & DWT_NLOS_SEL_IPATOV) != 0U) ? IP_DIAG_0_ID : STS_DIAG_0_ID;
+            end = ((acc_mask & DWT_NLOS_SEL_STS1) != 0U) ? (STS_DIAG_3_ID + STS_DIAG_3_LEN) : (IP_DIAG_12_ID + IP_DIAG_12_LEN);
+            ull_readfromdevice(dw, start, 0U, (uint16_t)(end - start), &buf_c[start - IP_DIAG_0_ID]);
+        }
+
+        // 0xD0000 file: STS_DIAG_4..12, followed by STS1 diagnostics
+        if ((acc_mask & (DWT_NLOS_SEL_STS1 | DWT_NLOS_SEL_STS2)) != 0U)
+        {
+            start = ((acc_mask & DWT_NLOS_SEL_STS1) != 0U) ? STS_DIAG_4_ID : STS1_DIAG_0_ID;
+            end = ((acc_mask & DWT_NLOS_SEL_STS2) != 0U) ? (STS1_DIAG_12_ID + STS1_DIAG_12_LEN) : (STS_DIAG_12_ID + STS_DIAG_12_LEN);
+            ull_readfromdevice(dw, start, 0U, (uint16_t)(end - start), &buf_d[start - STS_DIAG_4_ID]);
+        }
+
+        if ((acc_mask & DWT_NLOS_SEL_IPATOV) != 0U)
+        {
+            dwt_nlos_accdiag_t *acc = &snap->acc[IPATOV];
+            acc->accumCount = diag_sel_get32(&buf_c[IP_DIAG_12_ID - IP_DIAG_0_ID]) & IP_DIAG_12_IPNACC_BIT_MASK;
+            acc->F1 = diag_sel_get32(&buf_c[IP_DIAG_2_ID - IP_DIAG_0_ID]) & IP_DIAG_2_IPF1_BIT_MASK;
+            acc->F2 = diag_sel_get32(&buf_c[IP_DIAG_3_ID - IP_DIAG_0_ID]) & IP_DIAG_3_IPF2_BIT_MASK;
+            acc->F3 = diag_sel_get32(&buf_c[IP_DIAG_4_ID - IP_DIAG_0_ID]) & IP_DIAG_4_IPF3_BIT_MASK;
+            acc->cir_power = diag_sel_get32(&buf_c[IP_DIAG_1_ID - IP_DIAG_0_ID]) & IP_DIAG_1_IPCHANNELAREA_BIT_MASK;
+            acc->index_fp = diag_sel_get32(&buf_c[IP_DIAG_8_ID - IP_DIAG_0_ID]) & IP_DIAG_8_IPFPLOC_BIT_MASK;
+            acc->index_pp = ((diag_sel_get32(&buf_c[IP_DIAG_0_ID - IP_DIAG_0_ID]) & IP_DIAG_0_PEAKLOC_BIT_MASK) >> 21UL) << 6UL;
+        }
+
+        if ((acc_mask & DWT_NLOS_SEL_STS1) != 0U)
+        {
+            dwt_nlos_accdiag_t *acc = &snap->acc[STS1];
+            acc->accumCount = diag_sel_get32(&buf_d[STS_DIAG_12_ID - STS_DIAG_4_ID]) & STS_DIAG_12_CYNACC_BIT_MASK;
+            acc->F1 = diag_sel_get32(&buf_c[STS_DIAG_2_ID - IP_DIAG_0_ID]) & STS_DIAG_2_CY0F1_BIT_MASK;
+            acc->F2 = diag_sel_get32(&buf_c[STS_DIAG_3_ID - IP_DIAG_0_ID]) & STS_DIAG_3_CY0F2_BIT_MASK;
+            acc->F3 = diag_sel_get32(&buf_d[STS_DIAG_4_ID - STS_DIAG_4_ID]) & STS_DIAG_4_CY0F3_BIT_MASK;
+            acc->cir_power = diag_sel_get32(&buf_c[STS_DIAG_1_ID - IP_DIAG_0_ID]) & STS_DIAG_1_CY0CHANNELAREA_BIT_MASK;
+            acc->index_fp = diag_sel_get32(&buf_d[STS_DIAG_8_ID - STS_DIAG_4_ID]) & 0x7FFFUL;        // First path index [14:0]
+            acc->index_pp = ((diag_sel_get32(&buf_c[STS_DIAG_0_ID - IP_DIAG_0_ID]) >> 21UL) & 0x1FFUL) << 6UL; // Peak index [29:21]
+        }
+
+        if ((acc_mask & DWT_NLOS_SEL_STS2) != 0U)
+        {
+            dwt_nlos_accdiag_t *acc = &snap->acc[STS2];
+            acc->accumCount = diag_sel_get32(&buf_d[STS1_DIAG_12_ID - STS_DIAG_4_ID]) & STS1_DIAG_12_CY1NACC_BIT_MASK;
+            acc->F1 = diag_sel_get32(&buf_d[STS1_DIAG_2_ID - STS_DIAG_4_ID]) & STS1_DIAG_2_CY1F1_BIT_MASK;
+            acc->F2 = diag_sel_get32(&buf_d[STS1_DIAG_3_ID - STS_DIAG_4_ID]) & STS1_DIAG_3_CY1F2_BIT_MASK;
+            acc->F3 = diag_sel_get32(&buf_d[STS1_DIAG_4_ID - STS_DIAG_4_ID]) & STS1_DIAG_4_CY1F3_BIT_MASK;
+            acc->cir_power = diag_sel_get32(&buf_d[STS1_DIAG_1_ID - STS_DIAG_4_ID]) & STS1_DIAG_1_CY1CHANNELAREA_BIT_MASK;
+            acc->index_fp = diag_sel_get32(&buf_d[STS1_DIAG_8_ID - STS_DIAG_4_ID]) & 0x7FFFUL;        // First path index [14:0]
+            acc->index_pp = ((diag_sel_get32(&buf_d[STS1_DIAG_0_ID - STS_DIAG_4_ID]) >> 21UL) & 0x1FFUL) << 6UL; // Peak index [29:21]
+        }
+
+        snap->D = ull_get_dgcdecision(dw);
+
+        // RX code is cached by ull_configure(), only read it back if the device was not configured through it
+        rx_pcode = LOCAL_DATA(dw)->rxCode;
+        if (rx_pcode == 0U)
+        {
+            rx_pcode = ull_getrxcode(dw);
+        }
+
+        ret = nlos_estimate(snap, RSL_QUANTIZATION_FACTOR, rx_pcode);
+    }
+
+    return ret;
+}
+
+#ifdef AUTO_PLL_CAL
+/**
+ * dwt_pll_cache_entry() - Entry of the PLL calibration cache for a channel, in the temperature band of the last
+ * temperature measured by ull_configure() (or set with ull_setpllcaltemperature())
+ * @dw: DW3720 chip descriptor handler.
+ * @ch: channel (5 or 9)
+ *
+ * Return: the PLL_COARSE_CODE locked last time, 0 if none, or NULL if the temperature is not known
+ */
+static uint32_t *dwt_pll_cache_entry(dwchip_t *dw, uint8_t ch)
+{
+    uint32_t *entry = NULL;
+
+    if (LOCAL_DATA(dw)->temperature != TEMP_INIT)
+    {
+        int32_t band = ((int32_t)LOCAL_DATA(dw)->temperature + 40) / PLL_CACHE_BAND_C;
+
+        if (band < 0)
+        {
+            band = 0;
+        }
+        else if (band >= PLL_CACHE_BANDS)
+        {
+            band = PLL_CACHE_BANDS - 1;
+        }
+        else
+        {
+            // In range
+        }
+        entry = &LOCAL_DATA(dw)->pll_cc[(ch == (uint8_t)DWT_CH9) ? 1U : 0U][band];
+    }
+    return entry;
+}
+
+/**
+ * dwt_pll_coarse() - VCO coarse tune code of a channel, as ull_pll_ch5_auto_cal() and ull_pll_ch9_auto_cal() take it
+ * @ch: channel (5 or 9)
+ * @pll_cc: PLL_COARSE_CODE register, or its value in OTP
+ */
+static uint32_t dwt_pll_coarse(uint8_t ch, uint32_t pll_cc)
+{
+    uint32_t coarse;
+
+    if (ch == (uint8_t)DWT_CH9)
+    {
+        // PLL_COARSE_CODE = 0x0B000000 + [21:8] Ch5 coarse code (Test 8180) + [6:0] Ch9 coarse code (Test 8550)
+        coarse = pll_cc & PLL_COARSE_CODE_CH9_VCO_COARSE_TUNE_BIT_MASK;  // [6:0]
+    }
+    else //(ch == 5)
+    {
+        coarse = (pll_cc & PLL_COARSE_CODE_CH5_VCO_COARSE_TUNE_BIT_MASK) >> 8UL;  // [21:8]
+    }
+    return coarse;
+}
+
+/**
+ * dwt_pll_auto_cal() - Run the auto PLL calibration of a channel
+ * @dw: DW3720 chip descriptor handler.
+ * @ch: channel (5 or 9)
+ * @coarse: VCO coarse tune code to start from
+ * @steps: the max number of steps over which to run PLL cal
+ * @p_num_steps_lock: at return, number of steps required to get PLL locked
+ *
+ * Return: DWT_SUCCESS (i.e PLL lock OK) or DWT_ERR_PLL_LOCK
+ */
+static uint8_t dwt_pll_auto_cal(dwchip_t *dw, uint8_t ch, uint32_t coarse, uint8_t steps, uint8_t *p_num_steps_lock)
+{
+    uint8_t ret;
+
+    if (ch == (uint8_t)DWT_CH9)
+    {
+        ret = ull_pll_ch9_auto_cal(dw, coarse, 0U, steps, p_num_steps_lock);
+    }
+    else //(ch == 5)
+    {
+        ret = ull_pll_ch5_auto_cal(dw, coarse, 0U, steps, p_num_steps_lock, LOCAL_DATA(dw)->temperature);
+    }
+    return ret;
+}
+#endif /* AUTO_PLL_CAL */
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function will configure the channel number.
  *
@@ -7963,6 +9448,7 @@ static int32_t ull_setchannel(dwchip_t *dw, uint8_t ch)
 
 #ifdef AUTO_PLL_CAL
     uint32_t coarse;
+    uint32_t *pll_cc;
     uint8_t steps_to_lock;
 #endif
 
@@ -7990,20 +9476,30 @@ static int32_t ull_setchannel(dwchip_t *dw, uint8_t ch)
 #ifdef AUTO_PLL_CAL
         dwt_and_or32bitoffsetreg(dw, SEQ_CTRL_ID, 0U, ~SEQ_CTRL_FORCE2IDLE_BIT_MASK, SEQ_CTRL_FORCE2INIT_BIT_MASK);
 
-        if (ch == (uint8_t)DWT_CH9)
+        pll_cc = dwt_pll_cache_entry(dw, ch);
+        err = (int32_t)DWT_ERR_PLL_LOCK;
+        if ((pll_cc != NULL) && (*pll_cc != 0UL))
         {
-            // PLL_COARSE_CODE = 0x0B000000 + [21:8] Ch5 coarse code (Test 8180) + [6:0] Ch9 coarse code (Test 8550)
-            coarse = dwt_otpreadpintoparams(dw, PLL_CC_ADDRESS) & PLL_COARSE_CODE_CH9_VCO_COARSE_TUNE_BIT_MASK;  // [6:0]
-            err = ull_pll_ch9_auto_cal(dw, coarse, 0U, AUTO_PLL_CAL_STEPS, &steps_to_lock );
+            // Start from the code locked last time in this temperature band, which only needs the lock to be verified
+            coarse = dwt_pll_coarse(ch, *pll_cc);
+            err = (int32_t)dwt_pll_auto_cal(dw, ch, coarse, PLL_CACHE_STEPS, &steps_to_lock);
+            if (err != (int32_t)DWT_SUCCESS)
+            {
+                *pll_cc = 0UL;
+            }
         }
-        else //(ch == 5)
+        if (err != (int32_t)DWT_SUCCESS)
         {
-            coarse = (dwt_otpreadpintoparams(dw, PLL_CC_ADDRESS) & PLL_COARSE_CODE_CH5_VCO_COARSE_TUNE_BIT_MASK) >> 8UL;  // [21:8]
-            err = ull_pll_ch5_auto_cal(dw, coarse, 0U, AUTO_PLL_CAL_STEPS, &steps_to_lock, LOCAL_DATA(dw)->temperature);
+            coarse = dwt_pll_coarse(ch, dwt_otpreadpintoparams(dw, PLL_CC_ADDRESS));
+            err = (int32_t)dwt_pll_auto_cal(dw, ch, coarse, AUTO_PLL_CAL_STEPS, &steps_to_lock);
         }
 
         if(err == DWT_SUCCESS)
         {
+            if (pll_cc != NULL)
+            {
+                *pll_cc = dwt_read32bitoffsetreg(dw, PLL_COARSE_CODE_ID, 0x0U);
+            }
 #if DWT_DEBUG_PRINT
             printf("AUTO PLL locked after %d steps\n", steps_to_lock);
 #endif
@@ -8289,7 +9785,7 @@ static uint8_t ull_pll_ch5_auto_cal(dwchip_t *dw, uint32_t coarse_code, uint16_t
     if (temperature == TEMP_INIT) // If set to TEMP_INIT use temperature sensor to read the temp
     {
         tempvbat = ull_readtempvbat(dw);
-        temperature = (int8_t)ull_convertrawtemperature(dw, (uint8_t)(tempvbat >> 8U));  // Temperature in upper 8 bits
+        temperature = (int8_t)(ull_convertrawtemperature_cdeg(dw, (uint8_t)(tempvbat >> 8U)) / 100);  // Temperature in upper 8 bits
     }
 
     if (temperature > 95) // If hot - change the LDO_PLL tune
@@ -8467,7 +9963,7 @@ int32_t ull_xtal_temperature_compensation(dwchip_t *dw,
         if (params->temperature == TEMP_INIT)
         {
             tempvbat = ull_readtempvbat(dw);
-            params->temperature = (int8_t)ull_convertrawtemperature(dw, (uint8_t)(tempvbat >> 8U));  // Temperature in upper 8 bits
+            params->temperature = (int8_t)(ull_convertrawtemperature_cdeg(dw, (uint8_t)(tempvbat >> 8U)) / 100);  // Temperature in upper 8 bits
         }
         LOCAL_DATA(dw)->temperature = params->temperature; // This can be used by PLL calibration
 
@@ -21,6 +21,24 @@
 /* Log2(10) 2 ^ 16 / 10. */
 #define LOG2_10_DIV_10_Q16 21771
 
+/* log2 kernels, QMATH_LOG2_IMPL selects the one used by log2_lut() at build time. */
+#define QMATH_LOG2_LUT        0 /* 33 entries lut, half delta approximation (default). */
+#define QMATH_LOG2_LUT_INTERP 1 /* 17 entries lut, linear interpolation. */
+#define QMATH_LOG2_POLY       2 /* No lut, degree 4 polynomial. */
+
+#ifndef QMATH_LOG2_IMPL
+#define QMATH_LOG2_IMPL QMATH_LOG2_LUT
+#endif
+
+/* 2^x kernels, QMATH_POW2_IMPL selects the one used by q8_pow_of_base2() at build time. */
+#define QMATH_POW2_LUT        0 /* 32 entries lut, exponent rounded to a q5 (default). */
+#define QMATH_POW2_LUT_INTERP 1 /* 17 entries lut, linear interpolation. */
+#define QMATH_POW2_POLY       2 /* No lut, degree 4 polynomial. */
+
+#ifndef QMATH_POW2_IMPL
+#define QMATH_POW2_IMPL QMATH_POW2_LUT
+#endif
+
 /**
  * log2_lut - Compute log2(x).
  * @x: x to convert in log2.
@@ -29,6 +47,38 @@
  */
 uint32_t log2_lut(uint32_t x);
 
+/**
+ * log2_lut_half_delta - Compute log2(x) with a 33 entries lut.
+ * @x: x to convert in log2, must not be 0.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT.
+ */
+uint32_t log2_lut_half_delta(uint32_t x);
+
+/**
+ * log2_lut_interp - Compute log2(x) with a 17 entries interpolated lut.
+ * @x: x to convert in log2, must not be 0.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT.
+ */
+uint32_t log2_lut_interp(uint32_t x);
+
+/**
+ * log2_poly - Compute log2(x) with a polynomial, without lut.
+ * @x: x to convert in log2, must not be 0.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT.
+ */
+uint32_t log2_poly(uint32_t x);
+
+/**
+ * log2_lut_batch - Compute log2(x) for an array of values.
+ * @x: array of @count values to convert in log2, must not be 0.
+ * @log2_x: array of @count results, log2(x) shifted by LUT_LOG_SHIFT.
+ * @count: number of values.
+ */
+void log2_lut_batch(const uint32_t *x, uint32_t *log2_x, uint32_t count);
+
 /**
  * log10_10 - Compute 10*log10(x).
  * @x: x to convert in 10*log10(x).
@@ -37,6 +87,14 @@ uint32_t log2_lut(uint32_t x);
  */
 uint16_t log10_10(uint32_t x);
 
+/**
+ * log10_10_batch - Compute 10*log10(x) for an array of values.
+ * @x: array of @count values to convert in 10*log10(x).
+ * @log10_x: array of @count results, 10*log(x) in 100th dB or LOG_INVALID_VALUE.
+ * @count: number of values.
+ */
+void log10_10_batch(const uint32_t *x, uint16_t *log10_x, uint32_t count);
+
 /**
  * q8_pow_of_base2 - Compute 2 ^ exponent_q18.
  * @exponent_q18: fixed point value.
@@ -45,4 +103,36 @@ uint16_t log10_10(uint32_t x);
  */
 uint32_t q8_pow_of_base2(int32_t exponent_q18);
 
+/**
+ * q8_pow_of_base2_lut - Compute 2 ^ exponent_q18 with a 32 entries lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8.
+ */
+uint32_t q8_pow_of_base2_lut(int32_t exponent_q18);
+
+/**
+ * q8_pow_of_base2_interp - Compute 2 ^ exponent_q18 with a 17 entries interpolated lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8, UINT32_MAX if it does not fit.
+ */
+uint32_t q8_pow_of_base2_interp(int32_t exponent_q18);
+
+/**
+ * q8_pow_of_base2_poly - Compute 2 ^ exponent_q18 with a polynomial, without lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8, UINT32_MAX if it does not fit.
+ */
+uint32_t q8_pow_of_base2_poly(int32_t exponent_q18);
+
+/**
+ * q8_pow_of_base2_batch - Compute 2 ^ exponent_q18 for an array of values.
+ * @exponent_q18: array of @count fixed point values.
+ * @pow_q8: array of @count results, as q8.
+ * @count: number of values.
+ */
+void q8_pow_of_base2_batch(const int32_t *exponent_q18, uint32_t *pow_q8, uint32_t count);
+
 #endif /* QMATH_H */
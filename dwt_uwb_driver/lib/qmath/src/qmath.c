@@ -17,6 +17,28 @@
 #define LOG_PRECISION                5U
 #define LOG2_10_SHIFTED_100TH        109UL
 #define DIVIDE_BY_POW2_ROUNDED(x, y) (((uint64_t)(x) + (1ULL << ((uint64_t)(y) - 1ULL))) >> (uint64_t)(y))
+#define LUT_INTERP_SIZE              17U
+#define LOG_INTERP_PRECISION         4U
+#define POW2_FRAC_SHIFT              18U
+#define POW2_INTERP_SIZE             17U
+#define POW2_INTERP_PRECISION        4U
+
+/* Fractional part m of x = (1 + m) * 2^z as a q15 (truncated), z being the msb of x. */
+#define LOG2_MANTISSA_Q15(x, z) \
+    ((((z) >= LUT_LOG_SHIFT) ? ((x) >> ((z) - LUT_LOG_SHIFT)) : ((x) << (LUT_LOG_SHIFT - (z)))) & ((1UL << LUT_LOG_SHIFT) - 1UL))
+
+/* Degree 4 minimax approximation of log2(1 + m) for m in [0,1[, q15 coefficients. */
+#define LOG2_POLY_C1_Q15 47154L
+#define LOG2_POLY_C2_Q15 (-22280L)
+#define LOG2_POLY_C3_Q15 10669L
+#define LOG2_POLY_C4_Q15 (-2778L)
+
+/* Degree 4 minimax approximation of 2^f for f in [0,1[ (relative error), q15 coefficients. */
+#define POW2_POLY_C0_Q15 32768L
+#define POW2_POLY_C1_Q15 22710L
+#define POW2_POLY_C2_Q15 7906L
+#define POW2_POLY_C3_Q15 1712L
+#define POW2_POLY_C4_Q15 440L
 
 /**
  * lut_power_base_2 is a lut that computes ((2 ^ x) multiplied by 4)
@@ -41,7 +63,25 @@ static const uint16_t lut_log2[LUT_SIZE] =
 };
 
 /**
- * log2_lut - Compute log2(x).
+ * lut_log2_interp is a lut that computes log2(x) shifted by LUT_LOG_SHIFT
+ * with a step for x of 1/(2^LOG_INTERP_PRECISION), used with linear interpolation.
+ */
+static const uint16_t lut_log2_interp[LUT_INTERP_SIZE] =
+{
+    0U, 2866U, 5568U, 8124U, 10549U, 12855U, 15055U, 17156U, 19168U, 21098U, 22952U, 24736U, 26455U, 28114U, 29717U, 31267U, 32768U
+};
+
+/**
+ * lut_pow2_interp is a lut that computes 2^x as a q15
+ * with a step for x of 1/(2^POW2_INTERP_PRECISION), used with linear interpolation.
+ */
+static const uint32_t lut_pow2_interp[POW2_INTERP_SIZE] =
+{
+    32768U, 34219U, 35734U, 37316U, 38968U, 40693U, 42495U, 44376U, 46341U, 48393U, 50535U, 52773U, 55109U, 57549U, 60097U, 62757U, 65536U
+};
+
+/**
+ * log2_lut_half_delta - Compute log2(x) with the 33 entries lut.
  * @x: x to convert in log2.
  *
  * Return: Return the log2(x) shifted by LUT_LOG_SHIFT.
@@ -59,7 +99,7 @@ static const uint16_t lut_log2[LUT_SIZE] =
  * Hence the use of __builtin_clz to find quickly the msb (named z in the algo).
  */
 
-uint32_t log2_lut(uint32_t x)
+uint32_t log2_lut_half_delta(uint32_t x)
 {
     uint32_t log2_x = 0UL;
     uint64_t x_shifted = 0ULL;
@@ -90,6 +130,92 @@ uint32_t log2_lut(uint32_t x)
     return log2_x;
 }
 
+/**
+ * log2_lut_interp - Compute log2(x) with the 17 entries lut.
+ * @x: x to convert in log2, must not be 0.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT.
+ *
+ * Same normalisation as log2_poly(), then linear interpolation between the
+ * two entries of lut_log2_interp around the mantissa. Half the table of
+ * log2_lut_half_delta() for a maximum error of about 2e-3 dB (10*log10),
+ * against 7e-2 dB for log2_lut_half_delta().
+ */
+uint32_t log2_lut_interp(uint32_t x)
+{
+    uint32_t z, m, index, frac;
+
+    if (x == 0UL)
+    {
+        return 0UL;
+    }
+    z = 31UL - (uint32_t)__builtin_clz(x);
+    m = LOG2_MANTISSA_Q15(x, z);
+    index = m >> (LUT_LOG_SHIFT - LOG_INTERP_PRECISION);
+    frac = m & ((1UL << (LUT_LOG_SHIFT - LOG_INTERP_PRECISION)) - 1UL);
+
+    return (z << LUT_LOG_SHIFT) + (uint32_t)lut_log2_interp[index] +
+           ((((uint32_t)lut_log2_interp[index + 1UL] - (uint32_t)lut_log2_interp[index]) * frac) >>
+            (LUT_LOG_SHIFT - LOG_INTERP_PRECISION));
+}
+
+/**
+ * log2_poly - Compute log2(x) without lut.
+ * @x: x to convert in log2, must not be 0.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT.
+ *
+ * x is written as (1 + m) * 2^z with __builtin_clz, m in [0,1[ as a q15, and
+ * log2(1 + m) is evaluated with a degree 4 minimax polynomial using Horner's
+ * scheme in 32 bits. Maximum error is about 5e-4 dB (10*log10).
+ */
+uint32_t log2_poly(uint32_t x)
+{
+    uint32_t z;
+    int32_t m, acc;
+
+    if (x == 0UL)
+    {
+        return 0UL;
+    }
+    z = 31UL - (uint32_t)__builtin_clz(x);
+    m = (int32_t)LOG2_MANTISSA_Q15(x, z);
+
+    acc = LOG2_POLY_C4_Q15;
+    acc = LOG2_POLY_C3_Q15 + ((acc * m + (1L << 14)) >> 15);
+    acc = LOG2_POLY_C2_Q15 + ((acc * m + (1L << 14)) >> 15);
+    acc = LOG2_POLY_C1_Q15 + ((acc * m + (1L << 14)) >> 15);
+    acc = (acc * m + (1L << 14)) >> 15;
+
+    return (z << LUT_LOG_SHIFT) + (uint32_t)acc;
+}
+
+/**
+ * log2_lut - Compute log2(x).
+ * @x: x to convert in log2.
+ *
+ * Return: log2(x) shifted by LUT_LOG_SHIFT, computed by the kernel selected
+ *         with QMATH_LOG2_IMPL.
+ */
+uint32_t log2_lut(uint32_t x)
+{
+#if QMATH_LOG2_IMPL == QMATH_LOG2_POLY
+    return log2_poly(x);
+#elif QMATH_LOG2_IMPL == QMATH_LOG2_LUT_INTERP
+    return log2_lut_interp(x);
+#else
+    return log2_lut_half_delta(x);
+#endif
+}
+
+void log2_lut_batch(const uint32_t *x, uint32_t *log2_x, uint32_t count)
+{
+    for (uint32_t i = 0UL; i < count; i++)
+    {
+        log2_x[i] = log2_lut(x[i]);
+    }
+}
+
 /**
  * log10_10 - Compute 10*log10(x).
  * @x: x to convert in 10*log10(x).
@@ -112,7 +238,24 @@ uint16_t log10_10(uint32_t x)
     return (uint16_t)((log2_lut(x) + (LOG2_10_SHIFTED_100TH >> 1UL)) / LOG2_10_SHIFTED_100TH);
 }
 
-uint32_t q8_pow_of_base2(int32_t exponent_q18)
+void log10_10_batch(const uint32_t *x, uint16_t *log10_x, uint32_t count)
+{
+    for (uint32_t i = 0UL; i < count; i++)
+    {
+        log10_x[i] = log10_10(x[i]);
+    }
+}
+
+/**
+ * q8_pow_of_base2_lut - Compute 2 ^ exponent_q18 with the 32 entries lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8.
+ *
+ * The exponent is rounded to a q5 and split into its integer part, applied
+ * with a shift, and its fractional part, looked up in lut_power_base_2.
+ */
+uint32_t q8_pow_of_base2_lut(int32_t exponent_q18)
 {
     uint16_t int_part = 0U;
     uint16_t frac_part = 0U;
@@ -153,3 +296,104 @@ uint32_t q8_pow_of_base2(int32_t exponent_q18)
 
     return ((r1_q5 * r2_q5) >> 2UL);
 }
+
+/*
+ * pow2_scale_q8 - Scale the 2^f mantissa of 2^(i + f) by 2^i.
+ * @m_q15: 2^f as a q15, in [1,2].
+ * @int_part: i.
+ *
+ * Return: 2^(i + f) as a q8, rounded, UINT32_MAX if it does not fit.
+ */
+static uint32_t pow2_scale_q8(uint32_t m_q15, int32_t int_part)
+{
+    int32_t shift = int_part - (int32_t)(LUT_LOG_SHIFT - 8U);
+    uint64_t r;
+
+    if (shift >= 0)
+    {
+        r = (shift > 16) ? UINT64_MAX : ((uint64_t)m_q15 << (uint32_t)shift);
+        return (r > UINT32_MAX) ? UINT32_MAX : (uint32_t)r;
+    }
+    shift = -shift;
+    if (shift > 31)
+    {
+        return 0UL;
+    }
+    return (m_q15 + (1UL << ((uint32_t)shift - 1UL))) >> (uint32_t)shift;
+}
+
+/**
+ * q8_pow_of_base2_interp - Compute 2 ^ exponent_q18 with the 17 entries lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8, UINT32_MAX if it does not fit.
+ *
+ * The exponent is split into its integer part i (rounded down, also for
+ * negative exponents) and its fractional part f in [0,1[, 2^f is linearly
+ * interpolated between the two entries of lut_pow2_interp around f and
+ * scaled by 2^i. Maximum relative error is about 2.5e-4 (1e-3 dB) on top of
+ * the q8 rounding.
+ */
+uint32_t q8_pow_of_base2_interp(int32_t exponent_q18)
+{
+    uint32_t frac = (uint32_t)exponent_q18 & ((1UL << POW2_FRAC_SHIFT) - 1UL);
+    int32_t int_part = (exponent_q18 - (int32_t)frac) / (1L << POW2_FRAC_SHIFT);
+    uint32_t index = frac >> (POW2_FRAC_SHIFT - POW2_INTERP_PRECISION);
+    uint32_t left = frac & ((1UL << (POW2_FRAC_SHIFT - POW2_INTERP_PRECISION)) - 1UL);
+    uint32_t m_q15 = lut_pow2_interp[index] +
+                     (((lut_pow2_interp[index + 1UL] - lut_pow2_interp[index]) * left) >> (POW2_FRAC_SHIFT - POW2_INTERP_PRECISION));
+
+    return pow2_scale_q8(m_q15, int_part);
+}
+
+/**
+ * q8_pow_of_base2_poly - Compute 2 ^ exponent_q18 without lut.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8, UINT32_MAX if it does not fit.
+ *
+ * Same split as q8_pow_of_base2_interp(), 2^f being evaluated with a degree 4
+ * minimax polynomial using Horner's scheme in 32 bits. Maximum relative error
+ * is about 4e-5 (2e-4 dB) on top of the q8 rounding.
+ */
+uint32_t q8_pow_of_base2_poly(int32_t exponent_q18)
+{
+    uint32_t frac = (uint32_t)exponent_q18 & ((1UL << POW2_FRAC_SHIFT) - 1UL);
+    int32_t int_part = (exponent_q18 - (int32_t)frac) / (1L << POW2_FRAC_SHIFT);
+    int32_t f = (int32_t)(frac >> (POW2_FRAC_SHIFT - LUT_LOG_SHIFT));
+    int32_t acc;
+
+    acc = POW2_POLY_C4_Q15;
+    acc = POW2_POLY_C3_Q15 + ((acc * f + (1L << 14)) >> 15);
+    acc = POW2_POLY_C2_Q15 + ((acc * f + (1L << 14)) >> 15);
+    acc = POW2_POLY_C1_Q15 + ((acc * f + (1L << 14)) >> 15);
+    acc = POW2_POLY_C0_Q15 + ((acc * f + (1L << 14)) >> 15);
+
+    return pow2_scale_q8((uint32_t)acc, int_part);
+}
+
+/**
+ * q8_pow_of_base2 - Compute 2 ^ exponent_q18.
+ * @exponent_q18: fixed point value.
+ *
+ * Return: 2 ^ exponent_q18 as a q8, computed by the kernel selected with
+ *         QMATH_POW2_IMPL.
+ */
+uint32_t q8_pow_of_base2(int32_t exponent_q18)
+{
+#if QMATH_POW2_IMPL == QMATH_POW2_POLY
+    return q8_pow_of_base2_poly(exponent_q18);
+#elif QMATH_POW2_IMPL == QMATH_POW2_LUT_INTERP
+    return q8_pow_of_base2_interp(exponent_q18);
+#else
+    return q8_pow_of_base2_lut(exponent_q18);
+#endif
+}
+
+void q8_pow_of_base2_batch(const int32_t *exponent_q18, uint32_t *pow_q8, uint32_t count)
+{
+    for (uint32_t i = 0UL; i < count; i++)
+    {
+        pow_q8[i] = q8_pow_of_base2(exponent_q18[i]);
+    }
+}
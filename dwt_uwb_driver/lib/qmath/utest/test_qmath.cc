@@ -6,7 +6,10 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <cmath>
+#include <string>
+#include <vector>
 
 extern "C"
 {
@@ -30,6 +33,105 @@ TEST_P(TestPowOfBase10, fullRange)
     EXPECT_NEAR(result_q8 / 256.0f, real_val, 0.17);
 }
 
+/*
+ * 2^x kernels: relative error against the double precision 2^x, the q8
+ * rounding (half a unit) aside, over the exponents giving 2^-8 to 2^24.
+ */
+static std::vector<int32_t> Pow2Inputs(int32_t min_q18, int32_t max_q18)
+{
+    std::vector<int32_t> e;
+
+    for (int64_t v = min_q18; v < max_q18; v += 97)
+        e.push_back((int32_t)v);
+    return e;
+}
+
+static double Pow2MaxError(uint32_t (*kernel)(int32_t), int32_t min_q18, int32_t max_q18)
+{
+    double max_err = 0.0;
+
+    for (int32_t e : Pow2Inputs(min_q18, max_q18))
+    {
+        double ref = pow(2.0, e / 262144.0) * 256.0;
+        double err = (fabs((double)kernel(e) - ref) - 0.5) / ref;
+        if (err > max_err)
+            max_err = err;
+    }
+    return max_err;
+}
+
+struct Pow2Kernel
+{
+    const char *name;
+    uint32_t (*kernel)(int32_t);
+    double max_err; /* Relative bound. */
+    int32_t min_q18; /* Exponents checked. */
+    int32_t max_q18;
+};
+
+static void PrintTo(const Pow2Kernel &k, std::ostream *os)
+{
+    *os << k.name;
+}
+
+class TestPow2Kernel : public ::testing::TestWithParam<Pow2Kernel>
+{
+};
+
+/*
+ * The lut kernel adds the fractional part of negative exponents instead of subtracting it, and overflows from 2^21:
+ * checked on [1, 2^21[ only.
+ */
+INSTANTIATE_TEST_SUITE_P(Pow2Kernels, TestPow2Kernel,
+                         testing::Values(Pow2Kernel{ "lut", q8_pow_of_base2_lut, 3e-2, 0, 21 << 18 },
+                                         Pow2Kernel{ "interp", q8_pow_of_base2_interp, 3e-4, -(8 << 18), 24 << 18 },
+                                         Pow2Kernel{ "poly", q8_pow_of_base2_poly, 6e-5, -(8 << 18), 24 << 18 }),
+                         [](const testing::TestParamInfo<Pow2Kernel> &info) { return std::string(info.param.name); });
+
+TEST_P(TestPow2Kernel, errorBound)
+{
+    Pow2Kernel k = GetParam();
+    double max_err = Pow2MaxError(k.kernel, k.min_q18, k.max_q18);
+
+    /* Reported in dB, as used by the RSL computations. */
+    printf("%-10s max relative error %.2e (%.4f dB)\n", k.name, max_err, 10.0 * log10(1.0 + max_err));
+    EXPECT_LE(max_err, k.max_err);
+    EXPECT_EQ(k.kernel(0), 256U);
+    EXPECT_EQ(k.kernel(20 << 18), 256U << 20);
+}
+
+TEST(TestPow2Range, negativeExponents)
+{
+    for (auto kernel : { q8_pow_of_base2_interp, q8_pow_of_base2_poly })
+    {
+        EXPECT_EQ(kernel(-(1 << 18)), 128U);
+        EXPECT_EQ(kernel(-(1 << 17)), 181U); /* 256 / sqrt(2) */
+        EXPECT_EQ(kernel(-(9 << 18)), 1U);   /* Rounded up from 0.5 */
+        EXPECT_EQ(kernel(-(31 << 18)), 0U);
+        EXPECT_EQ(kernel(INT32_MIN), 0U);
+    }
+}
+
+TEST(TestPow2Range, saturation)
+{
+    for (auto kernel : { q8_pow_of_base2_interp, q8_pow_of_base2_poly })
+    {
+        EXPECT_NEAR((double)kernel((23 << 18) + (1 << 17)), 3037000500.0, 3037000500.0 * 3e-4); /* 2^31.5 */
+        EXPECT_EQ(kernel(24 << 18), UINT32_MAX);
+        EXPECT_EQ(kernel(INT32_MAX), UINT32_MAX);
+    }
+}
+
+TEST(TestPow2Batch, matchesScalar)
+{
+    std::vector<int32_t> e = Pow2Inputs(-(8 << 18), 21 << 18);
+    std::vector<uint32_t> pow_q8(e.size());
+
+    q8_pow_of_base2_batch(e.data(), pow_q8.data(), e.size());
+    for (size_t i = 0; i < e.size(); i++)
+        ASSERT_EQ(pow_q8[i], q8_pow_of_base2(e[i]));
+}
+
 class TestLogInt : public ::testing::TestWithParam<int>
 {
 };
@@ -69,3 +171,147 @@ TEST_F(TestLogMin, logMin)
 
     EXPECT_EQ(result_q8, LOG_INVALID_VALUE);
 }
+
+/*
+ * log2 kernels: error against the double precision log2, in units of
+ * 2^-LUT_LOG_SHIFT, over the full input range (logarithmic sweep plus the
+ * values around each power of two).
+ */
+static std::vector<uint32_t> Log2Inputs(void)
+{
+    std::vector<uint32_t> x;
+
+    for (uint32_t z = 0; z < 32; z++)
+    {
+        for (uint32_t k = 0; k < 4096; k++)
+        {
+            uint64_t v = ((uint64_t)(4096 + k) << z) >> 12;
+            if (v > 0 && v <= UINT32_MAX)
+                x.push_back((uint32_t)v);
+        }
+    }
+    x.push_back(UINT32_MAX);
+    return x;
+}
+
+static double Log2MaxError(uint32_t (*kernel)(uint32_t))
+{
+    double max_err = 0.0;
+
+    for (uint32_t v : Log2Inputs())
+    {
+        double ref = log2((double)v) * (1 << LUT_LOG_SHIFT);
+        double err = fabs((double)kernel(v) - ref);
+        if (err > max_err)
+            max_err = err;
+    }
+    return max_err;
+}
+
+struct Log2Kernel
+{
+    const char *name;
+    uint32_t (*kernel)(uint32_t);
+    double max_err; /* Bound in 2^-LUT_LOG_SHIFT units. */
+};
+
+static void PrintTo(const Log2Kernel &k, std::ostream *os)
+{
+    *os << k.name;
+}
+
+class TestLog2Kernel : public ::testing::TestWithParam<Log2Kernel>
+{
+};
+
+INSTANTIATE_TEST_SUITE_P(Log2Kernels, TestLog2Kernel,
+                         testing::Values(Log2Kernel{ "half_delta", log2_lut_half_delta, 750.0 },
+                                         Log2Kernel{ "interp", log2_lut_interp, 30.0 },
+                                         Log2Kernel{ "poly", log2_poly, 10.0 }),
+                         [](const testing::TestParamInfo<Log2Kernel> &info) { return std::string(info.param.name); });
+
+TEST_P(TestLog2Kernel, errorBound)
+{
+    Log2Kernel k = GetParam();
+    double max_err = Log2MaxError(k.kernel);
+
+    /* Reported in dB for 10*log10(x), as used by the RSL computations. */
+    printf("%-10s max error %6.1f (%.4f dB)\n", k.name, max_err,
+           max_err / (1 << LUT_LOG_SHIFT) * 10.0 * log10(2.0));
+    EXPECT_LE(max_err, k.max_err);
+    EXPECT_EQ(k.kernel(1), 0U);
+    EXPECT_EQ(k.kernel(1U << 20), 20U << LUT_LOG_SHIFT);
+}
+
+TEST_P(TestLog2Kernel, notWorseThanHalfDelta)
+{
+    EXPECT_LE(Log2MaxError(GetParam().kernel), Log2MaxError(log2_lut_half_delta));
+}
+
+TEST(TestLog2Batch, matchesScalar)
+{
+    std::vector<uint32_t> x = Log2Inputs();
+    std::vector<uint32_t> log2_x(x.size());
+    std::vector<uint16_t> log10_x(x.size() + 1);
+
+    log2_lut_batch(x.data(), log2_x.data(), x.size());
+    x.push_back(0);
+    log10_10_batch(x.data(), log10_x.data(), x.size());
+    for (size_t i = 0; i < x.size() - 1; i++)
+    {
+        ASSERT_EQ(log2_x[i], log2_lut(x[i]));
+        ASSERT_EQ(log10_x[i], log10_10(x[i]));
+    }
+    EXPECT_EQ(log10_x.back(), LOG_INVALID_VALUE);
+}
+
+/* Throughput of each kernel, informative only. */
+TEST(TestLog2Batch, benchmark)
+{
+    const Log2Kernel kernels[] = { { "half_delta", log2_lut_half_delta, 0 },
+                                   { "interp", log2_lut_interp, 0 },
+                                   { "poly", log2_poly, 0 } };
+    std::vector<uint32_t> x = Log2Inputs();
+    const int rounds = 32;
+    volatile uint32_t sink = 0;
+
+    for (const Log2Kernel &k : kernels)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            uint32_t acc = 0;
+            for (uint32_t v : x)
+                acc += k.kernel(v);
+            sink = sink + acc;
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("%-10s %.2f ns/call\n", k.name, ns / (x.size() * rounds));
+    }
+    (void)sink;
+}
+
+TEST(TestPow2Batch, benchmark)
+{
+    const Pow2Kernel kernels[] = { { "lut", q8_pow_of_base2_lut, 0, 0, 0 },
+                                   { "interp", q8_pow_of_base2_interp, 0, 0, 0 },
+                                   { "poly", q8_pow_of_base2_poly, 0, 0, 0 } };
+    std::vector<int32_t> e = Pow2Inputs(0, 21 << 18);
+    const int rounds = 32;
+    volatile uint32_t sink = 0;
+
+    for (const Pow2Kernel &k : kernels)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            uint32_t acc = 0;
+            for (int32_t v : e)
+                acc += k.kernel(v);
+            sink = sink + acc;
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("%-10s %.2f ns/call\n", k.name, ns / (e.size() * rounds));
+    }
+    (void)sink;
+}
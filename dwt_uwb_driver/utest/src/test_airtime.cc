@@ -0,0 +1,117 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_airtime.h"
+}
+
+/* 64 MHz PRF, 128 symbols preamble, 4z SFD, 6.8 Mb/s: 138398 ns of SHR, 21539 ns of PHR */
+static_assert(AIRTIME_FRAME_NS(DWT_PLEN_128, 9, DWT_SFD_IEEE_4Z, DWT_BR_6M8, DWT_PHRRATE_STD, DWT_STS_MODE_OFF, DWT_STS_LEN_64, 12)
+		      == 138398 + 21539 + 18462,
+	      "air time must be a constant expression");
+
+static dwt_config_t Config(uint16_t plen, uint8_t code, dwt_sfd_type_e sfd, dwt_uwb_bit_rate_e rate, dwt_phr_rate_e phr_rate,
+			   dwt_sts_mode_e sts_mode, dwt_sts_lengths_e sts_len)
+{
+	dwt_config_t config = {};
+
+	config.chan = 5;
+	config.txPreambLength = plen;
+	config.txCode = code;
+	config.rxCode = code;
+	config.sfdType = sfd;
+	config.dataRate = rate;
+	config.phrRate = phr_rate;
+	config.stsMode = sts_mode;
+	config.stsLength = sts_len;
+	return config;
+}
+
+TEST(AirTime, Prf64Short)
+{
+	dwt_config_t config = Config(DWT_PLEN_128, 9, DWT_SFD_IEEE_4Z, DWT_BR_6M8, DWT_PHRRATE_STD, DWT_STS_MODE_OFF, DWT_STS_LEN_64);
+	dwt_airtime_t at;
+
+	airtime_calc(&config, &at);
+	EXPECT_EQ(138398u, at.shr_ns);
+	EXPECT_EQ(0u, at.sts_ns);
+	EXPECT_EQ(21539u, at.phr_ns);
+	EXPECT_EQ(128205u, at.bit_ps);
+	// 12 bytes: 96 bits and one Reed-Solomon block of parity
+	EXPECT_EQ(138398u + 21539u + 18462u, airtime_frame_ns(&at, 12));
+	EXPECT_EQ(21539u + 18462u, airtime_after_rmarker_ns(&at, 12));
+	EXPECT_EQ(AIRTIME_FRAME_NS(DWT_PLEN_128, 9, DWT_SFD_IEEE_4Z, DWT_BR_6M8, DWT_PHRRATE_STD, DWT_STS_MODE_OFF, DWT_STS_LEN_64, 12),
+		  airtime_frame_ns(&at, 12));
+}
+
+TEST(AirTime, Prf16Long)
+{
+	dwt_config_t config = Config(DWT_PLEN_1024, 3, DWT_SFD_DW_16, DWT_BR_850K, DWT_PHRRATE_STD, DWT_STS_MODE_OFF, DWT_STS_LEN_64);
+	dwt_airtime_t at;
+
+	airtime_calc(&config, &at);
+	EXPECT_EQ(1033334u, at.shr_ns);
+	EXPECT_EQ(21539u, at.phr_ns);
+	// 127 bytes: 1016 bits and four blocks of parity
+	EXPECT_EQ(1033334u + 21539u + 1238975u, airtime_frame_ns(&at, 127));
+}
+
+TEST(AirTime, PhrAtDataRate)
+{
+	dwt_config_t config = Config(DWT_PLEN_64, 10, DWT_SFD_DW_8, DWT_BR_6M8, DWT_PHRRATE_DTA, DWT_STS_MODE_OFF, DWT_STS_LEN_64);
+	dwt_airtime_t at;
+
+	airtime_calc(&config, &at);
+	EXPECT_EQ(2693u, at.phr_ns);
+	EXPECT_EQ(73270u, at.shr_ns);
+}
+
+TEST(AirTime, Sts)
+{
+	dwt_config_t config = Config(DWT_PLEN_64, 9, DWT_SFD_IEEE_4Z, DWT_BR_6M8, DWT_PHRRATE_STD, DWT_STS_MODE_1, DWT_STS_LEN_64);
+	dwt_airtime_t at;
+
+	airtime_calc(&config, &at);
+	EXPECT_EQ(65642u, at.sts_ns);
+	EXPECT_EQ(73270u + 65642u + 21539u + 18462u, airtime_frame_ns(&at, 12));
+
+	// Super deterministic codes do not change the frame
+	config.stsMode = (dwt_sts_mode_e)(DWT_STS_MODE_2 | DWT_STS_MODE_SDC);
+	config.stsLength = DWT_STS_LEN_128;
+	airtime_calc(&config, &at);
+	EXPECT_EQ(131283u, at.sts_ns);
+
+	// No data (SP3): SHR and STS only, whatever the length
+	config.stsMode = DWT_STS_MODE_ND;
+	airtime_calc(&config, &at);
+	EXPECT_EQ(0u, at.phr_ns);
+	EXPECT_EQ(0u, at.bit_ps);
+	EXPECT_EQ(73270u + 131283u, airtime_frame_ns(&at, 0));
+	EXPECT_EQ(73270u + 131283u, airtime_frame_ns(&at, 20));
+}
+
+TEST(AirTime, ReplyDelay)
+{
+	dwt_config_t config = Config(DWT_PLEN_128, 9, DWT_SFD_IEEE_4Z, DWT_BR_6M8, DWT_PHRRATE_STD, DWT_STS_MODE_OFF, DWT_STS_LEN_64);
+	dwt_airtime_t at;
+	uint32_t dly;
+
+	airtime_calc(&config, &at);
+	// Rest of the frame received, turnaround and SHR of the reply, plus the delayed TX rounding
+	dly = airtime_reply_dly_dtu(&at, 12, 100000);
+	EXPECT_GE((double)dly, (40001.0 + 100000.0 + 138398.0) * 63.8976 + 512.0);
+	EXPECT_LT((double)dly, (40001.0 + 100000.0 + 138398.0) * 63.8976 + 514.0);
+
+	// The peer turns its receiver on when the reply starts: after the turnaround, 97.5 UUS
+	EXPECT_EQ(97u, airtime_rx_after_tx_uus(&at, 12, dly));
+	// Too short a reply delay to turn the receiver on after TX
+	EXPECT_EQ(0u, airtime_rx_after_tx_uus(&at, 12, 1000));
+	EXPECT_EQ(0u, airtime_rx_after_tx_uus(&at, 12, airtime_reply_dly_dtu(&at, 12, 0) - 1000));
+}
@@ -0,0 +1,137 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_antcal.h"
+}
+
+static const uint32_t kTof = 1000;
+
+static void InitCal(antcal_t *cal, uint16_t min_count = 10, uint16_t max_stderr_q4 = 8)
+{
+	antcal_config_t config = {};
+
+	config.tof_dtu = kTof;
+	config.tx_antenna_delay = 16450;
+	config.rx_antenna_delay = 16400;
+	config.tx_share_q8 = ANTCAL_TX_SHARE_HALF;
+	config.min_count = min_count;
+	config.max_stderr_q4 = max_stderr_q4;
+	antcal_init(cal, &config);
+}
+
+TEST(AntCal, MmToTof)
+{
+	// 1 DTU is 4.69 mm
+	EXPECT_EQ(0u, antcal_mm_to_tof(0));
+	EXPECT_EQ(213u, antcal_mm_to_tof(1000));
+	EXPECT_EQ(21320u, antcal_mm_to_tof(100000));
+	EXPECT_EQ(2132u, antcal_mm_to_tof(9999));
+}
+
+TEST(AntCal, SolveExact)
+{
+	antcal_delays_t delays;
+	antcal_t cal;
+
+	InitCal(&cal);
+	// Delays 100 DTU too large in sum: times of flight are 50 DTU short
+	for (int i = 0; i < 9; i++)
+		EXPECT_EQ(ANTCAL_RUNNING, antcal_add(&cal, kTof - 50));
+	EXPECT_EQ(ANTCAL_DONE, antcal_add(&cal, kTof - 50));
+	ASSERT_EQ(DWT_SUCCESS, antcal_solve(&cal, &delays));
+	EXPECT_EQ(16375, delays.tx_antenna_delay);
+	EXPECT_EQ(16375, delays.rx_antenna_delay);
+}
+
+TEST(AntCal, SolveTooShortAndSplit)
+{
+	antcal_delays_t delays;
+	antcal_t cal;
+
+	InitCal(&cal);
+	cal.config.tx_share_q8 = 192;
+	// Delays 30 DTU too small in sum, three quarters of the sum is TX
+	antcal_add(&cal, kTof + 15);
+	antcal_add(&cal, kTof + 15);
+	ASSERT_EQ(DWT_SUCCESS, antcal_solve(&cal, &delays));
+	EXPECT_EQ(24660, delays.tx_antenna_delay);
+	EXPECT_EQ(8220, delays.rx_antenna_delay);
+}
+
+TEST(AntCal, NotEnoughMeasurements)
+{
+	antcal_delays_t delays;
+	antcal_t cal;
+
+	InitCal(&cal);
+	EXPECT_EQ(DWT_ERROR, antcal_solve(&cal, &delays));
+	antcal_add(&cal, kTof);
+	EXPECT_EQ(DWT_ERROR, antcal_solve(&cal, &delays));
+}
+
+TEST(AntCal, NoisyConverges)
+{
+	std::mt19937 rng(3);
+	std::normal_distribution<double> noise(0.0, 4.0);
+	antcal_delays_t delays;
+	antcal_status_e status = ANTCAL_RUNNING;
+	antcal_t cal;
+	int n = 0;
+
+	// Standard error of 0.25 DTU with 4 DTU of noise takes about 256 measurements
+	InitCal(&cal, 10, 4);
+	while ((status != ANTCAL_DONE) && (n < 2000)) {
+		status = antcal_add(&cal, kTof - 37 + (int32_t)lround(noise(rng)));
+		n++;
+	}
+	ASSERT_EQ(ANTCAL_DONE, status);
+	EXPECT_GT(n, 150);
+	EXPECT_LT(n, 400);
+	ASSERT_EQ(DWT_SUCCESS, antcal_solve(&cal, &delays));
+	EXPECT_NEAR(16450 + 16400 - 74, delays.tx_antenna_delay + delays.rx_antenna_delay, 2);
+}
+
+TEST(AntCal, OutliersRejected)
+{
+	antcal_delays_t delays;
+	antcal_t cal;
+
+	InitCal(&cal, 10, 16);
+	for (int i = 0; i < 40; i++)
+		EXPECT_NE(ANTCAL_REJECTED, antcal_add(&cal, kTof - 20 + ((i % 3) - 1)));
+	// Reflections are longer paths, far out of the distribution
+	EXPECT_EQ(ANTCAL_REJECTED, antcal_add(&cal, kTof + 60));
+	EXPECT_EQ(ANTCAL_REJECTED, antcal_add(&cal, kTof - 35));
+	// Beyond ANTCAL_RESIDUAL_MAX_DTU whatever the count
+	EXPECT_EQ(ANTCAL_REJECTED, antcal_add(&cal, (int32_t)kTof + 5000));
+	EXPECT_EQ(3, cal.rejected);
+	EXPECT_EQ(40, cal.count);
+	ASSERT_EQ(DWT_SUCCESS, antcal_solve(&cal, &delays));
+	EXPECT_EQ(16450 + 16400 - 40, delays.tx_antenna_delay + delays.rx_antenna_delay);
+}
+
+TEST(AntCal, OutOfRange)
+{
+	antcal_delays_t delays;
+	antcal_t cal;
+
+	InitCal(&cal);
+	cal.config.tx_antenna_delay = 40000;
+	cal.config.rx_antenna_delay = 40000;
+	cal.config.tx_share_q8 = 256;
+	// All of the sum on TX overflows 16 bits
+	antcal_add(&cal, kTof);
+	antcal_add(&cal, kTof);
+	EXPECT_EQ(DWT_ERROR, antcal_solve(&cal, &delays));
+}
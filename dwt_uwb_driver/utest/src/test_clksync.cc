@@ -0,0 +1,188 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_clksync.h"
+#include "dw3000_deca_regs.h"
+}
+
+/*
+ * Free running 40-bit counters of the reference (master) anchor and of the
+ * local anchor, with their crystal offsets in ppm, at true time t in seconds.
+ */
+struct Clocks {
+	uint64_t master0, local0;
+	double ppm_master, ppm_local;
+
+	ts40_t Master(double t) const
+	{
+		return (master0 + (uint64_t)llround(t * TS40_DTU_PER_S * (1.0 + ppm_master * 1e-6))) & TS40_MASK;
+	}
+	ts40_t Local(double t) const
+	{
+		return (local0 + (uint64_t)llround(t * TS40_DTU_PER_S * (1.0 + ppm_local * 1e-6))) & TS40_MASK;
+	}
+	/* Clock offset as measured by the CIA, positive when the local clock is slower. */
+	int16_t Coe() const
+	{
+		return (int16_t)lround(((1.0 + ppm_master * 1e-6) / (1.0 + ppm_local * 1e-6) - 1.0) * (1 << 26));
+	}
+};
+
+static const double kTof = 20.0 / 299702547.0;
+
+static int32_t Sync(csync_t *cs, const Clocks &c, double t, int32_t noise = 0)
+{
+	return csync_update(cs, 0x10, c.Master(t), ts40_add(c.Local(t + kTof), (uint64_t)(int64_t)noise), c.Coe());
+}
+
+static int64_t ConvError(const csync_t *cs, const Clocks &c, double t)
+{
+	ts40_t master;
+
+	EXPECT_EQ(DWT_SUCCESS, csync_to_master(cs, 0x10, c.Local(t), &master));
+	return ts40_diff(master, c.Master(t));
+}
+
+static void InitSync(csync_t *cs)
+{
+	csync_init(cs, 0xDECA, 1, 16385, NULL);
+	ASSERT_EQ(DWT_SUCCESS, csync_add_ref(cs, 0x10, (uint32_t)llround(kTof * TS40_DTU_PER_S)));
+}
+
+TEST(ClkSync, RegressionAcrossWrap)
+{
+	std::mt19937 rng(37);
+	std::uniform_int_distribution<int32_t> noise(-8, 8);
+	std::uniform_real_distribution<double> ppm(-20.0, 20.0);
+
+	for (int run = 0; run < 200; run++) {
+		/* Local counter wrapping within the run now and then. */
+		Clocks c = { rng() & TS40_MASK, (run % 4 == 0) ? TS40_MASK - 10000000000ULL : (uint64_t)rng(),
+			     ppm(rng), ppm(rng) };
+		csync_t cs;
+
+		InitSync(&cs);
+		for (int k = 0; k < 40; k++) {
+			ASSERT_EQ(DWT_SUCCESS, Sync(&cs, c, k * 0.1, noise(rng)));
+		}
+		/* Blink 50 ms after the last sync frame, time stamp noise of +/-8 DTU averaged over the window. */
+		ASSERT_LE(std::abs(ConvError(&cs, c, 3.95)), 16) << "run " << run;
+		EXPECT_NEAR((c.ppm_master - c.ppm_local) * 1e-6 * 1099511627776.0, (double)cs.ref[0].drift_q40, 1099512.0);
+	}
+}
+
+TEST(ClkSync, ClockOffsetBeforeSecondSync)
+{
+	Clocks c = { 0x1234567890ULL, 0xFEDCBA9876ULL, 12.0, -7.0 };
+	csync_t cs;
+	ts40_t master;
+
+	InitSync(&cs);
+	EXPECT_EQ(DWT_ERROR, csync_to_master(&cs, 0x10, c.Local(0.05), &master));
+	EXPECT_EQ(DWT_ERROR, csync_to_master(&cs, 0x20, c.Local(0.05), &master));
+	ASSERT_EQ(DWT_SUCCESS, Sync(&cs, c, 0.0));
+	/* The drift comes from the clock offset alone, 2^-26 resolution over 50 ms. */
+	EXPECT_LE(std::abs(ConvError(&cs, c, 0.05)), 64);
+	/* Without it the error would be 19 ppm of 50 ms. */
+	EXPECT_GT(std::abs(ts40_diff(ts40_add(c.Local(0.05), cs.ref[0].fit_offset), c.Master(0.05))), 50000);
+}
+
+TEST(ClkSync, OutlierAndReferenceReset)
+{
+	Clocks c = { 0x1234567890ULL, 0x0000001000ULL, 5.0, -3.0 };
+	csync_t cs;
+
+	InitSync(&cs);
+	EXPECT_EQ(DWT_ERROR, csync_update(&cs, 0x20, 0, 0, 0));
+	for (int k = 0; k < 8; k++) {
+		ASSERT_EQ(DWT_SUCCESS, Sync(&cs, c, k * 0.1));
+	}
+	/* A late detection (e.g. first path missed) is rejected and does not move the fit. */
+	EXPECT_EQ(DWT_ERROR, Sync(&cs, c, 0.8, 5000));
+	EXPECT_LE(std::abs(ConvError(&cs, c, 0.85)), 2);
+	EXPECT_EQ(DWT_SUCCESS, Sync(&cs, c, 0.9));
+
+	/* The reference restarts its counter: the third sync frame in a row restarts the fit. */
+	c.master0 = 0x5555555555ULL;
+	EXPECT_EQ(DWT_ERROR, Sync(&cs, c, 1.0));
+	EXPECT_EQ(DWT_ERROR, Sync(&cs, c, 1.1));
+	EXPECT_EQ(DWT_SUCCESS, Sync(&cs, c, 1.2));
+	EXPECT_EQ(1U, cs.ref[0].count);
+	EXPECT_EQ(DWT_SUCCESS, Sync(&cs, c, 1.3));
+	EXPECT_LE(std::abs(ConvError(&cs, c, 1.35)), 2);
+}
+
+TEST(ClkSync, References)
+{
+	csync_t cs;
+
+	csync_init(&cs, 0xDECA, 1, 0, NULL);
+	for (uint16_t i = 0; i < CSYNC_REF_MAX; i++) {
+		EXPECT_EQ(DWT_SUCCESS, csync_add_ref(&cs, i, 0));
+	}
+	EXPECT_EQ(DWT_ERROR, csync_add_ref(&cs, 100, 0));
+}
+
+/* Frame length, buffer offset and ranging bit programmed in TX_FCTRL */
+static uint64_t Fctrl(uwbsim::Sim &sim, int dev)
+{
+	return sim.Peek(dev, TX_FCTRL_ID, 4) & (TX_FCTRL_TXFLEN_BIT_MASK | TX_FCTRL_TXB_OFFSET_BIT_MASK | TX_FCTRL_TR_BIT_MASK);
+}
+
+TEST(ClkSync, SendFromTemplates)
+{
+	uwbsim::Sim sim;
+	int dev = sim.AddDevice(uwbsim::NodeConfig());
+	uint8_t frame[TXTMPL_FRAME_MAX] = { 0x41, 0x88 };
+	const uint64_t other = 22 | TX_FCTRL_TR_BIT_MASK;
+	const uint64_t sync = CSYNC_LEN | (20 << TX_FCTRL_TXB_OFFSET_BIT_OFFSET) | TX_FCTRL_TR_BIT_MASK;
+	txtmpl_mgr_t tx;
+	csync_t cs;
+
+	// The sync frame is added after the other frame of the manager, which writes TX_FCTRL back for it
+	txtmpl_init(&tx, 0);
+	ASSERT_EQ(0, txtmpl_add(&tx, frame, 22, 1));
+	csync_init(&cs, 0xDECA, 1, 16385, &tx);
+	ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&tx, 0));
+	ASSERT_EQ(DWT_SUCCESS, csync_send(&cs, (uint32_t)(TS40_DTU_PER_S / 1000)));
+	EXPECT_EQ(sync, Fctrl(sim, dev));
+	sim.Run(2e-3);
+	EXPECT_EQ(1u, sim.FramesSent());
+	ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&tx, 0));
+	EXPECT_EQ(other, Fctrl(sim, dev));
+	ASSERT_EQ(DWT_SUCCESS, csync_send(&cs, (uint32_t)(TS40_DTU_PER_S / 1000)));
+	EXPECT_EQ(sync, Fctrl(sim, dev));
+	EXPECT_EQ(2u, tx.count);
+
+	// Added again once the manager is initialised again
+	txtmpl_init(&tx, 0);
+	ASSERT_EQ(0, txtmpl_add(&tx, frame, 22, 1));
+	ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&tx, 0));
+	ASSERT_EQ(DWT_SUCCESS, csync_send(&cs, (uint32_t)(TS40_DTU_PER_S / 1000)));
+	EXPECT_EQ(sync, Fctrl(sim, dev));
+	EXPECT_EQ(2u, tx.count);
+
+	// A full manager forgets the device content
+	txtmpl_init(&tx, 0);
+	for (unsigned i = 0; i < TXTMPL_MAX; i++)
+		ASSERT_EQ((int32_t)i, txtmpl_add(&tx, frame, 12, 1));
+	ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&tx, 0));
+	ASSERT_EQ(DWT_SUCCESS, csync_send(&cs, (uint32_t)(TS40_DTU_PER_S / 1000)));
+	EXPECT_EQ(TXTMPL_NONE, tx.selected);
+	EXPECT_EQ(0, tx.tmpl[0].staged);
+	ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&tx, 0));
+	EXPECT_EQ(12u | TX_FCTRL_TR_BIT_MASK, Fctrl(sim, dev));
+}
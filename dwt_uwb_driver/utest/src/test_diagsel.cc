@@ -0,0 +1,165 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+using uwbsim::Sim;
+
+/* Fields are compared through copies: the structure is packed */
+#define EXPECT_FIELD(f) EXPECT_EQ((int64_t)full.f, (int64_t)sel.f) << #f
+#define EXPECT_BYTES(f) EXPECT_EQ(0, memcmp(full.f, sel.f, sizeof(full.f))) << #f
+
+static void ExpectSameDiag(const dwt_rxdiag_t &full, const dwt_rxdiag_t &sel)
+{
+	EXPECT_BYTES(ipatovRxTime);
+	EXPECT_FIELD(ipatovRxStatus);
+	EXPECT_FIELD(ipatovPOA);
+	EXPECT_BYTES(stsRxTime);
+	EXPECT_FIELD(stsRxStatus);
+	EXPECT_FIELD(stsPOA);
+	EXPECT_BYTES(sts2RxTime);
+	EXPECT_FIELD(sts2RxStatus);
+	EXPECT_FIELD(sts2POA);
+	EXPECT_BYTES(tdoa);
+	EXPECT_FIELD(pdoa);
+	EXPECT_FIELD(xtalOffset);
+	EXPECT_FIELD(ciaDiag1);
+	EXPECT_FIELD(ipatovPeak);
+	EXPECT_FIELD(ipatovPower);
+	EXPECT_FIELD(ipatovF1);
+	EXPECT_FIELD(ipatovF2);
+	EXPECT_FIELD(ipatovF3);
+	EXPECT_FIELD(ipatovFpIndex);
+	EXPECT_FIELD(ipatovAccumCount);
+	EXPECT_FIELD(stsPeak);
+	EXPECT_FIELD(stsPower);
+	EXPECT_FIELD(stsF1);
+	EXPECT_FIELD(stsF2);
+	EXPECT_FIELD(stsF3);
+	EXPECT_FIELD(stsFpIndex);
+	EXPECT_FIELD(stsAccumCount);
+	EXPECT_FIELD(sts2Peak);
+	EXPECT_FIELD(sts2Power);
+	EXPECT_FIELD(sts2F1);
+	EXPECT_FIELD(sts2F2);
+	EXPECT_FIELD(sts2F3);
+	EXPECT_FIELD(sts2FpIndex);
+	EXPECT_FIELD(sts2AccumCount);
+}
+
+/* The selective read against the full one, on CIA result registers and swinging sets filled with random data */
+class DiagSel : public ::testing::Test {
+protected:
+	Sim sim;
+
+	void SetUp() override
+	{
+		std::mt19937 rng(26);
+
+		sim.AddDevice(uwbsim::NodeConfig());
+		for (uint32_t id : { IP_TOA_LO_ID, STS_DIAG_4_ID, BUF0_RX_FINFO }) {
+			uint8_t *p = sim.Reg(0, id);
+
+			for (unsigned i = 0; i < 0x200; i++)
+				p[i] = (uint8_t)rng();
+		}
+	}
+
+	/* Full read, selective read of all the fields, and of one span at a time */
+	void Compare(uint8_t level, const char *mode)
+	{
+		dwt_rxdiag_t full, all, each;
+		uint32_t got = 0;
+
+		memset(&full, 0, sizeof(full));
+		memset(&all, 0, sizeof(all));
+		memset(&each, 0, sizeof(each));
+		dwt_readdiagnostics(&full);
+		(void)dwt_readdiagnostics_sel(&all, DWT_DIAG_SEL_ALL);
+		for (uint32_t bit = 1; bit <= DWT_DIAG_SEL_ALL; bit <<= 1)
+			got |= dwt_readdiagnostics_sel(&each, bit);
+
+		SCOPED_TRACE(::testing::Message() << mode << ", level " << (int)level);
+		EXPECT_EQ(got, dwt_readdiagnostics_sel(&all, DWT_DIAG_SEL_ALL));
+		ExpectSameDiag(full, all);
+		ExpectSameDiag(full, each);
+	}
+};
+
+TEST_F(DiagSel, NormalMode)
+{
+	for (uint8_t level : { (uint8_t)DW_CIA_DIAG_LOG_OFF, (uint8_t)DW_CIA_DIAG_LOG_ALL }) {
+		dwt_configciadiag(level);
+		Compare(level, "normal mode");
+	}
+}
+
+TEST_F(DiagSel, DoubleBuffer)
+{
+	dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN);
+	for (uint8_t level : { (uint8_t)DW_CIA_DIAG_LOG_MIN, (uint8_t)DW_CIA_DIAG_LOG_MID, (uint8_t)DW_CIA_DIAG_LOG_MAX }) {
+		dwt_configciadiag(level);
+		Compare(level, "RX buffer 0");
+		dwt_signal_rx_buff_free();
+		Compare(level, "RX buffer 1");
+		dwt_signal_rx_buff_free();
+	}
+}
+
+TEST_F(DiagSel, StsPoaNormalMode)
+{
+	dwt_rxdiag_t full, sel;
+
+	// Phases of arrival after the 5th time stamp byte, as the Ipatov one
+	sim.Poke(0, STS_TOA_LO_ID, 0x11111111, 4);
+	sim.Poke(0, STS_TOA_HI_ID, 0x00CAFE00, 4);
+	sim.Poke(0, STS1_TOA_LO_ID, 0x22222222, 4);
+	sim.Poke(0, STS1_TOA_HI_ID, 0x00BEEF00, 4);
+	dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+	memset(&full, 0, sizeof(full));
+	memset(&sel, 0, sizeof(sel));
+	dwt_readdiagnostics(&full);
+	EXPECT_EQ((uint32_t)(DWT_DIAG_SEL_STS_TOA | DWT_DIAG_SEL_STS2_TOA),
+		  dwt_readdiagnostics_sel(&sel, DWT_DIAG_SEL_STS_TOA | DWT_DIAG_SEL_STS2_TOA));
+	EXPECT_EQ(0xCAFE, (int)full.stsPOA);
+	EXPECT_EQ(0xBEEF, (int)full.sts2POA);
+	EXPECT_EQ(0xCAFE, (int)sel.stsPOA);
+	EXPECT_EQ(0xBEEF, (int)sel.sts2POA);
+}
+
+TEST_F(DiagSel, StsPoaDoubleBuffer)
+{
+	dwt_rxdiag_t full, sel;
+
+	// Same layout in the swinging set: BUF0_STS_STAT and BUF0_STS1_STAT, not the time stamp bytes before them
+	sim.Poke(0, BUF0_STS_TS, 0x11111111, 4);
+	sim.Poke(0, BUF0_STS_STAT, 0x00CAFE00, 4);
+	sim.Poke(0, BUF0_STS1_TS, 0x22222222, 4);
+	sim.Poke(0, BUF0_STS1_STAT, 0x00BEEF00, 4);
+	dwt_setdblrxbuffmode(DBL_BUF_STATE_EN, DBL_BUF_MODE_MAN);
+	dwt_configciadiag(DW_CIA_DIAG_LOG_MID);
+	memset(&full, 0, sizeof(full));
+	memset(&sel, 0, sizeof(sel));
+	dwt_readdiagnostics(&full);
+	EXPECT_EQ((uint32_t)(DWT_DIAG_SEL_STS_TOA | DWT_DIAG_SEL_STS2_TOA),
+		  dwt_readdiagnostics_sel(&sel, DWT_DIAG_SEL_STS_TOA | DWT_DIAG_SEL_STS2_TOA));
+	EXPECT_EQ(0xCAFE, (int)full.stsPOA);
+	EXPECT_EQ(0xBEEF, (int)full.sts2POA);
+	EXPECT_EQ(0xCAFE, (int)sel.stsPOA);
+	EXPECT_EQ(0xBEEF, (int)sel.sts2POA);
+}
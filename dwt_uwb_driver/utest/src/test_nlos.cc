@@ -0,0 +1,295 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_nlos.h"
+#include "deca_rsl.h"
+}
+
+static dwt_nlos_snapshot_t MakeSnapshot(uint32_t cir_power, uint32_t f,
+					uint32_t index_fp, uint32_t index_pp)
+{
+	dwt_nlos_snapshot_t snap;
+
+	memset(&snap, 0, sizeof(snap));
+	snap.acc_mask = DWT_NLOS_SEL_IPATOV;
+	snap.D = 0;
+	snap.acc[IPATOV].accumCount = 1000;
+	snap.acc[IPATOV].cir_power = cir_power;
+	snap.acc[IPATOV].F1 = f;
+	snap.acc[IPATOV].F2 = f;
+	snap.acc[IPATOV].F3 = f;
+	snap.acc[IPATOV].index_fp = index_fp;
+	snap.acc[IPATOV].index_pp = index_pp;
+	return snap;
+}
+
+TEST(NlosEstimate, PowerDifference)
+{
+	/* Sweep C for a fixed first path, covering LOS, possible NLOS and NLOS. */
+	for (uint32_t c = 50; c < 5000; c += 50) {
+		dwt_nlos_snapshot_t snap = MakeSnapshot(c, 20000, 0, 0);
+
+		ASSERT_EQ(DWT_SUCCESS, nlos_estimate(&snap, 21, 9));
+		EXPECT_EQ(IPATOV, snap.diag_type);
+		EXPECT_EQ(snap.rsl_q8,
+			  rsl_calculate_signal_power(c, 21, 1000, 0, 9, false));
+		EXPECT_EQ(snap.fsl_q8,
+			  rsl_calculate_first_path_power(20000, 20000, 20000,
+							 1000, 0, 9, false));
+
+		/* Classification uses the power ratio, equal to the
+		 * difference of both powers up to rounding. */
+		double diff_db = (snap.rsl_q8 - snap.fsl_q8) / 256.0;
+		if (std::fabs(diff_db - 12.0) < 0.05 ||
+		    std::fabs(diff_db - 4.8) < 0.05) {
+			continue;
+		}
+		if (diff_db > 12.0) {
+			EXPECT_EQ(DWT_NLOS_RESULT_NLOS, snap.result);
+			EXPECT_EQ(100, snap.prob_nlos);
+		} else if (diff_db > 4.8) {
+			EXPECT_EQ(DWT_NLOS_RESULT_POSSIBLE, snap.result);
+			EXPECT_NEAR((diff_db - 4.8) * 100.0 / 7.2,
+				    snap.prob_nlos, 2.0);
+		} else {
+			EXPECT_EQ(DWT_NLOS_RESULT_LOS, snap.result);
+			EXPECT_EQ(0, snap.prob_nlos);
+		}
+	}
+}
+
+TEST(NlosEstimate, IndexSpread)
+{
+	/* C small enough that the first path power is close to signal power. */
+	for (uint32_t spread_q6 = 0; spread_q6 < 8 * 64; spread_q6++) {
+		dwt_nlos_snapshot_t snap =
+			MakeSnapshot(50, 20000, 700 << 6, (700 << 6) + spread_q6);
+
+		ASSERT_EQ(DWT_SUCCESS, nlos_estimate(&snap, 21, 9));
+		ASSERT_LE(snap.rsl_q8 - snap.fsl_q8, (int)(4.8 * 256));
+
+		double spread = spread_q6 / 64.0;
+		if (spread <= 3.3) {
+			EXPECT_EQ(DWT_NLOS_RESULT_LOS, snap.result);
+			EXPECT_EQ(0, snap.prob_nlos);
+		} else if (spread >= 6.0) {
+			EXPECT_EQ(DWT_NLOS_RESULT_NLOS, snap.result);
+			EXPECT_EQ(100, snap.prob_nlos);
+		} else {
+			double expected = (0.39178 * spread - 1.31719) * 100.0;
+			expected = std::max(0.0, std::min(100.0, expected));
+			EXPECT_NEAR(expected, snap.prob_nlos, 1.0);
+		}
+	}
+}
+
+TEST(NlosEstimate, AccumulatorSelection)
+{
+	dwt_nlos_snapshot_t snap = MakeSnapshot(50, 20000, 0, 0);
+
+	snap.acc[STS2] = snap.acc[IPATOV];
+	snap.acc_mask = DWT_NLOS_SEL_STS2;
+	EXPECT_EQ(DWT_SUCCESS, nlos_estimate(&snap, 17, 9));
+	EXPECT_EQ(STS2, snap.diag_type);
+	EXPECT_EQ(snap.rsl_q8,
+		  rsl_calculate_signal_power(50, 17, 1000, 0, 9, true));
+
+	snap.acc_mask = 0;
+	EXPECT_EQ(DWT_ERROR, nlos_estimate(&snap, 21, 9));
+	EXPECT_EQ(DWT_ERROR, nlos_estimate(NULL, 21, 9));
+
+	/* Power can't be computed with no accumulated symbols. */
+	snap = MakeSnapshot(50, 20000, 0, 0);
+	snap.acc[IPATOV].accumCount = 0;
+	EXPECT_EQ(DWT_ERROR, nlos_estimate(&snap, 21, 9));
+}
+
+/*
+ * Replay of diagnostics through the classifier, checked against a double
+ * precision implementation of the same algorithm.
+ *
+ * Diagnostics recorded on a device (cir_power, F1, F2, F3, accumCount,
+ * index_fp and index_pp as read by dwt_nlos_readsnapshot(), one frame per
+ * line, comma separated) can be replayed by setting NLOS_REPLAY_FILE.
+ */
+struct NlosRecord {
+	uint32_t cir_power;
+	uint32_t F1;
+	uint32_t F2;
+	uint32_t F3;
+	uint32_t accumCount;
+	uint32_t index_fp;
+	uint32_t index_pp;
+};
+
+static const NlosRecord nlos_records[] = {
+	/* Strong first path, short spread. */
+	{ 1200, 76000, 118000, 92000, 1017, 47120, 47232 },
+	{ 980, 61000, 97000, 80000, 1009, 47302, 47360 },
+	{ 3100, 140000, 210000, 170000, 1021, 46980, 47040 },
+	/* First path a few dB below total. */
+	{ 1450, 36000, 52000, 41000, 1013, 47410, 47552 },
+	{ 2300, 41000, 60000, 47000, 1019, 47020, 47232 },
+	{ 850, 21000, 30000, 26000, 1008, 47500, 47680 },
+	/* Weak first path, reflections. */
+	{ 2600, 12000, 19000, 15000, 1018, 47260, 47680 },
+	{ 1900, 6000, 9400, 8100, 1014, 47080, 47616 },
+	{ 4200, 4100, 7000, 5200, 1022, 46900, 47552 },
+	/* Strong first path but long spread. */
+	{ 700, 40000, 66000, 52000, 1004, 47190, 47488 },
+	{ 640, 41000, 63000, 50000, 1002, 47330, 47680 },
+	/* STS lengths, CIR power on 17 bits of quantization. */
+	{ 19000, 70000, 110000, 90000, 64, 31100, 31168 },
+	{ 25000, 9000, 15000, 12000, 64, 31200, 31744 },
+};
+
+struct NlosReference {
+	double fp_ratio_db;
+	double spread;
+	double prob_nlos;
+	double confidence;
+};
+
+static double PowerProbability(double fp_ratio_db)
+{
+	double diff = -fp_ratio_db;
+
+	if (diff > 12.0)
+		return 100.0;
+	if (diff > 4.8)
+		return (diff - 4.8) * 100.0 / 7.2;
+	return 0.0;
+}
+
+static double IndexProbability(double spread)
+{
+	if (spread <= 3.3)
+		return 0.0;
+	if (spread >= 6.0)
+		return 100.0;
+	return std::max(0.0, std::min(100.0, (0.39178 * spread - 1.31719) * 100.0));
+}
+
+static NlosReference Reference(const NlosRecord &r, uint8_t quantization_factor)
+{
+	NlosReference ref;
+	double f1 = r.F1 / 4, f2 = r.F2 / 4, f3 = r.F3 / 4;
+
+	ref.fp_ratio_db = 10.0 * log10((f1 * f1 + f2 * f2 + f3 * f3) /
+				       (r.cir_power * std::pow(2.0, quantization_factor)));
+	ref.spread = ((double)r.index_pp - (double)r.index_fp) / 64.0;
+	double prob_power = PowerProbability(ref.fp_ratio_db);
+	double prob_index = IndexProbability(ref.spread);
+	ref.prob_nlos = prob_power != 0.0 ? prob_power : prob_index;
+	ref.confidence = std::fabs(2.0 * ref.prob_nlos - 100.0) *
+			 (100.0 - std::fabs(prob_power - prob_index) / 2.0) / 100.0;
+	return ref;
+}
+
+static std::vector<NlosRecord> LoadRecords(void)
+{
+	std::vector<NlosRecord> records;
+	const char *path = getenv("NLOS_REPLAY_FILE");
+
+	if (path == NULL) {
+		return std::vector<NlosRecord>(std::begin(nlos_records), std::end(nlos_records));
+	}
+
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		ADD_FAILURE() << "cannot open " << path;
+		return records;
+	}
+	NlosRecord r;
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%u,%u,%u,%u,%u,%u,%u", &r.cir_power, &r.F1, &r.F2, &r.F3,
+			   &r.accumCount, &r.index_fp, &r.index_pp) == 7) {
+			records.push_back(r);
+		}
+	}
+	fclose(f);
+	return records;
+}
+
+TEST(NlosClassifier, Replay)
+{
+	std::vector<NlosRecord> records = LoadRecords();
+	int count[3] = { 0, 0, 0 };
+
+	ASSERT_FALSE(records.empty());
+	for (const NlosRecord &r : records) {
+		/* STS accumulation counts use the 17 bits quantization of E0 devices. */
+		uint8_t quantization_factor = r.accumCount <= 256 ? 17 : 21;
+		dwt_nlos_accdiag_t diag = { r.accumCount, r.F1, r.F2, r.F3, r.cir_power,
+					    r.index_fp, r.index_pp };
+		nlos_class_t cls;
+
+		ASSERT_EQ(DWT_SUCCESS, nlos_classify(&diag, quantization_factor, &cls));
+		NlosReference ref = Reference(r, quantization_factor);
+
+		/* log2_lut() is accurate to about 0.07 dB. */
+		EXPECT_NEAR(ref.fp_ratio_db, cls.metrics.fp_ratio_q8 / 256.0, 0.1);
+		EXPECT_EQ(r.index_pp - r.index_fp, (uint32_t)cls.metrics.index_spread_q6);
+		if (std::fabs(-ref.fp_ratio_db - 12.0) < 0.1 ||
+		    std::fabs(-ref.fp_ratio_db - 4.8) < 0.1) {
+			continue; /* rounding may land on either side */
+		}
+		EXPECT_NEAR(ref.prob_nlos, cls.prob_nlos, 2.0);
+		EXPECT_NEAR(ref.confidence, cls.confidence, 4.0);
+		EXPECT_EQ(cls.prob_nlos == 0 ? DWT_NLOS_RESULT_LOS :
+			  cls.prob_nlos == 100 ? DWT_NLOS_RESULT_NLOS : DWT_NLOS_RESULT_POSSIBLE,
+			  cls.result);
+		count[cls.result]++;
+	}
+	printf("replayed %zu frames: %d LOS, %d possible NLOS, %d NLOS\n", records.size(),
+	       count[DWT_NLOS_RESULT_LOS], count[DWT_NLOS_RESULT_POSSIBLE], count[DWT_NLOS_RESULT_NLOS]);
+}
+
+TEST(NlosClassifier, Confidence)
+{
+	dwt_nlos_accdiag_t diag = { 1000, 80000, 120000, 90000, 1000, 700 << 6, 700 << 6 };
+	nlos_class_t cls;
+
+	/* Strong first path and no spread, both metrics agree on LOS. */
+	diag.cir_power = 200;
+	ASSERT_EQ(DWT_SUCCESS, nlos_classify(&diag, 21, &cls));
+	EXPECT_EQ(DWT_NLOS_RESULT_LOS, cls.result);
+	EXPECT_EQ(100, cls.confidence);
+
+	/* Weak first path and long spread, both metrics agree on NLOS. */
+	diag.cir_power = 100000;
+	diag.index_pp = (700 + 8) << 6;
+	ASSERT_EQ(DWT_SUCCESS, nlos_classify(&diag, 21, &cls));
+	EXPECT_EQ(DWT_NLOS_RESULT_NLOS, cls.result);
+	EXPECT_EQ(100, cls.confidence);
+
+	/* Weak first path but no spread: NLOS, with less confidence. */
+	diag.index_pp = diag.index_fp;
+	ASSERT_EQ(DWT_SUCCESS, nlos_classify(&diag, 21, &cls));
+	EXPECT_EQ(DWT_NLOS_RESULT_NLOS, cls.result);
+	EXPECT_EQ(50, cls.confidence);
+
+	/* Metrics can't be computed without power. */
+	diag.cir_power = 0;
+	EXPECT_EQ(DWT_ERROR, nlos_classify(&diag, 21, &cls));
+	diag.cir_power = 1000;
+	diag.F1 = diag.F2 = diag.F3 = 0;
+	EXPECT_EQ(DWT_ERROR, nlos_compute_metrics(&diag, 21, &cls.metrics));
+}
@@ -0,0 +1,154 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_otpsnap.h"
+}
+
+static dwt_otp_snapshot_t Snapshot(void)
+{
+	dwt_otp_snapshot_t snap = {};
+
+	snap.mode = DWT_READ_OTP_PID | DWT_READ_OTP_TMP;
+	snap.part_id = 0x12345678;
+	snap.ldo_tune_lo = 0x88888888;
+	snap.ldo_tune_hi = 0x00000A88;
+	snap.bias_tune = 0x00110000;
+	snap.dgc_tune = 0x10000240;
+	snap.vtemp = 0x85;
+	snap.otprev = 2;
+	snap.xtrim = 0x2E;
+	snap.pll_cc = 0x1C0A;
+	otpsnap_seal(&snap);
+	return snap;
+}
+
+TEST(OtpSnap, Crc32)
+{
+	const uint8_t check[] = "123456789";
+
+	// CRC-32 check value
+	EXPECT_EQ(0xCBF43926u, otpsnap_crc32(check, 9));
+	EXPECT_EQ(0u, otpsnap_crc32(check, 0));
+}
+
+TEST(OtpSnap, SealAndCheck)
+{
+	dwt_otp_snapshot_t snap = Snapshot();
+
+	EXPECT_EQ(DWT_OTP_SNAPSHOT_VERSION, snap.version);
+	EXPECT_EQ(DWT_SUCCESS, otpsnap_check(&snap));
+
+	// Sealing again gives the same CRC
+	uint32_t crc = snap.crc;
+	otpsnap_seal(&snap);
+	EXPECT_EQ(crc, snap.crc);
+}
+
+TEST(OtpSnap, CorruptedRejected)
+{
+	dwt_otp_snapshot_t snap = Snapshot();
+	dwt_otp_snapshot_t blank = {};
+
+	// Any bit of any field
+	for (size_t i = 0; i < offsetof(dwt_otp_snapshot_t, crc) * 8; i++) {
+		dwt_otp_snapshot_t bad = snap;
+
+		((uint8_t *)&bad)[i / 8] ^= (uint8_t)(1u << (i % 8));
+		EXPECT_EQ(DWT_ERROR, otpsnap_check(&bad)) << "bit " << i;
+	}
+	snap.crc ^= 1;
+	EXPECT_EQ(DWT_ERROR, otpsnap_check(&snap));
+	// Never given
+	EXPECT_EQ(DWT_ERROR, otpsnap_check(&blank));
+}
+
+TEST(OtpSnap, OtherVersionRejected)
+{
+	dwt_otp_snapshot_t snap = Snapshot();
+
+	snap.version = DWT_OTP_SNAPSHOT_VERSION + 1;
+	snap.crc = otpsnap_crc32((const uint8_t *)&snap, offsetof(dwt_otp_snapshot_t, crc));
+	EXPECT_EQ(DWT_ERROR, otpsnap_check(&snap));
+}
+
+/* Initialisation of virtual devices with the snapshot imported, OTP reads counted */
+class OtpSnapImport : public ::testing::Test {
+protected:
+	uwbsim::Sim sim;
+
+	void TearDown() override
+	{
+		dwt_otpsnapshot_import(NULL);
+	}
+
+	/* Initialises a new device of the part, returns the OTP words read */
+	uint64_t Init(uint32_t part_id, int mode)
+	{
+		uwbsim::NodeConfig node;
+		int dev;
+
+		node.otp = { { uwbsim::kOtpPartId, part_id }, { uwbsim::kOtpVtemp, 0x85 }, { uwbsim::kOtpBiasTune, 0x00110000 } };
+		dev = sim.AddDevice(node);
+		EXPECT_EQ(DWT_SUCCESS, dwt_initialise(mode));
+		return sim.OtpReads(dev);
+	}
+};
+
+TEST_F(OtpSnapImport, SamePartSkipsOtp)
+{
+	dwt_otp_snapshot_t snap, again;
+	uint64_t reads = Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP);
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_export(&snap));
+	EXPECT_EQ(0x12345678u, snap.part_id);
+	EXPECT_EQ(0x85u, snap.vtemp);
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_import(&snap));
+	// The part ID only
+	EXPECT_EQ(1u, Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP));
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_export(&again));
+	EXPECT_EQ(0, memcmp(&snap, &again, sizeof(snap)));
+	// Fewer values asked for than in the snapshot
+	EXPECT_EQ(1u, Init(0x12345678, DWT_DW_INIT));
+	// Not imported any more
+	dwt_otpsnapshot_import(NULL);
+	EXPECT_EQ(reads, Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP));
+}
+
+TEST_F(OtpSnapImport, OtherPartReadsOtp)
+{
+	dwt_otp_snapshot_t snap;
+	uint64_t reads = Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP);
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_export(&snap));
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_import(&snap));
+	EXPECT_EQ(reads, Init(0x12345679, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP));
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_export(&snap));
+	EXPECT_EQ(0x12345679u, snap.part_id);
+	// Part ID not programmed
+	EXPECT_EQ(reads, Init(0, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP));
+}
+
+TEST_F(OtpSnapImport, MissingModeReadsOtp)
+{
+	dwt_otp_snapshot_t snap;
+	uint64_t reads = Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP);
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_export(&snap));
+	ASSERT_EQ(DWT_SUCCESS, dwt_otpsnapshot_import(&snap));
+	// The lot ID is not in the snapshot: two more words
+	EXPECT_EQ(reads + 2, Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP | DWT_READ_OTP_LID));
+	// The snapshot imported is kept, still without the lot ID
+	EXPECT_EQ(reads + 2, Init(0x12345678, DWT_DW_INIT | DWT_READ_OTP_PID | DWT_READ_OTP_TMP | DWT_READ_OTP_LID));
+}
@@ -0,0 +1,133 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_recal.h"
+}
+
+static recal_config_t Config()
+{
+	recal_config_t config = {};
+
+	config.sample_ms = 10000;
+	config.source = RECAL_TEMP_SAR;
+	config.tasks = RECAL_BIT(RECAL_PLL) | RECAL_BIT(RECAL_PGF) | RECAL_BIT(RECAL_SLEEPCNT);
+	config.hysteresis_c[RECAL_PLL] = 10;
+	config.hysteresis_c[RECAL_PGF] = 5;
+	config.hysteresis_c[RECAL_SLEEPCNT] = 3;
+	config.cost_us[RECAL_PLL] = RECAL_PLL_US;
+	config.cost_us[RECAL_PGF] = RECAL_PGF_US;
+	config.cost_us[RECAL_SLEEPCNT] = RECAL_SLEEPCNT_US;
+	return config;
+}
+
+TEST(Recal, Hysteresis)
+{
+	recal_config_t config = Config();
+	recal_t rc;
+
+	recal_init(&rc, &config, 25);
+	EXPECT_EQ(0u, recal_temperature(&rc, 0, 27));
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT), recal_temperature(&rc, 10000, 28));
+	// Due calibrations stay due when the temperature goes back
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT), recal_temperature(&rc, 20000, 25));
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT) | RECAL_BIT(RECAL_PGF), recal_temperature(&rc, 30000, 20));
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT) | RECAL_BIT(RECAL_PGF) | RECAL_BIT(RECAL_PLL), recal_temperature(&rc, 40000, 15));
+	EXPECT_EQ(15, rc.temp_c);
+}
+
+TEST(Recal, OnlyConfiguredTasks)
+{
+	recal_config_t config = Config();
+	recal_t rc;
+
+	// Nothing calibrated yet at a known temperature: all the configured calibrations are due
+	recal_init(&rc, &config, TEMP_INIT);
+	EXPECT_EQ(config.tasks, recal_temperature(&rc, 0, -20));
+
+	config.tasks = RECAL_BIT(RECAL_XTAL);
+	config.hysteresis_c[RECAL_XTAL] = 2;
+	recal_init(&rc, &config, 85);
+	EXPECT_EQ(0u, recal_temperature(&rc, 0, 84));
+	EXPECT_EQ(RECAL_BIT(RECAL_XTAL), recal_temperature(&rc, 0, 83));
+}
+
+TEST(Recal, GapTooShort)
+{
+	recal_config_t config = Config();
+	recal_t rc;
+
+	recal_init(&rc, &config, 25);
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT) | RECAL_BIT(RECAL_PGF), recal_temperature(&rc, 0xFFFFF000UL, 30));
+	// Sampled less than a period ago, across the wrap of the clock, and no calibration fits in the gap
+	EXPECT_EQ(0u, recal_idle(&rc, 0x1000UL, RECAL_PGF_US - 1));
+	EXPECT_EQ(RECAL_BIT(RECAL_SLEEPCNT) | RECAL_BIT(RECAL_PGF), rc.due);
+	EXPECT_EQ(0u, rc.runs[RECAL_PGF]);
+}
+
+TEST(Recal, SleepCount)
+{
+	// 38.4 MHz / 32.768 kHz LP OSC
+	EXPECT_EQ(8u, recal_sleepcnt(1000, 1172));
+	EXPECT_EQ(1u, recal_sleepcnt(0, 1172));
+	EXPECT_EQ(0xFFFFu, recal_sleepcnt(0xFFFFFFFFUL, 1172));
+	// LP OSC running slow when hot: fewer counts for the same time
+	EXPECT_EQ(80u, recal_sleepcnt(10000, 1172));
+	EXPECT_EQ(73u, recal_sleepcnt(10000, 1280));
+	EXPECT_EQ(0u, recal_sleepcnt(1000, 0));
+}
+
+/* recal_idle() on a configured device, across a temperature step */
+TEST(Recal, IdleOnDevice)
+{
+	uwbsim::Sim sim;
+	uwbsim::NodeConfig node;
+	dwt_config_t phy = uwbsim::DefaultConfig();
+	recal_config_t config = Config();
+	recal_t rc;
+	int dev;
+	int8_t before, after;
+
+	node.lposc_cal = 1700;
+	dev = sim.AddDevice(node);
+	ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+	ASSERT_EQ(DWT_SUCCESS, dwt_configure(&phy));
+	before = (int8_t)(dwt_convertrawtemperature_cdeg(sim.Node(dev).sar_temp) / 100);
+	// The crystal trim is not compensated on DW3000
+	config.tasks |= RECAL_BIT(RECAL_XTAL);
+	config.hysteresis_c[RECAL_XTAL] = 2;
+	config.cost_us[RECAL_XTAL] = RECAL_XTAL_US;
+	config.sleep_ms = 1000;
+	recal_init(&rc, &config, before);
+
+	// Sampled at the temperature of the configuration: nothing to run
+	EXPECT_EQ(0u, recal_idle(&rc, 0, 10000));
+	EXPECT_EQ(1u, rc.sampled);
+	EXPECT_EQ(before, rc.temp_c);
+	EXPECT_EQ(0u, rc.due);
+
+	// 20 raw steps is 21 C: all due at the next sample
+	sim.Node(dev).sar_temp += 20;
+	after = (int8_t)(dwt_convertrawtemperature_cdeg(sim.Node(dev).sar_temp) / 100);
+	EXPECT_EQ(0u, recal_idle(&rc, config.sample_ms - 1, 10000));
+	EXPECT_EQ(RECAL_BIT(RECAL_PLL) | RECAL_BIT(RECAL_PGF) | RECAL_BIT(RECAL_SLEEPCNT), recal_idle(&rc, config.sample_ms, 10000));
+	EXPECT_EQ(after, rc.temp_c);
+	EXPECT_EQ(0u, rc.due);
+	for (unsigned i = 0; i < RECAL_TASKS; i++)
+		EXPECT_EQ(after, rc.done_c[i]) << i;
+	EXPECT_EQ(0u, rc.runs[RECAL_XTAL]);
+	EXPECT_EQ(1u, rc.runs[RECAL_PLL]);
+	EXPECT_EQ(1u, rc.runs[RECAL_PGF]);
+	EXPECT_EQ(1u, rc.runs[RECAL_SLEEPCNT]);
+	// The sleep counter for the LP OSC calibrated
+	EXPECT_EQ(recal_sleepcnt(config.sleep_ms, node.lposc_cal), sim.Aon(dev)[AON_SLPCNT_LO] | (sim.Aon(dev)[AON_SLPCNT_HI] << 8));
+}
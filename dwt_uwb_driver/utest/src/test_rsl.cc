@@ -6,7 +6,11 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
 
 extern "C"
 {
@@ -205,4 +209,145 @@ TEST_P(TestLLHWRxPower, ForEachCase)
 }
 
 INSTANTIATE_TEST_CASE_P(ForEachCase, TestLLHWRxPower,
-			::testing::ValuesIn(TestLLHWRxPower::test_cases));
\ No newline at end of file
+			::testing::ValuesIn(TestLLHWRxPower::test_cases));
+/**
+ * Batch computations section
+ * The batch variants must give the same result as the scalar functions, record
+ * per record, including the invalid (-128 dBm) cases.
+ */
+struct RslBatch {
+	std::vector<int32_t> power;
+	std::vector<uint32_t> f1;
+	std::vector<uint32_t> f2;
+	std::vector<uint32_t> f3;
+	std::vector<uint16_t> accum_count;
+	std::vector<uint8_t> dgc_decision;
+	rsl_diag_batch_t batch;
+
+	explicit RslBatch(size_t count, uint32_t seed = 1)
+		: power(count), f1(count), f2(count), f3(count),
+		  accum_count(count), dgc_decision(count)
+	{
+		std::mt19937 gen(seed);
+		for (size_t i = 0; i < count; i++) {
+			power[i] = (int32_t)(gen() & 0x1FFFF);
+			f1[i] = gen() & 0x3FFFFF;
+			f2[i] = gen() & 0x3FFFFF;
+			f3[i] = gen() & 0x3FFFFF;
+			/* Mostly a fixed preamble length, with some changes. */
+			accum_count[i] = (i % 16 == 15) ? (gen() & 0xFFF) : 0x3f;
+			dgc_decision[i] = gen() % 8;
+		}
+		/* Invalid records. */
+		if (count > 2) {
+			power[0] = 0;
+			f1[0] = f2[0] = f3[0] = 0;
+			accum_count[1] = 0;
+		}
+		batch.count = count;
+		batch.power = power.data();
+		batch.F1 = f1.data();
+		batch.F2 = f2.data();
+		batch.F3 = f3.data();
+		batch.accum_count = accum_count.data();
+		batch.dgc_decision = dgc_decision.data();
+	}
+};
+
+class RslBatchTest
+	: public ::testing::TestWithParam<std::tuple<uint8_t, bool> > {
+};
+
+TEST_P(RslBatchTest, SignalPowerMatchesScalar)
+{
+	uint8_t rx_pcode = std::get<0>(GetParam());
+	bool is_sts = std::get<1>(GetParam());
+	RslBatch b(1024);
+	std::vector<int16_t> rsl(b.batch.count);
+
+	ASSERT_EQ(rsl_calculate_signal_power_batch(&b.batch, 21, rx_pcode,
+						   is_sts, rsl.data()),
+		  DWT_SUCCESS);
+	for (size_t i = 0; i < b.batch.count; i++) {
+		ASSERT_EQ(rsl[i], rsl_calculate_signal_power(
+					  b.power[i], 21, b.accum_count[i],
+					  b.dgc_decision[i], rx_pcode, is_sts))
+			<< "record " << i;
+	}
+}
+
+TEST_P(RslBatchTest, FirstPathPowerMatchesScalar)
+{
+	uint8_t rx_pcode = std::get<0>(GetParam());
+	bool is_sts = std::get<1>(GetParam());
+	RslBatch b(1024);
+	std::vector<int16_t> fsl(b.batch.count);
+
+	ASSERT_EQ(rsl_calculate_first_path_power_batch(&b.batch, rx_pcode,
+						       is_sts, fsl.data()),
+		  DWT_SUCCESS);
+	for (size_t i = 0; i < b.batch.count; i++) {
+		ASSERT_EQ(fsl[i], rsl_calculate_first_path_power(
+					  b.f1[i], b.f2[i], b.f3[i],
+					  b.accum_count[i], b.dgc_decision[i],
+					  rx_pcode, is_sts))
+			<< "record " << i;
+	}
+}
+
+INSTANTIATE_TEST_CASE_P(ForEachPrf, RslBatchTest,
+			::testing::Values(std::make_tuple(8, false),
+					  std::make_tuple(9, false),
+					  std::make_tuple(10, true)));
+
+TEST(RslBatch, MissingArrays)
+{
+	RslBatch b(4);
+	int16_t out[4];
+
+	b.batch.power = NULL;
+	EXPECT_EQ(rsl_calculate_signal_power_batch(&b.batch, 21, 9, false, out),
+		  DWT_ERROR);
+	EXPECT_EQ(rsl_calculate_first_path_power_batch(&b.batch, 9, false, out),
+		  DWT_SUCCESS);
+	b.batch.F2 = NULL;
+	EXPECT_EQ(rsl_calculate_first_path_power_batch(&b.batch, 9, false, out),
+		  DWT_ERROR);
+	EXPECT_EQ(rsl_calculate_signal_power_batch(NULL, 21, 9, false, out),
+		  DWT_ERROR);
+}
+
+/* Throughput of the batch path against the scalar path, informative only. */
+TEST(RslBatch, Benchmark)
+{
+	const size_t count = 1 << 16;
+	const int rounds = 16;
+	RslBatch b(count);
+	std::vector<int16_t> out(count);
+	volatile int16_t sink = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < count; i++)
+			out[i] = rsl_calculate_first_path_power(
+				b.f1[i], b.f2[i], b.f3[i], b.accum_count[i],
+				b.dgc_decision[i], 9, false);
+		sink = sink + out[count - 1];
+	}
+	auto scalar = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++) {
+		rsl_calculate_first_path_power_batch(&b.batch, 9, false,
+						     out.data());
+		sink = sink + out[count - 1];
+	}
+	auto batch = std::chrono::steady_clock::now() - start;
+
+	double scalar_ns = std::chrono::duration<double, std::nano>(scalar).count();
+	double batch_ns = std::chrono::duration<double, std::nano>(batch).count();
+	printf("first path power: scalar %.1f ns/record, batch %.1f ns/record (x%.2f)\n",
+	       scalar_ns / (count * rounds), batch_ns / (count * rounds),
+	       scalar_ns / batch_ns);
+	(void)sink;
+}
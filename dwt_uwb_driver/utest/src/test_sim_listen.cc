@@ -0,0 +1,131 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+using uwbsim::Sim;
+
+static const uint32_t kIntLo = DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | DWT_INT_RXFTO_BIT_MASK;
+static const uint32_t kIntHi = DWT_INT_HI_CCA_FAIL_BIT_MASK;
+static const uint16_t kListenWake = DWT_CONFIG | DWT_GOTORX | DWT_PGFCAL;
+static const uint16_t kLoads = DWT_LOADLDO | DWT_LOADBIAS | DWT_LOADDGC;
+
+/* Duty-cycled listening on an initialised and configured device, with the OTP given */
+class SimListen : public ::testing::Test {
+protected:
+	Sim sim;
+	int dev = 0;
+	dwt_listen_config_t listen = {};
+
+	void Init(const std::map<uint16_t, uint32_t> &otp)
+	{
+		uwbsim::NodeConfig node;
+		dwt_config_t config = uwbsim::DefaultConfig();
+
+		node.otp = otp;
+		dev = sim.AddDevice(node);
+		ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+		ASSERT_EQ(DWT_SUCCESS, dwt_configure(&config));
+		dwt_setinterrupt(kIntLo, kIntHi, DWT_ENABLE_INT_ONLY);
+
+		listen.period_ms = 1000;
+		listen.window_pac = 16;
+		listen.sniff_on = 2;
+		listen.sniff_off = 16;
+		listen.recal_temp = 5;
+	}
+
+	uint16_t WakeConfig()
+	{
+		return (uint16_t)sim.Peek(dev, AON_DIG_CFG_ID, 2);
+	}
+
+	void ExpectListening()
+	{
+		EXPECT_EQ((uint32_t)DWT_INT_RXFCG_BIT_MASK, sim.Peek(dev, SYS_ENABLE_LO_ID, 4));
+		EXPECT_EQ(0U, sim.Peek(dev, SYS_ENABLE_HI_ID, 4));
+		EXPECT_EQ(kListenWake, WakeConfig() & kListenWake);
+		EXPECT_NE(0U, sim.Peek(dev, ANA_CFG_ID, 1) & DWT_SLP_CNT_RPT);
+		EXPECT_NE(0U, sim.Peek(dev, SEQ_CTRL_ID, 2) & SEQ_CTRL_ARX2SLP_BIT_MASK);
+		EXPECT_EQ((16U << 8) | 2U, sim.Peek(dev, RX_SNIFF_ID, 2));
+	}
+
+	void ExpectStopped()
+	{
+		EXPECT_EQ(kIntLo, sim.Peek(dev, SYS_ENABLE_LO_ID, 4));
+		EXPECT_EQ(kIntHi, sim.Peek(dev, SYS_ENABLE_HI_ID, 4));
+		EXPECT_EQ(0U, WakeConfig());
+		EXPECT_EQ(0U, sim.Peek(dev, ANA_CFG_ID, 1));
+		EXPECT_EQ(0U, sim.Peek(dev, SEQ_CTRL_ID, 2) & SEQ_CTRL_ARX2SLP_BIT_MASK);
+		EXPECT_EQ(0U, sim.Peek(dev, RX_SNIFF_ID, 2));
+
+		// The next on-wake configuration has none of the listening
+		dwt_configuresleep(DWT_CONFIG, DWT_PRES_SLEEP | DWT_WAKE_CSN | DWT_SLP_EN);
+		EXPECT_EQ(0U, WakeConfig() & (DWT_GOTORX | DWT_PGFCAL | kLoads));
+		EXPECT_NE(0U, WakeConfig() & DWT_CONFIG);
+	}
+};
+
+TEST_F(SimListen, StartStop)
+{
+	Init({ { uwbsim::kOtpLdoTuneLo, 0x00071234 },
+	       { uwbsim::kOtpLdoTuneHi, 0x00005555 },
+	       { uwbsim::kOtpBiasTune, 0x00110000 },
+	       { uwbsim::kOtpDgcTune, DWT_DGC_CFG0 } });
+	ASSERT_EQ(DWT_SUCCESS, dwt_listen_start(&listen));
+	ExpectListening();
+	// No host restore on wake: the device does the kicks from OTP
+	EXPECT_EQ(kLoads, WakeConfig() & kLoads);
+	dwt_listen_stop();
+	ExpectStopped();
+}
+
+TEST_F(SimListen, NotProgrammed)
+{
+	// Nothing in OTP to load on wake
+	Init({});
+	ASSERT_EQ(DWT_SUCCESS, dwt_listen_start(&listen));
+	ExpectListening();
+	EXPECT_EQ(0U, WakeConfig() & kLoads);
+	dwt_listen_stop();
+	ExpectStopped();
+}
+
+TEST_F(SimListen, StartAgain)
+{
+	// Listening again after a frame keeps the interrupts enabled before the first start
+	Init({ { uwbsim::kOtpBiasTune, 0x00110000 } });
+	ASSERT_EQ(DWT_SUCCESS, dwt_listen_start(&listen));
+	ASSERT_EQ(DWT_SUCCESS, dwt_listen_start(&listen));
+	ExpectListening();
+	dwt_listen_stop();
+	ExpectStopped();
+}
+
+TEST_F(SimListen, SleepCountNotCalibrated)
+{
+	uwbsim::NodeConfig node;
+
+	node.lposc_cal = 0;
+	dev = sim.AddDevice(node);
+	ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+	dwt_setinterrupt(kIntLo, kIntHi, DWT_ENABLE_INT_ONLY);
+	listen.period_ms = 1000;
+	EXPECT_EQ(DWT_ERROR, dwt_listen_start(&listen));
+	EXPECT_EQ(kIntLo, sim.Peek(dev, SYS_ENABLE_LO_ID, 4));
+	EXPECT_EQ(0U, WakeConfig());
+}
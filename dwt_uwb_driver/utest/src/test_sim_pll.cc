@@ -0,0 +1,133 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+using uwbsim::Sim;
+
+/* Platform of the driver, utest has it in test_tx_power.cc */
+void deca_usleep(unsigned long time_us)
+{
+	(void)time_us;
+}
+
+void deca_sleep(unsigned int time_ms)
+{
+	(void)time_ms;
+}
+
+decaIrqStatus_t decamutexon(void)
+{
+	return 0;
+}
+
+void decamutexoff(decaIrqStatus_t s)
+{
+	(void)s;
+}
+
+/*
+ * PLL calibration cache of the automotive driver (AUTO_PLL_CAL): dwt_configure() starts the PLL calibration of a
+ * channel from the coarse code locked last time in the temperature band, and falls back to the full search from the OTP
+ * code when it does not lock within PLL_CACHE_STEPS. Nothing is programmed in OTP: the search starts from code 0.
+ */
+class SimPll : public ::testing::Test {
+protected:
+	Sim sim;
+	int dev = 0;
+
+	void Init(uint32_t ch5_coarse)
+	{
+		uwbsim::NodeConfig node;
+
+		node.pll_ch5_coarse = ch5_coarse;
+		dev = sim.AddDevice(node);
+		ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+	}
+
+	/* Configures a channel, returns the SPI transactions it took */
+	uint64_t Configure(uint8_t chan)
+	{
+		dwt_config_t config = uwbsim::DefaultConfig(chan);
+		uint64_t xfers;
+
+		xfers = sim.SpiTransactions();
+		EXPECT_EQ(DWT_SUCCESS, dwt_configure(&config));
+		return sim.SpiTransactions() - xfers;
+	}
+
+	/* Channel 5 after channel 9, the PLL calibrated on each */
+	uint64_t Channel5()
+	{
+		Configure(9);
+		return Configure(5);
+	}
+
+	uint32_t Ch5Coarse()
+	{
+		return (sim.Peek(dev, PLL_COARSE_CODE_ID, 4) & PLL_COARSE_CODE_CH5_VCO_COARSE_TUNE_BIT_MASK) >> PLL_COARSE_CODE_CH5_VCO_COARSE_TUNE_BIT_OFFSET;
+	}
+};
+
+TEST_F(SimPll, Hit)
+{
+	uint64_t miss, hit;
+
+	Init(0xFF);
+	miss = Channel5();
+	EXPECT_EQ(0xFFU, Ch5Coarse());
+	EXPECT_EQ(0x10U, sim.Peek(dev, PLL_COARSE_CODE_ID, 4) & (PLL_COARSE_CODE_CH9_RVCO_FREQ_BOOST_BIT_MASK | PLL_COARSE_CODE_CH9_VCO_COARSE_TUNE_BIT_MASK));
+	hit = Channel5();
+	EXPECT_EQ(0xFFU, Ch5Coarse());
+	EXPECT_LT(hit, miss);
+	EXPECT_EQ(hit, Channel5());
+}
+
+TEST_F(SimPll, MissThenFill)
+{
+	uint64_t miss, hit;
+
+	Init(0xFF);
+	miss = Channel5();
+	hit = Channel5();
+	// 48 raw steps is 50 C: another temperature band, with nothing cached
+	sim.Node(dev).sar_temp += 48;
+	EXPECT_EQ(miss, Channel5());
+	EXPECT_EQ(0xFFU, Ch5Coarse());
+	EXPECT_EQ(hit, Channel5());
+	// Back in the first band, still cached
+	sim.Node(dev).sar_temp -= 48;
+	EXPECT_EQ(hit, Channel5());
+}
+
+TEST_F(SimPll, Fallback)
+{
+	uint64_t cold, fallback, hit;
+
+	Init(0xFFF);
+	cold = Channel5();
+
+	Init(0xFF);
+	hit = Channel5();
+	hit = Channel5();
+	// The VCO drifts beyond PLL_CACHE_STEPS of the cached code: the full search from OTP locks it again
+	sim.Node(dev).pll_ch5_coarse = 0xFFF;
+	fallback = Channel5();
+	EXPECT_EQ(0xFFFU, Ch5Coarse());
+	EXPECT_GT(fallback, cold);
+	// The cache holds the new code
+	EXPECT_EQ(hit, Channel5());
+	EXPECT_EQ(0xFFFU, Ch5Coarse());
+}
@@ -0,0 +1,206 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+using uwbsim::Sim;
+
+/*
+ * dwt_reconfigure() from a configuration A to B against dwt_configure() of B, on devices configured with A: the
+ * register images must be the same. dwt_initialise() gives the driver its single static local data: the devices are
+ * initialised and used one after the other.
+ */
+class SimReconfigure : public ::testing::Test {
+protected:
+	Sim sim;
+	std::map<uint16_t, uint32_t> otp = { { uwbsim::kOtpLdoTuneLo, 0x00071234 },
+					     { uwbsim::kOtpLdoTuneHi, 0x00005555 },
+					     { uwbsim::kOtpBiasTune, 0x00110000 } };
+
+	std::vector<uint8_t> Image(dwt_config_t *a, dwt_config_t *b, bool reconfigure)
+	{
+		uwbsim::NodeConfig node;
+		std::vector<uint8_t> image;
+		int dev;
+
+		node.otp = otp;
+		dev = sim.AddDevice(node);
+		EXPECT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+		EXPECT_EQ(DWT_SUCCESS, dwt_configure(a));
+		if (reconfigure)
+			EXPECT_EQ(DWT_SUCCESS, dwt_reconfigure(b));
+		else
+			EXPECT_EQ(DWT_SUCCESS, dwt_configure(b));
+		image = sim.Save(dev);
+		// The system time is read at different times
+		for (unsigned i = 0; i < 4; i++)
+			image[SYS_TIME_ID + i] = 0;
+		return image;
+	}
+
+	void Compare(dwt_config_t a, dwt_config_t b)
+	{
+		std::vector<uint8_t> reconfigured = Image(&a, &b, true);
+		std::vector<uint8_t> configured = Image(&a, &b, false);
+		unsigned diffs = 0;
+
+		for (size_t i = 0; (i < reconfigured.size()) && (diffs < 8); i++) {
+			if (reconfigured[i] != configured[i]) {
+				ADD_FAILURE() << "register file 0x" << std::hex << (i / 0x800) << " offset 0x" << (i % 0x800) << ": 0x"
+					      << (int)reconfigured[i] << " reconfigured, 0x" << (int)configured[i] << " configured";
+				diffs++;
+			}
+		}
+	}
+};
+
+TEST_F(SimReconfigure, Prf)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.txCode = 3;
+	b.rxCode = 3;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, PrfDgcFromOtp)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	otp[uwbsim::kOtpDgcTune] = DWT_DGC_CFG0;
+	b.txCode = 3;
+	b.rxCode = 3;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, Phr)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.phrMode = DWT_PHRMODE_EXT;
+	b.phrRate = DWT_PHRRATE_DTA;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, Sts)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.stsMode = DWT_STS_MODE_1;
+	b.stsLength = DWT_STS_LEN_128;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, SfdTimeout)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.sfdTO = 257;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, PreambleLength)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	// Across 256 symbols: the OPS table
+	b.txPreambLength = DWT_PLEN_1024;
+	Compare(a, b);
+	Compare(b, a);
+	// Across 64 symbols: the SFD holdoff
+	b.txPreambLength = DWT_PLEN_64;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, Preamble4096)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	// TXPSR with the fine length cleared
+	b.txPreambLength = DWT_PLEN_4096;
+	b.rxPAC = DWT_PAC32;
+	Compare(a, b);
+	Compare(b, a);
+	a.txPreambLength = DWT_PLEN_1024;
+	a.rxPAC = DWT_PAC32;
+	Compare(a, b);
+	Compare(b, a);
+	a.txPreambLength = DWT_PLEN_64;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, Pac)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.rxPAC = DWT_PAC16;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, DataRate)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.dataRate = DWT_BR_850K;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, SfdType)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.sfdType = DWT_SFD_IEEE_4Z;
+	Compare(a, b);
+	Compare(b, a);
+}
+
+TEST_F(SimReconfigure, Pdoa)
+{
+	dwt_config_t a = uwbsim::DefaultConfig();
+	dwt_config_t b = uwbsim::DefaultConfig();
+
+	b.pdoaMode = DWT_PDOA_M3;
+	Compare(a, b);
+	Compare(b, a);
+	// With STS: the CIA lower bound of the STS depends on the mode
+	a.stsMode = DWT_STS_MODE_1;
+	a.stsLength = DWT_STS_LEN_128;
+	b.stsMode = DWT_STS_MODE_1;
+	b.stsLength = DWT_STS_LEN_128;
+	Compare(a, b);
+	Compare(b, a);
+}
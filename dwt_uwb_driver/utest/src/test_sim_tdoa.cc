@@ -0,0 +1,189 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_tdoa.h"
+#include "dw3000_deca_regs.h"
+}
+
+using uwbsim::Sim;
+
+static const int kTag = 0;
+static const int kAnchor = 1;
+static const uint64_t kTagId = 0x0123456789ABCDEFULL;
+static const double kBlinkPeriod = 1e-3;
+static const double kDistance = 30.0;
+
+/* A tag blinking periodically, received by an anchor running the capture pipeline */
+class SimTdoa : public ::testing::Test {
+protected:
+	static Sim *sim;
+	static tdoa_capture_t cap;
+	static std::vector<tdoa_blink_t> blinks;
+	static std::vector<uint64_t> tx_times;
+	static double t0;
+
+	void SetUp() override
+	{
+		uwbsim::NodeConfig tag;
+		uwbsim::NodeConfig anchor;
+		tdoa_config_t config = {};
+		dwt_callbacks_s cbs = {};
+
+		blinks.clear();
+		tx_times.clear();
+		sim = new Sim();
+		anchor.x = kDistance;
+		anchor.counter0 = 0x1234567890ULL;
+		ASSERT_EQ(kTag, sim->AddDevice(tag));
+		ASSERT_EQ(kAnchor, sim->AddDevice(anchor));
+
+		// Programmed antenna delays equal to the true ones: RX time stamps are TX ones plus the time of flight
+		sim->Select(kTag);
+		dwt_settxantennadelay(16385);
+		cbs.cbTxDone = TxDoneCb;
+		dwt_setcallbacks(&cbs);
+		dwt_setinterrupt(DWT_INT_TXFRS_BIT_MASK, 0, DWT_ENABLE_INT_ONLY);
+
+		sim->Select(kAnchor);
+		dwt_setrxantennadelay(16385);
+		cbs = {};
+		cbs.cbRxOk = RxOkCb;
+		cbs.cbRxTo = RxErrCb;
+		cbs.cbRxErr = RxErrCb;
+		dwt_setcallbacks(&cbs);
+		dwt_setinterrupt(DWT_INT_RXFCG_BIT_MASK | DWT_INT_RXFTO_BIT_MASK | DWT_INT_RXPTO_BIT_MASK | DWT_INT_RXPHE_BIT_MASK |
+					 DWT_INT_RXFCE_BIT_MASK | DWT_INT_RXFSL_BIT_MASK | DWT_INT_RXSTO_BIT_MASK,
+				 0, DWT_ENABLE_INT_ONLY);
+		config.batch_cb = BatchCb;
+		tdoa_init(&cap, &config);
+		ASSERT_EQ(DWT_SUCCESS, tdoa_start(&cap));
+		// Times of the test from here on, the set up took simulated SPI time
+		t0 = sim->Now();
+	}
+
+	void TearDown() override
+	{
+		delete sim;
+		sim = nullptr;
+	}
+
+	static void TxDoneCb(const dwt_cb_data_t *cb_data)
+	{
+		uint8_t ts[5];
+
+		(void)cb_data;
+		dwt_readtxtimestamp(ts);
+		tx_times.push_back(ts40_load(ts));
+	}
+
+	static void RxOkCb(const dwt_cb_data_t *cb_data)
+	{
+		tdoa_rx_ok_handler(&cap, cb_data);
+	}
+
+	static void RxErrCb(const dwt_cb_data_t *cb_data)
+	{
+		tdoa_rx_error_handler(&cap, cb_data);
+	}
+
+	static void BatchCb(tdoa_batch_t *batch)
+	{
+		blinks.insert(blinks.end(), batch->blink, batch->blink + batch->count);
+		tdoa_release(&cap, batch);
+	}
+
+	/* Blink sent at t */
+	static void Blink(double t, uint8_t seq)
+	{
+		sim->At(t0 + t, kTag, [seq]() {
+			uint8_t frame[TDOA_BLINK_HDR_LEN] = { TDOA_BLINK_FC, seq };
+
+			for (unsigned i = 0; i < 8; i++)
+				frame[TDOA_BLINK_ID_IDX + i] = (uint8_t)(kTagId >> (8 * i));
+			EXPECT_EQ(DWT_SUCCESS, dwt_writetxdata(sizeof(frame), frame, 0));
+			dwt_writetxfctrl(sizeof(frame) + FCS_LEN, 0, 0);
+			EXPECT_EQ(DWT_SUCCESS, dwt_starttx(DWT_START_TX_IMMEDIATE));
+		});
+	}
+
+	/* Raise RX events on the anchor, as the device would set them */
+	static void Event(double t, uint32_t status)
+	{
+		sim->At(t0 + t, kAnchor, [status]() {
+			sim->Poke(kAnchor, SYS_STATUS_ID, sim->Peek(kAnchor, SYS_STATUS_ID, 4) | status, 4);
+		});
+	}
+
+	static void Flush()
+	{
+		sim->Select(kAnchor);
+		tdoa_flush(&cap);
+	}
+};
+
+Sim *SimTdoa::sim;
+tdoa_capture_t SimTdoa::cap;
+std::vector<tdoa_blink_t> SimTdoa::blinks;
+std::vector<uint64_t> SimTdoa::tx_times;
+double SimTdoa::t0;
+
+TEST_F(SimTdoa, BlinkTimestamps)
+{
+	const unsigned n = 2 * TDOA_BATCH_LEN + 5;
+	const double tof_dtu = sim->Tof(kTag, kAnchor) * TS40_DTU_PER_S;
+
+	for (unsigned i = 0; i < n; i++)
+		Blink(i * kBlinkPeriod, (uint8_t)i);
+	sim->Run(t0 + n * kBlinkPeriod);
+	// Two full batches given to the transport, the rest on flush
+	EXPECT_EQ(2 * TDOA_BATCH_LEN, blinks.size());
+	Flush();
+	ASSERT_EQ(n, blinks.size());
+	ASSERT_EQ(n, tx_times.size());
+	for (unsigned i = 0; i < n; i++) {
+		// Counters of the tag and anchor differ by counter0 of the anchor
+		int64_t err = ts40_diff(blinks[i].rx_ipatov, ts40_add(tx_times[i], 0x1234567890ULL)) - (int64_t)(tof_dtu + 0.5);
+
+		EXPECT_EQ(kTagId, blinks[i].tag_id) << i;
+		EXPECT_EQ((uint8_t)i, blinks[i].seq) << i;
+		EXPECT_EQ(0U, blinks[i].rx_sts) << i;
+		EXPECT_EQ(TDOA_FP_UNKNOWN, blinks[i].fp_ratio_q8) << i;
+		EXPECT_LE(std::abs(err), 1) << i;
+	}
+}
+
+TEST_F(SimTdoa, FrameErrorKeepsReceiving)
+{
+	// A frame error reported while the receiver, re-enabled automatically, acquires the next blink
+	Blink(0.0, 0);
+	Event(150e-6, DWT_INT_RXPHE_BIT_MASK);
+	sim->Run(t0 + kBlinkPeriod);
+	Flush();
+	ASSERT_EQ(1U, blinks.size());
+	EXPECT_EQ(0, blinks[0].seq);
+}
+
+TEST_F(SimTdoa, TimeoutReenables)
+{
+	// A preamble timeout leaves the receiver off
+	sim->At(t0, kAnchor, []() { dwt_forcetrxoff(); });
+	Event(10e-6, DWT_INT_RXPTO_BIT_MASK);
+	Blink(100e-6, 0);
+	sim->Run(t0 + kBlinkPeriod);
+	Flush();
+	ASSERT_EQ(1U, blinks.size());
+	EXPECT_EQ(0, blinks[0].seq);
+}
@@ -0,0 +1,641 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_twr.h"
+#include "deca_antcal.h"
+#include "deca_airtime.h"
+#include "dw3000_deca_regs.h"
+}
+
+using uwbsim::Sim;
+
+#define UUS_TO_DTU(x) ((uint32_t)(x) * 65536UL)
+
+static const uint16_t kPan = 0xDECA;
+static const int kInitiator = 0;
+static const int kResponder = 1;
+
+/* Ranging exchanges run back to back between two virtual devices */
+class SimTwr : public ::testing::Test {
+protected:
+	static Sim *sim;
+	static twr_engine_t engine[2];
+	static std::vector<twr_result_t> results;
+	static std::vector<double> result_times;
+	static bool single_sided;
+	static int started;
+	static int resp_tx_antd_err;
+	static int resp_rx_antd_err;
+	static uint32_t reply_dly_dtu;
+	static uint32_t rx_dly_uus;
+	static uint32_t rx_timeout_uus;
+
+	void SetUp() override
+	{
+		results.clear();
+		result_times.clear();
+		started = 0;
+		resp_tx_antd_err = 0;
+		resp_rx_antd_err = 0;
+		// 128 symbols preamble at 6.8 Mb/s: the preamble and SFD take 140 us, the frames up to 60 us more
+		reply_dly_dtu = UUS_TO_DTU(500);
+		rx_dly_uus = 250;
+		rx_timeout_uus = 400;
+	}
+
+	void TearDown() override
+	{
+		delete sim;
+		sim = nullptr;
+	}
+
+	/* Start the next exchange once the current one is over */
+	static void Next()
+	{
+		sim->At(sim->Now(), kInitiator, []() {
+			int32_t ret = single_sided ? twr_initiate_ss(&engine[kInitiator], kResponder + 1) :
+						     twr_initiate(&engine[kInitiator], kResponder + 1);
+			EXPECT_EQ(DWT_SUCCESS, ret);
+			started++;
+		});
+	}
+
+	static bool Waiting(const twr_engine_t *e)
+	{
+		for (uint32_t i = 0; i < TWR_SESSION_MAX; i++) {
+			if (e->sessions[i].state != TWR_STATE_IDLE)
+				return true;
+		}
+		return false;
+	}
+
+	static void TxDoneCb(const dwt_cb_data_t *cb_data)
+	{
+		(void)cb_data;
+		// The DS-TWR initiator is done once its final is sent
+		if ((sim->Current() == kInitiator) && !single_sided && !Waiting(&engine[kInitiator]))
+			Next();
+	}
+
+	static void RxOkCb(const dwt_cb_data_t *cb_data)
+	{
+		twr_rx_ok_handler(&engine[sim->Current()], cb_data);
+	}
+
+	static void RxErrCb(const dwt_cb_data_t *cb_data)
+	{
+		twr_rx_error_handler(&engine[sim->Current()], cb_data);
+		if (sim->Current() == kInitiator)
+			Next();
+	}
+
+	static void ResultCb(const twr_result_t *result)
+	{
+		results.push_back(*result);
+		result_times.push_back(sim->Now());
+		if (single_sided)
+			Next();
+	}
+
+	/* Configure a device: programmed antenna delays, callbacks, interrupts and engine */
+	static void InitDevice(int dev, uint16_t tx_antd, uint16_t rx_antd, twr_clkofs_e clkofs)
+	{
+		dwt_callbacks_s cbs = {};
+		twr_config_t config = {};
+
+		sim->Select(dev);
+		dwt_settxantennadelay(tx_antd);
+		dwt_setrxantennadelay(rx_antd);
+		cbs.cbTxDone = TxDoneCb;
+		cbs.cbRxOk = RxOkCb;
+		cbs.cbRxTo = RxErrCb;
+		cbs.cbRxErr = RxErrCb;
+		dwt_setcallbacks(&cbs);
+		dwt_setinterrupt(DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | DWT_INT_RXFTO_BIT_MASK | DWT_INT_RXPTO_BIT_MASK |
+					 DWT_INT_RXPHE_BIT_MASK | DWT_INT_RXFCE_BIT_MASK | DWT_INT_RXFSL_BIT_MASK | DWT_INT_RXSTO_BIT_MASK,
+				 0, DWT_ENABLE_INT_ONLY);
+
+		config.pan_id = kPan;
+		config.address = (uint16_t)(dev + 1);
+		config.poll_rx_to_resp_tx_dly = reply_dly_dtu;
+		config.resp_rx_to_final_tx_dly = reply_dly_dtu;
+		config.poll_tx_to_resp_rx_dly_uus = rx_dly_uus;
+		config.resp_tx_to_final_rx_dly_uus = rx_dly_uus;
+		config.rx_timeout_uus = rx_timeout_uus;
+		config.tx_antenna_delay = tx_antd;
+		config.result_cb = ResultCb;
+		config.ss_clock_offset = clkofs;
+		twr_init(&engine[dev], &config);
+	}
+
+	/*
+	 * Range for a given time, devices at a distance, with their crystal offsets and
+	 * antenna delays, programmed antenna delays off from the true ones by antd_err, plus
+ * resp_tx_antd_err and resp_rx_antd_err on the responder.
+	 */
+	static void RunRanging(double duration, double distance, double ppm_init, double ppm_resp, int antd_err,
+			       const uwbsim::Channel &channel = uwbsim::Channel(), twr_clkofs_e clkofs = TWR_CLKOFS_CIA)
+	{
+		uwbsim::NodeConfig init;
+		uwbsim::NodeConfig resp;
+
+		delete sim;
+		sim = new Sim(uwbsim::Phy(), uwbsim::Timing(), channel);
+		init.ppm = ppm_init;
+		init.tx_antenna_dtu = 16410;
+		init.rx_antenna_dtu = 16360;
+		init.counter0 = 0xFF00000000ULL; // Wraps after 70 ms
+		resp.ppm = ppm_resp;
+		resp.tx_antenna_dtu = 16395;
+		resp.rx_antenna_dtu = 16375;
+		resp.x = distance;
+		resp.counter0 = 0x1234567890ULL;
+		ASSERT_EQ(kInitiator, sim->AddDevice(init));
+		ASSERT_EQ(kResponder, sim->AddDevice(resp));
+
+		InitDevice(kInitiator, (uint16_t)(16410 + antd_err), (uint16_t)(16360 + antd_err), clkofs);
+		InitDevice(kResponder, (uint16_t)(16395 + antd_err + resp_tx_antd_err), (uint16_t)(16375 + antd_err + resp_rx_antd_err),
+			   clkofs);
+		sim->Select(kResponder);
+		ASSERT_EQ(DWT_SUCCESS, twr_listen(&engine[kResponder]));
+		Next();
+		sim->Run(duration);
+	}
+
+	/* Report throughput and accuracy, errors in mm w.r.t. the true distance */
+	static void Report(const char *name, double duration, double distance, double *mean, double *max_abs)
+	{
+		double sum = 0.0;
+
+		*max_abs = 0.0;
+		for (const twr_result_t &r : results) {
+			double err = r.distance_mm - distance * 1000.0;
+
+			sum += err;
+			*max_abs = std::max(*max_abs, std::fabs(err));
+		}
+		*mean = results.empty() ? 0.0 : sum / (double)results.size();
+		printf("[ %-8s ] %zu ranges in %.1f s of air time: %.0f ranges/s, error mean %.1f mm max %.1f mm, %llu frames, %llu SPI transactions\n",
+		       name, results.size(), duration, results.size() / duration, *mean, *max_abs,
+		       (unsigned long long)sim->FramesSent(), (unsigned long long)sim->SpiTransactions());
+		RecordProperty("ranges_per_s", (int)(results.size() / duration));
+		RecordProperty("mean_error_um", (int)(*mean * 1000.0));
+		RecordProperty("max_error_um", (int)(*max_abs * 1000.0));
+	}
+};
+
+Sim *SimTwr::sim;
+twr_engine_t SimTwr::engine[2];
+std::vector<twr_result_t> SimTwr::results;
+std::vector<double> SimTwr::result_times;
+bool SimTwr::single_sided;
+int SimTwr::started;
+int SimTwr::resp_tx_antd_err;
+int SimTwr::resp_rx_antd_err;
+uint32_t SimTwr::reply_dly_dtu;
+uint32_t SimTwr::rx_dly_uus;
+uint32_t SimTwr::rx_timeout_uus;
+
+TEST_F(SimTwr, DoubleSided)
+{
+	double mean, max_abs;
+
+	single_sided = false;
+	RunRanging(0.5, 12.5, 18.0, -12.0, 0);
+	Report("DS-TWR", 0.5, 12.5, &mean, &max_abs);
+
+	// Exchanges take 1.2 ms, none is lost, across the initiator counter wrap
+	EXPECT_GE(results.size(), 370u);
+	EXPECT_GE(results.size() + 1, (size_t)started);
+	// Crystal offsets cancel, only time stamp rounding is left (one DTU is 4.7 mm)
+	EXPECT_LT(std::fabs(mean), 5.0);
+	EXPECT_LT(max_abs, 10.0);
+	for (const twr_result_t &r : results)
+		EXPECT_EQ(1, r.peer);
+}
+
+TEST_F(SimTwr, SingleSidedClockOffset)
+{
+	double mean, max_abs;
+
+	// 40 ppm between the devices over a 500 us reply would be 3 m of error without correction
+	single_sided = true;
+	RunRanging(0.5, 3.0, 20.0, -20.0, 0);
+	Report("SS-TWR", 0.5, 3.0, &mean, &max_abs);
+
+	EXPECT_GE(results.size(), 500u);
+	EXPECT_LT(std::fabs(mean), 10.0);
+	EXPECT_LT(max_abs, 20.0);
+}
+
+TEST_F(SimTwr, SingleSidedCarrierIntegrator)
+{
+	double mean, max_abs;
+
+	single_sided = true;
+	RunRanging(0.2, 3.0, -15.0, 25.0, 0, uwbsim::Channel(), TWR_CLKOFS_CARRIER_CH5);
+	Report("SS-TWR", 0.2, 3.0, &mean, &max_abs);
+
+	EXPECT_GE(results.size(), 200u);
+	EXPECT_LT(std::fabs(mean), 10.0);
+	EXPECT_LT(max_abs, 20.0);
+}
+
+TEST_F(SimTwr, AntennaDelayError)
+{
+	double mean, max_abs;
+
+	// Programmed delays 40 DTU too large on both sides of both devices: each time of flight is
+	// measured (40 + 40) DTU short on either device, the range is 80 DTU short
+	single_sided = false;
+	RunRanging(0.1, 8.0, 5.0, -5.0, 40);
+	Report("DS-TWR", 0.1, 8.0, &mean, &max_abs);
+
+	ASSERT_GE(results.size(), 50u);
+	EXPECT_NEAR(twr_tof_to_mm(-80), mean, 5.0);
+}
+
+TEST_F(SimTwr, TightReplyDelays)
+{
+	dwt_config_t config = {};
+	dwt_airtime_t at;
+	double mean, max_abs;
+
+	// Simulated PHY: channel 5, 64 MHz PRF, 128 symbols preamble, 8 symbols SFD, 6.8 Mb/s
+	config.txPreambLength = DWT_PLEN_128;
+	config.txCode = 9;
+	config.sfdType = DWT_SFD_IEEE_4Z;
+	config.dataRate = DWT_BR_6M8;
+	config.phrRate = DWT_PHRRATE_STD;
+	config.stsMode = DWT_STS_MODE_OFF;
+	airtime_calc(&config, &at);
+
+	// The host takes about 65 us from the end of a frame to the delayed TX started, allow 80 us. Delays
+	// are the same for the response and the final, taken for the longest frame of the exchange.
+	reply_dly_dtu = airtime_reply_dly_dtu(&at, TWR_FINAL_LEN, 80000);
+	rx_dly_uus = airtime_rx_after_tx_uus(&at, TWR_FINAL_LEN, reply_dly_dtu);
+	rx_timeout_uus = (airtime_frame_ns(&at, TWR_FINAL_LEN) / 1000) + 20;
+	printf("[ AIRTIME  ] reply delay %u us, RX after TX %u UUS, RX timeout %u UUS\n",
+	       (unsigned)(reply_dly_dtu / 63898), (unsigned)rx_dly_uus, (unsigned)rx_timeout_uus);
+	ASSERT_GT(rx_dly_uus, 0u);
+
+	single_sided = false;
+	RunRanging(0.5, 12.5, 18.0, -12.0, 0);
+	Report("DS-TWR", 0.5, 12.5, &mean, &max_abs);
+
+	// Against 500 us reply delays, every exchange succeeds in less time
+	EXPECT_GE(results.size(), 550u);
+	EXPECT_GE(results.size() + 1, (size_t)started);
+	EXPECT_LT(std::fabs(mean), 5.0);
+	EXPECT_LT(max_abs, 10.0);
+}
+
+TEST_F(SimTwr, AntennaDelayCalibration)
+{
+	uwbsim::Channel channel;
+	antcal_config_t config = {};
+	antcal_delays_t delays;
+	antcal_t cal;
+	double mean, max_abs;
+	size_t used = 0;
+
+	// The responder is calibrated against the initiator at 5 m, its TX and RX delays are 90 and
+	// 30 DTU too large, through a channel with 3 DTU of time stamp noise
+	channel.ts_noise_dtu = 3.0;
+	channel.seed = 11;
+	single_sided = false;
+	resp_tx_antd_err = 90;
+	resp_rx_antd_err = 30;
+	RunRanging(0.3, 5.0, 8.0, -6.0, 0, channel);
+	Report("DS-TWR", 0.3, 5.0, &mean, &max_abs);
+	EXPECT_NEAR(twr_tof_to_mm(-60), mean, 10.0);
+
+	config.tof_dtu = antcal_mm_to_tof(5000);
+	config.tx_antenna_delay = 16395 + 90;
+	config.rx_antenna_delay = 16375 + 30;
+	config.tx_share_q8 = ANTCAL_TX_SHARE_HALF;
+	config.min_count = 32;
+	config.max_stderr_q4 = 4; // 0.25 DTU
+	antcal_init(&cal, &config);
+	antcal_status_e status = ANTCAL_RUNNING;
+	for (const twr_result_t &r : results) {
+		used++;
+		status = antcal_add(&cal, r.tof_dtu);
+		if (status == ANTCAL_DONE)
+			break;
+	}
+	ASSERT_EQ(ANTCAL_DONE, status);
+	printf("[ ANTCAL   ] done after %zu ranges, %u rejected\n", used, cal.rejected);
+	ASSERT_EQ(DWT_SUCCESS, antcal_solve(&cal, &delays));
+
+	// Only the sum of the true delays (32770 DTU) is observable, split in half
+	EXPECT_NEAR(32770, delays.tx_antenna_delay + delays.rx_antenna_delay, 2);
+	EXPECT_NEAR(delays.tx_antenna_delay, delays.rx_antenna_delay, 1);
+
+	// Ranging with the delays found has no bias left
+	results.clear();
+	resp_tx_antd_err = delays.tx_antenna_delay - 16395;
+	resp_rx_antd_err = delays.rx_antenna_delay - 16375;
+	RunRanging(0.2, 5.0, 8.0, -6.0, 0, channel);
+	Report("DS-TWR", 0.2, 5.0, &mean, &max_abs);
+	ASSERT_GE(results.size(), 100u);
+	EXPECT_LT(std::fabs(mean), 5.0);
+}
+
+TEST_F(SimTwr, NoisyLossyChannel)
+{
+	uwbsim::Channel channel;
+	double mean, max_abs;
+
+	// 4 DTU of time stamp noise (2 cm) and one frame out of ten lost
+	channel.ts_noise_dtu = 4.0;
+	channel.loss = 0.1;
+	channel.seed = 7;
+	single_sided = false;
+	RunRanging(1.0, 20.0, 10.0, -3.0, 0, channel);
+	Report("DS-TWR", 1.0, 20.0, &mean, &max_abs);
+
+	// A lost frame costs an RX timeout, the exchanges go on to the end
+	EXPECT_GE(results.size(), 400u);
+	EXPECT_LT(results.size(), (size_t)started);
+	ASSERT_FALSE(result_times.empty());
+	EXPECT_GT(result_times.back(), 0.99);
+	EXPECT_LT(std::fabs(mean), 10.0);
+	EXPECT_LT(max_abs, 150.0);
+}
+
+/* Exchanges between several devices, each with its own delays, started by the tests */
+class SimTwrNet : public ::testing::Test {
+protected:
+	static const int kMax = TWR_MULTI_MAX + 1;
+
+	/* Range and the device which computed it */
+	struct Range {
+		int dev;
+		twr_result_t result;
+	};
+
+	static Sim *sim;
+	static twr_engine_t engine[kMax];
+	static std::vector<Range> ranges;
+
+	void SetUp() override
+	{
+		sim = new Sim();
+		ranges.clear();
+	}
+
+	void TearDown() override
+	{
+		delete sim;
+		sim = nullptr;
+	}
+
+	static void TxDoneCb(const dwt_cb_data_t *cb_data)
+	{
+		twr_tx_done_handler(&engine[sim->Current()], cb_data);
+	}
+
+	static void RxOkCb(const dwt_cb_data_t *cb_data)
+	{
+		twr_rx_ok_handler(&engine[sim->Current()], cb_data);
+	}
+
+	static void RxErrCb(const dwt_cb_data_t *cb_data)
+	{
+		twr_rx_error_handler(&engine[sim->Current()], cb_data);
+	}
+
+	static void ResultCb(const twr_result_t *result)
+	{
+		ranges.push_back({ sim->Current(), *result });
+	}
+
+	/* Delays of a device: reply after reply_us, receiver enabled 250 UUS after each TX, multi-responder slots of 300 UUS */
+	static twr_config_t Config(uint32_t reply_us, uint32_t rx_timeout_uus)
+	{
+		twr_config_t config = {};
+
+		config.poll_rx_to_resp_tx_dly = UUS_TO_DTU(reply_us);
+		config.resp_rx_to_final_tx_dly = UUS_TO_DTU(reply_us);
+		config.poll_tx_to_resp_rx_dly_uus = 250;
+		config.resp_tx_to_final_rx_dly_uus = 250;
+		config.rx_timeout_uus = rx_timeout_uus;
+		config.slot_uus = 300;
+		return config;
+	}
+
+	/* Add a device at (x, y) with a crystal offset, its short address is its index plus 1 */
+	static int Add(double x, double y, double ppm, twr_config_t config)
+	{
+		uwbsim::NodeConfig node;
+		dwt_callbacks_s cbs = {};
+		int dev;
+
+		node.x = x;
+		node.y = y;
+		node.ppm = ppm;
+		dev = sim->AddDevice(node);
+		dwt_settxantennadelay(16385);
+		dwt_setrxantennadelay(16385);
+		cbs.cbTxDone = TxDoneCb;
+		cbs.cbRxOk = RxOkCb;
+		cbs.cbRxTo = RxErrCb;
+		cbs.cbRxErr = RxErrCb;
+		dwt_setcallbacks(&cbs);
+		dwt_setinterrupt(DWT_INT_TXFRS_BIT_MASK | DWT_INT_RXFCG_BIT_MASK | DWT_INT_RXFTO_BIT_MASK | DWT_INT_RXPTO_BIT_MASK |
+					 DWT_INT_RXPHE_BIT_MASK | DWT_INT_RXFCE_BIT_MASK | DWT_INT_RXFSL_BIT_MASK | DWT_INT_RXSTO_BIT_MASK,
+				 0, DWT_ENABLE_INT_ONLY);
+
+		config.pan_id = kPan;
+		config.address = (uint16_t)(dev + 1);
+		config.tx_antenna_delay = 16385;
+		config.result_cb = ResultCb;
+		twr_init(&engine[dev], &config);
+		return dev;
+	}
+
+	static void Listen(int dev)
+	{
+		sim->Select(dev);
+		ASSERT_EQ(DWT_SUCCESS, twr_listen(&engine[dev]));
+	}
+
+	/* A frame with a bad FCS is received */
+	static void BadFrame(int dev)
+	{
+		sim->Poke(dev, SYS_STATUS_ID, sim->Peek(dev, SYS_STATUS_ID, 4) | SYS_STATUS_RXFCE_BIT_MASK, 4);
+	}
+
+	static bool Waiting(int dev)
+	{
+		for (uint32_t i = 0; i < TWR_SESSION_MAX; i++) {
+			if (engine[dev].sessions[i].state != TWR_STATE_IDLE)
+				return true;
+		}
+		return false;
+	}
+
+	/*
+	 * Multi-responder exchange from device 0 with the devices 1 to count, around it, those listening
+	 * answer. Returns the devices which computed a range, in slot order.
+	 */
+	static std::vector<int> Multi(int count, const std::vector<int> &deaf)
+	{
+		std::vector<uint16_t> peers;
+		std::vector<int> ranged;
+		int a = Add(0.0, 0.0, 4.0, Config(500, 400));
+
+		for (int i = 1; i <= count; i++) {
+			int dev = Add(2.0 + 1.5 * i, (i % 2 != 0) ? 1.0 : -2.5, (i % 2 != 0) ? -3.0 * i : 2.0 * i, Config(500, 400));
+
+			peers.push_back((uint16_t)(dev + 1));
+			if (std::find(deaf.begin(), deaf.end(), dev) == deaf.end())
+				Listen(dev);
+		}
+		sim->At(1e-3, a, [a, peers]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate_multi(&engine[a], peers.data(), (uint8_t)peers.size())); });
+		sim->Run(10e-3);
+
+		EXPECT_EQ(0u, engine[a].multi.active);
+		for (const Range &r : ranges) {
+			EXPECT_EQ(a + 1, r.result.peer);
+			ranged.push_back(r.dev);
+		}
+		return ranged;
+	}
+
+	/* Every range is the true distance, within the time stamp rounding */
+	static void CheckRanges()
+	{
+		for (const Range &r : ranges)
+			EXPECT_NEAR(sim->Distance(r.dev, r.result.peer - 1) * 1000.0, r.result.distance_mm, 10.0)
+				<< "device " << r.dev << " peer " << r.result.peer;
+	}
+};
+
+Sim *SimTwrNet::sim;
+twr_engine_t SimTwrNet::engine[SimTwrNet::kMax];
+std::vector<SimTwrNet::Range> SimTwrNet::ranges;
+
+TEST_F(SimTwrNet, ConcurrentPolls)
+{
+	// B answers after 1 ms and C after 2.5 ms. The initiator polls C while it waits for B: the final to B
+	// carries the TX time stamp of the first poll, not of the second, and leaves the receiver on for C.
+	int a = Add(0.0, 0.0, 5.0, Config(500, 3000));
+	int b = Add(6.0, 0.0, -4.0, Config(1000, 3000));
+	int c = Add(0.0, 9.0, 2.0, Config(2500, 3000));
+
+	Listen(b);
+	Listen(c);
+	sim->At(1e-3, a, [a, b]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(b + 1))); });
+	sim->At(1.3e-3, a, [a, c]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(c + 1))); });
+	sim->Run(10e-3);
+
+	ASSERT_EQ(2u, ranges.size());
+	EXPECT_EQ(b, ranges[0].dev);
+	EXPECT_EQ(c, ranges[1].dev);
+	CheckRanges();
+	EXPECT_FALSE(Waiting(a));
+}
+
+TEST_F(SimTwrNet, PollPending)
+{
+	// Without the TX done event, the TX time stamp of a poll is read on the next RX event: no other
+	// poll can be sent until then
+	int a = Add(0.0, 0.0, 0.0, Config(500, 1000));
+	int b = Add(4.0, 0.0, 0.0, Config(500, 1000));
+
+	Listen(b);
+	sim->At(1e-3, a, [a, b]() {
+		dwt_callbacks_s cbs = {};
+
+		cbs.cbRxOk = RxOkCb;
+		cbs.cbRxTo = RxErrCb;
+		cbs.cbRxErr = RxErrCb;
+		dwt_setcallbacks(&cbs);
+		EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(b + 1)));
+		EXPECT_EQ(DWT_ERROR, twr_initiate_ss(&engine[a], (uint16_t)(b + 1)));
+		EXPECT_EQ(DWT_ERROR, twr_initiate_multi(&engine[a], &engine[b].config.address, 1));
+	});
+	sim->Run(5e-3);
+
+	ASSERT_EQ(1u, ranges.size());
+	CheckRanges();
+}
+
+TEST_F(SimTwrNet, RxErrorKeepsWaiting)
+{
+	// A frame received with a bad FCS while the initiator waits for a late response ends nothing, the
+	// receiver is enabled again up to the end of the RX window
+	int a = Add(0.0, 0.0, 3.0, Config(500, 2000));
+	int b = Add(5.0, 0.0, -3.0, Config(1500, 2000));
+
+	Listen(b);
+	sim->At(1e-3, a, [a, b]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(b + 1))); });
+	sim->At(1.8e-3, a, [a]() { BadFrame(a); });
+	sim->Run(10e-3);
+
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(b, ranges[0].dev);
+	CheckRanges();
+}
+
+TEST_F(SimTwrNet, WindowOver)
+{
+	// B never answers. After a bad frame, the receiver times out at the end of the RX window of B, whose
+	// session ends, and is enabled again for C.
+	int a = Add(0.0, 0.0, 0.0, Config(500, 1500));
+	int b = Add(3.0, 0.0, 0.0, Config(500, 1500));
+	int c = Add(0.0, 7.0, 0.0, Config(1500, 1500));
+
+	Listen(c);
+	sim->At(1e-3, a, [a, b]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(b + 1))); });
+	sim->At(1.5e-3, a, [a, c]() { EXPECT_EQ(DWT_SUCCESS, twr_initiate(&engine[a], (uint16_t)(c + 1))); });
+	sim->At(2e-3, a, [a]() { BadFrame(a); });
+	sim->Run(10e-3);
+
+	ASSERT_EQ(1u, ranges.size());
+	EXPECT_EQ(c, ranges[0].dev);
+	CheckRanges();
+	EXPECT_FALSE(Waiting(a));
+}
+
+TEST_F(SimTwrNet, MultiResponder)
+{
+	// One poll and one final for all: every responder computes its own range, from its slot
+	EXPECT_EQ(std::vector<int>({ 1, 2, 3, 4, 5, 6 }), Multi(TWR_MULTI_MAX, {}));
+	CheckRanges();
+	EXPECT_EQ((uint64_t)TWR_MULTI_MAX + 2, sim->FramesSent());
+}
+
+TEST_F(SimTwrNet, MultiMissedSlot)
+{
+	// Responder 2 does not answer: the RX window of the initiator times out after the last slot, and the
+	// final goes to the others
+	EXPECT_EQ(std::vector<int>({ 1, 3, 4 }), Multi(4, { 2 }));
+	CheckRanges();
+	EXPECT_EQ(5u, sim->FramesSent());
+	EXPECT_EQ(0x0Du, engine[0].multi.received);
+}
+
+TEST_F(SimTwrNet, MultiNoResponse)
+{
+	// Nobody answers: no final
+	EXPECT_TRUE(Multi(2, { 1, 2 }).empty());
+	EXPECT_EQ(1u, sim->FramesSent());
+}
@@ -0,0 +1,156 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+using uwbsim::Sim;
+
+/* OTP words */
+static const uint32_t kLdoTuneLo = 0x00071234;
+static const uint32_t kLdoTuneHi = 0x00005555;
+static const uint32_t kBiasTune = 0x00110000;
+
+/* PLL LDO tune of the device out of sleep, before any kick */
+static const uint32_t kLdoTuneLoWake = 0x00050000;
+
+/* Registers written by dwt_restoreconfig(), lost in sleep */
+static const struct {
+	uint32_t id;
+	unsigned len;
+} kLost[] = {
+	{ LDO_TUNE_HI_ID, 4 },   { BIAS_CTRL_ID, 2 },     { LDO_RLOAD_ID, 4 },     { INDIRECT_ADDR_B_ID, 4 },
+	{ ADDR_OFFSET_B_ID, 4 }, { OTP_CFG_ID, 4 },       { RDB_DIAG_MODE_ID, 1 }, { DGC_CFG0_ID, 4 },
+	{ DGC_CFG1_ID, 4 },      { DGC_LUT_0_CFG_ID, 4 }, { DGC_LUT_1_CFG_ID, 4 }, { DGC_LUT_2_CFG_ID, 4 },
+	{ DGC_LUT_3_CFG_ID, 4 }, { DGC_LUT_4_CFG_ID, 4 }, { DGC_LUT_5_CFG_ID, 4 }, { DGC_LUT_6_CFG_ID, 4 },
+	{ TX_CTRL_LO_ID, 4 },
+};
+
+/*
+ * dwt_restoreconfig() replaying the wake profile precomputed by dwt_configure(), against a device in the same state
+ * without profile, which reads the device on wake. dwt_initialise() gives the driver its single static local data:
+ * the devices are initialised and used one after the other.
+ */
+class SimWake : public ::testing::Test {
+protected:
+	Sim sim;
+
+	/* Settings after dwt_configure(), they rebuild the profile. The OPS table is the one dwt_configure() selects. */
+	static void Settings()
+	{
+		dwt_configciadiag(DW_CIA_DIAG_LOG_ALL);
+		dwt_configuresleep(DWT_CONFIG | DWT_ALT_OPS | DWT_SEL_OPS2, DWT_PRES_SLEEP | DWT_WAKE_CSN | DWT_SLP_EN);
+	}
+
+	void Sleep(int dev)
+	{
+		for (const auto &r : kLost)
+			sim.Poke(dev, r.id, 0, r.len);
+		sim.Poke(dev, LDO_TUNE_LO_ID, kLdoTuneLoWake, 4);
+	}
+
+	/* Full restore, returns the SPI transactions it took */
+	uint64_t Restore(int dev, std::vector<uint8_t> *image)
+	{
+		uint64_t xfers;
+
+		Sleep(dev);
+		xfers = sim.SpiTransactions();
+		dwt_restoreconfig(1);
+		xfers = sim.SpiTransactions() - xfers;
+		*image = sim.Save(dev);
+		return xfers;
+	}
+
+	/* Register images restored with and without profile, the restore with profile is the shorter if it is valid */
+	void Compare(const std::map<uint16_t, uint32_t> &otp, uint8_t chan, bool valid)
+	{
+		uwbsim::NodeConfig node;
+		dwt_config_t config = uwbsim::DefaultConfig(chan);
+		std::vector<uint8_t> before, replayed, live;
+		uint64_t replay_xfers, live_xfers;
+		unsigned diffs = 0;
+		int dev;
+
+		node.otp = otp;
+		dev = sim.AddDevice(node);
+		ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+		ASSERT_EQ(DWT_SUCCESS, dwt_configure(&config));
+		Settings();
+		before = sim.Save(dev);
+		replay_xfers = Restore(dev, &replayed);
+
+		dev = sim.AddDevice(node);
+		ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+		sim.Load(dev, before);
+		Settings();
+		live_xfers = Restore(dev, &live);
+
+		// The system time is read at different times
+		for (unsigned i = 0; i < 4; i++) {
+			replayed[SYS_TIME_ID + i] = 0;
+			live[SYS_TIME_ID + i] = 0;
+		}
+		for (size_t i = 0; (i < replayed.size()) && (diffs < 8); i++) {
+			if (replayed[i] != live[i]) {
+				ADD_FAILURE() << "register file 0x" << std::hex << (i / 0x800) << " offset 0x" << (i % 0x800) << ": 0x"
+					      << (int)replayed[i] << " replayed, 0x" << (int)live[i] << " live";
+				diffs++;
+			}
+		}
+		if (valid)
+			EXPECT_LT(replay_xfers, live_xfers);
+		else
+			EXPECT_EQ(replay_xfers, live_xfers);
+	}
+};
+
+TEST_F(SimWake, Programmed)
+{
+	const std::map<uint16_t, uint32_t> otp = { { uwbsim::kOtpLdoTuneLo, kLdoTuneLo },
+						   { uwbsim::kOtpLdoTuneHi, kLdoTuneHi },
+						   { uwbsim::kOtpBiasTune, kBiasTune } };
+
+	Compare(otp, 5, true);
+	Compare(otp, 9, true);
+}
+
+TEST_F(SimWake, DgcFromOtp)
+{
+	const std::map<uint16_t, uint32_t> otp = { { uwbsim::kOtpLdoTuneLo, kLdoTuneLo },
+						   { uwbsim::kOtpLdoTuneHi, kLdoTuneHi },
+						   { uwbsim::kOtpBiasTune, kBiasTune },
+						   { uwbsim::kOtpDgcTune, DWT_DGC_CFG0 } };
+
+	Compare(otp, 5, true);
+	Compare(otp, 9, true);
+}
+
+TEST_F(SimWake, LdoTuneNotProgrammed)
+{
+	// The LDO kick leaves the PLL LDO tune of the device out of sleep, only known on wake
+	const std::map<uint16_t, uint32_t> otp = { { uwbsim::kOtpLdoTuneHi, kLdoTuneHi }, { uwbsim::kOtpBiasTune, kBiasTune } };
+
+	Compare(otp, 5, false);
+	Compare(otp, 9, true);
+}
+
+TEST_F(SimWake, NotProgrammed)
+{
+	Compare({}, 5, false);
+	Compare({}, 9, true);
+}
@@ -0,0 +1,110 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_sleepprof.h"
+}
+
+static uint32_t now;
+
+static uint32_t Clock(void)
+{
+	return now;
+}
+
+static void Mark(sleepprof_phase_e phase, uint32_t after_us)
+{
+	now += after_us;
+	sleepprof_mark(phase);
+}
+
+static const sleepprof_currents_t kCurrents = {
+	{ 1, 4000, 500, 10000, 40000, 60000 }, // sleep, wakeup, IDLE_RC, IDLE_PLL, TX, RX
+	3300,
+};
+
+/* One cycle: wake-up, restore, a TX, an RX, then back to sleep */
+static void Cycle(uint32_t sleep_us)
+{
+	Mark(SLEEPPROF_WAKE_PULSE, sleep_us);
+	Mark(SLEEPPROF_WAKE_DELAY, 500);
+	Mark(SLEEPPROF_SPI_READY, 1000);
+	Mark(SLEEPPROF_RESTORE, 200);
+	Mark(SLEEPPROF_FIRST_TXRX, 300);
+	Mark(SLEEPPROF_TX, 100);
+	Mark(SLEEPPROF_IDLE, 200);
+	Mark(SLEEPPROF_RX, 50);
+	Mark(SLEEPPROF_IDLE, 1000);
+	Mark(SLEEPPROF_CONFIG_SLEEP, 50);
+	Mark(SLEEPPROF_SLEEP, 100);
+}
+
+TEST(SleepProf, NoCycleYet)
+{
+	sleepprof_report_t report;
+
+	now = 0;
+	sleepprof_start(Clock, &kCurrents);
+	EXPECT_EQ(DWT_ERROR, sleepprof_report(&report));
+	// The time before the first sleep is not part of a cycle
+	Mark(SLEEPPROF_TX, 100);
+	Mark(SLEEPPROF_SLEEP, 5000);
+	EXPECT_EQ(DWT_ERROR, sleepprof_report(&report));
+	sleepprof_stop();
+}
+
+TEST(SleepProf, PhasesAndEnergy)
+{
+	sleepprof_report_t report;
+
+	now = 0xFFFF0000UL; // the clock wraps during the cycle
+	sleepprof_start(Clock, &kCurrents);
+	Mark(SLEEPPROF_SLEEP, 10);
+	Cycle(96500);
+	ASSERT_EQ(DWT_SUCCESS, sleepprof_report(&report));
+
+	EXPECT_EQ(1u, report.cycles);
+	EXPECT_EQ(96500u, report.phase_us[SLEEPPROF_SLEEP]);
+	EXPECT_EQ(500u, report.phase_us[SLEEPPROF_WAKE_PULSE]);
+	EXPECT_EQ(1000u, report.phase_us[SLEEPPROF_WAKE_DELAY]);
+	EXPECT_EQ(200u, report.phase_us[SLEEPPROF_SPI_READY]);
+	EXPECT_EQ(300u, report.phase_us[SLEEPPROF_RESTORE]);
+	EXPECT_EQ(100u, report.phase_us[SLEEPPROF_FIRST_TXRX]);
+	EXPECT_EQ(200u, report.phase_us[SLEEPPROF_TX]);
+	EXPECT_EQ(1000u, report.phase_us[SLEEPPROF_RX]);
+	EXPECT_EQ(100u, report.phase_us[SLEEPPROF_IDLE]);
+	EXPECT_EQ(100u, report.phase_us[SLEEPPROF_CONFIG_SLEEP]);
+	EXPECT_EQ(100000u, report.cycle_us);
+	EXPECT_EQ(2100u, report.wake_us);
+
+	// uA x us: 96500 + 4000 x 1500 + 500 x 500 + 10000 x 300 + 40000 x 200 + 60000 x 1000
+	EXPECT_EQ(77346u, report.charge_nc);
+	EXPECT_EQ(255243u, report.energy_nj);
+	EXPECT_EQ(773u, report.avg_current_ua);
+	sleepprof_stop();
+}
+
+TEST(SleepProf, LastCycleReported)
+{
+	sleepprof_report_t report;
+
+	now = 0;
+	sleepprof_start(Clock, &kCurrents);
+	Mark(SLEEPPROF_SLEEP, 0);
+	Cycle(10000);
+	Cycle(20000);
+	sleepprof_stop();
+	// Not profiled any more
+	Cycle(30000);
+	ASSERT_EQ(DWT_SUCCESS, sleepprof_report(&report));
+	EXPECT_EQ(2u, report.cycles);
+	EXPECT_EQ(20000u, report.phase_us[SLEEPPROF_SLEEP]);
+	EXPECT_EQ(SLEEPPROF_STATE_IDLE_PLL, sleepprof_phase_state(SLEEPPROF_FIRST_TXRX));
+}
@@ -0,0 +1,234 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "dw3000_deca_regs.h"
+}
+
+using uwbsim::Sim;
+
+/* The simulated devices are not initialised: the OTP references tempP and vBatP are 0 */
+class TempVbat : public ::testing::Test {
+protected:
+	Sim sim;
+
+	void SetUp() override
+	{
+		sim.AddDevice(uwbsim::NodeConfig());
+	}
+};
+
+TEST_F(TempVbat, TemperatureEquivalence)
+{
+	for (int raw = 0; raw <= 255; raw++) {
+		// DW3000 User Manual formula, Vtemp @ 22C
+		double ref = raw * 1.05 + 22.0;
+
+		EXPECT_EQ(std::lround(ref * 100.0), dwt_convertrawtemperature_cdeg((uint8_t)raw)) << raw;
+		EXPECT_NEAR(ref, dwt_convertrawtemperature((uint8_t)raw), 1e-3) << raw;
+	}
+}
+
+TEST_F(TempVbat, VoltageEquivalence)
+{
+	for (int raw = 0; raw <= 255; raw++) {
+		// 0.4V fullscale, 16x attenuation, 3.0V at the OTP reference
+		double ref = raw * 0.4 * 16.0 / 255.0 + 3.0;
+
+		EXPECT_EQ(std::lround(ref * 1000.0), dwt_convertrawvoltage_mv((uint8_t)raw)) << raw;
+		EXPECT_NEAR(ref, dwt_convertrawvoltage((uint8_t)raw), 1e-3) << raw;
+	}
+}
+
+TEST_F(TempVbat, WholeDegrees)
+{
+	// Truncated towards zero as the float temperature converted to int8_t, without its rounding errors on whole
+	// degrees: 100 x 1.05f + 22.0f is below 127
+	for (int raw = 0; raw <= 100; raw++) {
+		EXPECT_EQ((int8_t)std::trunc(raw * 1.05 + 22.0), (int8_t)(dwt_convertrawtemperature_cdeg((uint8_t)raw) / 100)) << raw;
+	}
+}
+
+/* Readings of the SAR model, as dwt_readtempvbat() returns them */
+static uint16_t Reading(const uwbsim::NodeConfig &node)
+{
+	return (uint16_t)((node.sar_temp << 8) | node.sar_vbat);
+}
+
+/* dwt_readtempvbat_start() and dwt_readtempvbat_complete() on an initialised device */
+class TempVbatAsync : public ::testing::Test {
+protected:
+	Sim sim;
+	int dev = 0;
+	uint32_t ldo_ctrl = 0;
+
+	void SetUp() override
+	{
+		dev = sim.AddDevice(uwbsim::NodeConfig());
+		ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+		ldo_ctrl = sim.Peek(dev, LDO_CTRL_ID, 4);
+	}
+
+	/* Polls until both readings are collected, returns the number of polls */
+	int Complete(uint16_t *tempvbat)
+	{
+		int polls = 1;
+
+		while (dwt_readtempvbat_complete(tempvbat) == DWT_ERR_BUSY) {
+			if (++polls > 100)
+				break;
+		}
+		return polls;
+	}
+
+	/* The SAR is powered down as before the start */
+	void ExpectIdle()
+	{
+		uint16_t tempvbat;
+
+		EXPECT_EQ(DWT_ERROR, dwt_readtempvbat_complete(&tempvbat));
+		EXPECT_EQ(ldo_ctrl, sim.Peek(dev, LDO_CTRL_ID, 4));
+		EXPECT_EQ(0U, sim.Peek(dev, SAR_TEST_ID, 1));
+	}
+};
+
+TEST_F(TempVbatAsync, StartComplete)
+{
+	uint16_t tempvbat = 0;
+	int polls;
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(DWT_ERR_BUSY, dwt_readtempvbat_start());
+	polls = Complete(&tempvbat);
+	EXPECT_GE(polls, 2);
+	EXPECT_LE(polls, 100);
+	EXPECT_EQ(Reading(sim.Node(dev)), tempvbat);
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	ExpectIdle();
+}
+
+TEST_F(TempVbatAsync, BlockingReadWhileConverting)
+{
+	unsigned muxes = 0;
+
+	// The blocking read at each step of the conversion finishes it, the polls still collect its readings
+	for (int step = 0; step < 4; step++) {
+		uint16_t tempvbat = 0;
+		int32_t ret = DWT_ERR_BUSY;
+
+		ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+		for (int i = 0; (i < step) && (ret == DWT_ERR_BUSY); i++)
+			ret = dwt_readtempvbat_complete(&tempvbat);
+		if (ret == DWT_SUCCESS) {
+			ExpectIdle();
+			break;
+		}
+		ASSERT_EQ(DWT_ERR_BUSY, ret);
+		muxes |= 1U << ((sim.Peek(dev, SAR_CTRL_ID, 2) & SAR_CTRL_SAR_FORCE_SEL_BIT_MASK) >> SAR_CTRL_SAR_FORCE_SEL_BIT_OFFSET);
+		EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat()) << step;
+		EXPECT_EQ(DWT_ERR_BUSY, dwt_readtempvbat_start()) << step;
+		EXPECT_EQ(DWT_SUCCESS, dwt_readtempvbat_complete(&tempvbat)) << step;
+		EXPECT_EQ(Reading(sim.Node(dev)), tempvbat) << step;
+		ExpectIdle();
+	}
+	// Both the temperature (2) and the voltage (1) conversions were interrupted
+	EXPECT_EQ((1U << 2) | (1U << 1), muxes);
+}
+
+TEST_F(TempVbatAsync, BlockingReadWhileUncollected)
+{
+	uint16_t tempvbat = 0;
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	// A new conversion, not the readings kept for the polls
+	sim.Node(dev).sar_temp++;
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	EXPECT_EQ(DWT_SUCCESS, dwt_readtempvbat_complete(&tempvbat));
+	EXPECT_EQ(Reading(sim.Node(dev)) - 0x100, tempvbat);
+	ExpectIdle();
+}
+
+TEST_F(TempVbatAsync, Abort)
+{
+	uint16_t tempvbat = 0;
+
+	EXPECT_EQ(DWT_ERROR, dwt_readtempvbat_abort());
+	// While converting: the SAR is powered down
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(DWT_SUCCESS, dwt_readtempvbat_abort());
+	ExpectIdle();
+	EXPECT_EQ(DWT_ERROR, dwt_readtempvbat_abort());
+	// Readings finished by the blocking read and not collected: dropped
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	EXPECT_EQ(DWT_SUCCESS, dwt_readtempvbat_abort());
+	ExpectIdle();
+	// A new conversion can be started
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	Complete(&tempvbat);
+	EXPECT_EQ(Reading(sim.Node(dev)), tempvbat);
+	ExpectIdle();
+}
+
+TEST_F(TempVbatAsync, SleepDropsConversion)
+{
+	// Sleep is not simulated: the device comes out of it with another LDO_CTRL
+	uint32_t ldo_ctrl_wake = ldo_ctrl ^ LDO_CTRL_LDO_VDDPLL_EN_BIT_MASK;
+	uint16_t tempvbat = 0;
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	dwt_entersleep(DWT_DW_IDLE);
+	EXPECT_EQ(0U, sim.Peek(dev, SAR_TEST_ID, 1));
+	sim.Poke(dev, LDO_CTRL_ID, ldo_ctrl_wake, 4);
+	ldo_ctrl = ldo_ctrl_wake;
+	// The blocking read converts again, and leaves the LDO_CTRL of the wake-up
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	ExpectIdle();
+
+	// Only when going to sleep after TX
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	dwt_entersleepaftertx(0);
+	EXPECT_EQ(DWT_ERR_BUSY, dwt_readtempvbat_start());
+	dwt_entersleepaftertx(1);
+	dwt_entersleepaftertx(0);
+	ExpectIdle();
+
+	// Readings collected by the blocking read are kept
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	dwt_entersleep(DWT_DW_IDLE);
+	EXPECT_EQ(DWT_SUCCESS, dwt_readtempvbat_complete(&tempvbat));
+	EXPECT_EQ(Reading(sim.Node(dev)), tempvbat);
+}
+
+TEST(TempVbatSlow, WaitBounded)
+{
+	uwbsim::Timing timing;
+	uint32_t ldo_ctrl;
+	uint16_t tempvbat = 0;
+
+	// A conversion longer than the polls of the blocking read, which gives it up and converts again
+	timing.sar_s = 1e-3;
+	Sim sim(uwbsim::Phy(), timing);
+	int dev = sim.AddDevice(uwbsim::NodeConfig());
+
+	ASSERT_EQ(DWT_SUCCESS, dwt_initialise(DWT_DW_INIT));
+	ldo_ctrl = (uint32_t)sim.Peek(dev, LDO_CTRL_ID, 4);
+	ASSERT_EQ(DWT_SUCCESS, dwt_readtempvbat_start());
+	EXPECT_EQ(Reading(sim.Node(dev)), dwt_readtempvbat());
+	EXPECT_GT(sim.Now(), 2 * timing.sar_s);
+	EXPECT_EQ(DWT_ERROR, dwt_readtempvbat_complete(&tempvbat));
+	EXPECT_EQ(ldo_ctrl, sim.Peek(dev, LDO_CTRL_ID, 4));
+}
@@ -0,0 +1,137 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_timestamp.h"
+}
+
+static constexpr uint64_t period = 1ULL << 40;
+
+/* Time stamps near 0 and near the wrap are where most bugs hide, draw them often. */
+static uint64_t DrawTimestamp(std::mt19937_64 &rng)
+{
+	switch (rng() % 4) {
+	case 0:
+		return rng() % 1000000;
+	case 1:
+		return period - 1 - rng() % 1000000;
+	default:
+		return rng() & TS40_MASK;
+	}
+}
+
+TEST(Timestamp, LoadStore)
+{
+	std::mt19937_64 rng(40);
+
+	for (int i = 0; i < 100000; i++) {
+		uint64_t ts = DrawTimestamp(rng);
+		uint8_t buf[TS40_LEN];
+		uint64_t expected = 0;
+
+		ts40_store(ts, buf);
+		for (int b = TS40_LEN - 1; b >= 0; b--) {
+			expected = (expected << 8) | buf[b];
+		}
+		ASSERT_EQ(ts, expected);
+		ASSERT_EQ(ts, ts40_load(buf));
+
+		uint8_t systime[TS40_SYSTIME_LEN] = { buf[1], buf[2], buf[3], buf[4] };
+		ASSERT_EQ(ts & ~0xFFULL, ts40_load_systime(systime));
+	}
+}
+
+TEST(Timestamp, WrapSafeArithmetic)
+{
+	std::mt19937_64 rng(17);
+
+	for (int i = 0; i < 1000000; i++) {
+		uint64_t a = DrawTimestamp(rng);
+		/* Durations strictly below half a period, both signs. */
+		int64_t d = (int64_t)(rng() % (TS40_HALF - 1)) - (int64_t)(TS40_HALF - 1) / 2;
+		if (rng() % 2) {
+			d = (int64_t)(rng() % 2000000) - 1000000;
+		}
+		uint64_t b = (uint64_t)(((__int128)a + d) % (__int128)period + period) % period;
+
+		ASSERT_LE(b, TS40_MASK);
+		ASSERT_EQ(b, ts40_add(a, (uint64_t)d & TS40_MASK));
+		ASSERT_EQ((uint64_t)d & TS40_MASK, ts40_sub(b, a));
+		ASSERT_EQ(d, ts40_diff(b, a));
+		ASSERT_EQ(-d, ts40_diff(a, b));
+		ASSERT_EQ(d < 0, ts40_before(b, a));
+		ASSERT_EQ(d > 0, ts40_before(a, b));
+	}
+
+	/* Explicit wrap: 1 DTU after the last value is 0. */
+	EXPECT_EQ(0u, ts40_add(TS40_MASK, 1));
+	EXPECT_EQ(1u, ts40_sub(0, TS40_MASK));
+	EXPECT_EQ(2, ts40_diff(1, TS40_MASK));
+	EXPECT_TRUE(ts40_before(TS40_MASK, 0));
+	EXPECT_FALSE(ts40_before(5, 5));
+}
+
+TEST(Timestamp, Conversions)
+{
+	std::mt19937_64 rng(499);
+
+	EXPECT_DOUBLE_EQ(1.0 / TS40_DTU_PER_S, DWT_TIME_UNITS);
+	EXPECT_EQ(TS40_DTU_PER_S * TS40_PS_NUM / TS40_PS_DEN, 1000000000000ULL);
+	EXPECT_EQ(TS40_DTU_PER_S * TS40_NS_NUM / TS40_NS_DEN, 1000000000ULL);
+	EXPECT_EQ(TS40_DTU_PER_S * TS40_US_NUM / TS40_US_DEN, 1000000ULL);
+
+	/* Reference: exact rational conversions with 128-bit intermediates. */
+	for (int i = 0; i < 100000; i++) {
+		uint64_t dtu = DrawTimestamp(rng);
+
+		ASSERT_EQ((uint64_t)((unsigned __int128)dtu * 1000000000000ULL / TS40_DTU_PER_S),
+			  ts40_dtu_to_ps(dtu));
+		ASSERT_EQ((uint64_t)((unsigned __int128)dtu * 1000000000ULL / TS40_DTU_PER_S),
+			  ts40_dtu_to_ns(dtu));
+
+		uint64_t ns = ts40_dtu_to_ns(dtu);
+		ASSERT_EQ((uint64_t)((unsigned __int128)ns * TS40_DTU_PER_S / 1000000000ULL),
+			  ts40_ns_to_dtu(ns));
+		ASSERT_LE(ts40_ns_to_dtu(ns), dtu);
+		ASSERT_LE(dtu - ts40_ns_to_dtu(ns), 64u);
+
+		uint64_t ps = ts40_dtu_to_ps(dtu);
+		ASSERT_LE(dtu - ts40_ps_to_dtu(ps), 1u);
+
+		uint64_t us = dtu / 64000;
+		ASSERT_EQ((uint64_t)((unsigned __int128)us * TS40_DTU_PER_S / 1000000ULL),
+			  ts40_us_to_dtu(us));
+	}
+}
+
+TEST(Timestamp, DelayedTxTime)
+{
+	std::mt19937_64 rng(9);
+
+	for (int i = 0; i < 100000; i++) {
+		uint64_t ts = DrawTimestamp(rng);
+		uint32_t starttime = ts40_to_delayed(ts);
+
+		ASSERT_EQ((uint32_t)(ts >> 8), starttime);
+		/* The device ignores the low 9 bits: the result is at most 511 DTU early. */
+		uint64_t at = ts40_from_delayed(starttime);
+		ASSERT_EQ(0u, at & 0x1FF);
+		ASSERT_LE(ts40_sub(ts, at), 0x1FFu);
+	}
+
+	/* Typical use: reply 500 us after an RX time stamp close to the wrap. */
+	uint64_t rx = TS40_MASK - 1000;
+	uint64_t tx = ts40_add(rx, ts40_us_to_dtu(500));
+	EXPECT_LT(tx, rx);
+	EXPECT_TRUE(ts40_before(rx, tx));
+	EXPECT_EQ(500000u, ts40_dtu_to_ns(ts40_sub(tx, rx)));
+}
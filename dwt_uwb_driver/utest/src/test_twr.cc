@@ -0,0 +1,115 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_twr.h"
+}
+
+/*
+ * Simulate one DS-TWR exchange between two devices whose clocks run with
+ * the given offsets (in ppm) from true time, and return the time stamps
+ * durations as seen by each device.
+ */
+struct Exchange {
+	uint32_t round_a, reply_a, round_b, reply_b;
+};
+
+static Exchange Simulate(double tof_s, double reply_b_s, double reply_a_s,
+			 double ppm_a, double ppm_b, uint64_t start_a, uint64_t start_b)
+{
+	const double dtu = (double)TS40_DTU_PER_S;
+	double ka = dtu * (1.0 + ppm_a * 1e-6), kb = dtu * (1.0 + ppm_b * 1e-6);
+	/* True times of the four events, poll TX at t = 0. */
+	double poll_rx = tof_s, resp_tx = poll_rx + reply_b_s;
+	double resp_rx = resp_tx + tof_s, final_tx = resp_rx + reply_a_s;
+	double final_rx = final_tx + tof_s;
+	auto ts_a = [&](double t) { return (uint32_t)(start_a + (uint64_t)llround(t * ka)); };
+	auto ts_b = [&](double t) { return (uint32_t)(start_b + (uint64_t)llround(t * kb)); };
+	Exchange e;
+
+	e.round_a = ts_a(resp_rx) - ts_a(0);
+	e.reply_a = ts_a(final_tx) - ts_a(resp_rx);
+	e.round_b = ts_b(final_rx) - ts_b(resp_tx);
+	e.reply_b = ts_b(resp_tx) - ts_b(poll_rx);
+	return e;
+}
+
+TEST(Twr, AsymmetricFormulaWithClockOffsets)
+{
+	std::mt19937 rng(32);
+	std::uniform_real_distribution<double> dist_m(0.0, 300.0);
+	std::uniform_real_distribution<double> ppm(-20.0, 20.0);
+	std::uniform_real_distribution<double> reply(200e-6, 3e-3);
+
+	for (int i = 0; i < 10000; i++) {
+		double distance = dist_m(rng);
+		double tof_s = distance / TWR_SPEED_OF_LIGHT;
+		/* Start counters close to the 32-bit wrap now and then. */
+		uint64_t start_a = (i % 3 == 0) ? 0xFFFFFF00ULL : rng();
+		Exchange e = Simulate(tof_s, reply(rng), reply(rng), ppm(rng), ppm(rng),
+				      start_a, rng());
+
+		int32_t tof = twr_compute_tof(e.round_a, e.reply_a, e.round_b, e.reply_b);
+		/* Asymmetric DS-TWR error stays within a few DTU of rounding. */
+		ASSERT_NEAR(tof_s * TS40_DTU_PER_S, tof, 3.0) << "distance " << distance;
+		ASSERT_NEAR(distance * 1000.0, twr_tof_to_mm(tof), 15.0);
+	}
+}
+
+TEST(Twr, SingleSidedClockOffsetCorrection)
+{
+	std::mt19937 rng(35);
+	std::uniform_real_distribution<double> dist_m(0.0, 300.0);
+	std::uniform_real_distribution<double> ppm(-20.0, 20.0);
+	std::uniform_real_distribution<double> reply(200e-6, 3e-3);
+
+	for (int i = 0; i < 10000; i++) {
+		double distance = dist_m(rng);
+		double tof_s = distance / TWR_SPEED_OF_LIGHT;
+		double ppm_a = ppm(rng), ppm_b = ppm(rng);
+		Exchange e = Simulate(tof_s, reply(rng), reply(rng), ppm_a, ppm_b, rng(), rng());
+		/* Offset as measured by the CIA, with its 2^-26 resolution. */
+		double ratio = 1.0 - (1.0 + ppm_a * 1e-6) / (1.0 + ppm_b * 1e-6);
+		int32_t coe = (int32_t)lround(ratio * (1 << 26));
+
+		int32_t tof = twr_compute_ss_tof(e.round_a, e.reply_b, coe * 64);
+		ASSERT_NEAR(tof_s * TS40_DTU_PER_S, tof, 3.0) << "distance " << distance;
+	}
+
+	/* Uncorrected, 20 ppm on a 3 ms reply is an error of 30 ns. */
+	Exchange e = Simulate(10.0 / TWR_SPEED_OF_LIGHT, 3e-3, 3e-3, 0.0, 20.0, 0, 0);
+	EXPECT_GT(std::abs(twr_compute_ss_tof(e.round_a, e.reply_b, 0) - 10.0 / TWR_SPEED_OF_LIGHT * TS40_DTU_PER_S), 1800.0);
+	EXPECT_EQ(-10, twr_compute_ss_tof(1000, 1020, 0));
+}
+
+TEST(Twr, NegativeAndDegenerate)
+{
+	/* Antenna delays larger than the flight time give a negative ToF. */
+	EXPECT_EQ(-5, twr_compute_tof(1000, 1000, 980, 1000));
+	EXPECT_EQ(10, twr_compute_tof(1020, 1000, 1020, 1000));
+	EXPECT_EQ(0, twr_compute_tof(0, 0, 0, 0));
+	/* Largest durations do not overflow. */
+	EXPECT_EQ(0, twr_compute_tof(UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX));
+}
+
+TEST(Twr, TofToDistance)
+{
+	EXPECT_EQ(0, twr_tof_to_mm(0));
+	/* One DTU is about 4.69 mm. */
+	EXPECT_EQ(4690, twr_tof_to_mm(1000));
+	EXPECT_EQ(-4690, twr_tof_to_mm(-1000));
+	EXPECT_EQ(999, twr_tof_to_mm(213));
+	/* Largest flight times do not overflow the intermediate product. */
+	EXPECT_EQ((int32_t)(10000000 / (double)TS40_DTU_PER_S * TWR_SPEED_OF_LIGHT * 1000.0),
+		  twr_tof_to_mm(10000000));
+}
@@ -0,0 +1,223 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "uwb_sim.h"
+
+extern "C"
+{
+#include "deca_device_api.h"
+#include "deca_txtemplate.h"
+#include "dw3000_deca_regs.h"
+}
+
+using uwbsim::Sim;
+
+static const uint8_t kUnwritten = 0xEE;
+
+/* Templates written through the driver to a virtual device, SPI transactions counted */
+class TxTemplate : public ::testing::Test {
+protected:
+	Sim sim;
+	int dev = 0;
+	txtmpl_mgr_t mgr;
+	uint8_t frame[TXTMPL_FRAME_MAX];
+
+	void SetUp() override
+	{
+		dev = sim.AddDevice(uwbsim::NodeConfig());
+		txtmpl_init(&mgr, 0);
+		for (unsigned i = 0; i < sizeof(frame); i++)
+			frame[i] = (uint8_t)(i + 1);
+	}
+
+	uint8_t *TxBuffer(uint16_t offset)
+	{
+		return sim.Reg(dev, TX_BUFFER_ID) + offset;
+	}
+
+	/* Overwrite the TX buffer behind the manager, so that the bytes it writes next can be told */
+	void Mark()
+	{
+		memset(TxBuffer(0), kUnwritten, 128);
+	}
+
+	/* First and last bytes of the TX buffer written since Mark(), -1 if none */
+	void Written(int *first, int *last)
+	{
+		*first = -1;
+		*last = -1;
+		for (int i = 0; i < 128; i++) {
+			if (TxBuffer(0)[i] != kUnwritten) {
+				if (*first < 0)
+					*first = i;
+				*last = i;
+			}
+		}
+	}
+
+	/* SPI transactions taken by fn */
+	template <typename F> uint64_t Xfers(F fn)
+	{
+		uint64_t before = sim.SpiTransactions();
+
+		fn();
+		return sim.SpiTransactions() - before;
+	}
+};
+
+TEST_F(TxTemplate, FirstSelect)
+{
+	int id0 = txtmpl_add(&mgr, frame, 12, 1);
+	int id1 = txtmpl_add(&mgr, frame, 30, 0);
+	int first, last;
+
+	ASSERT_EQ(0, id0);
+	ASSERT_EQ(1, id1);
+	Mark();
+	// The frame and TX_FCTRL
+	EXPECT_EQ(2u, Xfers([&]() { EXPECT_EQ(DWT_SUCCESS, txtmpl_select(&mgr, (uint8_t)id1)); }));
+	Written(&first, &last);
+	EXPECT_EQ(10, first);
+	EXPECT_EQ(10 + 28 - 1, last);
+	EXPECT_EQ(0, memcmp(frame, TxBuffer(10), 28));
+	EXPECT_EQ(30u | (10u << TX_FCTRL_TXB_OFFSET_BIT_OFFSET), sim.Peek(dev, TX_FCTRL_ID, 4) & (TX_FCTRL_TXFLEN_BIT_MASK | TX_FCTRL_TXB_OFFSET_BIT_MASK | TX_FCTRL_TR_BIT_MASK));
+}
+
+TEST_F(TxTemplate, RepeatedSelect)
+{
+	int id0 = txtmpl_add(&mgr, frame, 12, 1);
+	int id1 = txtmpl_add(&mgr, frame, 20, 1);
+
+	txtmpl_select(&mgr, (uint8_t)id0);
+	txtmpl_select(&mgr, (uint8_t)id1);
+	// Nothing to write for the template selected, only TX_FCTRL for the other one
+	EXPECT_EQ(0u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id1); }));
+	EXPECT_EQ(1u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id0); }));
+	EXPECT_EQ(0u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id0); }));
+	// A new length is written on the next selection only
+	EXPECT_EQ(0u, Xfers([&]() { txtmpl_setlen(&mgr, (uint8_t)id0, 11); }));
+	EXPECT_EQ(1u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id0); }));
+	EXPECT_EQ(11u, sim.Peek(dev, TX_FCTRL_ID, 4) & TX_FCTRL_TXFLEN_BIT_MASK);
+	// After sleep, everything again
+	txtmpl_invalidate(&mgr);
+	EXPECT_EQ(2u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id0); }));
+}
+
+TEST_F(TxTemplate, OneBytePatch)
+{
+	int id = txtmpl_add(&mgr, frame, 30, 1);
+	uint8_t seq = 0x80;
+	int first, last;
+
+	txtmpl_select(&mgr, (uint8_t)id);
+	Mark();
+	EXPECT_EQ(1u, Xfers([&]() { EXPECT_EQ(DWT_SUCCESS, txtmpl_patch(&mgr, (uint8_t)id, 2, &seq, 1)); }));
+	Written(&first, &last);
+	EXPECT_EQ(2, first);
+	EXPECT_EQ(2, last);
+	EXPECT_EQ(0x80, *TxBuffer(2));
+	// The same byte again is not written
+	EXPECT_EQ(0u, Xfers([&]() { txtmpl_patch(&mgr, (uint8_t)id, 2, &seq, 1); }));
+}
+
+TEST_F(TxTemplate, ScatteredPatch)
+{
+	int id0 = txtmpl_add(&mgr, frame, 12, 1);
+	int id1 = txtmpl_add(&mgr, frame, 30, 1);
+	uint8_t data[20];
+	int first, last;
+
+	txtmpl_select(&mgr, (uint8_t)id0);
+	txtmpl_select(&mgr, (uint8_t)id1);
+	memcpy(data, &frame[4], sizeof(data));
+	data[3] ^= 0xFF;
+	data[15] ^= 0xFF;
+	Mark();
+	// Bytes 7 and 19 of the frame differ: one transaction from the first to the last, at the template offset
+	EXPECT_EQ(1u, Xfers([&]() { EXPECT_EQ(DWT_SUCCESS, txtmpl_patch(&mgr, (uint8_t)id1, 4, data, sizeof(data))); }));
+	Written(&first, &last);
+	EXPECT_EQ(10 + 7, first);
+	EXPECT_EQ(10 + 19, last);
+	EXPECT_EQ(0, memcmp(&data[3], TxBuffer(10 + 7), 13));
+	// A patch of a template not yet written is kept for its first selection
+	Mark();
+	txtmpl_invalidate(&mgr);
+	EXPECT_EQ(0u, Xfers([&]() { txtmpl_patch(&mgr, (uint8_t)id0, 0, data, 10); }));
+	EXPECT_EQ(2u, Xfers([&]() { txtmpl_select(&mgr, (uint8_t)id0); }));
+	EXPECT_EQ(0, memcmp(data, TxBuffer(0), 10));
+}
+
+TEST_F(TxTemplate, BadArguments)
+{
+	int id = txtmpl_add(&mgr, frame, 12, 1);
+
+	EXPECT_EQ(DWT_ERROR, txtmpl_add(&mgr, frame, TXTMPL_FRAME_MAX + FCS_LEN + 1, 1));
+	EXPECT_EQ(DWT_ERROR, txtmpl_patch(&mgr, (uint8_t)id, 9, frame, 2));
+	EXPECT_EQ(DWT_ERROR, txtmpl_patch(&mgr, 1, 0, frame, 1));
+	EXPECT_EQ(DWT_ERROR, txtmpl_setlen(&mgr, (uint8_t)id, 13));
+	EXPECT_EQ(DWT_ERROR, txtmpl_select(&mgr, 1));
+}
+
+TEST_F(TxTemplate, SameAsFullRewrite)
+{
+	static const uint16_t kLen[] = { 12, 24, 40 };
+	std::mt19937 gen(5);
+	std::vector<std::vector<uint8_t>> frames;
+	std::vector<uint16_t> lens;
+	int rewrite = sim.AddDevice(uwbsim::NodeConfig());
+	uint64_t xfers = 0, rewrite_xfers = 0;
+
+	// Random patches and lengths sent from the templates on one device and written in full on the other:
+	// what goes on the air is the same
+	sim.Select(dev);
+	for (uint16_t len : kLen) {
+		frames.emplace_back(frame, frame + len - FCS_LEN);
+		lens.push_back(len);
+		ASSERT_LE(0, txtmpl_add(&mgr, frame, len, 1));
+	}
+	for (int step = 0; step < 500; step++) {
+		uint8_t id = (uint8_t)(gen() % 3);
+		std::vector<uint8_t> &f = frames[id];
+
+		// The last template has a variable length, the bytes beyond it are kept
+		if ((id == 2) && (gen() % 4 == 0))
+			lens[id] = (uint16_t)(12 + gen() % (kLen[2] - 11));
+		uint16_t len = lens[id];
+		uint16_t size = (uint16_t)(len - FCS_LEN);
+		uint16_t pos = (uint16_t)(gen() % size);
+		uint16_t n = (uint16_t)(1 + gen() % (size - pos));
+		std::vector<uint8_t> data(f.begin() + pos, f.begin() + pos + n);
+
+		for (unsigned k = gen() % 4; k > 0; k--)
+			data[gen() % n] = (uint8_t)gen();
+		std::copy(data.begin(), data.end(), f.begin() + pos);
+
+		sim.Select(dev);
+		xfers += Xfers([&]() {
+			ASSERT_EQ(DWT_SUCCESS, txtmpl_setlen(&mgr, id, len));
+			ASSERT_EQ(DWT_SUCCESS, txtmpl_patch(&mgr, id, pos, data.data(), n));
+			ASSERT_EQ(DWT_SUCCESS, txtmpl_select(&mgr, id));
+		});
+		sim.Select(rewrite);
+		rewrite_xfers += Xfers([&]() {
+			dwt_writetxdata(size, f.data(), mgr.tmpl[id].offset);
+			dwt_writetxfctrl(len, mgr.tmpl[id].offset, 1);
+		});
+
+		uint64_t fctrl = sim.Peek(dev, TX_FCTRL_ID, 4) & (TX_FCTRL_TXFLEN_BIT_MASK | TX_FCTRL_TXB_OFFSET_BIT_MASK | TX_FCTRL_TR_BIT_MASK);
+		ASSERT_EQ(sim.Peek(rewrite, TX_FCTRL_ID, 4) & (TX_FCTRL_TXFLEN_BIT_MASK | TX_FCTRL_TXB_OFFSET_BIT_MASK | TX_FCTRL_TR_BIT_MASK), fctrl)
+			<< "step " << step;
+		ASSERT_EQ(0, memcmp(sim.Reg(rewrite, TX_BUFFER_ID) + mgr.tmpl[id].offset, TxBuffer(mgr.tmpl[id].offset), size))
+			<< "step " << step;
+	}
+	EXPECT_LT(xfers, rewrite_xfers);
+}
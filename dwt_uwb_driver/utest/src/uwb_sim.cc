@@ -0,0 +1,905 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+#include "uwb_sim.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+extern "C"
+{
+#include "deca_timestamp.h"
+#include "dw3000_deca_regs.h"
+#include "dw3000_deca_vals.h"
+}
+
+extern const struct dwt_driver_s dw3000_driver;
+
+namespace uwbsim {
+
+const double Sim::kSpeedOfLight = 299702547.0;
+
+static const size_t kFileLen = 0x800;
+static const uint64_t kHalfPeriod = 1ULL << 39;
+static const double kUus = 65536.0; // DTU per UWB microsecond
+
+/* Fast commands */
+enum {
+	kCmdTxRxOff = 0x0,
+	kCmdTx = 0x1,
+	kCmdRx = 0x2,
+	kCmdDtx = 0x3,
+	kCmdDrx = 0x4,
+	kCmdDtxRef = 0x9,
+	kCmdDrxRef = 0xA,
+	kCmdCcaTx = 0xB,
+	kCmdTxW4r = 0xC,
+	kCmdDtxW4r = 0xD,
+	kCmdDtxRefW4r = 0x10,
+	kCmdCcaTxW4r = 0x11,
+	kCmdClrIrqs = 0x12,
+	kCmdDbToggle = 0x13,
+};
+
+/* SAR inputs, AON memory */
+enum {
+	kSarVbat = 1,
+	kSarTemp = 2,
+	kAonLen = 0x200,
+	kAonSlpCntCalRun = 0x04,
+};
+
+/* TSE state in SYS_STATE_LO byte 2 */
+enum {
+	kTseIdle = 0x03,
+	kTseTx = 0x08,
+	kTseRx = 0x12,
+};
+
+static const uint32_t kStatusTxDone = SYS_STATUS_TXFRB_BIT_MASK | SYS_STATUS_TXPRS_BIT_MASK | SYS_STATUS_TXPHS_BIT_MASK |
+				      SYS_STATUS_TXFRS_BIT_MASK;
+static const uint32_t kStatusRxGood = SYS_STATUS_RXPRD_BIT_MASK | SYS_STATUS_RXSFDD_BIT_MASK | SYS_STATUS_RXPHD_BIT_MASK |
+				      SYS_STATUS_RXFR_BIT_MASK | SYS_STATUS_RXFCG_BIT_MASK | SYS_STATUS_CIADONE_BIT_MASK;
+
+static Sim *g_sim;
+
+static int32_t sim_readfromspi(uint16_t hlen, uint8_t *hdr, uint16_t len, uint8_t *buf)
+{
+	return g_sim->SpiRead(hlen, hdr, len, buf);
+}
+
+static int32_t sim_writetospi(uint16_t hlen, const uint8_t *hdr, uint16_t len, const uint8_t *buf)
+{
+	return g_sim->SpiWrite(hlen, hdr, len, buf);
+}
+
+static int32_t sim_writetospiwithcrc(uint16_t hlen, const uint8_t *hdr, uint16_t len, const uint8_t *buf, uint8_t crc8)
+{
+	(void)crc8;
+	return g_sim->SpiWrite(hlen, hdr, len, buf);
+}
+
+static void sim_nop(void)
+{
+}
+
+/* A frame on the air, times at the transmitter antenna */
+struct AirFrame {
+	int src;
+	std::vector<uint8_t> data;       // Including the FCS
+	bool ranging;
+	double start;                    // First preamble symbol
+	double rmarker;
+	double end;
+};
+
+struct Device {
+	enum class State { kIdle, kTxWait, kTx, kRxWait, kRx, kRxFrame };
+
+	Sim *sim;
+	int index;
+	NodeConfig config;
+	struct dwchip_s chip;
+	struct dwt_spi_s spi;
+	uint64_t priv[128];
+	uint8_t regs[32][kFileLen];
+	uint8_t aon[kAonLen];
+	State state = State::kIdle;
+	uint64_t epoch = 0;              // Incremented on every state change, stale events are dropped
+	uint64_t sar_epoch = 0;          // Incremented on every SAR start or stop
+	uint64_t otp_reads = 0;
+	bool txerr = false;
+	double rx_on = 0.0;
+	unsigned rx_buf = 0;             // Double buffering: buffer the next frame is received into,
+	unsigned host_buf = 0;           // buffer the host accesses,
+	bool buf_full[2] = { false, false }; // and buffers holding a frame not released by the host
+
+	Device(Sim *s, int i, const NodeConfig &c) : sim(s), index(i), config(c)
+	{
+		memset(&chip, 0, sizeof(chip));
+		memset(&spi, 0, sizeof(spi));
+		memset(priv, 0, sizeof(priv));
+		memset(regs, 0, sizeof(regs));
+		memset(aon, 0, sizeof(aon));
+		spi.readfromspi = sim_readfromspi;
+		spi.writetospi = sim_writetospi;
+		spi.writetospiwithcrc = sim_writetospiwithcrc;
+		spi.setslowrate = sim_nop;
+		spi.setfastrate = sim_nop;
+		Put(DEV_ID_ID, (uint32_t)DWT_DW3000_DEV_ID, 4);
+		Put(SYS_CFG_ID, SYS_CFG_DIS_DRXB_BIT_MASK, 4);
+	}
+
+	uint8_t *Reg(uint32_t id)
+	{
+		return &regs[(id >> 16) & 0x1F][id & 0xFFFF];
+	}
+	uint64_t Get(uint32_t id, unsigned len)
+	{
+		uint64_t v = 0;
+
+		for (unsigned i = len; i > 0; i--)
+			v = (v << 8) | Reg(id)[i - 1];
+		return v;
+	}
+	void Put(uint32_t id, uint64_t v, unsigned len)
+	{
+		for (unsigned i = 0; i < len; i++)
+			Reg(id)[i] = (uint8_t)(v >> (8 * i));
+	}
+	uint32_t Status()
+	{
+		return (uint32_t)Get(SYS_STATUS_ID, 4);
+	}
+	void SetStatus(uint32_t bits)
+	{
+		Put(SYS_STATUS_ID, Status() | bits, 4);
+	}
+	bool Irq()
+	{
+		return ((Status() & (uint32_t)Get(SYS_ENABLE_LO_ID, 4)) != 0) ||
+		       ((Get(SYS_STATUS_HI_ID, 2) & Get(SYS_ENABLE_HI_ID, 2)) != 0);
+	}
+
+	double Rate() const
+	{
+		return TS40_DTU_PER_S * (1.0 + config.ppm * 1e-6);
+	}
+	/* Unwrapped system counter at true time t */
+	double LocalAt(double t) const
+	{
+		return (double)config.counter0 + t * Rate();
+	}
+	/* True time of an unwrapped system counter value */
+	double TrueAt(double local) const
+	{
+		return (local - (double)config.counter0) / Rate();
+	}
+	/*
+	 * Unwrapped counter value of a 40-bit time, taken in the next half period.
+	 * Returns false if it is in the previous half period (the device sets HPDWARN).
+	 */
+	bool Upcoming(uint64_t ts, double *local)
+	{
+		uint64_t now = (uint64_t)LocalAt(sim->now_);
+		uint64_t delta = (ts - now) & TS40_MASK;
+
+		*local = (double)now + (double)delta;
+		return delta < kHalfPeriod;
+	}
+
+	void Refresh()
+	{
+		uint64_t now = (uint64_t)LocalAt(sim->now_) & TS40_MASK;
+		uint32_t status = Status();
+		uint8_t fint = 0;
+		uint32_t sys_state;
+
+		Put(SYS_TIME_ID, (now >> 8) & ~1ULL, 4);
+		if ((status & kStatusTxDone) != 0)
+			fint |= FINT_STAT_TXOK_BIT_MASK;
+		if ((status & SYS_STATUS_RXFCG_BIT_MASK) != 0)
+			fint |= FINT_STAT_RXOK_BIT_MASK;
+		if ((status & SYS_STATUS_ALL_RX_ERR) != 0)
+			fint |= FINT_STAT_RXERR_BIT_MASK;
+		if ((status & (SYS_STATUS_RXFTO_BIT_MASK | SYS_STATUS_RXPTO_BIT_MASK)) != 0)
+			fint |= FINT_STAT_RXTO_BIT_MASK;
+		Put(FINT_STAT_ID, fint, 1);
+
+		if (txerr)
+			sys_state = DW_SYS_STATE_TXERR;
+		else if ((state == State::kTxWait) || (state == State::kTx))
+			sys_state = (uint32_t)kTseTx << 16;
+		else if (state == State::kIdle)
+			sys_state = (uint32_t)kTseIdle << 16;
+		else
+			sys_state = (uint32_t)kTseRx << 16;
+		Put(SYS_STATE_LO_ID, sys_state, 4);
+		Pll();
+	}
+
+	/* Lock and VCO tune flags of the automotive PLL calibration, while it drives the PLL of a channel */
+	void Pll()
+	{
+		uint32_t rf = (uint32_t)Get(RF_ENABLE_ID, 4);
+		uint32_t cc = (uint32_t)Get(PLL_COARSE_CODE_ID, 4);
+		uint32_t code, lock;
+		uint8_t rf_status;
+
+		if (rf == RF_EN_CH5) {
+			code = (cc & PLL_COARSE_CODE_CH5_VCO_COARSE_TUNE_BIT_MASK) >> 8;
+			lock = config.pll_ch5_coarse;
+			if (code == lock)
+				rf_status = RF_STATUS_PLL1_LO_FLAG_BIT_MASK | RF_STATUS_PLL1_LOCK_BIT_MASK;
+			else if (code > lock)
+				rf_status = RF_STATUS_PLL1_HI_FLAG_BIT_MASK | RF_STATUS_PLL1_LO_FLAG_BIT_MASK;
+			else
+				rf_status = 0;
+			Put(PLL_STATUS_ID, PLL_STATUS_XTAL_AMP_SETTLED_BIT_MASK | ((code == lock) ? (PLL_STATUS_PLL_LO_FLAG_N_BIT_MASK | PLL_STATUS_PLL_LOCK_FLAG_BIT_MASK) : 0), 1);
+		} else if (rf == RF_EN_CH9) {
+			code = (((cc & PLL_COARSE_CODE_CH9_RVCO_FREQ_BOOST_BIT_MASK) != 0) ? 0x20 : 0) | (cc & PLL_COARSE_CODE_CH9_VCO_COARSE_TUNE_BIT_MASK);
+			lock = config.pll_ch9_coarse;
+			if (code == lock)
+				rf_status = RF_STATUS_PLL1_MID_FLAG_BIT_MASK | RF_STATUS_PLL1_LO_FLAG_BIT_MASK | RF_STATUS_PLL1_LOCK_BIT_MASK;
+			else if (code > lock)
+				rf_status = RF_STATUS_PLL1_MID_FLAG_BIT_MASK | RF_STATUS_PLL1_HI_FLAG_BIT_MASK | RF_STATUS_PLL1_LO_FLAG_BIT_MASK;
+			else
+				rf_status = RF_STATUS_PLL1_LO_FLAG_BIT_MASK;
+			Put(PLL_STATUS_ID, PLL_STATUS_XTAL_AMP_SETTLED_BIT_MASK |
+						   ((code == lock) ? (PLL_STATUS_VCO_TUNE_UPDATE_BIT_MASK | PLL_STATUS_PLL_LO_FLAG_N_BIT_MASK |
+								      PLL_STATUS_PLL_LOCK_FLAG_BIT_MASK | PLL_STATUS_CPC_CAL_DONE_BIT_MASK) : 0), 1);
+		} else {
+			return;
+		}
+		Put(RF_STATUS_ID, rf_status, 1);
+	}
+
+	/* Register file and offset of an access, through the indirect pointers */
+	uint8_t *Map(unsigned file, unsigned off, unsigned len)
+	{
+		if (file == (INDIRECT_POINTER_A_ID >> 16)) {
+			file = (unsigned)Get(INDIRECT_ADDR_A_ID, 4) & 0x1F;
+			off += (unsigned)Get(ADDR_OFFSET_A_ID, 4);
+		} else if (file == (INDIRECT_POINTER_B_ID >> 16)) {
+			file = (unsigned)Get(INDIRECT_ADDR_B_ID, 4) & 0x1F;
+			off += (unsigned)Get(ADDR_OFFSET_B_ID, 4);
+		}
+		EXPECT_LE(off + len, kFileLen) << "device " << index << " access out of register file " << file;
+		return (off + len <= kFileLen) ? &regs[file][off] : nullptr;
+	}
+
+	void Read(unsigned file, unsigned off, uint16_t len, uint8_t *buf)
+	{
+		uint8_t *p;
+
+		Refresh();
+		p = Map(file, off, len);
+		if (p != nullptr)
+			memcpy(buf, p, len);
+	}
+
+	void Write(unsigned file, unsigned off, unsigned mode, uint16_t len, const uint8_t *buf)
+	{
+		uint8_t *p;
+		unsigned width = (mode == 0) ? len : (1U << (mode - 1));
+
+		if ((mode != 0) && (len != 2 * width)) {
+			ADD_FAILURE() << "AND/OR access of " << len << " bytes";
+			return;
+		}
+		p = Map(file, off, width);
+		if (p == nullptr)
+			return;
+		for (unsigned i = 0; i < width; i++) {
+			unsigned at = off + i;
+			uint8_t v = (mode == 0) ? buf[i] : (uint8_t)((p[i] & buf[i]) | buf[width + i]);
+
+			// SYS_STATUS, SYS_STATUS_HI, RDB_STATUS and RX_CAL_STS are write one to clear
+			if ((file == 0) && (at >= (SYS_STATUS_ID & 0xFFFF)) && (at < (SYS_STATUS_HI_ID & 0xFFFF) + 4))
+				p[i] &= (uint8_t)~v;
+			else if ((file == (RDB_STATUS_ID >> 16)) && (at == (RDB_STATUS_ID & 0xFFFF)))
+				p[i] &= (uint8_t)~v;
+			else if ((file == (RX_CAL_STS_ID >> 16)) && (at == (RX_CAL_STS_ID & 0xFFFF)))
+				p[i] &= (uint8_t)~v;
+			else
+				p[i] = v;
+		}
+		Analog(((uint32_t)file << 16) | off);
+		// Disabling double buffering resets the buffer pointers
+		if ((file == 0) && ((Get(SYS_CFG_ID, 4) & SYS_CFG_DIS_DRXB_BIT_MASK) != 0)) {
+			rx_buf = 0;
+			host_buf = 0;
+			buf_full[0] = false;
+			buf_full[1] = false;
+		}
+	}
+
+	uint32_t Otp(uint16_t address) const
+	{
+		auto it = config.otp.find(address);
+
+		return (it != config.otp.end()) ? it->second : 0;
+	}
+
+	/* AON memory access strobed in AON_CTRL, writes above 0xFF select the high page with WRITE_HI_EN */
+	void Aon()
+	{
+		uint8_t ctrl = (uint8_t)Get(AON_CTRL_ID, 1);
+		uint16_t addr = (uint16_t)Get(AON_ADDR_ID, 2);
+
+		if ((ctrl & AON_CTRL_DCA_ENAB_BIT_MASK) == 0)
+			return;
+		if ((ctrl & AON_CTRL_DCA_READ_EN_BIT_MASK) != 0)
+			Put(AON_RDATA_ID, aon[addr % kAonLen], 1);
+		if ((ctrl & AON_CTRL_DCA_WRITE_EN_BIT_MASK) != 0) {
+			addr = (uint16_t)((addr & 0xFF) | (((ctrl & AON_CTRL_DCA_WRITE_HI_EN_BIT_MASK) != 0) ? 0x100 : 0));
+			aon[addr] = (uint8_t)Get(AON_WDATA_ID, 1);
+			if ((addr == AON_SLPCNT_CAL_CTRL) && ((aon[addr] & kAonSlpCntCalRun) != 0)) {
+				aon[AON_SLPCNT_CAL_LO] = (uint8_t)config.lposc_cal;
+				aon[AON_SLPCNT_CAL_HI] = (uint8_t)(config.lposc_cal >> 8);
+			}
+		}
+	}
+
+	/* SAR_CTRL written: a start converts the selected input, clearing it stops the SAR */
+	void Sar()
+	{
+		uint32_t ctrl = (uint32_t)Get(SAR_CTRL_ID, 4);
+		unsigned mux = (ctrl >> SAR_CTRL_SAR_FORCE_SEL_BIT_OFFSET) & 0xF;
+		uint64_t e = ++sar_epoch;
+
+		Put(SAR_STATUS_ID, 0, 1);
+		if ((ctrl & SAR_CTRL_SAR_START_BIT_MASK) == 0)
+			return;
+		sim->Schedule(sim->now_ + sim->timing_.sar_s, [this, e, mux]() {
+			if (sar_epoch != e)
+				return;
+			Put(SAR_READING_ID, (mux == kSarTemp) ? config.sar_temp : ((mux == kSarVbat) ? config.sar_vbat : 0), 1);
+			Put(SAR_STATUS_ID, SAR_STATUS_SAR_DONE_BIT_MASK, 1);
+		});
+	}
+
+	/* Effects of a write to register id: OTP reads and kicks, PLL and PGF calibrations, SAR and AON */
+	void Analog(uint32_t id)
+	{
+		if (id == OTP_CFG_ID) {
+			uint32_t cfg = (uint32_t)Get(OTP_CFG_ID, 4);
+
+			if ((cfg & OTP_CFG_OTP_READ_BIT_MASK) != 0) {
+				Put(OTP_RDATA_ID, Otp((uint16_t)Get(OTP_ADDR_ID, 2)), 4);
+				otp_reads++;
+			}
+			// Words not programmed in OTP leave the registers unchanged
+			if ((cfg & OTP_CFG_LDO_KICK_BIT_MASK) != 0) {
+				if (Otp(kOtpLdoTuneLo) != 0)
+					Put(LDO_TUNE_LO_ID, Otp(kOtpLdoTuneLo), 4);
+				if (Otp(kOtpLdoTuneHi) != 0)
+					Put(LDO_TUNE_HI_ID, Otp(kOtpLdoTuneHi), 4);
+			}
+			// The read strobe and kicks clear themselves
+			Put(OTP_CFG_ID, cfg & ~(OTP_CFG_OTP_READ_BIT_MASK | LDO_BIAS_KICK), 4);
+		} else if ((id == PLL_CAL_ID) && ((Get(PLL_CAL_ID, 4) & PLL_CAL_PLL_CAL_EN_BIT_MASK) != 0)) {
+			SetStatus(SYS_STATUS_CP_LOCK_BIT_MASK);
+		} else if ((id == RX_CAL_CFG_ID) && ((Get(RX_CAL_CFG_ID, 1) & RX_CAL_CFG_CAL_EN_BIT_MASK) != 0)) {
+			Put(RX_CAL_STS_ID, 1, 1);
+		} else if (id == SAR_CTRL_ID) {
+			Sar();
+		} else if (id == AON_CTRL_ID) {
+			Aon();
+		}
+	}
+
+	void Command(unsigned cmd)
+	{
+		switch (cmd) {
+		case kCmdTxRxOff:
+			state = State::kIdle;
+			txerr = false;
+			epoch++;
+			break;
+		case kCmdTx:
+		case kCmdCcaTx:
+			StartTx(false, 0, false);
+			break;
+		case kCmdTxW4r:
+		case kCmdCcaTxW4r:
+			StartTx(false, 0, true);
+			break;
+		case kCmdDtx:
+		case kCmdDtxW4r:
+			StartTx(true, DelayedTime(false), cmd == kCmdDtxW4r);
+			break;
+		case kCmdDtxRef:
+		case kCmdDtxRefW4r:
+			StartTx(true, DelayedTime(true), cmd == kCmdDtxRefW4r);
+			break;
+		case kCmdRx:
+			RxOn();
+			break;
+		case kCmdDrx:
+		case kCmdDrxRef:
+			StartDelayedRx(DelayedTime(cmd == kCmdDrxRef));
+			break;
+		case kCmdClrIrqs:
+			Put(SYS_STATUS_ID, 0, 4);
+			Put(SYS_STATUS_HI_ID, 0, 2);
+			break;
+		case kCmdDbToggle:
+			buf_full[host_buf] = false;
+			host_buf ^= 1U;
+			break;
+		default:
+			ADD_FAILURE() << "device " << index << ": fast command " << cmd << " not simulated";
+			break;
+		}
+	}
+
+	/* Time programmed for a delayed TX or RX, the low bit of DX_TIME and DREF_TIME is ignored */
+	uint64_t DelayedTime(bool ref)
+	{
+		uint32_t t = (uint32_t)Get(DX_TIME_ID, 4) & ~1UL;
+
+		if (ref)
+			t += (uint32_t)Get(DREF_TIME_ID, 4) & ~1UL;
+		return ((uint64_t)t << 8) & TS40_MASK;
+	}
+
+	double Preamble() const
+	{
+		return (sim->phy_.preamble_symbols + sim->phy_.sfd_symbols) * sim->phy_.symbol_s;
+	}
+	double Payload(size_t len) const
+	{
+		size_t bits = len * 8;
+
+		// Reed-Solomon: 48 parity bits per block of up to 330 bits
+		bits += 48 * ((bits + 329) / 330);
+		return sim->phy_.phr_s + (double)bits * sim->phy_.data_bit_s;
+	}
+
+	void StartTx(bool delayed, uint64_t ts, bool w4r)
+	{
+		double now = LocalAt(sim->now_);
+		double rmarker;
+		uint32_t fctrl = (uint32_t)Get(TX_FCTRL_ID, 4);
+		unsigned len = fctrl & TX_FCTRL_TXFLEN_BIT_MASK;
+		unsigned offset = (fctrl & TX_FCTRL_TXB_OFFSET_BIT_MASK) >> TX_FCTRL_TXB_OFFSET_BIT_OFFSET;
+		auto frame = std::make_shared<AirFrame>();
+
+		if (delayed) {
+			// The device checks the delayed time on every command
+			Put(SYS_STATUS_ID + 3, Get(SYS_STATUS_ID + 3, 1) & ~(SYS_STATUS_HPDWARN_BIT_MASK >> 24), 1);
+			if (!Upcoming(ts, &rmarker)) {
+				Reg(SYS_STATUS_ID)[3] |= (uint8_t)(SYS_STATUS_HPDWARN_BIT_MASK >> 24);
+				return;
+			}
+			if (rmarker - Preamble() * Rate() < now) {
+				txerr = true;
+				return;
+			}
+		} else {
+			// Transmissions start on the 125 MHz clock, 512 DTU
+			rmarker = std::ceil((now + (sim->timing_.tx_start_s + Preamble()) * Rate()) / 512.0) * 512.0;
+		}
+		// Offsets above 127 are programmed plus 128
+		if (offset >= 256)
+			offset -= 128;
+		if ((len < FCS_LEN) || (offset + len - FCS_LEN > kFileLen)) {
+			ADD_FAILURE() << "device " << index << ": bad TX frame length " << len << " offset " << offset;
+			return;
+		}
+		frame->src = index;
+		frame->data.assign(&regs[TX_BUFFER_ID >> 16][offset], &regs[TX_BUFFER_ID >> 16][offset + len - FCS_LEN]);
+		frame->data.resize(len, 0);
+		frame->ranging = (fctrl & TX_FCTRL_TR_BIT_MASK) != 0;
+		frame->rmarker = TrueAt(rmarker) + config.tx_antenna_dtu / TS40_DTU_PER_S;
+		frame->start = frame->rmarker - Preamble();
+		frame->end = frame->rmarker + Payload(len);
+
+		state = State::kTxWait;
+		uint64_t e = ++epoch;
+		uint64_t tx_time = ((uint64_t)rmarker + Get(TX_ANTD_ID, 2)) & TS40_MASK;
+
+		sim->Schedule(frame->start, [this, e, frame]() {
+			if (epoch == e) {
+				state = State::kTx;
+				sim->Transmit(index, frame);
+			}
+		});
+		sim->Schedule(frame->end, [this, e, tx_time, w4r]() {
+			if (epoch != e)
+				return;
+			Put(TX_TIME_LO_ID, tx_time, 5);
+			SetStatus(kStatusTxDone);
+			state = State::kIdle;
+			if (w4r) {
+				double on = LocalAt(sim->now_) + (double)(Get(ACK_RESP_ID, 4) & ACK_RESP_W4R_TIM_BIT_MASK) * kUus;
+
+				state = State::kRxWait;
+				uint64_t e2 = ++epoch;
+				sim->Schedule(TrueAt(on), [this, e2]() {
+					if (epoch == e2)
+						RxOn();
+				});
+			}
+		});
+	}
+
+	void StartDelayedRx(uint64_t ts)
+	{
+		double on;
+
+		Put(SYS_STATUS_ID + 3, Get(SYS_STATUS_ID + 3, 1) & ~(SYS_STATUS_HPDWARN_BIT_MASK >> 24), 1);
+		if (!Upcoming(ts, &on)) {
+			Reg(SYS_STATUS_ID)[3] |= (uint8_t)(SYS_STATUS_HPDWARN_BIT_MASK >> 24);
+			return;
+		}
+		state = State::kRxWait;
+		uint64_t e = ++epoch;
+		sim->Schedule(TrueAt(on), [this, e]() {
+			if (epoch == e)
+				RxOn();
+		});
+	}
+
+	void RxOn()
+	{
+		state = State::kRx;
+		rx_on = sim->now_;
+		uint64_t e = ++epoch;
+
+		if ((Get(SYS_CFG_ID, 2) & SYS_CFG_RXWTOE_BIT_MASK) != 0) {
+			double timeout = (double)(Get(RX_FWTO_ID, 4) & 0xFFFFF) * kUus;
+
+			sim->Schedule(TrueAt(LocalAt(sim->now_) + timeout), [this, e]() {
+				if (epoch == e) {
+					state = State::kIdle;
+					epoch++;
+					SetStatus(SYS_STATUS_RXFTO_BIT_MASK);
+				}
+			});
+		}
+		// Frames whose preamble is already on the air
+		for (auto &f : sim->air_) {
+			if (f->src != index)
+				TryAcquire(f);
+		}
+	}
+
+	/* Schedule the acquisition of a frame if the receiver is on early enough */
+	void TryAcquire(const std::shared_ptr<AirFrame> &f)
+	{
+		double tof = sim->Tof(f->src, index);
+		double t = std::max(f->start + tof, rx_on) + sim->phy_.acquire_symbols * sim->phy_.symbol_s;
+		uint64_t e = epoch;
+
+		if ((state != State::kRx) || (t > f->rmarker + tof - sim->phy_.sfd_symbols * sim->phy_.symbol_s))
+			return;
+		sim->Schedule(t, [this, e, f, tof]() {
+			if ((epoch != e) || (state != State::kRx))
+				return;
+			if ((sim->channel_.loss > 0.0) && (std::uniform_real_distribution<double>(0.0, 1.0)(sim->rng_) < sim->channel_.loss))
+				return;
+			state = State::kRxFrame;
+			uint64_t e2 = ++epoch;
+			sim->Schedule(f->end + tof, [this, e2, f, tof]() {
+				if (epoch == e2)
+					Receive(*f, f->rmarker + tof);
+			});
+		});
+	}
+
+	void Receive(const AirFrame &f, double rmarker)
+	{
+		const Device &tx = *sim->devices_[f.src];
+		double local = LocalAt(rmarker + config.rx_antenna_dtu / TS40_DTU_PER_S);
+		double ratio = (1.0 + tx.config.ppm * 1e-6) / (1.0 + config.ppm * 1e-6) - 1.0;
+		int64_t rx_time;
+
+		if (sim->channel_.ts_noise_dtu > 0.0)
+			local += std::normal_distribution<double>(0.0, sim->channel_.ts_noise_dtu)(sim->rng_);
+		rx_time = (int64_t)std::llround(local) - (int64_t)Get(CIA_CONF_ID, 2);
+
+		uint32_t cfg = (uint32_t)Get(SYS_CFG_ID, 4);
+		bool dbl = (cfg & SYS_CFG_DIS_DRXB_BIT_MASK) == 0;
+		uint64_t finfo = f.data.size() | (f.ranging ? RX_FINFO_RNG_BIT_MASK : 0);
+		// Clock offset as a q5.26 on 13 bits, carrier integrator as on channel 5 (-32 / 13 of a q0.32)
+		uint64_t clkofs = (uint64_t)std::lround(ratio * (1 << 26)) & 0x1FFF;
+		bool stored = true;
+
+		if (!dbl) {
+			memcpy(Reg(RX_BUFFER_0_ID), f.data.data(), f.data.size());
+			Put(RX_FINFO_ID, finfo, 4);
+			Put(RX_TIME_0_ID, (uint64_t)rx_time & TS40_MASK, 5);
+			Put(IP_TOA_LO_ID, (uint64_t)rx_time & TS40_MASK, 5);
+			Put(CIA_DIAG_0_ID, clkofs, 2);
+		} else if (!buf_full[rx_buf]) {
+			// Frame and swinging set of the buffer, its events in RDB_STATUS
+			uint32_t set = (rx_buf != 0) ? (uint32_t)(BUF1_RX_FINFO - BUF0_RX_FINFO) : 0;
+
+			memcpy(Reg((rx_buf != 0) ? RX_BUFFER_1_ID : RX_BUFFER_0_ID), f.data.data(), f.data.size());
+			Put(BUF0_RX_FINFO + set, finfo, 4);
+			Put(BUF0_RX_TIME + set, (uint64_t)rx_time & TS40_MASK, 5);
+			Put(BUF0_IP_TS + set, (uint64_t)rx_time & TS40_MASK, 5);
+			Put(BUF0_CIA_DIAG_0 + set, clkofs, 2);
+			Reg(RDB_STATUS_ID)[0] |= (uint8_t)((RDB_STATUS_RXFCG0_BIT_MASK | RDB_STATUS_RXFR0_BIT_MASK |
+							   RDB_STATUS_CIADONE0_BIT_MASK) << (4 * rx_buf));
+			buf_full[rx_buf] = true;
+			rx_buf ^= 1U;
+		} else {
+			// Both buffers hold frames the host has not released: the frame is lost
+			stored = false;
+		}
+		if (stored) {
+			Put(DRX_DIAG3_ID, (uint64_t)std::llround(-ratio * 4294967296.0 * 13.0 / 32.0) & 0x1FFFFF, 3);
+			SetStatus(kStatusRxGood);
+			sim->frames_received_++;
+		}
+		// The receiver is re-enabled after a good frame with double buffering only
+		if (dbl && ((cfg & SYS_CFG_RXAUTR_BIT_MASK) != 0)) {
+			RxOn();
+		} else {
+			state = State::kIdle;
+			epoch++;
+		}
+	}
+};
+
+dwt_config_t DefaultConfig(uint8_t chan)
+{
+	dwt_config_t config = {};
+
+	config.chan = chan;
+	config.txPreambLength = DWT_PLEN_128;
+	config.rxPAC = DWT_PAC8;
+	config.txCode = 9;
+	config.rxCode = 9;
+	config.sfdType = DWT_SFD_DW_8;
+	config.dataRate = DWT_BR_6M8;
+	config.phrMode = DWT_PHRMODE_STD;
+	config.phrRate = DWT_PHRRATE_STD;
+	config.sfdTO = 129;
+	config.stsMode = DWT_STS_MODE_OFF;
+	config.stsLength = DWT_STS_LEN_64;
+	config.pdoaMode = DWT_PDOA_M0;
+	return config;
+}
+
+Sim::Sim(const Phy &phy, const Timing &timing, const Channel &channel)
+	: phy_(phy), timing_(timing), channel_(channel), rng_(channel.seed)
+{
+	g_sim = this;
+	saved_dw_ = dwt_update_dw(NULL);
+	(void)dwt_update_dw(saved_dw_);
+}
+
+Sim::~Sim()
+{
+	(void)dwt_update_dw(saved_dw_);
+	g_sim = nullptr;
+}
+
+int Sim::AddDevice(const NodeConfig &config)
+{
+	static const struct dwt_driver_s *drivers[] = { &dw3000_driver };
+	int index = (int)devices_.size();
+	struct dwt_probe_s probe;
+
+	devices_.emplace_back(new Device(this, index, config));
+	Device &d = *devices_.back();
+
+	cur_ = index;
+	memset(&probe, 0, sizeof(probe));
+	probe.dw = &d.chip;
+	probe.spi = &d.spi;
+	probe.wakeup_device_with_io = sim_nop;
+	probe.driver_list = (struct dwt_driver_s **)drivers;
+	probe.dw_driver_num = 1;
+	EXPECT_EQ(DWT_SUCCESS, dwt_probe(&probe));
+	// dwt_initialise() would give the driver its single static local data, each device has its own
+	d.chip.priv = d.priv;
+	Select(index);
+	return index;
+}
+
+void Sim::Select(int dev)
+{
+	cur_ = dev;
+	(void)dwt_update_dw(&devices_[dev]->chip);
+}
+
+dwchip_t *Sim::Chip(int dev)
+{
+	return &devices_[dev]->chip;
+}
+
+NodeConfig &Sim::Node(int dev)
+{
+	return devices_[dev]->config;
+}
+
+uint64_t Sim::OtpReads(int dev) const
+{
+	return devices_[dev]->otp_reads;
+}
+
+uint8_t *Sim::Reg(int dev, uint32_t id)
+{
+	return devices_[dev]->Reg(id);
+}
+
+uint64_t Sim::Peek(int dev, uint32_t id, unsigned len)
+{
+	return devices_[dev]->Get(id, len);
+}
+
+void Sim::Poke(int dev, uint32_t id, uint64_t v, unsigned len)
+{
+	devices_[dev]->Put(id, v, len);
+}
+
+uint8_t *Sim::Aon(int dev)
+{
+	return devices_[dev]->aon;
+}
+
+std::vector<uint8_t> Sim::Save(int dev)
+{
+	const uint8_t *p = &devices_[dev]->regs[0][0];
+
+	return std::vector<uint8_t>(p, p + sizeof(devices_[dev]->regs));
+}
+
+void Sim::Load(int dev, const std::vector<uint8_t> &image)
+{
+	ASSERT_EQ(sizeof(devices_[dev]->regs), image.size());
+	memcpy(devices_[dev]->regs, image.data(), image.size());
+}
+
+void Sim::At(double t, int dev, std::function<void()> fn)
+{
+	actions_.push_back({ t, order_++, [this, dev, fn]() {
+				    Select(dev);
+				    fn();
+			    } });
+	std::push_heap(actions_.begin(), actions_.end(), std::greater<Event>());
+}
+
+void Sim::SetExcessDelay(int a, int b, double seconds)
+{
+	excess_[{ std::min(a, b), std::max(a, b) }] = seconds;
+}
+
+double Sim::Distance(int a, int b) const
+{
+	const NodeConfig &p = devices_[a]->config;
+	const NodeConfig &q = devices_[b]->config;
+
+	return std::sqrt((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) + (p.z - q.z) * (p.z - q.z));
+}
+
+double Sim::Tof(int a, int b) const
+{
+	auto it = excess_.find({ std::min(a, b), std::max(a, b) });
+
+	return Distance(a, b) / kSpeedOfLight + ((it != excess_.end()) ? it->second : 0.0);
+}
+
+void Sim::Schedule(double t, std::function<void()> fn)
+{
+	events_.push_back({ std::max(t, now_), order_++, fn });
+	std::push_heap(events_.begin(), events_.end(), std::greater<Event>());
+}
+
+void Sim::Advance(double t)
+{
+	while (!events_.empty() && (events_.front().t <= t)) {
+		Event ev = events_.front();
+
+		std::pop_heap(events_.begin(), events_.end(), std::greater<Event>());
+		events_.pop_back();
+		now_ = ev.t;
+		ev.fn();
+	}
+	now_ = std::max(now_, t);
+}
+
+void Sim::Transmit(int src, std::shared_ptr<AirFrame> frame)
+{
+	frames_sent_++;
+	// Frames which have left the air cannot be acquired any more
+	air_.erase(std::remove_if(air_.begin(), air_.end(),
+				  [this](const std::shared_ptr<AirFrame> &f) { return f->end + 1e-3 < now_; }),
+		   air_.end());
+	air_.push_back(frame);
+	for (auto &d : devices_) {
+		if (d->index == src)
+			continue;
+		Device *rx = d.get();
+		Schedule(frame->start + Tof(src, rx->index), [rx, frame]() { rx->TryAcquire(frame); });
+	}
+}
+
+void Sim::SpiCost(uint16_t bytes)
+{
+	spi_xfers_++;
+	Advance(now_ + timing_.spi_xfer_s + bytes * 8.0 / timing_.spi_hz);
+}
+
+int32_t Sim::SpiRead(uint16_t hlen, const uint8_t *hdr, uint16_t len, uint8_t *buf)
+{
+	unsigned file = (hdr[0] >> 1) & 0x1F;
+	unsigned off = (hlen > 1) ? (((hdr[0] & 1U) << 6) | (hdr[1] >> 2)) : 0;
+
+	SpiCost((uint16_t)(hlen + len));
+	devices_[cur_]->Read(file, off, len, buf);
+	return DWT_SUCCESS;
+}
+
+int32_t Sim::SpiWrite(uint16_t hlen, const uint8_t *hdr, uint16_t len, const uint8_t *buf)
+{
+	Device &d = *devices_[cur_];
+
+	SpiCost((uint16_t)(hlen + len));
+	if ((hlen == 1) && ((hdr[0] & 1U) != 0))
+		d.Command((hdr[0] >> 1) & 0x1F);
+	else if (hlen == 1)
+		d.Write((hdr[0] >> 1) & 0x1F, 0, 0, len, buf);
+	else
+		d.Write((hdr[0] >> 1) & 0x1F, ((hdr[0] & 1U) << 6) | (hdr[1] >> 2), hdr[1] & 3U, len, buf);
+	return DWT_SUCCESS;
+}
+
+bool Sim::ServiceIrq()
+{
+	for (auto &d : devices_) {
+		if (!d->Irq())
+			continue;
+
+		uint32_t status = d->Status();
+		Select(d->index);
+		Advance(now_ + timing_.irq_latency_s);
+		dwt_isr();
+		if (d->Irq() && (d->Status() == status)) {
+			ADD_FAILURE() << "device " << d->index << ": interrupt not cleared, SYS_STATUS 0x" << std::hex << status;
+			d->Put(SYS_ENABLE_LO_ID, 0, 4);
+			d->Put(SYS_ENABLE_HI_ID, 0, 4);
+		}
+		return true;
+	}
+	return false;
+}
+
+void Sim::Run(double until)
+{
+	for (;;) {
+		if (ServiceIrq())
+			continue;
+
+		double te = events_.empty() ? std::numeric_limits<double>::infinity() : events_.front().t;
+		double ta = actions_.empty() ? std::numeric_limits<double>::infinity() : actions_.front().t;
+
+		if ((ta <= te) && (ta <= until)) {
+			Event act = actions_.front();
+
+			std::pop_heap(actions_.begin(), actions_.end(), std::greater<Event>());
+			actions_.pop_back();
+			Advance(act.t);
+			act.fn();
+		} else if (te <= until) {
+			Advance(te);
+		} else {
+			Advance(until);
+			break;
+		}
+	}
+}
+
+} // namespace uwbsim
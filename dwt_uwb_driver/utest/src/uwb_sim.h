@@ -0,0 +1,227 @@
+/*
+ * @copyright SPDX-FileCopyrightText: Copyright (c) 2024 Qorvo US, Inc.
+ *            SPDX-License-Identifier: LicenseRef-QORVO-2
+ *
+ */
+
+/*
+ * Host ranging simulation: virtual DW3000 devices behind struct dwt_spi_s, so
+ * that ranging protocols running on the real driver can be exercised end to end.
+ *
+ * Each device has its own register files, system counter with a crystal offset,
+ * true TX and RX antenna delays and position. The driver is probed on every
+ * device and the device accessed is the one last selected (dwt_update_dw()):
+ * SPI transactions are decoded into register accesses and fast commands, and
+ * take simulated time. Frames are put on the air with the preamble, SFD, PHR and
+ * data durations of the PHY configuration, and received by the devices whose
+ * receiver acquires the preamble, with the propagation delay of the link.
+ *
+ * Time stamps are those the real device would give:
+ *   TX_TIME = RMARKER leaving the digital part + TX_ANTD register
+ *   RX_TIME = RMARKER reaching the digital part - RX antenna delay register
+ * while the RMARKER crosses the antennas at the true antenna delays, so a
+ * mismatch between the programmed and the true delays biases ranges exactly as
+ * on hardware. The CIA clock offset and carrier integrator report the crystal
+ * offset of the transmitter relative to the receiver.
+ *
+ * Model limits: no frame filtering, STS, preamble or SFD timeouts, no delayed
+ * TX relative to RX/TX time stamps. With double buffering, only the frame
+ * information, time stamps and clock offset of the swinging set are written,
+ * the receiver is re-enabled after good frames (RXAUTR) and frames received
+ * while both buffers are held by the host are lost, without RXOVRR.
+ * The frame wait timeout stops once a preamble is acquired. The first frame
+ * acquired is received, overlapping frames are lost.
+ * The analog side is reduced to what the driver polls: OTP reads, LDO kicks
+ * loading the LDO tunes programmed in OTP, the PLL locking as soon as it is
+ * calibrated and the PGF calibration completing at once. SAR conversions give
+ * the readings of the node configuration, the AON memory is read and written
+ * through AON_CTRL and the sleep counter calibration gives lposc_cal. Sleep is
+ * not simulated: a device entering sleep stays awake. The automotive PLL
+ * calibration (AUTO_PLL_CAL) locks at the coarse codes of the node
+ * configuration, the VCO tune flags leading the search to them.
+ *
+ * Host code runs in zero time apart from its SPI transactions: application
+ * actions are scheduled with At(), and the interrupt of a device is serviced
+ * (dwt_isr()) as soon as one of its enabled events is set.
+ */
+
+#ifndef UWB_SIM_H_
+#define UWB_SIM_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+extern "C"
+{
+#include "deca_interface.h"
+#include "deca_device_api.h"
+}
+
+namespace uwbsim {
+
+/* PHY frame timing, channel 5, PRF 64 MHz, 128 symbols preamble, 8 symbols SFD, 6.8 Mb/s */
+struct Phy {
+	double symbol_s = 1.01763e-6;    // Preamble symbol
+	unsigned preamble_symbols = 128;
+	unsigned sfd_symbols = 8;
+	unsigned acquire_symbols = 16;   // Preamble the receiver needs before the SFD to acquire a frame
+	double phr_s = 19 * 1.02564e-6;  // 19 bits at 850 kb/s
+	double data_bit_s = 1.0 / 6.81e6;
+};
+
+/* Host and device latencies */
+struct Timing {
+	double spi_hz = 16e6;            // SPI clock
+	double spi_xfer_s = 1e-6;        // Per transaction overhead (chip select, host driver)
+	double irq_latency_s = 2e-6;     // IRQ line to dwt_isr()
+	double tx_start_s = 10e-6;       // Immediate TX command to first preamble symbol
+	double sar_s = 2e-6;             // SAR ADC conversion
+};
+
+/* Radio channel */
+struct Channel {
+	double ts_noise_dtu = 0.0;       // Standard deviation of the RX time stamp noise
+	double loss = 0.0;               // Probability of a frame not being acquired
+	uint32_t seed = 1;
+};
+
+/* OTP addresses of the calibration words */
+enum : uint16_t {
+	kOtpLdoTuneLo = 0x04,
+	kOtpLdoTuneHi = 0x05,
+	kOtpPartId = 0x06,
+	kOtpVtemp = 0x09,
+	kOtpBiasTune = 0x0A,
+	kOtpDgcTune = 0x20,
+};
+
+/* PHY configuration of the tests: 128 symbols preamble, 8 symbols SFD, 6.8 Mb/s, no STS nor PDoA */
+dwt_config_t DefaultConfig(uint8_t chan = 5);
+
+struct NodeConfig {
+	double ppm = 0.0;                // Crystal offset, positive when fast
+	double tx_antenna_dtu = 16385.0; // True TX antenna delay
+	double rx_antenna_dtu = 16385.0; // True RX antenna delay
+	double x = 0.0, y = 0.0, z = 0.0; // Position in m
+	uint64_t counter0 = 0;           // System counter at time 0
+	std::map<uint16_t, uint32_t> otp; // OTP words by address, the others read 0 (not programmed)
+	uint8_t sar_temp = 0x80;         // Raw SAR readings of the temperature
+	uint8_t sar_vbat = 0xA0;         // and of the battery voltage
+	uint16_t lposc_cal = 1920;       // XTAL cycles per LP OSC cycle, 20 kHz
+	uint32_t pll_ch5_coarse = 0xFF;  // VCO coarse codes the PLL locks at: channel 5 thermometer code,
+	uint32_t pll_ch9_coarse = 0x10;  // channel 9 code with the RVCO frequency boost in bit 5
+};
+
+struct Device;
+struct AirFrame;
+
+class Sim {
+public:
+	explicit Sim(const Phy &phy = Phy(), const Timing &timing = Timing(), const Channel &channel = Channel());
+	~Sim();
+
+	/* Add a device and probe the driver on it, it is left selected. Returns its index. */
+	int AddDevice(const NodeConfig &config);
+	/* Make the driver API address a device. */
+	void Select(int dev);
+	/* Device being addressed, e.g. from a callback. */
+	int Current() const
+	{
+		return cur_;
+	}
+	dwchip_t *Chip(int dev);
+	/* Configuration of a device, which can be changed on the fly (e.g. the VCO drifting) */
+	NodeConfig &Node(int dev);
+
+	/* Registers of a device, accessed directly: no SPI transaction, no simulated time. */
+	uint8_t *Reg(int dev, uint32_t id);
+	uint64_t Peek(int dev, uint32_t id, unsigned len);
+	void Poke(int dev, uint32_t id, uint64_t v, unsigned len);
+	/* AON memory of a device, accessed directly. */
+	uint8_t *Aon(int dev);
+	/* All the register files of a device, copied out or back. */
+	std::vector<uint8_t> Save(int dev);
+	void Load(int dev, const std::vector<uint8_t> &image);
+
+	/* Run fn on the host at true time t (at least now), with dev selected. */
+	void At(double t, int dev, std::function<void()> fn);
+	/* Process events and host actions up to true time until. */
+	void Run(double until);
+	double Now() const
+	{
+		return now_;
+	}
+
+	/* Extra delay added to the line of sight between two devices, both ways (NLOS). */
+	void SetExcessDelay(int a, int b, double seconds);
+	/* True time of flight between two devices. */
+	double Tof(int a, int b) const;
+	/* Distance between two devices in m. */
+	double Distance(int a, int b) const;
+
+	uint64_t FramesSent() const
+	{
+		return frames_sent_;
+	}
+	uint64_t FramesReceived() const
+	{
+		return frames_received_;
+	}
+	uint64_t SpiTransactions() const
+	{
+		return spi_xfers_;
+	}
+	/* OTP words read by a device. */
+	uint64_t OtpReads(int dev) const;
+
+	/* SPI trampolines, used through the struct dwt_spi_s of every device */
+	int32_t SpiRead(uint16_t hlen, const uint8_t *hdr, uint16_t len, uint8_t *buf);
+	int32_t SpiWrite(uint16_t hlen, const uint8_t *hdr, uint16_t len, const uint8_t *buf);
+
+	static const double kSpeedOfLight;
+
+private:
+	friend struct Device;
+
+	struct Event {
+		double t;
+		uint64_t order;
+		std::function<void()> fn;
+		bool operator>(const Event &o) const
+		{
+			return (t > o.t) || ((t == o.t) && (order > o.order));
+		}
+	};
+
+	void Schedule(double t, std::function<void()> fn);
+	void Advance(double t);
+	void SpiCost(uint16_t bytes);
+	void Transmit(int src, std::shared_ptr<AirFrame> frame);
+	bool ServiceIrq();
+
+	Phy phy_;
+	Timing timing_;
+	Channel channel_;
+	std::mt19937 rng_;
+	double now_ = 0.0;
+	uint64_t order_ = 0;
+	std::vector<Event> events_;
+	std::vector<Event> actions_;
+	std::vector<std::unique_ptr<Device>> devices_;
+	std::vector<std::shared_ptr<AirFrame>> air_;
+	std::map<std::pair<int, int>, double> excess_;
+	int cur_ = -1;
+	dwchip_t *saved_dw_ = nullptr;
+	uint64_t frames_sent_ = 0;
+	uint64_t frames_received_ = 0;
+	uint64_t spi_xfers_ = 0;
+};
+
+} // namespace uwbsim
+
+#endif /* UWB_SIM_H_ */
@@ -434,6 +434,40 @@ int32_t dwt_initialise(int32_t mode)
     return dw->dwt_driver->dwt_ops->initialize(dw, mode);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function gives dwt_initialise() the OTP calibration snapshot exported after a previous initialisation.
+ *        dwt_initialise() then reads the part ID from OTP and, if it is that of the snapshot and the snapshot holds all
+ *        the values requested by its mode, applies the snapshot instead of reading the other OTP values.
+ *        Otherwise the OTP is read as usual. The snapshot is kept for the following calls to dwt_initialise().
+ *
+ * input parameters
+ * @param snap - snapshot given by dwt_otpsnapshot_export(), or NULL to always read the OTP
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if the version or the CRC of the snapshot is wrong
+ */
+int32_t dwt_otpsnapshot_import(const dwt_otp_snapshot_t *snap)
+{
+    return ull_otpsnapshot_import(dw, snap);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function gives the OTP calibration snapshot of the last dwt_initialise(), to be kept in flash or RAM
+ *        and given to dwt_otpsnapshot_import() before the next dwt_initialise().
+ *
+ * input parameters
+ *
+ * output parameters
+ * @param snap - snapshot, sealed with its version and CRC
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if the part ID was not read (DWT_READ_OTP_PID not given to dwt_initialise())
+ */
+int32_t dwt_otpsnapshot_export(dwt_otp_snapshot_t *snap)
+{
+    return ull_otpsnapshot_export(dw, snap);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function can place DW3000 into IDLE/IDLE_PLL or IDLE_RC mode when it is not actively in TX or RX.
  *
@@ -511,6 +545,37 @@ int32_t dwt_configure(dwt_config_t *config)
     return dw->dwt_driver->dwt_ops->configure(dw, config);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function applies a configuration as dwt_configure() does, but only writes the registers depending on
+ * the fields which differ from the configuration last applied, e.g. to hop preamble codes or lengths every slot.
+ * The PLL is only calibrated again when the channel changes, and the DGC LUTs are only loaded and the RX calibrated
+ * again when the PRF of the RX preamble code changes.
+ *
+ * input parameters
+ * @param config    -   pointer to the configuration structure, which contains the device configuration data.
+ *
+ * output parameters
+ *
+ * return DWT_SUCCESS or DWT_ERROR (e.g. when PLL CAL fails / PLL fails to lock)
+ */
+int32_t dwt_reconfigure(dwt_config_t *config)
+{
+    return ull_reconfigure(dw, config);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function returns the frame timing of the configuration last set with dwt_configure(), so that frame
+ *        air times and reply delays can be computed without hard-coded constants (see deca_airtime.h).
+ *
+ * input parameters
+ *
+ * return pointer to the frame timing, all zero until dwt_configure() is called
+ */
+const dwt_airtime_t *dwt_getairtime(void)
+{
+    return ull_getairtime(dw);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function provides the API for the configuration of the TX power
  * The input is the desired tx power to configure.
@@ -983,6 +1048,23 @@ void dwt_readrxtimestamp_sts(uint8_t *timestamp)
     ull_readrxtimestamp_sts(dw, timestamp);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This is used to read the RX timestamp (adjusted time of arrival) together with the crystal offset
+ *        (see dwt_readclockoffset()). In double buffer mode both are read in one SPI transaction.
+ *
+ * input parameters
+ * @param timestamp - a pointer to a 5-byte buffer which will store the read RX timestamp time
+ *
+ * output parameters - the timestamp buffer will contain the value after the function call
+ *
+ * return value - the (int12) signed offset value. (s[-15:-26])
+ *                A positive value means the local (RX) clock is running slower than that of the remote (TX) device.
+ */
+int16_t dwt_readrxtimestamp_clkoffset(uint8_t *timestamp)
+{
+    return ull_readrxtimestamp_clkoffset(dw, timestamp);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This is used to read the high 32-bits of the RX timestamp (adjusted with the programmed antenna delay)
  *
@@ -1323,6 +1405,37 @@ void dwt_entersleepafter(int32_t event_mask)
     ull_entersleepafter(dw, event_mask);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Starts duty-cycled listening: the device wakes up on its sleep counter every period, listens in SNIFF mode for
+ * the window and goes back to sleep without the host, unless a frame is received (RXFCG interrupt).
+ *
+ * input parameters
+ * @param config - wake-up period, listen window, SNIFF ON/OFF times and recalibration temperature
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS for success, or DWT_ERROR if the sleep counter could not be calibrated
+ */
+int32_t dwt_listen_start(const dwt_listen_config_t *config)
+{
+    return ull_listen_start(dw, config);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Stops duty-cycled listening and enables the interrupts enabled before dwt_listen_start() again. The device
+ * must be awake.
+ *
+ * input parameters
+ *
+ * output parameters
+ *
+ * no return value
+ */
+void dwt_listen_stop(void)
+{
+    ull_listen_stop(dw);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function is used to register the different callbacks called when one of the corresponding event occurs.
  *
@@ -1855,6 +1968,23 @@ void dwt_readdiagnostics(dwt_rxdiag_t *diagnostics)
     ull_readdiagnostics(dw, diagnostics);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief this function reads a subset of the RX signal quality diagnostic data, transferring only the register spans
+ *        which back the requested fields
+ *
+ * input parameters
+ * @param field_mask - bitmask of dwt_diag_sel_e values selecting the fields to read
+ *
+ * output parameters
+ * @param diagnostics - diagnostic structure pointer, the selected fields will be updated with the data read from the DW3000
+ *
+ * returns the bitmask of dwt_diag_sel_e values which have been updated
+ */
+uint32_t dwt_readdiagnostics_sel(dwt_rxdiag_t *diagnostics, uint32_t field_mask)
+{
+    return ull_readdiagnostics_sel(dw, diagnostics, field_mask);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This is used to enable/disable the event counter in the IC
  *
@@ -2126,6 +2256,75 @@ uint16_t dwt_readtempvbat(void)
     return ull_readtempvbat(dw);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Starts the conversion of the temperature and battery voltage values read by dwt_readtempvbat(), without
+ * waiting for it: dwt_readtempvbat_complete() is then polled to collect the readings. The SAR ADC converts the
+ * temperature, then the voltage, so the host is free between the polls, and the device can be receiving.
+ * No other SAR reading can be done until the readings are collected: dwt_readtempvbat() finishes the conversion and
+ * returns its readings instead. dwt_readtempvbat_abort() gives the conversion up, as entering sleep does.
+ *
+ * input parameters:
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS, or DWT_ERR_BUSY if a conversion started before is not collected yet
+ */
+int32_t dwt_readtempvbat_start(void)
+{
+    return ull_readtempvbat_start(dw);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Collects the readings of the conversion started by dwt_readtempvbat_start(). Each call checks the
+ * SAR once and never waits: the voltage conversion is started by the call which finds the temperature converted,
+ * so at least two calls are needed.
+ *
+ * input parameters:
+ *
+ * output parameters
+ * @param tempvbat - (temp_raw<<8)|(vbat_raw), as returned by dwt_readtempvbat(), set on DWT_SUCCESS
+ *
+ * returns DWT_SUCCESS once both readings are collected, DWT_ERR_BUSY while converting, or DWT_ERROR if no
+ * conversion was started
+ */
+int32_t dwt_readtempvbat_complete(uint16_t *tempvbat)
+{
+    return ull_readtempvbat_complete(dw, tempvbat);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Gives up the conversion started by dwt_readtempvbat_start(): the SAR ADC is stopped and its inputs powered
+ * down, and readings not collected yet are dropped. A new conversion can then be started.
+ *
+ * input parameters:
+ *
+ * output parameters
+ *
+ * returns DWT_SUCCESS, or DWT_ERROR if no conversion was started
+ */
+int32_t dwt_readtempvbat_abort(void)
+{
+    return ull_readtempvbat_abort(dw);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief Converts both raw values of a temperature and battery voltage reading with integer arithmetic only,
+ * as dwt_convertrawtemperature_cdeg() and dwt_convertrawvoltage_mv() do.
+ *
+ * input parameters:
+ * @param tempvbat - (temp_raw<<8)|(vbat_raw), as read by dwt_readtempvbat() or dwt_readtempvbat_complete()
+ *
+ * output parameters
+ * @param temp_cdeg - temperature, in hundredths of degrees C
+ * @param vbat_mv - battery voltage, in mV
+ *
+ * no return value
+ */
+void dwt_converttempvbat(uint16_t tempvbat, int16_t *temp_cdeg, uint16_t *vbat_mv)
+{
+    ull_converttempvbat(dw, tempvbat, temp_cdeg, vbat_mv);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief  this function takes in a raw temperature value and applies the conversion factor
  * to give true temperature. The dwt_initialise needs to be called before call to this to
@@ -2136,7 +2335,7 @@ uint16_t dwt_readtempvbat(void)
  *
  * output parameters:
  *
- * returns: temperature sensor value
+ * returns: temperature sensor value, see dwt_convertrawtemperature_cdeg()
  */
 float dwt_convertrawtemperature(uint8_t raw_temp)
 {
@@ -2153,13 +2352,47 @@ float dwt_convertrawtemperature(uint8_t raw_temp)
  *
  * output parameters:
  *
- * returns: voltage sensor value
+ * returns: voltage sensor value, see dwt_convertrawvoltage_mv()
  */
 float dwt_convertrawvoltage(uint8_t raw_voltage)
 {
     return ull_convertrawvoltage(dw, raw_voltage);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief  this function takes in a raw temperature value and applies the conversion factor
+ * to give true temperature, with integer arithmetic only. The dwt_initialise needs to be called before call to
+ * this to ensure pdw3000local->tempP contains the SAR_LTEMP value from OTP.
+ *
+ * input parameters:
+ * @param raw_temp - this is the 8-bit raw temperature value as read by dwt_readtempvbat
+ *
+ * output parameters:
+ *
+ * returns: temperature sensor value, in hundredths of degrees C
+ */
+int16_t dwt_convertrawtemperature_cdeg(uint8_t raw_temp)
+{
+    return ull_convertrawtemperature_cdeg(dw, raw_temp);
+}
+
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief this function takes in a raw voltage value and applies the conversion factor
+ * to give true voltage, with integer arithmetic only. The dwt_initialise needs to be called before call to
+ * this to ensure pdw3000local->vBatP contains the SAR_LVBAT value from OTP
+ *
+ * input parameters:
+ * @param raw_voltage - this is the 8-bit raw voltage value as read by dwt_readtempvbat
+ *
+ * output parameters:
+ *
+ * returns: voltage sensor value, rounded to the nearest mV, 0 if below
+ */
+uint16_t dwt_convertrawvoltage_mv(uint8_t raw_voltage)
+{
+    return ull_convertrawvoltage_mv(dw, raw_voltage);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief this function reads the temperature of the DW3000 that was sampled
  * on waking from Sleep/Deepsleep. They are not current values, but read on last
@@ -3087,6 +3320,23 @@ void dwt_nlos_ipdiag(dwt_nlos_ipdiag_t *index)
     ull_nlos_ipdiag(dw, index);
 }
 
+/*! ------------------------------------------------------------------------------------------------------------------
+ * @brief This function reads the NLOS diagnostics of all requested accumulators at once and estimates the LOS/NLOS
+ *        condition of the received frame from them. See ull_nlos_readsnapshot().
+ *
+ * input parameters:
+ * @param acc_mask  - accumulators to read, a combination of DWT_NLOS_SEL_IPATOV, DWT_NLOS_SEL_STS1, DWT_NLOS_SEL_STS2.
+ *
+ * output parameters:
+ * @param snap      - pointer to the structure into which to read the diagnostics and the estimation result.
+ *
+ * @return DWT_SUCCESS for success, or DWT_ERROR if acc_mask is empty or invalid.
+ */
+int32_t dwt_nlos_readsnapshot(dwt_nlos_snapshot_t *snap, uint8_t acc_mask)
+{
+    return ull_nlos_readsnapshot(dw, snap, acc_mask);
+}
+
 /*! ------------------------------------------------------------------------------------------------------------------
  * @brief This function calculates the adjusted TxPower setting by applying a boost over a reference TxPower setting.
  * The reference TxPower setting should correspond to a 1ms frame (or 0dB) boost.
@@ -19,6 +19,10 @@ int ull_setdwstate(dwchip_t *dw, int32_t state);
 void ull_enablegpioclocks(dwchip_t *dw);
 void ull_restoreconfig(dwchip_t *dw, int32_t full_restore);
 void ull_configurestsmode(dwchip_t *dw, uint8_t stsMode);
+int32_t ull_reconfigure(dwchip_t *dw, dwt_config_t *config);
+const dwt_airtime_t *ull_getairtime(dwchip_t *dw);
+int32_t ull_otpsnapshot_import(dwchip_t *dw, const dwt_otp_snapshot_t *snap);
+int32_t ull_otpsnapshot_export(dwchip_t *dw, dwt_otp_snapshot_t *snap);
 void ull_settxpower(dwchip_t *dw, uint32_t power);
 void ull_configurestsloadiv(dwchip_t *dw);
 void ull_configmrxlut(dwchip_t *dw, int32_t channel);
@@ -41,6 +45,7 @@ void ull_readtdoa(dwchip_t *dw, uint8_t *tdoa);
 void ull_readrxtimestampunadj(dwchip_t *dw, uint8_t *timestamp);
 void ull_readrxtimestamp_ipatov(dwchip_t *dw, uint8_t *timestamp);
 void ull_readrxtimestamp_sts(dwchip_t *dw, uint8_t *timestamp);
+int16_t ull_readrxtimestamp_clkoffset(dwchip_t *dw, uint8_t *timestamp);
 uint32_t ull_readrxtimestamphi32(dwchip_t *dw);
 uint32_t ull_readrxtimestamplo32(dwchip_t *dw);
 uint32_t ull_readsystimehi32(dwchip_t *dw);
@@ -58,6 +63,8 @@ void ull_clearaonconfig(dwchip_t *dw);
 void ull_entersleep(dwchip_t *dw, int32_t idle_rc);
 void ull_entersleepaftertx(dwchip_t *dw, int32_t enable);
 void ull_entersleepafter(dwchip_t *dw, int32_t event_mask);
+int32_t ull_listen_start(dwchip_t *dw, const dwt_listen_config_t *config);
+void ull_listen_stop(dwchip_t *dw);
 uint8_t ull_checkirq(dwchip_t *dw);
 uint8_t ull_checkidlerc(dwchip_t *dw);
 void ull_setpanid(dwchip_t *dw, uint16_t panID);
@@ -79,6 +86,7 @@ void ull_configciadiag(dwchip_t *dw, uint8_t enable_mask);
 int32_t ull_readstsquality(dwchip_t *dw, int16_t *rxStsQualityIndex);
 int32_t ull_readstsstatus(dwchip_t *dw, uint16_t *stsStatus, int32_t sts_num);
 void ull_readdiagnostics(dwchip_t *dw, dwt_rxdiag_t *diagnostics);
+uint32_t ull_readdiagnostics_sel(dwchip_t *dw, dwt_rxdiag_t *diagnostics, uint32_t field_mask);
 int ull_readdiagnostics_acc(dwchip_t *dw, dwt_cirdiags_t *cir_diag, dwt_acc_idx_e acc_idx);
 void ull_configeventcounters(dwchip_t *dw, int32_t enable);
 void ull_readeventcounters(dwchip_t *dw, dwt_deviceentcnts_t *counters);
@@ -97,8 +105,14 @@ void ull_configcontinuousframemode(dwchip_t *dw, uint32_t framerepetitionrate);
 void ull_disablecontinuousframemode(dwchip_t *dw);
 void ull_disablecontinuouswavemode(dwchip_t *dw);
 uint16_t ull_readtempvbat(dwchip_t *dw);
+int32_t ull_readtempvbat_start(dwchip_t *dw);
+int32_t ull_readtempvbat_complete(dwchip_t *dw, uint16_t *tempvbat);
+int32_t ull_readtempvbat_abort(dwchip_t *dw);
+void ull_converttempvbat(dwchip_t *dw, uint16_t tempvbat, int16_t *temp_cdeg, uint16_t *vbat_mv);
 float ull_convertrawtemperature(dwchip_t *dw, uint8_t raw_temp);
 float ull_convertrawvoltage(dwchip_t *dw, uint8_t raw_voltage);
+int16_t ull_convertrawtemperature_cdeg(dwchip_t *dw, uint8_t raw_temp);
+uint16_t ull_convertrawvoltage_mv(dwchip_t *dw, uint8_t raw_voltage);
 uint8_t ull_readwakeuptemp(dwchip_t *dw);
 uint8_t ull_readwakeupvbat(dwchip_t *dw);
 uint8_t ull_readpgdelay(dwchip_t *dw);
@@ -131,6 +145,7 @@ void ull_config_ostr_mode(dwchip_t *dw, uint8_t enable, uint16_t wait_time);
 uint32_t ull_readCIAversion(dwchip_t* dw);
 uint8_t ull_nlos_alldiag(dwchip_t *dw, dwt_nlos_alldiag_t *all_diag);
 void ull_nlos_ipdiag(dwchip_t *dw, dwt_nlos_ipdiag_t *index);
+int32_t ull_nlos_readsnapshot(dwchip_t *dw, dwt_nlos_snapshot_t *snap, uint8_t acc_mask);
 int32_t ull_adjust_tx_power(uint16_t boost, uint32_t ref_tx_power, uint8_t channel, uint32_t* adj_tx_power, uint16_t* applied_boost );
 int32_t ull_calculate_linear_tx_setting(struct dwchip_s *dw, int32_t channel, power_indexes_t *p_indexes, tx_adj_res_t *p_res);
 int ull_convert_tx_power_to_index(int channel, uint8_t tx_power, uint8_t *tx_power_idx);
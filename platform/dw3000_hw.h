@@ -2,6 +2,7 @@
 #define DW3000_HW_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 int dw3000_hw_init(void);
 int dw3000_hw_init_interrupt(void);
@@ -9,6 +10,10 @@ void dw3000_hw_fini(void);
 void dw3000_hw_reset(void);
 void dw3000_hw_wakeup(void);
 void dw3000_hw_wakeup_pin_low(void);
+/* reset or wakeup, then wait for IDLE_RC on the SPIRDY interrupt or polling,
+ * instead of fixed delays. Need dwt_probe() done. 0 when ready */
+int dw3000_hw_reset_wait(uint32_t timeout_us);
+int dw3000_hw_wakeup_wait(uint32_t timeout_us);
 void dw3000_hw_interrupt_enable(void);
 void dw3000_hw_interrupt_disable(void);
 bool dw3000_hw_interrupt_is_enabled(void);
@@ -2,13 +2,20 @@
 #include <driver/gpio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <rom/ets_sys.h>
 
 #include "deca_device_api.h"
+#include "deca_sleepprof.h"
 #include "dw3000_hw.h"
 #include "dw3000_spi.h"
 #include "log.h"
 
 static const char* LOG_TAG = "DW3000";
+
+#define DW3000_RESET_PULSE_US	10 // API guide says 10 ns
+#define DW3000_WAKEUP_PULSE_US	500
+#define DW3000_IDLERC_STEP_US	10
+#define DW3000_IDLERC_POLL_US	100 // SPI reads take CS low: not too often
 static bool dw3000_interrupt_enabled;
 
 int dw3000_hw_init(void)
@@ -128,24 +135,110 @@ void dw3000_hw_reset(void)
 #endif
 }
 
-/** wakeup either using the WAKEUP pin or SPI CS */
-void dw3000_hw_wakeup(void)
+static void dw3000_hw_wakeup_pulse(void)
 {
 #if CONFIG_DW3000_GPIO_WAKEUP != -1
 	/* Use WAKEUP pin if available */
-	LOG_INF("WAKEUP PIN");
 	gpio_set_level(CONFIG_DW3000_GPIO_WAKEUP, 1);
-	vTaskDelay(1); // 500 usec
+	ets_delay_us(DW3000_WAKEUP_PULSE_US);
 	gpio_set_level(CONFIG_DW3000_GPIO_WAKEUP, 0);
 #else
 	/* Use SPI CS pin */
-	LOG_INF("WAKEUP CS");
 	// TODO: set from SPI to GPIO output
 	gpio_set_level(CONFIG_DW3000_SPI_CS, 0);
-	vTaskDelay(1); // 500 usec
+	ets_delay_us(DW3000_WAKEUP_PULSE_US);
 	gpio_set_level(CONFIG_DW3000_SPI_CS, 1);
 #endif
+}
+
+/** wakeup either using the WAKEUP pin or SPI CS */
+void dw3000_hw_wakeup(void)
+{
+	SLEEPPROF_MARK(SLEEPPROF_WAKE_PULSE);
+
+#if CONFIG_DW3000_GPIO_WAKEUP != -1
+	LOG_INF("WAKEUP PIN");
+#else
+	LOG_INF("WAKEUP CS");
+#endif
+	dw3000_hw_wakeup_pulse();
+
+	SLEEPPROF_MARK(SLEEPPROF_WAKE_DELAY);
 	vTaskDelay(1);
+	SLEEPPROF_MARK(SLEEPPROF_SPI_READY);
+}
+
+/** wait for IDLE_RC after a wakeup or reset: on the IRQ line raised by the
+ * SPIRDY interrupt if it is enabled, otherwise polling RCINIT. The interrupt
+ * is disabled by the caller, so that dwt_isr() does not clear RCINIT before
+ * it is seen, and dwt_isr() handles the event afterwards */
+static esp_err_t dw3000_hw_wait_idlerc(uint32_t timeout_us, bool irq_enabled)
+{
+	uint32_t waited = 0;
+	uint32_t polled = 0;
+	esp_err_t ret = ESP_ERR_TIMEOUT;
+
+	while (waited < timeout_us) {
+		ets_delay_us(DW3000_IDLERC_STEP_US);
+		waited += DW3000_IDLERC_STEP_US;
+		polled += DW3000_IDLERC_STEP_US;
+#if CONFIG_DW3000_GPIO_IRQ != -1
+		if (gpio_get_level(CONFIG_DW3000_GPIO_IRQ)) {
+			polled = DW3000_IDLERC_POLL_US;
+		}
+#endif
+		if (polled >= DW3000_IDLERC_POLL_US) {
+			polled = 0;
+			if (dwt_checkidlerc()) {
+				ret = ESP_OK;
+				break;
+			}
+		}
+	}
+
+#if CONFIG_DW3000_GPIO_IRQ != -1
+	if (irq_enabled) {
+		/* events raised while waiting, handled before the interrupt can
+		 * run dwt_isr() again */
+		dw3000_isr(NULL);
+		dw3000_hw_interrupt_enable();
+	}
+#else
+	(void)irq_enabled;
+#endif
+	return ret;
+}
+
+/** reset and wait until the DW3000 is in IDLE_RC, at most timeout_us */
+int dw3000_hw_reset_wait(uint32_t timeout_us)
+{
+#if CONFIG_DW3000_GPIO_RESET == -1
+	LOG_ERR("Reset pin is not defined");
+	return ESP_ERR_NOT_SUPPORTED;
+#else
+	bool irq_enabled = dw3000_hw_interrupt_is_enabled();
+
+	dw3000_hw_interrupt_disable();
+	gpio_set_direction(CONFIG_DW3000_GPIO_RESET, GPIO_MODE_OUTPUT);
+	gpio_set_level(CONFIG_DW3000_GPIO_RESET, 0);
+	ets_delay_us(DW3000_RESET_PULSE_US);
+	gpio_set_direction(CONFIG_DW3000_GPIO_RESET, GPIO_MODE_INPUT);
+
+	return dw3000_hw_wait_idlerc(timeout_us, irq_enabled);
+#endif
+}
+
+/** wakeup and wait until the DW3000 is in IDLE_RC, at most timeout_us */
+int dw3000_hw_wakeup_wait(uint32_t timeout_us)
+{
+	bool irq_enabled = dw3000_hw_interrupt_is_enabled();
+
+	dw3000_hw_interrupt_disable();
+	SLEEPPROF_MARK(SLEEPPROF_WAKE_PULSE);
+	dw3000_hw_wakeup_pulse();
+	SLEEPPROF_MARK(SLEEPPROF_SPI_READY);
+
+	return dw3000_hw_wait_idlerc(timeout_us, irq_enabled);
 }
 
 /** set WAKEUP pin low if available */
@@ -4,6 +4,7 @@
 #include <zephyr/logging/log.h>
 
 #include "deca_device_api.h"
+#include "deca_sleepprof.h"
 #include "dw3000_hw.h"
 #include "dw3000_spi.h"
 
@@ -11,8 +12,14 @@ LOG_MODULE_REGISTER(dw3000, CONFIG_DW3000_LOG_LEVEL);
 
 #define DW_INST DT_INST(0, decawave_dw3000)
 
+#define DW3000_RESET_PULSE_US	10	// API guide says 10 ns
+#define DW3000_WAKEUP_PULSE_US	500
+#define DW3000_IDLERC_POLL_US	100	// SPI reads take CS low: not too often
+
 static struct gpio_callback gpio_cb;
 static struct k_work dw3000_isr_work;
+static K_SEM_DEFINE(dw3000_idlerc_sem, 0, 1);
+static atomic_t dw3000_idlerc_waiting;
 
 struct dw3000_config {
 	struct gpio_dt_spec gpio_irq;
@@ -73,7 +80,12 @@ static void dw3000_hw_isr_work_handler(struct k_work* item)
 static void dw3000_hw_isr(const struct device* dev, struct gpio_callback* cb,
 						  uint32_t pins)
 {
-	k_work_submit(&dw3000_isr_work);
+	if (atomic_get(&dw3000_idlerc_waiting)) {
+		/* SPIRDY / RCINIT: ends dw3000_hw_wait_idlerc() */
+		k_sem_give(&dw3000_idlerc_sem);
+	} else {
+		k_work_submit(&dw3000_isr_work);
+	}
 }
 
 int dw3000_hw_init_interrupt(void)
@@ -147,6 +159,8 @@ void dw3000_hw_reset()
 /** wakeup either using the WAKEUP pin or SPI CS */
 void dw3000_hw_wakeup(void)
 {
+	SLEEPPROF_MARK(SLEEPPROF_WAKE_PULSE);
+
 	if (conf.gpio_wakeup.port) {
 		/* Use WAKEUP pin if available */
 		LOG_INF("WAKEUP PIN");
@@ -159,6 +173,72 @@ void dw3000_hw_wakeup(void)
 		LOG_INF("WAKEUP CS");
 		dw3000_spi_wakeup();
 	}
+
+	SLEEPPROF_MARK(SLEEPPROF_SPI_READY);
+}
+
+/** from now on the IRQ line ends dw3000_hw_wait_idlerc() instead of calling
+ * dwt_isr(), which would clear RCINIT before it is seen */
+static void dw3000_hw_wait_idlerc_prepare(void)
+{
+	k_sem_reset(&dw3000_idlerc_sem);
+	atomic_set(&dw3000_idlerc_waiting, 1);
+}
+
+/** wait for IDLE_RC after a wakeup or reset: on the SPIRDY interrupt if it is
+ * enabled, otherwise polling RCINIT. dwt_isr() handles the event afterwards */
+static int dw3000_hw_wait_idlerc(uint32_t timeout_us)
+{
+	int64_t end = k_uptime_ticks() + k_us_to_ticks_ceil64(timeout_us);
+	int ret = -ETIMEDOUT;
+
+	do {
+		k_sem_take(&dw3000_idlerc_sem, K_USEC(DW3000_IDLERC_POLL_US));
+		if (dwt_checkidlerc()) {
+			ret = 0;
+			break;
+		}
+	} while (k_uptime_ticks() < end);
+
+	atomic_set(&dw3000_idlerc_waiting, 0);
+	if (conf.gpio_irq.port && gpio_pin_get_dt(&conf.gpio_irq)) {
+		k_work_submit(&dw3000_isr_work);
+	}
+	return ret;
+}
+
+/** reset and wait until the DW3000 is in IDLE_RC, at most timeout_us */
+int dw3000_hw_reset_wait(uint32_t timeout_us)
+{
+	if (!conf.gpio_reset.port) {
+		LOG_ERR("No HW reset configured");
+		return -ENOENT;
+	}
+
+	dw3000_hw_wait_idlerc_prepare();
+	gpio_pin_configure_dt(&conf.gpio_reset, GPIO_OUTPUT_ACTIVE);
+	k_busy_wait(DW3000_RESET_PULSE_US);
+	gpio_pin_configure_dt(&conf.gpio_reset, GPIO_INPUT);
+
+	return dw3000_hw_wait_idlerc(timeout_us);
+}
+
+/** wakeup and wait until the DW3000 is in IDLE_RC, at most timeout_us */
+int dw3000_hw_wakeup_wait(uint32_t timeout_us)
+{
+	dw3000_hw_wait_idlerc_prepare();
+
+	SLEEPPROF_MARK(SLEEPPROF_WAKE_PULSE);
+	if (conf.gpio_wakeup.port) {
+		gpio_pin_set_dt(&conf.gpio_wakeup, 1);
+		k_usleep(DW3000_WAKEUP_PULSE_US);
+		gpio_pin_set_dt(&conf.gpio_wakeup, 0);
+	} else {
+		dw3000_spi_wakeup();
+	}
+	SLEEPPROF_MARK(SLEEPPROF_SPI_READY);
+
+	return dw3000_hw_wait_idlerc(timeout_us);
 }
 
 /** set WAKEUP pin low if available */